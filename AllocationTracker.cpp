@@ -0,0 +1,470 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <thread>
+#include "AllocationTracker.h"
+
+// --------------------------------------------------------
+// In front of every block.  Rounded up to 16 bytes so the
+// memory handed out keeps malloc's alignment.
+// --------------------------------------------------------
+struct alignas(16) BlockHeader
+{
+	BlockHeader* Prev;
+	BlockHeader* Next;
+	size_t Size;
+	uint64_t Info;		// Sequence << 8 | tag
+	size_t Offset;		// From what malloc returned to the header, only over-aligned blocks have one
+};
+
+#define BLOCK_TAG_BITS 8
+static_assert(ALLOCATION_TAGS <= (1 << BLOCK_TAG_BITS), "Tags must fit in a block header");
+
+// Everything new and delete touch is constant initialized, so
+// allocations made while other globals are constructed are fine
+static std::atomic_flag blocksLock = ATOMIC_FLAG_INIT;
+static BlockHeader liveBlocks = { &liveBlocks, &liveBlocks, 0, 0 };	// Sentinel of a circular list
+static uint64_t liveBlockCount = 0;
+static uint64_t sequence = 0;
+
+static std::atomic_flag tagsLock = ATOMIC_FLAG_INIT;
+static const char* tagNames[ALLOCATION_TAGS] = { "Untagged" };
+static std::atomic<unsigned int> tagCount(1);
+
+static std::atomic<uint64_t> tagAllocations[ALLOCATION_TAGS];
+static std::atomic<uint64_t> tagFrees[ALLOCATION_TAGS];
+static std::atomic<uint64_t> tagBytes[ALLOCATION_TAGS];
+static std::atomic<uint64_t> tagFreedBytes[ALLOCATION_TAGS];
+
+static thread_local unsigned int currentTag = 0;
+
+// Only BeginFrame's thread touches these
+static uint64_t frameStartAllocations[ALLOCATION_TAGS];
+static uint64_t frameStartFrees[ALLOCATION_TAGS];
+static uint64_t frameStartBytes[ALLOCATION_TAGS];
+static AllocationTagStats lastFrame[ALLOCATION_TAGS];
+static uint64_t frameCount = 0;
+static bool expectNoAllocations = false;
+static uint64_t expectedFrames = 0;
+static uint64_t unexpectedFrames = 0;
+
+static void Lock(std::atomic_flag& flag)
+{
+	while (flag.test_and_set(std::memory_order_acquire)) {
+		std::this_thread::yield();
+	}
+}
+
+static void Unlock(std::atomic_flag& flag)
+{
+	flag.clear(std::memory_order_release);
+}
+
+// alignment is a power of two; anything past the header's own gets slack to slide the header and block forward
+static void* Allocate(size_t size, size_t alignment = alignof(BlockHeader))
+{
+	size_t slack = alignment > alignof(BlockHeader) ? alignment - alignof(BlockHeader) : 0;
+	uint8_t* memory = (uint8_t*)malloc(sizeof(BlockHeader) + size + slack);
+	if (!memory) {
+		return nullptr;
+	}
+	uintptr_t block = ((uintptr_t)(memory + sizeof(BlockHeader)) + slack) & ~(uintptr_t)(alignment - 1);
+	BlockHeader* header = (BlockHeader*)block - 1;
+	header->Offset = (size_t)((uint8_t*)header - memory);
+	unsigned int tag = currentTag;
+	header->Size = size;
+
+	Lock(blocksLock);
+	header->Info = (sequence++ << BLOCK_TAG_BITS) | tag;
+	header->Prev = &liveBlocks;
+	header->Next = liveBlocks.Next;
+	liveBlocks.Next->Prev = header;
+	liveBlocks.Next = header;
+	liveBlockCount++;
+	Unlock(blocksLock);
+
+	tagAllocations[tag].fetch_add(1, std::memory_order_relaxed);
+	tagBytes[tag].fetch_add(size, std::memory_order_relaxed);
+	return header + 1;
+}
+
+static void Free(void* memory)
+{
+	if (!memory) {
+		return;
+	}
+	BlockHeader* header = (BlockHeader*)memory - 1;
+	unsigned int tag = (unsigned int)(header->Info & ((1 << BLOCK_TAG_BITS) - 1));
+
+	Lock(blocksLock);
+	header->Prev->Next = header->Next;
+	header->Next->Prev = header->Prev;
+	liveBlockCount--;
+	Unlock(blocksLock);
+
+	tagFrees[tag].fetch_add(1, std::memory_order_relaxed);
+	tagFreedBytes[tag].fetch_add(header->Size, std::memory_order_relaxed);
+	free((uint8_t*)header - header->Offset);
+}
+
+static AllocationTagStats GetTotal(unsigned int tag)
+{
+	AllocationTagStats stats;
+	stats.Name = tagNames[tag];
+	stats.Allocations = tagAllocations[tag].load(std::memory_order_relaxed);
+	stats.Frees = tagFrees[tag].load(std::memory_order_relaxed);
+	stats.Bytes = tagBytes[tag].load(std::memory_order_relaxed);
+	stats.LiveAllocations = (int64_t)(stats.Allocations - stats.Frees);
+	stats.LiveBytes = (int64_t)(stats.Bytes - tagFreedBytes[tag].load(std::memory_order_relaxed));
+	return stats;
+}
+
+static void PrintStats(const std::vector<AllocationTagStats>& stats)
+{
+	printf("  %-24s %10s %12s %10s %10s %12s\n", "tag", "allocs", "bytes", "frees", "live", "live bytes");
+	for (size_t i = 0; i < stats.size(); i++) {
+		printf("  %-24s %10llu %12llu %10llu %10lld %12lld\n", stats[i].Name,
+			(unsigned long long)stats[i].Allocations, (unsigned long long)stats[i].Bytes, (unsigned long long)stats[i].Frees,
+			(long long)stats[i].LiveAllocations, (long long)stats[i].LiveBytes);
+	}
+}
+
+unsigned int AllocationTracker::GetTag(const char* name)
+{
+	Lock(tagsLock);
+	unsigned int count = tagCount.load(std::memory_order_relaxed);
+	unsigned int tag = 0;
+	for (unsigned int t = 0; t < count; t++) {
+		if (strcmp(tagNames[t], name) == 0) {
+			tag = t;
+			break;
+		}
+	}
+	if (tag == 0 && strcmp(tagNames[0], name) != 0 && count < ALLOCATION_TAGS) {
+		tag = count;
+		tagNames[tag] = name;
+		tagCount.store(count + 1, std::memory_order_release);
+	}
+	Unlock(tagsLock);
+	return tag;
+}
+
+void AllocationTracker::BeginFrame()
+{
+	unsigned int count = tagCount.load(std::memory_order_acquire);
+	uint64_t allocations = 0;
+	uint64_t bytes = 0;
+	for (unsigned int t = 0; t < count; t++) {
+		AllocationTagStats total = GetTotal(t);
+		lastFrame[t] = total;
+		lastFrame[t].Allocations = total.Allocations - frameStartAllocations[t];
+		lastFrame[t].Frees = total.Frees - frameStartFrees[t];
+		lastFrame[t].Bytes = total.Bytes - frameStartBytes[t];
+		frameStartAllocations[t] = total.Allocations;
+		frameStartFrees[t] = total.Frees;
+		frameStartBytes[t] = total.Bytes;
+		allocations += lastFrame[t].Allocations;
+		bytes += lastFrame[t].Bytes;
+	}
+
+	if (frameCount > 0 && expectNoAllocations) {
+		expectedFrames++;
+		if (allocations > 0) {
+			unexpectedFrames++;
+			if (unexpectedFrames <= ALLOCATION_REPORTED_FRAMES) {
+				printf("Allocations: frame %llu allocated %llu times (%llu bytes):", (unsigned long long)(frameCount - 1),
+					(unsigned long long)allocations, (unsigned long long)bytes);
+				for (unsigned int t = 0; t < count; t++) {
+					if (lastFrame[t].Allocations > 0) {
+						printf(" %s %llu", lastFrame[t].Name, (unsigned long long)lastFrame[t].Allocations);
+					}
+				}
+				printf(unexpectedFrames == ALLOCATION_REPORTED_FRAMES ? "\n  (no more frames reported)\n" : "\n");
+			}
+		}
+	}
+	frameCount++;
+}
+
+uint64_t AllocationTracker::GetFrameCount()
+{
+	return frameCount;
+}
+
+void AllocationTracker::GetFrameStats(std::vector<AllocationTagStats>& stats)
+{
+	stats.clear();
+	if (frameCount < 2) {
+		return;
+	}
+	unsigned int count = tagCount.load(std::memory_order_acquire);
+	for (unsigned int t = 0; t < count; t++) {
+		if (lastFrame[t].Allocations > 0 || lastFrame[t].Frees > 0) {
+			stats.push_back(lastFrame[t]);
+		}
+	}
+}
+
+void AllocationTracker::GetTotals(std::vector<AllocationTagStats>& stats)
+{
+	stats.clear();
+	unsigned int count = tagCount.load(std::memory_order_acquire);
+	for (unsigned int t = 0; t < count; t++) {
+		AllocationTagStats total = GetTotal(t);
+		if (total.Allocations > 0) {
+			stats.push_back(total);
+		}
+	}
+}
+
+void AllocationTracker::PrintFrame()
+{
+#ifdef ALLOCATION_TRACKING_DISABLED
+	printf("Allocations: not tracked in this build\n");
+	return;
+#endif
+	std::vector<AllocationTagStats> stats;
+	GetFrameStats(stats);
+	if (stats.empty()) {
+		printf("Allocations: none in frame %llu\n", (unsigned long long)(frameCount - 1));
+		return;
+	}
+	printf("Allocations in frame %llu:\n", (unsigned long long)(frameCount - 1));
+	PrintStats(stats);
+}
+
+void AllocationTracker::PrintTotals()
+{
+#ifdef ALLOCATION_TRACKING_DISABLED
+	printf("Allocations: not tracked in this build\n");
+	return;
+#endif
+	std::vector<AllocationTagStats> stats;
+	GetTotals(stats);
+	printf("Allocations since the start:\n");
+	PrintStats(stats);
+	if (expectedFrames > 0) {
+		printf("  %llu of %llu steady-state frames allocated\n", (unsigned long long)unexpectedFrames, (unsigned long long)expectedFrames);
+	}
+}
+
+void AllocationTracker::ExpectNoAllocations(bool expect)
+{
+	expectNoAllocations = expect;
+}
+
+uint64_t AllocationTracker::GetUnexpectedFrames()
+{
+	return unexpectedFrames;
+}
+
+uint64_t AllocationTracker::GetExpectedFrames()
+{
+	return expectedFrames;
+}
+
+void AllocationTracker::TakeSnapshot(HeapSnapshot& snapshot)
+{
+	// Room for the blocks has to be made before taking the lock, since
+	// allocating takes it too; go round again if more showed up meanwhile
+	while (true) {
+		Lock(blocksLock);
+		uint64_t count = liveBlockCount;
+		Unlock(blocksLock);
+
+		snapshot.Blocks.clear();
+		snapshot.Blocks.reserve((size_t)(count + count / 8 + 64));
+
+		Lock(blocksLock);
+		if (liveBlockCount > snapshot.Blocks.capacity()) {
+			Unlock(blocksLock);
+			continue;
+		}
+		for (BlockHeader* header = liveBlocks.Next; header != &liveBlocks; header = header->Next) {
+			HeapBlock block;
+			block.Tag = tagNames[header->Info & ((1 << BLOCK_TAG_BITS) - 1)];
+			block.Size = header->Size;
+			block.Sequence = header->Info >> BLOCK_TAG_BITS;
+			snapshot.Blocks.push_back(block);
+		}
+		snapshot.Sequence = sequence;
+		Unlock(blocksLock);
+		return;
+	}
+}
+
+void AllocationTracker::PrintSnapshotDiff(const HeapSnapshot& before, const HeapSnapshot& after)
+{
+#ifdef ALLOCATION_TRACKING_DISABLED
+	printf("Heap: not tracked in this build\n");
+	return;
+#endif
+	struct Group
+	{
+		const char* Tag;
+		size_t Size;
+		uint64_t Count;
+	};
+	std::vector<Group> groups;
+	for (size_t i = 0; i < after.Blocks.size(); i++) {
+		const HeapBlock& block = after.Blocks[i];
+		if (block.Sequence < before.Sequence) {
+			continue;
+		}
+		size_t g = 0;
+		while (g < groups.size() && (groups[g].Tag != block.Tag || groups[g].Size != block.Size)) {
+			g++;
+		}
+		if (g == groups.size()) {
+			groups.push_back({ block.Tag, block.Size, 0 });
+		}
+		groups[g].Count++;
+	}
+	std::sort(groups.begin(), groups.end(), [](const Group& a, const Group& b) {
+		return a.Size * a.Count > b.Size * b.Count;
+	});
+
+	uint64_t blocks = 0;
+	uint64_t bytes = 0;
+	for (size_t g = 0; g < groups.size(); g++) {
+		blocks += groups[g].Count;
+		bytes += groups[g].Size * groups[g].Count;
+	}
+	printf("Heap: %llu blocks (%llu bytes) allocated between the snapshots are still live\n",
+		(unsigned long long)blocks, (unsigned long long)bytes);
+	for (size_t g = 0; g < groups.size(); g++) {
+		printf("  %-24s %8llu x %8llu bytes\n", groups[g].Tag, (unsigned long long)groups[g].Count, (unsigned long long)groups[g].Size);
+	}
+}
+
+AllocationScope::AllocationScope(unsigned int tag)
+{
+	previous = currentTag;
+	currentTag = tag;
+}
+
+AllocationScope::~AllocationScope()
+{
+	currentTag = previous;
+}
+
+#ifndef ALLOCATION_TRACKING_DISABLED
+// --------------------------------------------------------
+// The process-wide replacements.  Defining these anywhere
+// in the program is enough for every new and delete to
+// come here instead of the runtime's.
+// --------------------------------------------------------
+void* operator new(size_t size)
+{
+	void* memory = Allocate(size);
+	if (!memory) {
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return Allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return Allocate(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+	Free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	Free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	Free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+	Free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+	Free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+	Free(memory);
+}
+
+// Over-aligned types (alignas above 16) come here from C++17 on; they're freed the same way as any other block
+#ifdef __cpp_aligned_new
+void* operator new(size_t size, std::align_val_t alignment)
+{
+	void* memory = Allocate(size, (size_t)alignment);
+	if (!memory) {
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+	return operator new(size, alignment);
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return Allocate(size, (size_t)alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return Allocate(size, (size_t)alignment);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept
+{
+	Free(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t) noexcept
+{
+	Free(memory);
+}
+
+void operator delete(void* memory, size_t, std::align_val_t) noexcept
+{
+	Free(memory);
+}
+
+void operator delete[](void* memory, size_t, std::align_val_t) noexcept
+{
+	Free(memory);
+}
+
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept
+{
+	Free(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t, const std::nothrow_t&) noexcept
+{
+	Free(memory);
+}
+#endif
+#endif
@@ -0,0 +1,119 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// Tags that can be told apart; any more are counted as untagged
+#define ALLOCATION_TAGS 64
+// Steady-state frames that allocate are reported in full up to this many times
+#define ALLOCATION_REPORTED_FRAMES 8
+
+// --------------------------------------------------------
+// Scoped tags.  ALLOC_TAG("name") charges every allocation
+// the thread makes for the rest of the enclosing block to
+// that name (frees are charged to whichever tag allocated
+// the block).  Tags nest; the innermost wins.  Names must
+// be string literals, only the pointer is kept.
+//
+// Tracking is only compiled into Debug builds, since it
+// puts a lock on every new and delete.  Defining
+// ALLOCATION_TRACKING_ENABLED keeps it in Release too (to
+// check that an optimized frame doesn't allocate), and
+// defining ALLOCATION_TRACKING_DISABLED drops it from Debug.
+// Without it the tags compile to nothing, the global new
+// and delete are left alone and there is nothing to report.
+// --------------------------------------------------------
+#if !defined(_DEBUG) && !defined(ALLOCATION_TRACKING_ENABLED) && !defined(ALLOCATION_TRACKING_DISABLED)
+#define ALLOCATION_TRACKING_DISABLED
+#endif
+
+#define ALLOC_TAG_CONCAT_INNER(a, b) a##b
+#define ALLOC_TAG_CONCAT(a, b) ALLOC_TAG_CONCAT_INNER(a, b)
+#ifdef ALLOCATION_TRACKING_DISABLED
+#define ALLOC_TAG(name)
+#else
+#define ALLOC_TAG(name) \
+	static const unsigned int ALLOC_TAG_CONCAT(allocTag, __LINE__) = AllocationTracker::GetTag(name); \
+	AllocationScope ALLOC_TAG_CONCAT(allocScope, __LINE__)(ALLOC_TAG_CONCAT(allocTag, __LINE__))
+#endif
+
+// One tag's allocations, over a frame or since the start
+struct AllocationTagStats
+{
+	const char* Name;
+	uint64_t Allocations;
+	uint64_t Frees;
+	uint64_t Bytes;				// Allocated, whether or not they've been freed since
+	int64_t LiveAllocations;	// Since the start, whatever the stats cover
+	int64_t LiveBytes;
+};
+
+// A block that was still allocated when a snapshot was taken
+struct HeapBlock
+{
+	const char* Tag;
+	size_t Size;
+	uint64_t Sequence;			// Allocations made before it, process-wide
+};
+
+struct HeapSnapshot
+{
+	uint64_t Sequence;			// Allocations made before the snapshot
+	std::vector<HeapBlock> Blocks;
+};
+
+// --------------------------------------------------------
+// Counts every global new and delete in the process, by
+// tag and by frame.
+//
+// Each block carries a small header with its size, tag and
+// sequence number, and is linked into a list of live
+// blocks under a spin lock, so a snapshot can list what's
+// allocated at any point.  Diffing two snapshots shows
+// what was allocated in between and never freed, grouped
+// by tag and size.  The lock is taken on every new and
+// delete, which is fine for a frame that (ideally) doesn't
+// allocate, not for a hot allocator.
+//
+// BeginFrame closes the frame before it (call it from one
+// thread, once per frame).  With ExpectNoAllocations on,
+// a frame that allocated anything at all is reported.
+// --------------------------------------------------------
+class AllocationTracker
+{
+public:
+	//the same name always gets the same tag; 0 is "Untagged"
+	static unsigned int GetTag(const char* name);
+
+	static void BeginFrame();
+	static uint64_t GetFrameCount();
+	//tags that allocated or freed during the last complete frame
+	static void GetFrameStats(std::vector<AllocationTagStats>& stats);
+	//every tag that ever allocated
+	static void GetTotals(std::vector<AllocationTagStats>& stats);
+	static void PrintFrame();
+	static void PrintTotals();
+
+	//steady-state frames shouldn't allocate; count (and print) the ones that do
+	static void ExpectNoAllocations(bool expect);
+	static uint64_t GetUnexpectedFrames();	//frames that allocated while expected not to
+	static uint64_t GetExpectedFrames();	//frames closed while expected not to allocate
+
+	static void TakeSnapshot(HeapSnapshot& snapshot);
+	//blocks in after that were allocated since before was taken, by tag and size, biggest first
+	static void PrintSnapshotDiff(const HeapSnapshot& before, const HeapSnapshot& after);
+};
+
+// --------------------------------------------------------
+// Sets the thread's tag for its own lifetime; see ALLOC_TAG
+// --------------------------------------------------------
+class AllocationScope
+{
+private:
+	unsigned int previous;
+public:
+	AllocationScope(unsigned int tag);
+	~AllocationScope();
+	AllocationScope(const AllocationScope&) = delete;
+	void operator=(const AllocationScope&) = delete;
+};
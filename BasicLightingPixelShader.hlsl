@@ -4,7 +4,8 @@
 cbuffer externalData : register(b0) {
 	float4 color;
 	float3 cameraPosition;
-	Light lights[5];
+	int lightCount;
+	Light lights[32];	// MAX_LIGHTS
 }
 
 Texture2D Albedo : register(t0);
@@ -46,7 +47,7 @@ float4 main(VertexToPixel input) : SV_TARGET
 	info.alpha = 1;
 
 	float3 pixelColor = 0;
-	for (int i = 0; i < 5; i++) {
+	for (int i = 0; i < lightCount; i++) {
 		pixelColor += calculateTotalLighting(lights[i], info);
 
 	}
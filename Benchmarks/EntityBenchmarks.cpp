@@ -0,0 +1,104 @@
+#include <memory>
+#include <thread>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "EntityWorld.h"
+#include "JobSystem.h"
+#include "Transform.h"
+#include "TransformSystem.h"
+
+using namespace DirectX;
+
+#define ENTITY_BENCHMARK_MIN_ROWS_PER_JOB 4096
+
+// range(0) entities in a 1000 unit square, in two archetypes as the scene loader makes them
+static void FillWorld(EntityWorld& world, unsigned int count)
+{
+	for (unsigned int i = 0; i < count; i++) {
+		unsigned int mask = COMPONENT_TRANSFORM | COMPONENT_RENDERABLE | COMPONENT_BOUNDS;
+		EntityHandle entity = world.Create(i % 4 == 0 ? mask | COMPONENT_STATIC : mask);
+		TransformComponent* transform = world.GetTransform(entity);
+		transform->Position = XMFLOAT3((float)(i % 1000), 0, (float)(i / 1000));
+		transform->Rotation = XMFLOAT3(0, 0.001f * i, 0);
+	}
+}
+
+// --------------------------------------------------------
+// Reading every entity's position, the way a system walks
+// the dense arrays.  BM_EntityIterateSharedPtr does the same
+// over a vector<shared_ptr<Transform>>, the layout Game had
+// before the entity world.  range(0) entities.
+// --------------------------------------------------------
+static void BM_EntityIterate(benchmark::State& state)
+{
+	EntityWorld world;
+	FillWorld(world, (unsigned int)state.range(0));
+	for (auto _ : state) {
+		float sum = 0;
+		world.ForEach(COMPONENT_TRANSFORM, 0, [&sum](Archetype& archetype, unsigned int first, unsigned int last) {
+			for (unsigned int i = first; i < last; i++) {
+				sum += archetype.Transforms[i].Position.x;
+			}
+		});
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_EntityIterate)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+static void BM_EntityIterateSharedPtr(benchmark::State& state)
+{
+	std::vector<std::shared_ptr<Transform>> transforms;
+	for (int i = 0; i < state.range(0); i++) {
+		transforms.push_back(std::make_shared<Transform>((float)(i % 1000), 0, (float)(i / 1000), 0, 0.001f * i, 0, 1, 1, 1));
+	}
+	for (auto _ : state) {
+		float sum = 0;
+		for (size_t i = 0; i < transforms.size(); i++) {
+			sum += transforms[i]->GetPosition().x;
+		}
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_EntityIterateSharedPtr)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+// --------------------------------------------------------
+// Every dynamic entity moves each frame, then the transform
+// system rebuilds their world matrices, on range(1) threads
+// in all: one, inline, or every hardware thread.  The
+// static quarter is skipped, as in the game.  The meshes
+// would need a device, so there are none and the bounds
+// aren't recomputed.
+// --------------------------------------------------------
+static void BM_TransformSystemUpdate(benchmark::State& state)
+{
+	EntityWorld world;
+	FillWorld(world, (unsigned int)state.range(0));
+	unsigned int threads = (unsigned int)state.range(1);
+	JobSystem* jobs = threads > 1 ? new JobSystem(threads - 1) : nullptr;
+	TransformSystem system(ENTITY_BENCHMARK_MIN_ROWS_PER_JOB);
+	system.SetJobSystem(jobs);
+	system.Update(world, true);
+	for (auto _ : state) {
+		world.ForEach(COMPONENT_TRANSFORM, COMPONENT_STATIC, [](Archetype& archetype, unsigned int first, unsigned int last) {
+			for (unsigned int i = first; i < last; i++) {
+				archetype.Transforms[i].Position.y += 0.01f;
+				archetype.Transforms[i].Dirty = true;
+			}
+		}, jobs, ENTITY_BENCHMARK_MIN_ROWS_PER_JOB);
+		system.Update(world);
+	}
+	state.SetItemsProcessed(state.iterations() * system.GetStats().Updated);
+	delete jobs;
+}
+
+static void EntityThreadCounts(benchmark::internal::Benchmark* benchmark)
+{
+	int hardwareThreads = (int)std::thread::hardware_concurrency();
+	benchmark->Args({ 1000000, 1 });
+	if (hardwareThreads > 1) {
+		benchmark->Args({ 1000000, hardwareThreads });
+	}
+}
+BENCHMARK(BM_TransformSystemUpdate)->Apply(EntityThreadCounts)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,45 @@
+#include <stdint.h>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "FrameArena.h"
+
+// --------------------------------------------------------
+// A frame's worth of scratch vectors: range(0) of them,
+// 16-1023 elements each, reserved, filled, read once and
+// thrown away, as the culling and batching passes do.
+// With std::vector every one is a trip to the heap and
+// back; with FrameVector it's a bump of the arena, and
+// BeginFrame throws them all away at once.  The sizes are
+// the same every frame and every run.
+// --------------------------------------------------------
+template <typename Vector>
+static void BM_ScratchVectors(benchmark::State& state)
+{
+	const unsigned int count = (unsigned int)state.range(0);
+	std::vector<uint32_t> sizes(count);
+	uint32_t random = 777;
+	for (unsigned int i = 0; i < count; i++) {
+		random = random * 1664525 + 1013904223;
+		sizes[i] = 16 + (random >> 8) % 1008;
+	}
+
+	FrameArena::Initialize();
+	uint64_t elements = 0;
+	for (auto _ : state) {
+		FrameArena::BeginFrame();
+		for (unsigned int i = 0; i < count; i++) {
+			Vector scratch;
+			scratch.reserve(sizes[i]);
+			for (uint32_t e = 0; e < sizes[i]; e++) {
+				scratch.push_back(e);
+			}
+			benchmark::DoNotOptimize(scratch.data());
+			elements += sizes[i];
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * count);
+	state.counters["Elements"] = benchmark::Counter((double)elements, benchmark::Counter::kIsRate);
+	state.counters["Overflows"] = (double)FrameArena::GetStats().Overflows;
+}
+BENCHMARK_TEMPLATE(BM_ScratchVectors, std::vector<uint32_t>)->Arg(1000);
+BENCHMARK_TEMPLATE(BM_ScratchVectors, FrameVector<uint32_t>)->Arg(1000);
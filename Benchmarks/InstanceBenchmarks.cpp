@@ -0,0 +1,84 @@
+#include <stdint.h>
+#include <memory>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "InstanceBatcher.h"
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Counts what a D3D11 target would turn into draw calls
+// and instance buffer bytes, without a device
+// --------------------------------------------------------
+class CountingTarget : public IInstanceDrawTarget
+{
+public:
+	unsigned int Draws = 0;
+	unsigned int UploadedBytes = 0;
+
+	void UploadInstances(const InstanceData* instances, unsigned int count)
+	{
+		benchmark::DoNotOptimize(instances);
+		UploadedBytes = count * sizeof(InstanceData);
+	}
+
+	void DrawBatch(const InstanceBatch& batch)
+	{
+		benchmark::DoNotOptimize(batch.FirstInstance);
+		Draws++;
+	}
+};
+
+// --------------------------------------------------------
+// range(0) spheres of one mesh over eight tinted materials,
+// scattered in a 200 unit cube.  With instanced set the
+// materials share instanced shaders, so the whole lot is a
+// single draw; without, every sphere is its own batch, which
+// is what the renderer falls back to per object.  The
+// meshes and shaders are never created: the batcher only
+// compares pointers.
+// --------------------------------------------------------
+static void BM_InstanceSubmit(benchmark::State& state, bool instanced)
+{
+	const unsigned int count = (unsigned int)state.range(0);
+	int meshStorage = 0;
+	Mesh* sphere = reinterpret_cast<Mesh*>(&meshStorage);
+	std::shared_ptr<SimpleVertexShader> vertexShader = std::make_shared<SimpleVertexShader>(nullptr, nullptr, L"InstancedVertexShader.cso");
+	std::shared_ptr<SimplePixelShader> pixelShader = std::make_shared<SimplePixelShader>(nullptr, nullptr, L"InstancedPixelShader.cso");
+	std::vector<std::unique_ptr<Material>> materials;
+	for (int m = 0; m < 8; m++) {
+		materials.emplace_back(new Material(XMFLOAT4(m / 8.0f, 1, 1, 1), vertexShader, pixelShader));
+		if (instanced) {
+			materials.back()->SetInstancedShaders(vertexShader, pixelShader);
+		}
+	}
+
+	std::vector<RenderObject> objects(count);
+	std::vector<const RenderObject*> pointers(count);
+	uint32_t random = 4242;
+	for (unsigned int i = 0; i < count; i++) {
+		float coordinates[3];
+		for (int c = 0; c < 3; c++) {
+			random = random * 1664525 + 1013904223;
+			coordinates[c] = (random >> 8) * (200.0f / 16777216.0f) - 100.0f;
+		}
+		objects[i].RenderMesh = sphere;
+		objects[i].RenderMaterial = materials[i % materials.size()].get();
+		objects[i].Position = XMFLOAT3(coordinates[0], coordinates[1], coordinates[2]);
+		XMStoreFloat4x4(&objects[i].World, XMMatrixTranslation(coordinates[0], coordinates[1], coordinates[2]));
+		pointers[i] = &objects[i];
+	}
+
+	InstanceBatcher batcher;
+	CountingTarget target;
+	for (auto _ : state) {
+		target.Draws = 0;
+		batcher.Build(pointers.data(), count, false);
+		batcher.Submit(target);
+	}
+	state.SetItemsProcessed(state.iterations() * count);
+	state.counters["Draws"] = (double)target.Draws;
+	state.counters["UploadedBytes"] = (double)target.UploadedBytes;
+}
+BENCHMARK_CAPTURE(BM_InstanceSubmit, instanced, true)->Arg(10000);
+BENCHMARK_CAPTURE(BM_InstanceSubmit, perObject, false)->Arg(10000);
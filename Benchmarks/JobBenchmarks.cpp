@@ -0,0 +1,56 @@
+#include <thread>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "JobSystem.h"
+#include "Transform.h"
+
+using namespace DirectX;
+
+#define JOB_BENCHMARK_TRANSFORMS 65536
+#define JOB_BENCHMARK_MIN_PER_JOB 256
+
+// --------------------------------------------------------
+// How ParallelFor scales: world matrices for a big run of
+// transforms, on range(0) threads in all.  One thread runs
+// the loop inline (the job system always has at least one
+// worker), as the baseline the others are measured against.
+// --------------------------------------------------------
+static void BM_ParallelForWorldMatrices(benchmark::State& state)
+{
+	unsigned int threads = (unsigned int)state.range(0);
+	std::vector<Transform> transforms;
+	for (int i = 0; i < JOB_BENCHMARK_TRANSFORMS; i++) {
+		transforms.push_back(Transform((float)i, 0, 0, 0.1f * i, 0.2f * i, 0, 1, 1, 1));
+	}
+	std::vector<XMFLOAT4X4> worlds(transforms.size());
+	auto body = [&](unsigned int first, unsigned int last) {
+		for (unsigned int i = first; i < last; i++) {
+			worlds[i] = transforms[i].GetWorldMatrix();
+		}
+	};
+
+	JobSystem* jobs = threads > 1 ? new JobSystem(threads - 1) : nullptr;
+	for (auto _ : state) {
+		if (jobs) {
+			jobs->ParallelFor((unsigned int)transforms.size(), JOB_BENCHMARK_MIN_PER_JOB, body);
+		}
+		else {
+			body(0, (unsigned int)transforms.size());
+		}
+		benchmark::ClobberMemory();
+	}
+	delete jobs;
+	state.SetItemsProcessed(state.iterations() * transforms.size());
+}
+
+// 1, 2, 4, ... up to and including every hardware thread
+static void ThreadCounts(benchmark::internal::Benchmark* benchmark)
+{
+	int hardwareThreads = (int)std::thread::hardware_concurrency();
+	hardwareThreads = hardwareThreads > 0 ? hardwareThreads : 1;
+	for (int threads = 1; threads < hardwareThreads; threads *= 2) {
+		benchmark->Arg(threads);
+	}
+	benchmark->Arg(hardwareThreads);
+}
+BENCHMARK(BM_ParallelForWorldMatrices)->Apply(ThreadCounts)->UseRealTime();
@@ -0,0 +1,79 @@
+#include <math.h>
+#include <memory>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "Camera.h"
+#include "CameraPath.h"
+#include "Transform.h"
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// World matrices for a run of transforms, as the transform
+// system rebuilds them each frame.  range(0) transforms.
+// --------------------------------------------------------
+static void BM_TransformGetWorldMatrix(benchmark::State& state)
+{
+	std::vector<Transform> transforms;
+	for (int i = 0; i < state.range(0); i++) {
+		transforms.push_back(Transform((float)i, 0, (float)-i, 0.1f * i, 0.2f * i, 0, 1, 1 + 0.001f * i, 1));
+	}
+	for (auto _ : state) {
+		for (size_t i = 0; i < transforms.size(); i++) {
+			XMFLOAT4X4 world = transforms[i].GetWorldMatrix();
+			benchmark::DoNotOptimize(world);
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_TransformGetWorldMatrix)->Arg(1)->Arg(1024)->Arg(16384);
+
+static void BM_TransformMoveAndGetWorldMatrix(benchmark::State& state)
+{
+	Transform transform(0, 1, -5, 0.2f, 0.4f, 0, 1, 1, 1);
+	for (auto _ : state) {
+		transform.Move(0, 0, 0.01f);
+		transform.Turn(0, 0.001f, 0);
+		XMFLOAT4X4 world = transform.GetWorldMatrix();
+		benchmark::DoNotOptimize(world);
+	}
+}
+BENCHMARK(BM_TransformMoveAndGetWorldMatrix);
+
+static void BM_CameraUpdateViewMatrix(benchmark::State& state)
+{
+	Camera camera(0, 1, -8, 16.0f / 9.0f);
+	for (auto _ : state) {
+		camera.UpdateViewMatrix();
+		XMFLOAT4X4 view = camera.GetViewMatrix();
+		benchmark::DoNotOptimize(view);
+	}
+}
+BENCHMARK(BM_CameraUpdateViewMatrix);
+
+// --------------------------------------------------------
+// A flythrough frame: evaluating the spline, moving the
+// camera and rebuilding its view matrix
+// --------------------------------------------------------
+static void BM_CameraFollowPath(benchmark::State& state)
+{
+	std::shared_ptr<CameraPath> path = std::make_shared<CameraPath>();
+	for (int k = 0; k < 9; k++) {
+		CameraKey key;
+		key.Time = k * 2.5f;
+		key.Position = XMFLOAT3(10 * cosf(k * XM_PIDIV4), 2, 10 * sinf(k * XM_PIDIV4));
+		key.Rotation = XMFLOAT3(0.2f, -k * XM_PIDIV4, 0);
+		path->AddKey(key);
+	}
+	Camera camera(0, 0, 0, 16.0f / 9.0f);
+	camera.SetPath(path);
+	for (auto _ : state) {
+		camera.Update(1.0f / 60.0f);
+		if (camera.IsPathFinished()) {
+			camera.SetPath(path);
+		}
+		XMFLOAT4X4 view = camera.GetViewMatrix();
+		benchmark::DoNotOptimize(view);
+	}
+}
+BENCHMARK(BM_CameraFollowPath);
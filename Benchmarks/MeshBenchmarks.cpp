@@ -0,0 +1,136 @@
+#include <string>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "DynamicBatcher.h"
+#include "MeshData.h"
+
+using namespace DirectX;
+
+// Set by the build to the repository's Assets/Models
+#ifndef MODEL_DIRECTORY
+#define MODEL_DIRECTORY "../Assets/Models/"
+#endif
+
+// --------------------------------------------------------
+// Reading an OBJ file, from opening it to the last index,
+// as Mesh does before creating its buffers
+// --------------------------------------------------------
+static void BM_LoadObj(benchmark::State& state, const char* model)
+{
+	std::string fileName = std::string(MODEL_DIRECTORY) + model;
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+	if (!MeshData::LoadObj(fileName.c_str(), vertices, indices)) {
+		state.SkipWithError(("Can't open " + fileName).c_str());
+		return;
+	}
+	for (auto _ : state) {
+		MeshData::LoadObj(fileName.c_str(), vertices, indices);
+		benchmark::DoNotOptimize(vertices.data());
+	}
+	state.SetItemsProcessed(state.iterations() * vertices.size());
+}
+BENCHMARK_CAPTURE(BM_LoadObj, cube, "cube.obj");
+BENCHMARK_CAPTURE(BM_LoadObj, sphere, "sphere.obj");
+BENCHMARK_CAPTURE(BM_LoadObj, helix, "helix.obj");
+
+static void BM_CalculateTangents(benchmark::State& state, const char* model)
+{
+	std::string fileName = std::string(MODEL_DIRECTORY) + model;
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+	if (!MeshData::LoadObj(fileName.c_str(), vertices, indices)) {
+		state.SkipWithError(("Can't open " + fileName).c_str());
+		return;
+	}
+	for (auto _ : state) {
+		MeshData::CalculateTangents(vertices.data(), (int)vertices.size(), indices.data(), (int)indices.size());
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * vertices.size());
+}
+BENCHMARK_CAPTURE(BM_CalculateTangents, sphere, "sphere.obj");
+BENCHMARK_CAPTURE(BM_CalculateTangents, helix, "helix.obj");
+
+// --------------------------------------------------------
+// The dynamic batcher's merge kernel: range(0) copies of a
+// mesh, each with its own world matrix, written one after
+// the other as a batch is.  BM_MergeMeshScalar does the
+// same a vertex at a time, for comparison with the stream
+// transforms MergeMesh uses.
+// --------------------------------------------------------
+static bool LoadMergeInput(benchmark::State& state, const char* model, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices,
+	std::vector<XMFLOAT4X4>& worlds)
+{
+	std::string fileName = std::string(MODEL_DIRECTORY) + model;
+	if (!MeshData::LoadObj(fileName.c_str(), vertices, indices)) {
+		state.SkipWithError(("Can't open " + fileName).c_str());
+		return false;
+	}
+	MeshData::CalculateTangents(vertices.data(), (int)vertices.size(), indices.data(), (int)indices.size());
+	worlds.resize((size_t)state.range(0));
+	for (size_t i = 0; i < worlds.size(); i++) {
+		XMMATRIX world = XMMatrixScaling(0.5f, 0.5f, 0.5f) * XMMatrixRotationRollPitchYaw(0, 0.01f * i, 0) * XMMatrixTranslation((float)(i % 32), 0, (float)(i / 32));
+		XMStoreFloat4x4(&worlds[i], world);
+	}
+	return true;
+}
+
+static void BM_MergeMesh(benchmark::State& state, const char* model)
+{
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+	std::vector<XMFLOAT4X4> worlds;
+	if (!LoadMergeInput(state, model, vertices, indices, worlds)) {
+		return;
+	}
+	unsigned int vertexCount = (unsigned int)vertices.size();
+	unsigned int indexCount = (unsigned int)indices.size();
+	std::vector<Vertex> outVertices(vertexCount * worlds.size());
+	std::vector<unsigned int> outIndices(indexCount * worlds.size());
+	for (auto _ : state) {
+		for (unsigned int i = 0; i < worlds.size(); i++) {
+			DynamicBatcher::MergeMesh(vertices.data(), vertexCount, indices.data(), indexCount, worlds[i],
+				i * vertexCount, &outVertices[i * vertexCount], &outIndices[i * indexCount]);
+		}
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * worlds.size() * vertexCount);
+	state.SetBytesProcessed(state.iterations() * (outVertices.size() * sizeof(Vertex) + outIndices.size() * sizeof(unsigned int)));
+}
+BENCHMARK_CAPTURE(BM_MergeMesh, cube, "cube.obj")->Arg(1024);
+BENCHMARK_CAPTURE(BM_MergeMesh, sphere, "sphere.obj")->Arg(64);
+
+static void BM_MergeMeshScalar(benchmark::State& state, const char* model)
+{
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+	std::vector<XMFLOAT4X4> worlds;
+	if (!LoadMergeInput(state, model, vertices, indices, worlds)) {
+		return;
+	}
+	unsigned int vertexCount = (unsigned int)vertices.size();
+	unsigned int indexCount = (unsigned int)indices.size();
+	std::vector<Vertex> outVertices(vertexCount * worlds.size());
+	std::vector<unsigned int> outIndices(indexCount * worlds.size());
+	for (auto _ : state) {
+		for (unsigned int i = 0; i < worlds.size(); i++) {
+			XMMATRIX world = XMLoadFloat4x4(&worlds[i]);
+			Vertex* out = &outVertices[i * vertexCount];
+			for (unsigned int v = 0; v < vertexCount; v++) {
+				out[v] = vertices[v];
+				XMStoreFloat3(&out[v].Position, XMVector3TransformCoord(XMLoadFloat3(&vertices[v].Position), world));
+				XMStoreFloat3(&out[v].Normal, XMVector3TransformNormal(XMLoadFloat3(&vertices[v].Normal), world));
+				XMStoreFloat3(&out[v].Tangent, XMVector3TransformNormal(XMLoadFloat3(&vertices[v].Tangent), world));
+			}
+			for (unsigned int n = 0; n < indexCount; n++) {
+				outIndices[i * indexCount + n] = indices[n] + i * vertexCount;
+			}
+		}
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * worlds.size() * vertexCount);
+	state.SetBytesProcessed(state.iterations() * (outVertices.size() * sizeof(Vertex) + outIndices.size() * sizeof(unsigned int)));
+}
+BENCHMARK_CAPTURE(BM_MergeMeshScalar, cube, "cube.obj")->Arg(1024);
+BENCHMARK_CAPTURE(BM_MergeMeshScalar, sphere, "sphere.obj")->Arg(64);
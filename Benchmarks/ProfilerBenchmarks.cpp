@@ -0,0 +1,35 @@
+#include <benchmark/benchmark.h>
+#include "Profiler.h"
+
+// --------------------------------------------------------
+// What one PROFILE_SCOPE costs: opening and closing it,
+// with the event written to the thread's ring.  The
+// target is under 50 ns a scope.  Run on range(0)
+// threads at once, as job workers profile alongside the
+// main thread; each has a ring of its own, so the time per
+// scope shouldn't grow with the thread count.
+// --------------------------------------------------------
+static void BM_ProfileScope(benchmark::State& state)
+{
+	for (auto _ : state) {
+		PROFILE_SCOPE("BM_ProfileScope");
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ProfileScope)->Threads(1)->Threads(4);
+
+// One scope around range(0) - 1 short ones, as a system's scope wraps the scopes in its loop
+static void BM_ProfileScopeNested(benchmark::State& state)
+{
+	const int depth = (int)state.range(0);
+	for (auto _ : state) {
+		PROFILE_SCOPE("Outer");
+		for (int d = 1; d < depth; d++) {
+			PROFILE_SCOPE("Inner");
+			benchmark::ClobberMemory();
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * depth);
+}
+BENCHMARK(BM_ProfileScopeNested)->Arg(8);
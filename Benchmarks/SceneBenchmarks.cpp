@@ -0,0 +1,71 @@
+#include <stdio.h>
+#include <string>
+#include <benchmark/benchmark.h>
+#include "SceneFile.h"
+#include "StressScene.h"
+
+// A stress scene of range(0) shapes, cooked to a binary file in the working directory
+static bool CookStressScene(benchmark::State& state, std::string& fileName)
+{
+	StressSceneDesc desc;
+	desc.Spheres = (unsigned int)state.range(0) / 3;
+	desc.Cubes = (unsigned int)state.range(0) / 3;
+	desc.Tori = (unsigned int)state.range(0) - desc.Spheres - desc.Cubes;
+	desc.StaticFraction = 0.5f;
+	SceneData scene;
+	StressScene::Generate(desc, scene);
+	fileName = StressScene::GetName(desc) + ".sceneb";
+	if (!SceneFile::SaveBinary(fileName.c_str(), scene)) {
+		state.SkipWithError(("Can't write " + fileName).c_str());
+		return false;
+	}
+	return true;
+}
+
+// --------------------------------------------------------
+// Loading a binary scene of range(0) entities: mapping it
+// and fixing up its offsets, which is all Game::LoadScene
+// needs, then with every entity and light copied back out
+// by ToSceneData as well.  The file stays in the OS's
+// cache between iterations, as it would when a level is
+// reloaded; a cold first load also waits on the disk.
+// --------------------------------------------------------
+static void BM_SceneOpen(benchmark::State& state)
+{
+	std::string fileName;
+	if (!CookStressScene(state, fileName)) {
+		return;
+	}
+	for (auto _ : state) {
+		MappedScene mapped;
+		if (!mapped.Open(fileName.c_str())) {
+			state.SkipWithError(("Can't open " + fileName).c_str());
+			break;
+		}
+		benchmark::DoNotOptimize(mapped.GetEntities());
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+	remove(fileName.c_str());
+}
+BENCHMARK(BM_SceneOpen)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+static void BM_SceneOpenToSceneData(benchmark::State& state)
+{
+	std::string fileName;
+	if (!CookStressScene(state, fileName)) {
+		return;
+	}
+	for (auto _ : state) {
+		MappedScene mapped;
+		if (!mapped.Open(fileName.c_str())) {
+			state.SkipWithError(("Can't open " + fileName).c_str());
+			break;
+		}
+		SceneData scene;
+		mapped.ToSceneData(scene);
+		benchmark::DoNotOptimize(scene.Entities.data());
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+	remove(fileName.c_str());
+}
+BENCHMARK(BM_SceneOpenToSceneData)->Arg(100000)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,127 @@
+#include <memory>
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <benchmark/benchmark.h>
+#include "ShaderConstants.h"
+#include "SimpleShader.h"
+
+using namespace DirectX;
+
+// Set by the build to the VertexShader.cso it compiles
+#ifndef SHADER_FILE
+#define SHADER_FILE L"VertexShader.cso"
+#endif
+
+// --------------------------------------------------------
+// The vertex shader every entity draws with, on a WARP
+// device so no GPU is needed.  Only the reflected variable
+// tables and local buffers are exercised, never the device,
+// apart from loading.  Null if it couldn't be loaded.
+// --------------------------------------------------------
+static std::shared_ptr<SimpleVertexShader> GetShader()
+{
+	static std::shared_ptr<SimpleVertexShader> shader;
+	static bool loaded = false;
+	if (!loaded) {
+		loaded = true;
+		Microsoft::WRL::ComPtr<ID3D11Device> device;
+		Microsoft::WRL::ComPtr<ID3D11DeviceContext> context;
+		HRESULT result = D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_WARP, nullptr, 0, nullptr, 0, D3D11_SDK_VERSION, device.GetAddressOf(), nullptr, context.GetAddressOf());
+		if (SUCCEEDED(result)) {
+			shader = std::make_shared<SimpleVertexShader>(device, context, SHADER_FILE);
+		}
+		if (shader && !shader->IsShaderValid()) {
+			shader = nullptr;
+		}
+	}
+	return shader;
+}
+
+static XMFLOAT4X4 MakeMatrix()
+{
+	XMFLOAT4X4 matrix;
+	XMStoreFloat4x4(&matrix, XMMatrixTranslation(1, 2, 3));
+	return matrix;
+}
+
+static void BM_ShaderFindVariable(benchmark::State& state)
+{
+	std::shared_ptr<SimpleVertexShader> shader = GetShader();
+	if (!shader) {
+		state.SkipWithError("Can't load the vertex shader on a WARP device");
+		return;
+	}
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(shader->GetVariableInfo("projection"));
+	}
+}
+BENCHMARK(BM_ShaderFindVariable);
+
+static void BM_ShaderSetData(benchmark::State& state)
+{
+	std::shared_ptr<SimpleVertexShader> shader = GetShader();
+	if (!shader) {
+		state.SkipWithError("Can't load the vertex shader on a WARP device");
+		return;
+	}
+	XMFLOAT4X4 matrix = MakeMatrix();
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(shader->SetData("view", &matrix, sizeof(matrix)));
+	}
+}
+BENCHMARK(BM_ShaderSetData);
+
+static void BM_ShaderSetMatrix4x4(benchmark::State& state)
+{
+	std::shared_ptr<SimpleVertexShader> shader = GetShader();
+	if (!shader) {
+		state.SkipWithError("Can't load the vertex shader on a WARP device");
+		return;
+	}
+	XMFLOAT4X4 matrix = MakeMatrix();
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(shader->SetMatrix4x4("world", matrix));
+	}
+}
+BENCHMARK(BM_ShaderSetMatrix4x4);
+
+// --------------------------------------------------------
+// One entity's constants, set on the shader the way the
+// immediate path does it and on a ShaderConstants copy the
+// way recording jobs do
+// --------------------------------------------------------
+static void BM_ShaderSetEntityConstants(benchmark::State& state)
+{
+	std::shared_ptr<SimpleVertexShader> shader = GetShader();
+	if (!shader) {
+		state.SkipWithError("Can't load the vertex shader on a WARP device");
+		return;
+	}
+	XMFLOAT4X4 matrix = MakeMatrix();
+	for (auto _ : state) {
+		shader->SetMatrix4x4("world", matrix);
+		shader->SetMatrix4x4("worldInvTranspose", matrix);
+		shader->SetMatrix4x4("view", matrix);
+		shader->SetMatrix4x4("projection", matrix);
+	}
+}
+BENCHMARK(BM_ShaderSetEntityConstants);
+
+static void BM_ShaderConstantsSetEntityConstants(benchmark::State& state)
+{
+	std::shared_ptr<SimpleVertexShader> shader = GetShader();
+	if (!shader) {
+		state.SkipWithError("Can't load the vertex shader on a WARP device");
+		return;
+	}
+	ShaderConstants constants;
+	constants.Reset(shader.get());
+	XMFLOAT4X4 matrix = MakeMatrix();
+	for (auto _ : state) {
+		constants.SetMatrix4x4("world", matrix);
+		constants.SetMatrix4x4("worldInvTranspose", matrix);
+		constants.SetMatrix4x4("view", matrix);
+		constants.SetMatrix4x4("projection", matrix);
+	}
+}
+BENCHMARK(BM_ShaderConstantsSetEntityConstants);
@@ -0,0 +1,89 @@
+#include <stdint.h>
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "DepthSorter.h"
+#include "Transform.h"
+
+using namespace DirectX;
+
+// Scattered through a 200 unit cube, the same every run
+static std::vector<XMFLOAT3> MakePositions(unsigned int count)
+{
+	std::vector<XMFLOAT3> positions(count);
+	uint32_t state = 12345;
+	for (unsigned int i = 0; i < count; i++) {
+		float coordinates[3];
+		for (int c = 0; c < 3; c++) {
+			state = state * 1664525 + 1013904223;
+			coordinates[c] = (state >> 8) * (200.0f / 16777216.0f) - 100.0f;
+		}
+		positions[i] = XMFLOAT3(coordinates[0], coordinates[1], coordinates[2]);
+	}
+	return positions;
+}
+
+// --------------------------------------------------------
+// The transparent sort in steady state: the camera creeps
+// forward, so last frame's order is re-sorted by insertion.
+// range(0) transparent objects.
+// --------------------------------------------------------
+static void BM_DepthSortCoherent(benchmark::State& state)
+{
+	std::vector<XMFLOAT3> positions = MakePositions((unsigned int)state.range(0));
+	DepthSorter sorter;
+	XMFLOAT3 camera(0, 0, -150);
+	sorter.Sort(positions.data(), (unsigned int)positions.size(), camera);
+	for (auto _ : state) {
+		camera.z = camera.z < 150 ? camera.z + 0.01f : -150;
+		benchmark::DoNotOptimize(sorter.Sort(positions.data(), (unsigned int)positions.size(), camera).data());
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DepthSortCoherent)->Arg(10000);
+
+// --------------------------------------------------------
+// The camera cuts back and forth, so every sort is a full
+// radix sort
+// --------------------------------------------------------
+static void BM_DepthSortJump(benchmark::State& state)
+{
+	std::vector<XMFLOAT3> positions = MakePositions((unsigned int)state.range(0));
+	DepthSorter sorter;
+	XMFLOAT3 cameras[2] = { XMFLOAT3(0, 0, -150), XMFLOAT3(120, 40, 150) };
+	unsigned int frame = 0;
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(sorter.Sort(positions.data(), (unsigned int)positions.size(), cameras[frame++ % 2]).data());
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DepthSortJump)->Arg(10000);
+
+// --------------------------------------------------------
+// What Game::Update did before DepthSorter, for comparison:
+// std::sort over shared_ptrs passed by value, with two
+// square roots per comparison
+// --------------------------------------------------------
+static void BM_DepthSortSharedPtr(benchmark::State& state)
+{
+	std::vector<XMFLOAT3> positions = MakePositions((unsigned int)state.range(0));
+	std::vector<std::shared_ptr<Transform>> transforms;
+	for (unsigned int i = 0; i < positions.size(); i++) {
+		transforms.push_back(std::make_shared<Transform>(positions[i].x, positions[i].y, positions[i].z, 0, 0, 0, 1, 1, 1));
+	}
+	XMFLOAT3 camPos(0, 0, -150);
+	for (auto _ : state) {
+		camPos.z = camPos.z < 150 ? camPos.z + 0.01f : -150;
+		std::sort(transforms.begin(), transforms.end(), [&](std::shared_ptr<Transform> a, std::shared_ptr<Transform> b) -> bool {
+			XMFLOAT3 aPos = a->GetPosition();
+			XMFLOAT3 bPos = b->GetPosition();
+			float aDist = XMVectorGetX(XMVector3Length(XMLoadFloat3(&aPos) - XMLoadFloat3(&camPos)));
+			float bDist = XMVectorGetX(XMVector3Length(XMLoadFloat3(&bPos) - XMLoadFloat3(&camPos)));
+			return aDist > bDist;
+		});
+		benchmark::DoNotOptimize(transforms.data());
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DepthSortSharedPtr)->Arg(10000);
@@ -0,0 +1,238 @@
+#include <math.h>
+#include <stdint.h>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "Camera.h"
+#include "DynamicAABBTree.h"
+#include "Frustum.h"
+#include "LooseGrid.h"
+
+using namespace DirectX;
+
+// Boxes up to 3 units across scattered through a 1000 x 100 x 1000 world, the same every run
+static std::vector<AABB> MakeBounds(unsigned int count)
+{
+	std::vector<AABB> bounds(count);
+	uint32_t state = 4242;
+	for (unsigned int i = 0; i < count; i++) {
+		float values[4];
+		for (int v = 0; v < 4; v++) {
+			state = state * 1664525 + 1013904223;
+			values[v] = (state >> 8) / 16777216.0f;
+		}
+		bounds[i].Center = XMFLOAT3(values[0] * 1000 - 500, values[1] * 100 - 50, values[2] * 1000 - 500);
+		float extent = 0.5f + values[3];
+		bounds[i].Extents = XMFLOAT3(extent, extent, extent);
+	}
+	return bounds;
+}
+
+// At the middle of the world looking down +Z, so about a tenth of it is in view
+static Frustum MakeFrustum()
+{
+	Camera camera(Transform(0, 0, 0, 0, 0, 0, 1, 1, 1), 16.0f / 9.0f);
+	return Frustum(camera.GetViewMatrix(), camera.GetProjectionMatrix());
+}
+
+static bool SphereOverlaps(const XMFLOAT3& center, float radius, const AABB& box)
+{
+	float dx = fmaxf(fabsf(center.x - box.Center.x) - box.Extents.x, 0.0f);
+	float dy = fmaxf(fabsf(center.y - box.Center.y) - box.Extents.y, 0.0f);
+	float dz = fmaxf(fabsf(center.z - box.Center.z) - box.Extents.z, 0.0f);
+	return dx * dx + dy * dy + dz * dz <= radius * radius;
+}
+
+// --------------------------------------------------------
+// The coarse culling pass, done the way Game did before
+// there was a spatial index: every entity against the
+// frustum.  range(0) entities.
+// --------------------------------------------------------
+static void BM_FrustumQueryBruteForce(benchmark::State& state)
+{
+	std::vector<AABB> bounds = MakeBounds((unsigned int)state.range(0));
+	Frustum frustum = MakeFrustum();
+	std::vector<int> visible;
+	for (auto _ : state) {
+		visible.clear();
+		for (unsigned int i = 0; i < bounds.size(); i++) {
+			if (frustum.Intersects(bounds[i])) {
+				visible.push_back(i);
+			}
+		}
+		benchmark::DoNotOptimize(visible.data());
+	}
+	state.counters["Visible"] = (double)visible.size();
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FrustumQueryBruteForce)->Arg(1000)->Arg(10000)->Arg(100000);
+
+static void BM_FrustumQueryTree(benchmark::State& state)
+{
+	std::vector<AABB> bounds = MakeBounds((unsigned int)state.range(0));
+	Frustum frustum = MakeFrustum();
+	DynamicAABBTree tree;
+	for (unsigned int i = 0; i < bounds.size(); i++) {
+		tree.CreateProxy(bounds[i], nullptr);
+	}
+	std::vector<int> visible;
+	for (auto _ : state) {
+		visible.clear();
+		tree.QueryFrustum(frustum, visible);
+		benchmark::DoNotOptimize(visible.data());
+	}
+	state.counters["Visible"] = (double)visible.size();
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FrustumQueryTree)->Arg(1000)->Arg(10000)->Arg(100000);
+
+// --------------------------------------------------------
+// A gameplay query: everything within 20 units of a point
+// that wanders around the world
+// --------------------------------------------------------
+static void BM_SphereQueryBruteForce(benchmark::State& state)
+{
+	std::vector<AABB> bounds = MakeBounds((unsigned int)state.range(0));
+	std::vector<int> hits;
+	int frame = 0;
+	for (auto _ : state) {
+		XMFLOAT3 center(400 * sinf(frame * 0.01f), 0, 400 * cosf(frame * 0.013f));
+		frame++;
+		hits.clear();
+		for (unsigned int i = 0; i < bounds.size(); i++) {
+			if (SphereOverlaps(center, 20, bounds[i])) {
+				hits.push_back(i);
+			}
+		}
+		benchmark::DoNotOptimize(hits.data());
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SphereQueryBruteForce)->Arg(1000)->Arg(10000)->Arg(100000);
+
+static void BM_SphereQueryTree(benchmark::State& state)
+{
+	std::vector<AABB> bounds = MakeBounds((unsigned int)state.range(0));
+	DynamicAABBTree tree;
+	for (unsigned int i = 0; i < bounds.size(); i++) {
+		tree.CreateProxy(bounds[i], nullptr);
+	}
+	std::vector<int> hits;
+	int frame = 0;
+	for (auto _ : state) {
+		XMFLOAT3 center(400 * sinf(frame * 0.01f), 0, 400 * cosf(frame * 0.013f));
+		frame++;
+		hits.clear();
+		tree.QuerySphere(center, 20, hits);
+		benchmark::DoNotOptimize(hits.data());
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SphereQueryTree)->Arg(1000)->Arg(10000)->Arg(100000);
+
+// --------------------------------------------------------
+// Keeping the tree up to date: every entity drifts a
+// little each frame, so some leave their fat boxes and are
+// reinserted.  The price the queries above pay for.
+// --------------------------------------------------------
+static void BM_TreeMoveProxies(benchmark::State& state)
+{
+	std::vector<AABB> bounds = MakeBounds((unsigned int)state.range(0));
+	DynamicAABBTree tree;
+	std::vector<int> proxies;
+	for (unsigned int i = 0; i < bounds.size(); i++) {
+		proxies.push_back(tree.CreateProxy(bounds[i], nullptr));
+	}
+	int frame = 0;
+	long long reinserted = 0;
+	for (auto _ : state) {
+		float step = 0.02f * sinf(frame * 0.05f);
+		frame++;
+		for (unsigned int i = 0; i < bounds.size(); i++) {
+			bounds[i].Center.x += (i & 1) ? step : -step;
+			bounds[i].Center.z += 0.01f;
+			reinserted += tree.MoveProxy(proxies[i], bounds[i]) ? 1 : 0;
+		}
+	}
+	state.counters["Reinserted"] = benchmark::Counter((double)reinserted, benchmark::Counter::kAvgIterations);
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_TreeMoveProxies)->Arg(1000)->Arg(10000)->Arg(100000);
+
+// --------------------------------------------------------
+// The loose grid's case: range(0) points that all move
+// every frame, then 16 gameplay sphere queries and the
+// frustum query.  The brute-force version just updates the
+// positions and tests everything.
+// --------------------------------------------------------
+static void MovePoints(std::vector<AABB>& points, int frame)
+{
+	float step = 0.5f * sinf(frame * 0.02f);
+	for (unsigned int i = 0; i < points.size(); i++) {
+		points[i].Center.x += (i & 1) ? step : -step;
+		points[i].Center.z += (i & 2) ? step : -step;
+	}
+}
+
+static std::vector<AABB> MakePoints(unsigned int count)
+{
+	std::vector<AABB> points = MakeBounds(count);
+	for (unsigned int i = 0; i < count; i++) {
+		points[i].Extents = XMFLOAT3(0.25f, 0.25f, 0.25f);
+	}
+	return points;
+}
+
+static void BM_MovingPointsBruteForce(benchmark::State& state)
+{
+	std::vector<AABB> points = MakePoints((unsigned int)state.range(0));
+	Frustum frustum = MakeFrustum();
+	std::vector<int> hits;
+	int frame = 0;
+	for (auto _ : state) {
+		MovePoints(points, frame++);
+		hits.clear();
+		for (int q = 0; q < 16; q++) {
+			XMFLOAT3 center(q * 50.0f - 400, 0, q * 30.0f - 200);
+			for (unsigned int i = 0; i < points.size(); i++) {
+				if (SphereOverlaps(center, 10, points[i])) {
+					hits.push_back(i);
+				}
+			}
+		}
+		for (unsigned int i = 0; i < points.size(); i++) {
+			if (frustum.Intersects(points[i])) {
+				hits.push_back(i);
+			}
+		}
+		benchmark::DoNotOptimize(hits.data());
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_MovingPointsBruteForce)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+static void BM_MovingPointsGrid(benchmark::State& state)
+{
+	std::vector<AABB> points = MakePoints((unsigned int)state.range(0));
+	Frustum frustum = MakeFrustum();
+	LooseGrid grid(16.0f);	// A few points to a cell at this density
+	std::vector<int> proxies;
+	for (unsigned int i = 0; i < points.size(); i++) {
+		proxies.push_back(grid.CreateProxy(points[i], nullptr));
+	}
+	std::vector<int> hits;
+	int frame = 0;
+	for (auto _ : state) {
+		MovePoints(points, frame++);
+		for (unsigned int i = 0; i < points.size(); i++) {
+			grid.MoveProxy(proxies[i], points[i]);
+		}
+		hits.clear();
+		for (int q = 0; q < 16; q++) {
+			grid.QuerySphere(XMFLOAT3(q * 50.0f - 400, 0, q * 30.0f - 200), 10, hits);
+		}
+		grid.QueryFrustum(frustum, hits);
+		benchmark::DoNotOptimize(hits.data());
+	}
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_MovingPointsGrid)->Arg(100000)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+"""Compares two benchmark runs and flags regressions.
+
+Takes either Google Benchmark JSON (EngineBenchmarks --benchmark_out=run.json
+--benchmark_out_format=json) or the frame stats CSV the game writes
+(frame_stats.csv, headless_frame_stats.csv).  Every measurement is a time, so
+lower is better; anything more than --threshold percent slower than the
+baseline is a regression.  Exits with 1 if there were any, 2 on bad input.
+
+With --benchmark_repetitions, the median of the repetitions is compared;
+otherwise the mean of whatever runs there are.  Benchmarks registered with
+UseRealTime are compared on wall-clock time, the rest on CPU time.
+"""
+
+import argparse
+import csv
+import json
+import sys
+
+NANOSECONDS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def load_json(path):
+    with open(path) as f:
+        data = json.load(f)
+    runs = {}
+    medians = {}
+    for run in data.get("benchmarks", []):
+        if run.get("error_occurred"):
+            continue
+        name = run.get("run_name", run["name"])
+        metric = "real_time" if name.endswith("/real_time") else "cpu_time"
+        value = run[metric] * NANOSECONDS[run.get("time_unit", "ns")]
+        if run.get("run_type") == "aggregate":
+            if run.get("aggregate_name") == "median":
+                medians[name] = value
+        else:
+            runs.setdefault(name, []).append(value)
+    results = {name: (sum(values) / len(values), "ns") for name, values in runs.items()}
+    results.update((name, (value, "ns")) for name, value in medians.items())
+    return results
+
+
+def load_csv(path):
+    results = {}
+    with open(path, newline="") as f:
+        for row in csv.DictReader(f):
+            if row["statistic"] == "frames":
+                continue
+            unit = "" if row["statistic"].startswith("hitches") else "ms"
+            results[row["phase"] + "/" + row["statistic"]] = (float(row["value"]), unit)
+    return results
+
+
+def load(path):
+    try:
+        return load_csv(path) if path.endswith(".csv") else load_json(path)
+    except (OSError, ValueError, KeyError) as error:
+        print("%s: %s" % (path, error), file=sys.stderr)
+        sys.exit(2)
+
+
+def format_value(value, unit):
+    if unit == "ns":
+        for suffix, scale in (("s", 1e9), ("ms", 1e6), ("us", 1e3)):
+            if value >= scale:
+                return "%.3f %s" % (value / scale, suffix)
+        return "%.1f ns" % value
+    if unit:
+        return "%.3f %s" % (value, unit)
+    return "%g" % value
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=5.0,
+                        help="percent slower than the baseline that counts as a regression (default 5)")
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    current = load(args.current)
+
+    regressions = 0
+    width = max([len(name) for name in baseline] + [len(name) for name in current] + [9])
+    print("%-*s %14s %14s %9s" % (width, "Benchmark", "Baseline", "Current", "Change"))
+    for name in sorted(set(baseline) | set(current)):
+        if name not in current:
+            print("%-*s %14s %14s %9s" % (width, name, format_value(*baseline[name]), "-", "missing"))
+            continue
+        if name not in baseline:
+            print("%-*s %14s %14s %9s" % (width, name, "-", format_value(*current[name]), "new"))
+            continue
+        before, unit = baseline[name]
+        after, _ = current[name]
+        if before > 0:
+            change = (after - before) / before * 100.0
+            change_text = "%+8.1f%%" % change
+        else:
+            change = float("inf") if after > 0 else 0.0
+            change_text = "%9s" % ("+inf" if after > 0 else "0")
+        flag = ""
+        if change > args.threshold:
+            flag = "  REGRESSION"
+            regressions += 1
+        elif change < -args.threshold:
+            flag = "  improved"
+        print("%-*s %14s %14s %s%s" % (width, name, format_value(before, unit), format_value(after, unit), change_text, flag))
+
+    if regressions:
+        print("\n%d regression%s over %.1f%%" % (regressions, "" if regressions == 1 else "s", args.threshold))
+        return 1
+    print("\nNo regressions over %.1f%%" % args.threshold)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,20 @@
+#include "Bounds.h"
+
+using namespace DirectX;
+
+AABB TransformBounds(const AABB& local, const XMFLOAT4X4& world)
+{
+	// The new center is the transformed center, and the new extents
+	// are the old extents pushed through the absolute value of the upper 3x3
+	XMMATRIX worldMat = XMLoadFloat4x4(&world);
+	XMVECTOR extents = XMLoadFloat3(&local.Extents);
+	XMVECTOR worldExtents =
+		XMVectorAbs(worldMat.r[0]) * XMVectorSplatX(extents) +
+		XMVectorAbs(worldMat.r[1]) * XMVectorSplatY(extents) +
+		XMVectorAbs(worldMat.r[2]) * XMVectorSplatZ(extents);
+
+	AABB bounds;
+	XMStoreFloat3(&bounds.Center, XMVector3TransformCoord(XMLoadFloat3(&local.Center), worldMat));
+	XMStoreFloat3(&bounds.Extents, worldExtents);
+	return bounds;
+}
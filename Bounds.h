@@ -0,0 +1,20 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+// --------------------------------------------------------
+// An axis-aligned bounding box, stored as a center point
+// and the half-size of the box along each axis
+// --------------------------------------------------------
+struct AABB
+{
+	DirectX::XMFLOAT3 Center;
+	DirectX::XMFLOAT3 Extents;
+};
+
+// --------------------------------------------------------
+// The world-space box around local, once it's been moved
+// by world (Arvo's method, so the result is tight for the
+// box but not for whatever's inside it)
+// --------------------------------------------------------
+AABB TransformBounds(const AABB& local, const DirectX::XMFLOAT4X4& world);
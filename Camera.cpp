@@ -17,7 +17,9 @@ Camera::Camera(Transform transform, float aspectRatio, float frustumRadians, flo
 	this->farPlane = farPlane;
 	this->movementSpeed = movementSpeed;
 	this->mouseLookSpeed = mouseLookSpeed;
-	XMStoreFloat4x4(&(this->viewMatrix), XMMatrixLookToLH(XMLoadFloat3(&(transform.GetPosition())), XMLoadFloat3(&(transform.GetForward())), XMLoadFloat3(&(transform.GetUp()))));
+	this->pathTime = 0;
+	this->pathStep = 0;
+	UpdateViewMatrix();
 	XMStoreFloat4x4(&(this->projectionMatrix), XMMatrixPerspectiveFovLH(frustumRadians, aspectRatio, nearPlane, farPlane));
 }
 
@@ -36,6 +38,11 @@ Transform Camera::GetTransform()
 	return transform;
 }
 
+Frustum Camera::GetFrustum()
+{
+	return Frustum(viewMatrix, projectionMatrix);
+}
+
 void Camera::UpdateProjectionMatrix(float aspectRatio)
 {
 	XMStoreFloat4x4(&(this->projectionMatrix), XMMatrixPerspectiveFovLH(frustumRadians, aspectRatio, nearPlane, farPlane));
@@ -43,11 +50,50 @@ void Camera::UpdateProjectionMatrix(float aspectRatio)
 
 void Camera::UpdateViewMatrix()
 {
-	XMStoreFloat4x4(&(this->viewMatrix), XMMatrixLookToLH(XMLoadFloat3(&(transform.GetPosition())), XMLoadFloat3(&(transform.GetForward())), XMLoadFloat3(&(transform.GetUp()))));
+	//copies, since taking the address of a returned value is an MSVC extension
+	XMFLOAT3 position = transform.GetPosition();
+	XMFLOAT3 forward = transform.GetForward();
+	XMFLOAT3 up = transform.GetUp();
+	XMStoreFloat4x4(&(this->viewMatrix), XMMatrixLookToLH(XMLoadFloat3(&position), XMLoadFloat3(&forward), XMLoadFloat3(&up)));
+}
+
+// --------------------------------------------------------
+// Starts the camera at the beginning of the path.  With a
+// fixed step, the path moves on by exactly that much every
+// Update, however long the frame took.
+// --------------------------------------------------------
+void Camera::SetPath(std::shared_ptr<CameraPath> path, float fixedStep)
+{
+	this->path = path;
+	pathTime = 0;
+	pathStep = fixedStep;
 }
 
+// --------------------------------------------------------
+// True once a path has been flown to its end
+// --------------------------------------------------------
+bool Camera::IsPathFinished()
+{
+	return path && pathTime >= path->GetDuration();
+}
+
+// --------------------------------------------------------
+// Follows the path if there is one, otherwise moves and
+// turns with the keyboard and mouse
+// --------------------------------------------------------
 void Camera::Update(float dt)
 {
+	if (path) {
+		pathTime += pathStep > 0 ? pathStep : dt;
+		XMFLOAT3 position;
+		XMFLOAT3 rotation;
+		path->Evaluate(pathTime, position, rotation);
+		transform.SetPosition(position.x, position.y, position.z);
+		transform.SetRotation(rotation.x, rotation.y, rotation.z);
+		UpdateViewMatrix();
+		return;
+	}
+
 	Input& input = Input::GetInstance();
 	//I am intentionally not using else-ifs -- I want forward and backward to cancel and to be able to move diagonally
 	if (input.KeyDown('W') || input.KeyDown(VK_UP)) {
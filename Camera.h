@@ -1,6 +1,9 @@
 #pragma once
 #include <DirectXMath.h>
 #include "Transform.h"
+#include "Frustum.h"
+#include <memory>
+#include "CameraPath.h"
 class Camera
 {
 private:
@@ -12,6 +15,9 @@ private:
 	float farPlane;
 	float movementSpeed;
 	float mouseLookSpeed;
+	std::shared_ptr<CameraPath> path; //followed instead of reading input, when set
+	float pathTime;
+	float pathStep; //how far along the path each Update goes, 0 to go by dt
 public:
 	Camera(float x, float y, float z, float aspectRatio);
 	Camera(Transform transform, float aspectRatio);
@@ -19,8 +25,14 @@ public:
 	DirectX::XMFLOAT4X4 GetViewMatrix();
 	DirectX::XMFLOAT4X4 GetProjectionMatrix();
 	Transform GetTransform();
+	Frustum GetFrustum(); //world-space planes built from the current view and projection matrices
 	void UpdateProjectionMatrix(float aspectRatio);
 	void UpdateViewMatrix();
 	void Update(float dt);
+
+	// Flies the camera along the path from its start, ignoring input, until it's set back to null;
+	// a fixedStep above 0 is used in place of dt, so every run renders the same frames
+	void SetPath(std::shared_ptr<CameraPath> path, float fixedStep = 0);
+	bool IsPathFinished();
 };
 
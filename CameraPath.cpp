@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "CameraPath.h"
+
+using namespace DirectX;
+
+static bool ReadFloat3(std::istringstream& stream, XMFLOAT3& value)
+{
+	return (bool)(stream >> value.x >> value.y >> value.z);
+}
+
+bool CameraPath::Load(const char* fileName)
+{
+	keys.clear();
+	std::ifstream file(fileName);
+	if (!file.is_open()) {
+		printf("Camera path: couldn't open %s\n", fileName);
+		return false;
+	}
+
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(file, line)) {
+		lineNumber++;
+		size_t comment = line.find('#');
+		if (comment != std::string::npos) {
+			line.erase(comment);
+		}
+		std::istringstream stream(line);
+		std::string keyword;
+		if (!(stream >> keyword)) {
+			continue; //blank
+		}
+
+		bool valid = keyword == "key";
+		CameraKey key = {};
+		valid = valid && (bool)(stream >> key.Time);
+		std::string property;
+		while (valid && stream >> property) {
+			if (property == "position") valid = ReadFloat3(stream, key.Position);
+			else if (property == "rotation") valid = ReadFloat3(stream, key.Rotation);
+			else valid = false;
+		}
+		valid = valid && (keys.empty() || key.Time > keys.back().Time);
+		if (!valid) {
+			printf("Camera path: %s(%d): can't read \"%s\"\n", fileName, lineNumber, line.c_str());
+			keys.clear();
+			return false;
+		}
+		keys.push_back(key);
+	}
+	if (keys.size() < 2) {
+		printf("Camera path: %s needs at least two keys\n", fileName);
+		keys.clear();
+		return false;
+	}
+	return true;
+}
+
+void CameraPath::AddKey(const CameraKey& key)
+{
+	keys.push_back(key);
+}
+
+unsigned int CameraPath::GetKeyCount() const
+{
+	return (unsigned int)keys.size();
+}
+
+float CameraPath::GetDuration() const
+{
+	return keys.size() > 1 ? keys.back().Time - keys.front().Time : 0.0f;
+}
+
+void CameraPath::Evaluate(float time, XMFLOAT3& position, XMFLOAT3& rotation) const
+{
+	if (keys.empty()) {
+		return;
+	}
+	time += keys.front().Time;
+	if (keys.size() == 1 || time <= keys.front().Time) {
+		position = keys.front().Position;
+		rotation = keys.front().Rotation;
+		return;
+	}
+	if (time >= keys.back().Time) {
+		position = keys.back().Position;
+		rotation = keys.back().Rotation;
+		return;
+	}
+
+	// The segment from key k to k + 1, with the keys either side of it shaping the curve (the ends repeat)
+	unsigned int k = 0;
+	while (keys[k + 1].Time <= time) {
+		k++;
+	}
+	unsigned int last = (unsigned int)keys.size() - 1;
+	const CameraKey& k0 = keys[k > 0 ? k - 1 : 0];
+	const CameraKey& k1 = keys[k];
+	const CameraKey& k2 = keys[k + 1];
+	const CameraKey& k3 = keys[k + 2 <= last ? k + 2 : last];
+	float t = (time - k1.Time) / (k2.Time - k1.Time);
+
+	XMStoreFloat3(&position, XMVectorCatmullRom(XMLoadFloat3(&k0.Position), XMLoadFloat3(&k1.Position), XMLoadFloat3(&k2.Position), XMLoadFloat3(&k3.Position), t));
+	XMStoreFloat3(&rotation, XMVectorCatmullRom(XMLoadFloat3(&k0.Rotation), XMLoadFloat3(&k1.Rotation), XMLoadFloat3(&k2.Rotation), XMLoadFloat3(&k3.Rotation), t));
+}
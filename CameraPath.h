@@ -0,0 +1,36 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+
+struct CameraKey
+{
+	float Time;						// Seconds from the start of the path
+	DirectX::XMFLOAT3 Position;
+	DirectX::XMFLOAT3 Rotation;		// Pitch, yaw, roll, as Transform takes them
+};
+
+// --------------------------------------------------------
+// A camera path: a Catmull-Rom spline through keyframes,
+// for flying the camera the same way on every run.  The
+// text form has one key per line, times increasing:
+//
+//   key 0 position 0 1 -8 rotation 0.2 0 0
+//   key 4 position 6 2 -4 rotation 0.3 -0.8 0
+//
+// Rotations are interpolated as plain numbers, so keep
+// neighbouring keys within half a turn of each other.
+// --------------------------------------------------------
+class CameraPath
+{
+private:
+	std::vector<CameraKey> keys;
+public:
+	//false, and the path is left empty, if the file is missing, damaged or has fewer than two keys
+	bool Load(const char* fileName);
+	void AddKey(const CameraKey& key); //after every key already added
+	unsigned int GetKeyCount() const;
+	float GetDuration() const;
+
+	//time is from the first key; before it or past the last key the end keys are held
+	void Evaluate(float time, DirectX::XMFLOAT3& position, DirectX::XMFLOAT3& rotation) const;
+};
@@ -0,0 +1,220 @@
+#include <string.h>
+#include "CommandBuffer.h"
+
+#define COMMAND_ALIGNMENT 8
+
+// Smallest valid size of each command type, indexed by CommandType
+static const unsigned int commandSizes[COMMAND_TYPE_COUNT] = {
+	sizeof(SetVertexShaderCommand),
+	sizeof(SetPixelShaderCommand),
+	sizeof(SetConstantsCommand),
+	sizeof(SetBindingCommand),
+	sizeof(SetBindingCommand),
+	sizeof(SetStateCommand),
+	sizeof(SetStateCommand),
+	sizeof(SetStateCommand),
+	sizeof(SetPipelineStateCommand),
+	sizeof(SetMeshBuffersCommand),
+	sizeof(DrawIndexedCommand)
+};
+
+CommandBuffer::CommandBuffer()
+{
+	commandCount = 0;
+}
+
+void CommandBuffer::Clear()
+{
+	data.clear();
+	commandCount = 0;
+}
+
+// Appends a zeroed command of at least size bytes with its header filled in
+void* CommandBuffer::Allocate(CommandType type, unsigned int size)
+{
+	size = (size + COMMAND_ALIGNMENT - 1) & ~(COMMAND_ALIGNMENT - 1);
+	size_t offset = data.size();
+	data.resize(offset + size, 0);
+	CommandHeader* header = (CommandHeader*)&data[offset];
+	header->Type = type;
+	header->Size = size;
+	commandCount++;
+	return header;
+}
+
+void CommandBuffer::SetVertexShader(void* shader, void* inputLayout)
+{
+	SetVertexShaderCommand* command = (SetVertexShaderCommand*)Allocate(COMMAND_SET_VERTEX_SHADER, sizeof(SetVertexShaderCommand));
+	command->Shader = shader;
+	command->InputLayout = inputLayout;
+}
+
+void CommandBuffer::SetPixelShader(void* shader)
+{
+	SetPixelShaderCommand* command = (SetPixelShaderCommand*)Allocate(COMMAND_SET_PIXEL_SHADER, sizeof(SetPixelShaderCommand));
+	command->Shader = shader;
+}
+
+void CommandBuffer::SetConstants(unsigned int stage, unsigned int slot, void* buffer, const void* constants, unsigned int size)
+{
+	void* destination = SetConstants(stage, slot, buffer, size);
+	memcpy(destination, constants, size);
+}
+
+void* CommandBuffer::SetConstants(unsigned int stage, unsigned int slot, void* buffer, unsigned int size)
+{
+	SetConstantsCommand* command = (SetConstantsCommand*)Allocate(COMMAND_SET_CONSTANTS, sizeof(SetConstantsCommand) + size);
+	command->Stage = stage;
+	command->Slot = slot;
+	command->Buffer = buffer;
+	command->DataSize = size;
+	return command + 1;
+}
+
+void CommandBuffer::SetShaderResource(unsigned int stage, unsigned int slot, void* resource)
+{
+	SetBindingCommand* command = (SetBindingCommand*)Allocate(COMMAND_SET_SHADER_RESOURCE, sizeof(SetBindingCommand));
+	command->Stage = stage;
+	command->Slot = slot;
+	command->Resource = resource;
+}
+
+void CommandBuffer::SetSampler(unsigned int stage, unsigned int slot, void* sampler)
+{
+	SetBindingCommand* command = (SetBindingCommand*)Allocate(COMMAND_SET_SAMPLER, sizeof(SetBindingCommand));
+	command->Stage = stage;
+	command->Slot = slot;
+	command->Resource = sampler;
+}
+
+void CommandBuffer::SetBlendState(void* state)
+{
+	SetStateCommand* command = (SetStateCommand*)Allocate(COMMAND_SET_BLEND_STATE, sizeof(SetStateCommand));
+	command->State = state;
+}
+
+void CommandBuffer::SetRasterizerState(void* state)
+{
+	SetStateCommand* command = (SetStateCommand*)Allocate(COMMAND_SET_RASTERIZER_STATE, sizeof(SetStateCommand));
+	command->State = state;
+}
+
+void CommandBuffer::SetDepthStencilState(void* state, unsigned int stencilRef)
+{
+	SetStateCommand* command = (SetStateCommand*)Allocate(COMMAND_SET_DEPTH_STENCIL_STATE, sizeof(SetStateCommand));
+	command->State = state;
+	command->StencilRef = stencilRef;
+}
+
+void CommandBuffer::SetPipelineState(const PipelineHandles& pipeline)
+{
+	SetPipelineStateCommand* command = (SetPipelineStateCommand*)Allocate(COMMAND_SET_PIPELINE_STATE, sizeof(SetPipelineStateCommand));
+	command->Pipeline = pipeline;
+}
+
+void CommandBuffer::SetMeshBuffers(void* vertexBuffer, void* indexBuffer, unsigned int stride)
+{
+	SetMeshBuffersCommand* command = (SetMeshBuffersCommand*)Allocate(COMMAND_SET_MESH_BUFFERS, sizeof(SetMeshBuffersCommand));
+	command->VertexBuffer = vertexBuffer;
+	command->IndexBuffer = indexBuffer;
+	command->Stride = stride;
+}
+
+void CommandBuffer::DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex)
+{
+	DrawIndexedCommand* command = (DrawIndexedCommand*)Allocate(COMMAND_DRAW_INDEXED, sizeof(DrawIndexedCommand));
+	command->IndexCount = indexCount;
+	command->StartIndex = startIndex;
+	command->BaseVertex = baseVertex;
+}
+
+// Commands hold no offsets into their own buffer, so merging is a plain copy
+void CommandBuffer::Append(const CommandBuffer& other)
+{
+	data.insert(data.end(), other.data.begin(), other.data.end());
+	commandCount += other.commandCount;
+}
+
+bool CommandBuffer::Replay(ICommandBackend& backend) const
+{
+	size_t offset = 0;
+	while (offset < data.size()) {
+		const CommandHeader* header = (const CommandHeader*)&data[offset];
+		if (data.size() - offset < sizeof(CommandHeader) || header->Type >= COMMAND_TYPE_COUNT ||
+			header->Size < commandSizes[header->Type] || header->Size % COMMAND_ALIGNMENT != 0 || header->Size > data.size() - offset) {
+			return false;
+		}
+
+		switch (header->Type) {
+		case COMMAND_SET_VERTEX_SHADER: {
+			const SetVertexShaderCommand* command = (const SetVertexShaderCommand*)header;
+			backend.SetVertexShader(command->Shader, command->InputLayout);
+			break;
+		}
+		case COMMAND_SET_PIXEL_SHADER: {
+			const SetPixelShaderCommand* command = (const SetPixelShaderCommand*)header;
+			backend.SetPixelShader(command->Shader);
+			break;
+		}
+		case COMMAND_SET_CONSTANTS: {
+			const SetConstantsCommand* command = (const SetConstantsCommand*)header;
+			if (command->DataSize > header->Size - sizeof(SetConstantsCommand)) {
+				return false;
+			}
+			backend.SetConstants(command->Stage, command->Slot, command->Buffer, command + 1, command->DataSize);
+			break;
+		}
+		case COMMAND_SET_SHADER_RESOURCE: {
+			const SetBindingCommand* command = (const SetBindingCommand*)header;
+			backend.SetShaderResource(command->Stage, command->Slot, command->Resource);
+			break;
+		}
+		case COMMAND_SET_SAMPLER: {
+			const SetBindingCommand* command = (const SetBindingCommand*)header;
+			backend.SetSampler(command->Stage, command->Slot, command->Resource);
+			break;
+		}
+		case COMMAND_SET_BLEND_STATE:
+			backend.SetBlendState(((const SetStateCommand*)header)->State);
+			break;
+		case COMMAND_SET_RASTERIZER_STATE:
+			backend.SetRasterizerState(((const SetStateCommand*)header)->State);
+			break;
+		case COMMAND_SET_DEPTH_STENCIL_STATE: {
+			const SetStateCommand* command = (const SetStateCommand*)header;
+			backend.SetDepthStencilState(command->State, command->StencilRef);
+			break;
+		}
+		case COMMAND_SET_PIPELINE_STATE:
+			backend.SetPipelineState(((const SetPipelineStateCommand*)header)->Pipeline);
+			break;
+		case COMMAND_SET_MESH_BUFFERS: {
+			const SetMeshBuffersCommand* command = (const SetMeshBuffersCommand*)header;
+			backend.SetMeshBuffers(command->VertexBuffer, command->IndexBuffer, command->Stride);
+			break;
+		}
+		case COMMAND_DRAW_INDEXED: {
+			const DrawIndexedCommand* command = (const DrawIndexedCommand*)header;
+			backend.DrawIndexed(command->IndexCount, command->StartIndex, command->BaseVertex);
+			break;
+		}
+		}
+		offset += header->Size;
+	}
+	return true;
+}
+
+unsigned int CommandBuffer::GetCommandCount() const
+{
+	return commandCount;
+}
+
+size_t CommandBuffer::GetSize() const
+{
+	return data.size();
+}
+
+const uint8_t* CommandBuffer::GetData() const
+{
+	return data.empty() ? nullptr : &data[0];
+}
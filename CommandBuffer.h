@@ -0,0 +1,149 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "ICommandBackend.h"
+
+enum CommandType
+{
+	COMMAND_SET_VERTEX_SHADER,
+	COMMAND_SET_PIXEL_SHADER,
+	COMMAND_SET_CONSTANTS,
+	COMMAND_SET_SHADER_RESOURCE,
+	COMMAND_SET_SAMPLER,
+	COMMAND_SET_BLEND_STATE,
+	COMMAND_SET_RASTERIZER_STATE,
+	COMMAND_SET_DEPTH_STENCIL_STATE,
+	COMMAND_SET_PIPELINE_STATE,
+	COMMAND_SET_MESH_BUFFERS,
+	COMMAND_DRAW_INDEXED,
+	COMMAND_TYPE_COUNT
+};
+
+// --------------------------------------------------------
+// The command formats.  Every command starts with a header
+// whose Size covers the whole command, including any data
+// stored inline after it, padded to 8 bytes so the next
+// command's pointers stay aligned.
+// --------------------------------------------------------
+struct CommandHeader
+{
+	uint32_t Type;
+	uint32_t Size;
+};
+
+struct SetVertexShaderCommand
+{
+	CommandHeader Header;
+	void* Shader;
+	void* InputLayout;
+};
+
+struct SetPixelShaderCommand
+{
+	CommandHeader Header;
+	void* Shader;
+};
+
+struct SetConstantsCommand
+{
+	CommandHeader Header;
+	uint32_t Stage;
+	uint32_t Slot;
+	void* Buffer;
+	uint32_t DataSize;		// Bytes of constant data right after this struct
+	uint32_t Padding;
+};
+
+// Shader resources and samplers
+struct SetBindingCommand
+{
+	CommandHeader Header;
+	uint32_t Stage;
+	uint32_t Slot;
+	void* Resource;
+};
+
+// Blend, rasterizer and depth-stencil states
+struct SetStateCommand
+{
+	CommandHeader Header;
+	void* State;
+	uint32_t StencilRef;	// Depth-stencil only
+	uint32_t Padding;
+};
+
+struct SetPipelineStateCommand
+{
+	CommandHeader Header;
+	PipelineHandles Pipeline;
+};
+
+struct SetMeshBuffersCommand
+{
+	CommandHeader Header;
+	void* VertexBuffer;
+	void* IndexBuffer;
+	uint32_t Stride;
+	uint32_t Padding;
+};
+
+struct DrawIndexedCommand
+{
+	CommandHeader Header;
+	uint32_t IndexCount;
+	uint32_t StartIndex;
+	int32_t BaseVertex;
+	uint32_t Padding;
+};
+
+// --------------------------------------------------------
+// A flat, POD stream of rendering commands.
+//
+// Recording only appends to the buffer's own memory and
+// never touches a device, so any number of threads can
+// record into buffers of their own at the same time.  The
+// results are merged with Append, in whatever order they
+// have to be drawn, and one thread replays the merged
+// buffer into a backend (the real context, or anything
+// else that implements ICommandBackend).
+//
+// Resources are opaque handles, and the buffer holds no
+// references: whatever they point at has to stay alive
+// until the buffer has been replayed.
+// --------------------------------------------------------
+class CommandBuffer
+{
+private:
+	std::vector<uint8_t> data;
+	unsigned int commandCount;
+
+	void* Allocate(CommandType type, unsigned int size);
+public:
+	CommandBuffer();
+	void Clear(); //keeps the memory for the next frame
+
+	void SetVertexShader(void* shader, void* inputLayout);
+	void SetPixelShader(void* shader);
+	//copies size bytes of constant data into the buffer
+	void SetConstants(unsigned int stage, unsigned int slot, void* buffer, const void* constants, unsigned int size);
+	//reserves size bytes of constant data and returns them to be filled in, valid until the next command is recorded
+	void* SetConstants(unsigned int stage, unsigned int slot, void* buffer, unsigned int size);
+	void SetShaderResource(unsigned int stage, unsigned int slot, void* resource);
+	void SetSampler(unsigned int stage, unsigned int slot, void* sampler);
+	void SetBlendState(void* state);
+	void SetRasterizerState(void* state);
+	void SetDepthStencilState(void* state, unsigned int stencilRef);
+	void SetPipelineState(const PipelineHandles& pipeline);
+	void SetMeshBuffers(void* vertexBuffer, void* indexBuffer, unsigned int stride);
+	void DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex);
+
+	//adds a copy of every command in other after this buffer's own
+	void Append(const CommandBuffer& other);
+	//calls the backend once per command, in order; false if the stream is malformed, after replaying everything before the bad command
+	bool Replay(ICommandBackend& backend) const;
+
+	unsigned int GetCommandCount() const;
+	size_t GetSize() const; //in bytes
+	const uint8_t* GetData() const;
+};
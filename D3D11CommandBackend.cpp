@@ -0,0 +1,88 @@
+#include "D3D11CommandBackend.h"
+
+D3D11CommandBackend::D3D11CommandBackend(Microsoft::WRL::ComPtr<ID3D11DeviceContext> context)
+{
+	this->context = context;
+}
+
+void D3D11CommandBackend::SetVertexShader(void* shader, void* inputLayout)
+{
+	context->IASetInputLayout((ID3D11InputLayout*)inputLayout);
+	context->VSSetShader((ID3D11VertexShader*)shader, 0, 0);
+}
+
+void D3D11CommandBackend::SetPixelShader(void* shader)
+{
+	context->PSSetShader((ID3D11PixelShader*)shader, 0, 0);
+}
+
+void D3D11CommandBackend::SetConstants(unsigned int stage, unsigned int slot, void* buffer, const void* data, unsigned int size)
+{
+	ID3D11Buffer* constantBuffer = (ID3D11Buffer*)buffer;
+	context->UpdateSubresource(constantBuffer, 0, 0, data, 0, 0);
+	if (stage == SHADER_STAGE_VERTEX) {
+		context->VSSetConstantBuffers(slot, 1, &constantBuffer);
+	}
+	else {
+		context->PSSetConstantBuffers(slot, 1, &constantBuffer);
+	}
+}
+
+void D3D11CommandBackend::SetShaderResource(unsigned int stage, unsigned int slot, void* resource)
+{
+	ID3D11ShaderResourceView* srv = (ID3D11ShaderResourceView*)resource;
+	if (stage == SHADER_STAGE_VERTEX) {
+		context->VSSetShaderResources(slot, 1, &srv);
+	}
+	else {
+		context->PSSetShaderResources(slot, 1, &srv);
+	}
+}
+
+void D3D11CommandBackend::SetSampler(unsigned int stage, unsigned int slot, void* sampler)
+{
+	ID3D11SamplerState* samplerState = (ID3D11SamplerState*)sampler;
+	if (stage == SHADER_STAGE_VERTEX) {
+		context->VSSetSamplers(slot, 1, &samplerState);
+	}
+	else {
+		context->PSSetSamplers(slot, 1, &samplerState);
+	}
+}
+
+void D3D11CommandBackend::SetBlendState(void* state)
+{
+	context->OMSetBlendState((ID3D11BlendState*)state, 0, 0xffffffff);
+}
+
+void D3D11CommandBackend::SetRasterizerState(void* state)
+{
+	context->RSSetState((ID3D11RasterizerState*)state);
+}
+
+void D3D11CommandBackend::SetDepthStencilState(void* state, unsigned int stencilRef)
+{
+	context->OMSetDepthStencilState((ID3D11DepthStencilState*)state, stencilRef);
+}
+
+void D3D11CommandBackend::SetPipelineState(const PipelineHandles& pipeline)
+{
+	SetVertexShader(pipeline.VertexShader, pipeline.InputLayout);
+	SetPixelShader(pipeline.PixelShader);
+	SetBlendState(pipeline.BlendState);
+	SetRasterizerState(pipeline.RasterizerState);
+	SetDepthStencilState(pipeline.DepthStencilState, pipeline.StencilRef);
+}
+
+void D3D11CommandBackend::SetMeshBuffers(void* vertexBuffer, void* indexBuffer, unsigned int stride)
+{
+	ID3D11Buffer* vertices = (ID3D11Buffer*)vertexBuffer;
+	UINT offset = 0;
+	context->IASetVertexBuffers(0, 1, &vertices, &stride, &offset);
+	context->IASetIndexBuffer((ID3D11Buffer*)indexBuffer, DXGI_FORMAT_R32_UINT, 0);
+}
+
+void D3D11CommandBackend::DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex)
+{
+	context->DrawIndexed(indexCount, startIndex, baseVertex);
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <d3d11.h>
+#include <wrl/client.h>
+#include "ICommandBackend.h"
+
+// --------------------------------------------------------
+// Replays command buffers into a D3D11 device context.  The
+// handles are the raw ID3D11 pointers that were recorded,
+// e.g. ComPtr::Get() of a shader or buffer.
+// --------------------------------------------------------
+class D3D11CommandBackend : public ICommandBackend
+{
+private:
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> context;
+public:
+	D3D11CommandBackend(Microsoft::WRL::ComPtr<ID3D11DeviceContext> context);
+
+	void SetVertexShader(void* shader, void* inputLayout);
+	void SetPixelShader(void* shader);
+	void SetConstants(unsigned int stage, unsigned int slot, void* buffer, const void* data, unsigned int size);
+	void SetShaderResource(unsigned int stage, unsigned int slot, void* resource);
+	void SetSampler(unsigned int stage, unsigned int slot, void* sampler);
+	void SetBlendState(void* state);
+	void SetRasterizerState(void* state);
+	void SetDepthStencilState(void* state, unsigned int stencilRef);
+	void SetPipelineState(const PipelineHandles& pipeline);
+	void SetMeshBuffers(void* vertexBuffer, void* indexBuffer, unsigned int stride);
+	void DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex);
+};
@@ -1,9 +1,15 @@
 #include "DXCore.h"
 #include "Input.h"
+#include "Profiler.h"
+#include "AllocationTracker.h"
+#include "FrameArena.h"
 
 #include <WindowsX.h>
 #include <sstream>
 
+// Frames run before a headless run expects the frame to stop allocating
+#define HEADLESS_WARMUP_FRAMES 60
+
 // Define the static instance variable so our OS-level 
 // message handling function below can talk to our object
 DXCore* DXCore::DXCoreInstance = 0;
@@ -50,6 +56,10 @@ DXCore::DXCore(
 
 	// Initialize fields
 	this->hasFocus = true; 
+	this->headless = false;
+	this->hWnd = 0;
+	this->playbackFrame = 0;
+	this->playingInput = false;
 	
 	this->fpsFrameCount = 0;
 	this->fpsTimeElapsed = 0.0f;
@@ -382,6 +392,8 @@ HRESULT DXCore::Run()
 	previousTime = now;
 
 	// Give subclass a chance to initialize
+	Profiler::SetThreadName("Main");
+	FrameArena::Initialize();
 	Init();
 
 	// Our overall game and message loop
@@ -399,28 +411,266 @@ HRESULT DXCore::Run()
 		else
 		{
 			// Update timer and title bar (if necessary)
-			UpdateTimer();
+			Profiler::BeginFrame();
+			AllocationTracker::BeginFrame();
+			FrameArena::BeginFrame();
+			if (playingInput) {
+				// Time and input both come from the recording, however long the frame really took
+				if (!PlayInputFrame()) {
+					Quit();
+					continue;
+				}
+			}
+			else {
+				UpdateTimer();
+			}
 			if(titleBarStats)
 				UpdateTitleBarStats();
 
 			// Update the input manager
-			Input::GetInstance().Update();
+			if (!playingInput)
+				Input::GetInstance().Update();
+			RecordInputFrame();
 
 			// The game loop
+			frameStats.BeginFrame();
+			frameStats.BeginPhase(FRAME_PHASE_UPDATE);
 			Update(deltaTime, totalTime);
+			frameStats.BeginPhase(FRAME_PHASE_DRAW);
 			Draw(deltaTime, totalTime);
+			frameStats.EndFrame();
 
 			// Frame is over, notify the input manager
 			Input::GetInstance().EndOfFrame();
 		}
 	}
 
+	frameStats.Print();
+	frameStats.WriteCsv(GetFullPathTo("frame_stats.csv"));
+	SaveRecordedInput();
+
 	// We'll end up here once we get a WM_QUIT message,
 	// which usually comes from the user closing the window
 	return (HRESULT)msg.wParam;
 }
 
 
+// --------------------------------------------------------
+// Initializes DirectX without a window, for running the
+// game loop on Windows machines with no GPU (build and
+// benchmark machines).  The null driver accepts every call
+// and creates every resource, but never renders anything,
+// so only the CPU side of each frame costs anything.  It's
+// part of the D3D11 SDK layers, which is the Graphics Tools
+// optional feature, so device creation fails without them.
+//
+// Render targets are plain textures in place of a swap
+// chain, and the input manager is set up with no window;
+// it's never updated, so no keys are ever down.
+// --------------------------------------------------------
+HRESULT DXCore::InitHeadless()
+{
+	headless = true;
+
+	// Print to whatever started us if we can, otherwise to a console of our own
+	if (!GetConsoleWindow())
+	{
+		if (AttachConsole(ATTACH_PARENT_PROCESS))
+		{
+			FILE* stream;
+			freopen_s(&stream, "CONOUT$", "w", stdout);
+			freopen_s(&stream, "CONOUT$", "w", stderr);
+		}
+		else
+		{
+			CreateConsoleWindow(500, 120, 32, 120);
+		}
+	}
+
+	unsigned int deviceFlags = 0;
+#if defined(DEBUG) || defined(_DEBUG)
+	deviceFlags |= D3D11_CREATE_DEVICE_DEBUG;
+#endif
+
+	HRESULT hr = D3D11CreateDevice(
+		0,							// Default adapter, the null driver ignores it
+		D3D_DRIVER_TYPE_NULL,		// No rendering at all
+		0,
+		deviceFlags,
+		0,
+		0,
+		D3D11_SDK_VERSION,
+		device.GetAddressOf(),
+		&dxFeatureLevel,
+		context.GetAddressOf());
+	if (FAILED(hr)) return hr;
+
+	// A texture stands in for the swap chain's back buffer
+	D3D11_TEXTURE2D_DESC backBufferDesc = {};
+	backBufferDesc.Width				= width;
+	backBufferDesc.Height				= height;
+	backBufferDesc.MipLevels			= 1;
+	backBufferDesc.ArraySize			= 1;
+	backBufferDesc.Format				= DXGI_FORMAT_R8G8B8A8_UNORM;
+	backBufferDesc.Usage				= D3D11_USAGE_DEFAULT;
+	backBufferDesc.BindFlags			= D3D11_BIND_RENDER_TARGET;
+	backBufferDesc.SampleDesc.Count		= 1;
+
+	ID3D11Texture2D* backBufferTexture = 0;
+	hr = device->CreateTexture2D(&backBufferDesc, 0, &backBufferTexture);
+	if (FAILED(hr)) return hr;
+	device->CreateRenderTargetView(backBufferTexture, 0, backBufferRTV.GetAddressOf());
+	backBufferTexture->Release();
+
+	D3D11_TEXTURE2D_DESC depthStencilDesc = backBufferDesc;
+	depthStencilDesc.Format				= DXGI_FORMAT_D24_UNORM_S8_UINT;
+	depthStencilDesc.BindFlags			= D3D11_BIND_DEPTH_STENCIL;
+
+	ID3D11Texture2D* depthBufferTexture = 0;
+	hr = device->CreateTexture2D(&depthStencilDesc, 0, &depthBufferTexture);
+	if (FAILED(hr)) return hr;
+	device->CreateDepthStencilView(depthBufferTexture, 0, depthStencilView.GetAddressOf());
+	depthBufferTexture->Release();
+
+	context->OMSetRenderTargets(1, backBufferRTV.GetAddressOf(), depthStencilView.Get());
+
+	D3D11_VIEWPORT viewport = {};
+	viewport.Width		= (float)width;
+	viewport.Height		= (float)height;
+	viewport.MinDepth	= 0.0f;
+	viewport.MaxDepth	= 1.0f;
+	context->RSSetViewports(1, &viewport);
+
+	Input::GetInstance().Initialize(0);
+
+	return S_OK;
+}
+
+// --------------------------------------------------------
+// Runs a fixed number of frames with a fixed time step, as
+// fast as they'll go, then prints how much CPU time Update
+// and Draw took per frame, and which frames allocated after
+// the first HEADLESS_WARMUP_FRAMES.  When playing input
+// back, the recording decides the number of frames and
+// their time steps instead.  The fixed step makes runs of
+// the same scene do the same work, so they're comparable
+// from one build to the next.
+// --------------------------------------------------------
+HRESULT DXCore::RunHeadless(unsigned int frameCount, float frameDeltaTime)
+{
+	Profiler::SetThreadName("Main");
+	FrameArena::Initialize();
+	Init();
+
+	if (playingInput)
+		frameCount = playbackInput.GetFrameCount();
+	for (unsigned int frame = 0; frame < frameCount; frame++)
+	{
+		Profiler::BeginFrame();
+		AllocationTracker::BeginFrame();
+		FrameArena::BeginFrame();
+		if (frame == HEADLESS_WARMUP_FRAMES)
+			AllocationTracker::ExpectNoAllocations(true);
+		if (playingInput) {
+			PlayInputFrame();
+		}
+		else {
+			deltaTime = frameDeltaTime;
+			totalTime = frameDeltaTime * (frame + 1);
+		}
+		RecordInputFrame();
+
+		frameStats.BeginFrame();
+		frameStats.BeginPhase(FRAME_PHASE_UPDATE);
+		Update(deltaTime, totalTime);
+		frameStats.BeginPhase(FRAME_PHASE_DRAW);
+		Draw(deltaTime, totalTime);
+		frameStats.EndFrame();
+
+		Input::GetInstance().EndOfFrame();
+	}
+	SaveRecordedInput();
+	if (frameCount == 0)
+		return S_OK;
+
+	FramePhaseSummary total = frameStats.GetSummary(FRAME_PHASE_TOTAL, true);
+	printf("Headless: %u frames, %.2f s of game time, %.1f ms in total\n", frameCount, totalTime, total.MeanMs * frameCount);
+	frameStats.Print();
+	frameStats.WriteCsv(GetFullPathTo("headless_frame_stats.csv"));
+	PrintHeadlessStats(frameCount);
+	AllocationTracker::BeginFrame();
+	AllocationTracker::ExpectNoAllocations(false);
+	AllocationTracker::PrintTotals();
+	FrameArena::BeginFrame();
+	FrameArenaStats arena = FrameArena::GetStats();
+	printf("Frame arena: %.1f KB used by the last frame, %.1f KB at most, of %.1f KB; %u overflows\n",
+		arena.Used / 1024.0f, arena.Peak / 1024.0f, arena.Capacity / 1024.0f, arena.Overflows);
+	Profiler::BeginFrame(); //closes the last frame, so it can be printed
+	Profiler::PrintFrameTree();
+	Profiler::ExportChromeTrace(GetFullPathTo("headless_trace.json"));
+	fflush(stdout);
+
+	return S_OK;
+}
+
+
+// --------------------------------------------------------
+// Records every frame's input and time step from here on,
+// saving them to path when the run ends
+// --------------------------------------------------------
+void DXCore::RecordInput(const std::string& path)
+{
+	recordingPath = path;
+	recordedInput.Clear();
+}
+
+// --------------------------------------------------------
+// Plays a recording back in place of the real input and
+// timer.  The window closes (or a headless run ends) with
+// the recording.  Playing and recording at once saves the
+// same bytes that were played, which shows a run stayed
+// deterministic.
+// --------------------------------------------------------
+bool DXCore::PlayInput(const std::string& path)
+{
+	if (!playbackInput.Load(path))
+		return false;
+	printf("Input recording: playing %u frames from %s\n", playbackInput.GetFrameCount(), path.c_str());
+	playingInput = true;
+	playbackFrame = 0;
+	return true;
+}
+
+bool DXCore::PlayInputFrame()
+{
+	if (playbackFrame >= playbackInput.GetFrameCount())
+		return false;
+	const InputFrame& frame = playbackInput.GetFrame(playbackFrame++);
+	deltaTime = frame.DeltaTime;
+	totalTime = frame.TotalTime;
+	Input::GetInstance().SetFrame(frame);
+	return true;
+}
+
+void DXCore::RecordInputFrame()
+{
+	if (recordingPath.empty())
+		return;
+	InputFrame frame;
+	Input::GetInstance().GetFrame(frame);
+	frame.DeltaTime = deltaTime;
+	frame.TotalTime = totalTime;
+	recordedInput.AddFrame(frame);
+}
+
+void DXCore::SaveRecordedInput()
+{
+	if (recordingPath.empty())
+		return;
+	if (recordedInput.Save(recordingPath))
+		printf("Input recording: %u frames saved to %s\n", recordedInput.GetFrameCount(), recordingPath.c_str());
+}
+
 // --------------------------------------------------------
 // Sends an OS-level window close message to our process, which
 // will be handled by our message processing function
@@ -483,6 +733,13 @@ void DXCore::UpdateTitleBarStats()
 		"    FPS: "			<< fpsFrameCount <<
 		"    Frame Time: "	<< mspf << "ms";
 
+	// Stutter over the last FRAME_STATS_WINDOW frames
+	output.precision(3);
+	output <<
+		"    p99: "			<< frameStats.GetSummary(FRAME_PHASE_TOTAL, false).P99Ms << "ms";
+	if (!frameStats.GetBudgets().empty())
+		output << "    Hitches: " << frameStats.GetHitches(0, false);
+
 	// Append the version of DirectX the app is using
 	switch (dxFeatureLevel)
 	{
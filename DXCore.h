@@ -4,6 +4,8 @@
 #include <d3d11.h>
 #include <string>
 #include <wrl/client.h> // Used for ComPtr - a smart pointer for COM objects
+#include "FrameStats.h"
+#include "InputRecording.h"
 
 // We can include the correct library files here
 // instead of in Visual Studio settings if we want
@@ -36,6 +38,17 @@ public:
 	HRESULT InitWindow();
 	HRESULT InitDirectX();
 	HRESULT Run();
+
+	// Headless benchmarking, on Windows only: no window, a null
+	// driver device and a fixed time step, reporting the CPU time
+	// of each frame
+	HRESULT InitHeadless();
+	HRESULT RunHeadless(unsigned int frameCount, float frameDeltaTime);
+
+	// Input and frame times can be saved when the run ends, or played
+	// back instead of the real ones; call before Run or RunHeadless
+	void RecordInput(const std::string& path);
+	bool PlayInput(const std::string& path);
 	void Quit();
 	virtual void OnResize();
 
@@ -43,12 +56,14 @@ public:
 	virtual void Init() = 0;
 	virtual void Update(float deltaTime, float totalTime) = 0;
 	virtual void Draw(float deltaTime, float totalTime) = 0;
+	virtual void PrintHeadlessStats(unsigned int frameCount) {}
 
 protected:
 	HINSTANCE	hInstance;		// The handle to the application
 	HWND		hWnd;			// The handle to the window itself
 	std::string titleBarText;	// Custom text in window's title bar
 	bool		titleBarStats;	// Show extra stats in title bar?
+	bool		headless;		// Running without a window or GPU? (no swap chain either)
 
 	// Size of the window's client area
 	unsigned int width;
@@ -67,6 +82,10 @@ protected:
 	Microsoft::WRL::ComPtr<ID3D11RenderTargetView> backBufferRTV;
 	Microsoft::WRL::ComPtr<ID3D11DepthStencilView> depthStencilView;
 
+	// Frame time percentiles and hitches; Run times the update and
+	// draw phases, and Draw marks FRAME_PHASE_PRESENT before presenting
+	FrameStats frameStats;
+
 	// Helper function for allocating a console window
 	void CreateConsoleWindow(int bufferLines, int bufferColumns, int windowLines, int windowColumns);
 
@@ -93,5 +112,16 @@ private:
 
 	void UpdateTimer();			// Updates the timer for this frame
 	void UpdateTitleBarStats();	// Puts debug info in the title bar
+
+	// Input recording and playback
+	InputRecording recordedInput;	// Frames so far when recording, or the whole run when playing
+	InputRecording playbackInput;
+	std::string recordingPath;		// Empty when not recording
+	unsigned int playbackFrame;
+	bool playingInput;
+
+	bool PlayInputFrame();			// Sets the timer and Input from the recording, false once it's over
+	void RecordInputFrame();
+	void SaveRecordedInput();
 };
 
@@ -0,0 +1,129 @@
+#include <chrono>
+#include <string.h>
+#include "DepthSorter.h"
+
+using namespace DirectX;
+
+DepthSorter::DepthSorter(float coherentDistance, unsigned int maxShiftsPerElement)
+{
+	this->coherentDistance = coherentDistance;
+	this->maxShiftsPerElement = maxShiftsPerElement;
+	lastCameraPosition = XMFLOAT3(0, 0, 0);
+	hasPreviousOrder = false;
+	stats = {};
+}
+
+const std::vector<uint32_t>& DepthSorter::Sort(const XMFLOAT3* positions, unsigned int count, XMFLOAT3 cameraPosition)
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	depths.resize(count);
+	for (unsigned int i = 0; i < count; i++) {
+		float dx = positions[i].x - cameraPosition.x;
+		float dy = positions[i].y - cameraPosition.y;
+		float dz = positions[i].z - cameraPosition.z;
+		depths[i] = dx * dx + dy * dy + dz * dz;
+	}
+
+	float mx = cameraPosition.x - lastCameraPosition.x;
+	float my = cameraPosition.y - lastCameraPosition.y;
+	float mz = cameraPosition.z - lastCameraPosition.z;
+	bool coherent = hasPreviousOrder && order.size() == count && mx * mx + my * my + mz * mz <= coherentDistance * coherentDistance;
+
+	// Lay the keys out in last frame's order if we can trust it
+	entries.resize(count);
+	for (unsigned int i = 0; i < count; i++) {
+		uint32_t index = coherent ? order[i] : i;
+		entries[i].depthSq = depths[index];
+		entries[i].index = index;
+	}
+
+	stats.Shifts = 0;
+	stats.UsedInsertionSort = coherent && InsertionSort();
+	if (!stats.UsedInsertionSort) {
+		RadixSort();
+	}
+
+	order.resize(count);
+	for (unsigned int i = 0; i < count; i++) {
+		order[i] = entries[i].index;
+	}
+	lastCameraPosition = cameraPosition;
+	hasPreviousOrder = true;
+
+	std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+	stats.Count = count;
+	stats.Microseconds = std::chrono::duration<double, std::micro>(end - start).count();
+	return order;
+}
+
+// Descending insertion sort; gives up (leaving entries partially sorted) past the shift budget
+bool DepthSorter::InsertionSort()
+{
+	unsigned int budget = maxShiftsPerElement * (unsigned int)entries.size();
+	for (size_t i = 1; i < entries.size(); i++) {
+		SortEntry current = entries[i];
+		size_t j = i;
+		while (j > 0 && entries[j - 1].depthSq < current.depthSq) {
+			entries[j] = entries[j - 1];
+			j--;
+			if (++stats.Shifts > budget) {
+				entries[j] = current;
+				return false;
+			}
+		}
+		entries[j] = current;
+	}
+	return true;
+}
+
+// --------------------------------------------------------
+// Squared distances are never negative, so their bit
+// patterns sort like unsigned ints.  Sorting ~bits ascending
+// gives farthest first.  11 bits per pass, 3 passes.
+// --------------------------------------------------------
+void DepthSorter::RadixSort()
+{
+	size_t count = entries.size();
+	scratch.resize(count);
+	for (int shift = 0; shift < 32; shift += 11) {
+		unsigned int histogram[2048] = {};
+		for (size_t i = 0; i < count; i++) {
+			uint32_t bits;
+			memcpy(&bits, &entries[i].depthSq, sizeof(float));
+			histogram[(~bits >> shift) & 0x7FF]++;
+		}
+		unsigned int total = 0;
+		for (int b = 0; b < 2048; b++) {
+			unsigned int bucket = histogram[b];
+			histogram[b] = total;
+			total += bucket;
+		}
+		for (size_t i = 0; i < count; i++) {
+			uint32_t bits;
+			memcpy(&bits, &entries[i].depthSq, sizeof(float));
+			scratch[histogram[(~bits >> shift) & 0x7FF]++] = entries[i];
+		}
+		entries.swap(scratch);
+	}
+}
+
+const std::vector<uint32_t>& DepthSorter::GetOrder()
+{
+	return order;
+}
+
+float DepthSorter::GetDepthSq(unsigned int index)
+{
+	return depths[index];
+}
+
+void DepthSorter::Reset()
+{
+	hasPreviousOrder = false;
+}
+
+const DepthSortStats& DepthSorter::GetStats()
+{
+	return stats;
+}
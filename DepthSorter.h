@@ -0,0 +1,58 @@
+#pragma once
+#include <DirectXMath.h>
+#include <stdint.h>
+#include <vector>
+
+// --------------------------------------------------------
+// Counters from the most recent DepthSorter::Sort
+// --------------------------------------------------------
+struct DepthSortStats
+{
+	unsigned int Count;
+	bool UsedInsertionSort;	// False when the radix sort ran (first frame, big camera move, or too many shifts)
+	unsigned int Shifts;	// Element moves made by the insertion sort, if it ran
+	double Microseconds;
+};
+
+// --------------------------------------------------------
+// Sorts positions back to front (farthest from the camera
+// first) by squared distance, so there's no square root per
+// entity and nothing but a float and an index gets moved.
+//
+// Frame to frame the order barely changes, so when the
+// camera moved less than coherentDistance since last frame,
+// last frame's order is re-sorted with an insertion sort,
+// which is close to linear on nearly-sorted input.  If that
+// turns out to need too many shifts, or the camera jumped,
+// it falls back to a 3-pass LSD radix sort on the float bits.
+// --------------------------------------------------------
+class DepthSorter
+{
+private:
+	struct SortEntry
+	{
+		float depthSq;
+		uint32_t index;
+	};
+
+	std::vector<SortEntry> entries;
+	std::vector<SortEntry> scratch;
+	std::vector<uint32_t> order;
+	std::vector<float> depths;		// Squared depth by original index
+	DirectX::XMFLOAT3 lastCameraPosition;
+	bool hasPreviousOrder;
+	float coherentDistance;
+	unsigned int maxShiftsPerElement;
+	DepthSortStats stats;
+
+	bool InsertionSort();
+	void RadixSort();
+public:
+	DepthSorter(float coherentDistance = 0.5f, unsigned int maxShiftsPerElement = 4);
+	//returns indices into positions, farthest first
+	const std::vector<uint32_t>& Sort(const DirectX::XMFLOAT3* positions, unsigned int count, DirectX::XMFLOAT3 cameraPosition);
+	const std::vector<uint32_t>& GetOrder();
+	float GetDepthSq(unsigned int index); //squared distance computed for positions[index] by the last Sort
+	void Reset(); //forget the previous order, e.g. after the set of positions changes
+	const DepthSortStats& GetStats();
+};
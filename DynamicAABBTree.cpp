@@ -0,0 +1,479 @@
+#include <float.h>
+#include <math.h>
+#include "DynamicAABBTree.h"
+
+using namespace DirectX;
+
+// Half the surface area of a box, which is all the cost heuristic needs
+static float BoxArea(const XMFLOAT3& min, const XMFLOAT3& max)
+{
+	float dx = max.x - min.x;
+	float dy = max.y - min.y;
+	float dz = max.z - min.z;
+	return dx * dy + dy * dz + dz * dx;
+}
+
+static float UnionArea(const XMFLOAT3& minA, const XMFLOAT3& maxA, const XMFLOAT3& minB, const XMFLOAT3& maxB)
+{
+	XMFLOAT3 min(fminf(minA.x, minB.x), fminf(minA.y, minB.y), fminf(minA.z, minB.z));
+	XMFLOAT3 max(fmaxf(maxA.x, maxB.x), fmaxf(maxA.y, maxB.y), fmaxf(maxA.z, maxB.z));
+	return BoxArea(min, max);
+}
+
+static bool Contains(const XMFLOAT3& outerMin, const XMFLOAT3& outerMax, const XMFLOAT3& innerMin, const XMFLOAT3& innerMax)
+{
+	return outerMin.x <= innerMin.x && outerMin.y <= innerMin.y && outerMin.z <= innerMin.z &&
+		innerMax.x <= outerMax.x && innerMax.y <= outerMax.y && innerMax.z <= outerMax.z;
+}
+
+// Returns -1 when the box is outside a plane, 1 when it's inside all of them, 0 when it straddles
+static int ClassifyBox(const Frustum& frustum, const XMFLOAT3& min, const XMFLOAT3& max)
+{
+	float cx = (min.x + max.x) * 0.5f, cy = (min.y + max.y) * 0.5f, cz = (min.z + max.z) * 0.5f;
+	float ex = (max.x - min.x) * 0.5f, ey = (max.y - min.y) * 0.5f, ez = (max.z - min.z) * 0.5f;
+	int result = 1;
+	for (int i = 0; i < 6; i++) {
+		XMFLOAT4 p = frustum.GetPlane(i);
+		float distance = p.x * cx + p.y * cy + p.z * cz + p.w;
+		float radius = fabsf(p.x) * ex + fabsf(p.y) * ey + fabsf(p.z) * ez;
+		if (distance < -radius) {
+			return -1;
+		}
+		if (distance < radius) {
+			result = 0;
+		}
+	}
+	return result;
+}
+
+static bool SphereOverlapsBox(const XMFLOAT4& sphere, const XMFLOAT3& min, const XMFLOAT3& max)
+{
+	float dx = fmaxf(fmaxf(min.x - sphere.x, 0.0f), sphere.x - max.x);
+	float dy = fmaxf(fmaxf(min.y - sphere.y, 0.0f), sphere.y - max.y);
+	float dz = fmaxf(fmaxf(min.z - sphere.z, 0.0f), sphere.z - max.z);
+	return dx * dx + dy * dy + dz * dz <= sphere.w * sphere.w;
+}
+
+// Slab test; invDirection may hold infinities for axis-aligned rays
+static bool RayOverlapsBox(const XMFLOAT3& origin, const XMFLOAT3& invDirection, float maxDistance, const XMFLOAT3& min, const XMFLOAT3& max)
+{
+	float t1 = (min.x - origin.x) * invDirection.x, t2 = (max.x - origin.x) * invDirection.x;
+	float tMin = fminf(t1, t2), tMax = fmaxf(t1, t2);
+	t1 = (min.y - origin.y) * invDirection.y; t2 = (max.y - origin.y) * invDirection.y;
+	tMin = fmaxf(tMin, fminf(t1, t2)); tMax = fminf(tMax, fmaxf(t1, t2));
+	t1 = (min.z - origin.z) * invDirection.z; t2 = (max.z - origin.z) * invDirection.z;
+	tMin = fmaxf(tMin, fminf(t1, t2)); tMax = fminf(tMax, fmaxf(t1, t2));
+	return tMax >= fmaxf(tMin, 0.0f) && tMin <= maxDistance;
+}
+
+DynamicAABBTree::DynamicAABBTree(float margin)
+{
+	this->margin = margin;
+	root = NULL_NODE;
+	freeList = NULL_NODE;
+	proxyCount = 0;
+}
+
+int DynamicAABBTree::AllocateNode()
+{
+	if (freeList == NULL_NODE) {
+		TreeNode node = {};
+		node.height = -1;
+		node.parent = NULL_NODE;
+		nodes.push_back(node);
+		freeList = (int)nodes.size() - 1;
+	}
+	int index = freeList;
+	freeList = nodes[index].parent;
+	nodes[index].parent = NULL_NODE;
+	nodes[index].child1 = NULL_NODE;
+	nodes[index].child2 = NULL_NODE;
+	nodes[index].height = 0;
+	nodes[index].userData = nullptr;
+	return index;
+}
+
+void DynamicAABBTree::FreeNode(int index)
+{
+	nodes[index].parent = freeList;
+	nodes[index].height = -1;
+	freeList = index;
+}
+
+int DynamicAABBTree::CreateProxy(const AABB& bounds, void* userData)
+{
+	int leaf = AllocateNode();
+	TreeNode& node = nodes[leaf];
+	node.min = XMFLOAT3(bounds.Center.x - bounds.Extents.x - margin, bounds.Center.y - bounds.Extents.y - margin, bounds.Center.z - bounds.Extents.z - margin);
+	node.max = XMFLOAT3(bounds.Center.x + bounds.Extents.x + margin, bounds.Center.y + bounds.Extents.y + margin, bounds.Center.z + bounds.Extents.z + margin);
+	node.userData = userData;
+	InsertLeaf(leaf);
+	proxyCount++;
+	return leaf;
+}
+
+void DynamicAABBTree::DestroyProxy(int proxyId)
+{
+	RemoveLeaf(proxyId);
+	FreeNode(proxyId);
+	proxyCount--;
+}
+
+bool DynamicAABBTree::MoveProxy(int proxyId, const AABB& bounds)
+{
+	XMFLOAT3 min(bounds.Center.x - bounds.Extents.x, bounds.Center.y - bounds.Extents.y, bounds.Center.z - bounds.Extents.z);
+	XMFLOAT3 max(bounds.Center.x + bounds.Extents.x, bounds.Center.y + bounds.Extents.y, bounds.Center.z + bounds.Extents.z);
+	TreeNode& leaf = nodes[proxyId];
+	if (Contains(leaf.min, leaf.max, min, max)) {
+		return false;
+	}
+
+	// Resizing the leaf in place would drag its old siblings along wherever it goes,
+	// so it's reinserted next to whatever is cheapest at its new position
+	RemoveLeaf(proxyId);
+	leaf.min = XMFLOAT3(min.x - margin, min.y - margin, min.z - margin);
+	leaf.max = XMFLOAT3(max.x + margin, max.y + margin, max.z + margin);
+	InsertLeaf(proxyId);
+	return true;
+}
+
+void* DynamicAABBTree::GetUserData(int proxyId)
+{
+	return nodes[proxyId].userData;
+}
+
+AABB DynamicAABBTree::GetFatBounds(int proxyId)
+{
+	const TreeNode& node = nodes[proxyId];
+	AABB bounds;
+	bounds.Center = XMFLOAT3((node.min.x + node.max.x) * 0.5f, (node.min.y + node.max.y) * 0.5f, (node.min.z + node.max.z) * 0.5f);
+	bounds.Extents = XMFLOAT3((node.max.x - node.min.x) * 0.5f, (node.max.y - node.min.y) * 0.5f, (node.max.z - node.min.z) * 0.5f);
+	return bounds;
+}
+
+void DynamicAABBTree::InsertLeaf(int leaf)
+{
+	if (root == NULL_NODE) {
+		root = leaf;
+		nodes[root].parent = NULL_NODE;
+		return;
+	}
+
+	// Walk down towards the cheapest sibling (surface area heuristic with inherited cost, as in Box2D)
+	XMFLOAT3 leafMin = nodes[leaf].min;
+	XMFLOAT3 leafMax = nodes[leaf].max;
+	int index = root;
+	while (!nodes[index].IsLeaf()) {
+		const TreeNode& node = nodes[index];
+		float area = BoxArea(node.min, node.max);
+		float combinedArea = UnionArea(node.min, node.max, leafMin, leafMax);
+		float cost = 2.0f * combinedArea;
+		float inheritanceCost = 2.0f * (combinedArea - area);
+
+		float childCost[2];
+		int children[2] = { node.child1, node.child2 };
+		for (int c = 0; c < 2; c++) {
+			const TreeNode& child = nodes[children[c]];
+			float unionArea = UnionArea(child.min, child.max, leafMin, leafMax);
+			childCost[c] = child.IsLeaf() ? unionArea + inheritanceCost : unionArea - BoxArea(child.min, child.max) + inheritanceCost;
+		}
+
+		if (cost < childCost[0] && cost < childCost[1]) {
+			break;
+		}
+		index = childCost[0] < childCost[1] ? children[0] : children[1];
+	}
+
+	int sibling = index;
+	int oldParent = nodes[sibling].parent;
+	int newParent = AllocateNode();
+	nodes[newParent].parent = oldParent;
+	nodes[newParent].child1 = sibling;
+	nodes[newParent].child2 = leaf;
+	nodes[sibling].parent = newParent;
+	nodes[leaf].parent = newParent;
+	if (oldParent == NULL_NODE) {
+		root = newParent;
+	}
+	else if (nodes[oldParent].child1 == sibling) {
+		nodes[oldParent].child1 = newParent;
+	}
+	else {
+		nodes[oldParent].child2 = newParent;
+	}
+	RefitAncestors(newParent);
+}
+
+void DynamicAABBTree::RemoveLeaf(int leaf)
+{
+	if (leaf == root) {
+		root = NULL_NODE;
+		return;
+	}
+
+	int parent = nodes[leaf].parent;
+	int grandParent = nodes[parent].parent;
+	int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+	if (grandParent == NULL_NODE) {
+		root = sibling;
+		nodes[sibling].parent = NULL_NODE;
+	}
+	else {
+		if (nodes[grandParent].child1 == parent) {
+			nodes[grandParent].child1 = sibling;
+		}
+		else {
+			nodes[grandParent].child2 = sibling;
+		}
+		nodes[sibling].parent = grandParent;
+		RefitAncestors(grandParent);
+	}
+	FreeNode(parent);
+}
+
+void DynamicAABBTree::SetBoxFromChildren(int index)
+{
+	TreeNode& node = nodes[index];
+	const TreeNode& a = nodes[node.child1];
+	const TreeNode& b = nodes[node.child2];
+	node.min = XMFLOAT3(fminf(a.min.x, b.min.x), fminf(a.min.y, b.min.y), fminf(a.min.z, b.min.z));
+	node.max = XMFLOAT3(fmaxf(a.max.x, b.max.x), fmaxf(a.max.y, b.max.y), fmaxf(a.max.z, b.max.z));
+	node.height = 1 + (a.height > b.height ? a.height : b.height);
+}
+
+void DynamicAABBTree::RefitAncestors(int index)
+{
+	while (index != NULL_NODE) {
+		SetBoxFromChildren(index);
+		Rotate(index);
+		index = nodes[index].parent;
+	}
+}
+
+// --------------------------------------------------------
+// Tries swapping one child of a node with one of its
+// grandchildren on the other side.  Of the (up to) four
+// swaps, the one that shrinks the intermediate node's area
+// the most is applied, if any of them shrink it at all.
+// --------------------------------------------------------
+void DynamicAABBTree::Rotate(int index)
+{
+	TreeNode& a = nodes[index];
+	if (a.height < 2) {
+		return;
+	}
+	int b = a.child1;
+	int c = a.child2;
+
+	float bestGain = 0.0f;
+	int bestChild = NULL_NODE;		// The child of a that moves down
+	int bestGrandchild = NULL_NODE;	// The grandchild that moves up
+	int pivot = NULL_NODE;			// The intermediate node whose children change
+
+	// Swap b with a child of c, so c ends up containing b and the remaining grandchild
+	if (!nodes[c].IsLeaf()) {
+		int f = nodes[c].child1, g = nodes[c].child2;
+		float area = BoxArea(nodes[c].min, nodes[c].max);
+		float gainF = area - UnionArea(nodes[b].min, nodes[b].max, nodes[g].min, nodes[g].max);
+		float gainG = area - UnionArea(nodes[b].min, nodes[b].max, nodes[f].min, nodes[f].max);
+		if (gainF > bestGain) { bestGain = gainF; bestChild = b; bestGrandchild = f; pivot = c; }
+		if (gainG > bestGain) { bestGain = gainG; bestChild = b; bestGrandchild = g; pivot = c; }
+	}
+	// Swap c with a child of b
+	if (!nodes[b].IsLeaf()) {
+		int d = nodes[b].child1, e = nodes[b].child2;
+		float area = BoxArea(nodes[b].min, nodes[b].max);
+		float gainD = area - UnionArea(nodes[c].min, nodes[c].max, nodes[e].min, nodes[e].max);
+		float gainE = area - UnionArea(nodes[c].min, nodes[c].max, nodes[d].min, nodes[d].max);
+		if (gainD > bestGain) { bestGain = gainD; bestChild = c; bestGrandchild = d; pivot = b; }
+		if (gainE > bestGain) { bestGain = gainE; bestChild = c; bestGrandchild = e; pivot = b; }
+	}
+	if (pivot == NULL_NODE) {
+		return;
+	}
+
+	// bestChild takes bestGrandchild's slot under pivot, and bestGrandchild takes bestChild's slot under a
+	if (a.child1 == bestChild) {
+		a.child1 = bestGrandchild;
+	}
+	else {
+		a.child2 = bestGrandchild;
+	}
+	if (nodes[pivot].child1 == bestGrandchild) {
+		nodes[pivot].child1 = bestChild;
+	}
+	else {
+		nodes[pivot].child2 = bestChild;
+	}
+	nodes[bestGrandchild].parent = index;
+	nodes[bestChild].parent = pivot;
+	SetBoxFromChildren(pivot);
+	SetBoxFromChildren(index);
+}
+
+void DynamicAABBTree::CollectLeaves(int index, std::vector<int>& proxies)
+{
+	size_t base = stack.size();
+	stack.push_back(index);
+	while (stack.size() > base) {
+		int current = stack.back();
+		stack.pop_back();
+		if (nodes[current].IsLeaf()) {
+			proxies.push_back(current);
+		}
+		else {
+			stack.push_back(nodes[current].child1);
+			stack.push_back(nodes[current].child2);
+		}
+	}
+}
+
+void DynamicAABBTree::QueryFrustum(const Frustum& frustum, std::vector<int>& proxies)
+{
+	if (root == NULL_NODE) {
+		return;
+	}
+	stack.clear();
+	stack.push_back(root);
+	while (!stack.empty()) {
+		int index = stack.back();
+		stack.pop_back();
+		const TreeNode& node = nodes[index];
+		int classification = ClassifyBox(frustum, node.min, node.max);
+		if (classification < 0) {
+			continue;
+		}
+		if (classification > 0 || node.IsLeaf()) {
+			CollectLeaves(index, proxies); //fully inside, no need to test anything below
+		}
+		else {
+			stack.push_back(node.child1);
+			stack.push_back(node.child2);
+		}
+	}
+}
+
+void DynamicAABBTree::QuerySphere(XMFLOAT3 center, float radius, std::vector<int>& proxies)
+{
+	XMFLOAT4 sphere(center.x, center.y, center.z, radius);
+	QuerySpheres(&sphere, 1, proxies, singleOffsets);
+}
+
+void DynamicAABBTree::QueryRay(XMFLOAT3 origin, XMFLOAT3 direction, float maxDistance, std::vector<int>& proxies)
+{
+	QueryRays(&origin, &direction, &maxDistance, 1, proxies, singleOffsets);
+}
+
+// --------------------------------------------------------
+// Shared traversal for the batched queries.  Each stack
+// entry carries the mask of queries that reached that node,
+// so a subtree is visited once no matter how many of the
+// (up to 32) queries in flight overlap it
+// --------------------------------------------------------
+template <typename OverlapTest>
+void DynamicAABBTree::QueryBatch(unsigned int count, OverlapTest overlaps, std::vector<int>& proxies, std::vector<unsigned int>& offsets)
+{
+	if (batchResults.size() < count) {
+		batchResults.resize(count);
+	}
+	for (unsigned int q = 0; q < count; q++) {
+		batchResults[q].clear();
+	}
+
+	for (unsigned int first = 0; first < count && root != NULL_NODE; first += 32) {
+		unsigned int batchSize = count - first < 32 ? count - first : 32;
+		stack.clear();
+		maskStack.clear();
+		stack.push_back(root);
+		maskStack.push_back(batchSize == 32 ? 0xFFFFFFFFu : (1u << batchSize) - 1);
+		while (!stack.empty()) {
+			int index = stack.back();
+			unsigned int mask = maskStack.back();
+			stack.pop_back();
+			maskStack.pop_back();
+
+			const TreeNode& node = nodes[index];
+			unsigned int survivors = 0;
+			for (unsigned int bit = 0; bit < batchSize; bit++) {
+				if ((mask & (1u << bit)) && overlaps(first + bit, node.min, node.max)) {
+					survivors |= 1u << bit;
+				}
+			}
+			if (!survivors) {
+				continue;
+			}
+			if (node.IsLeaf()) {
+				for (unsigned int bit = 0; bit < batchSize; bit++) {
+					if (survivors & (1u << bit)) {
+						batchResults[first + bit].push_back(index);
+					}
+				}
+			}
+			else {
+				stack.push_back(node.child1);
+				maskStack.push_back(survivors);
+				stack.push_back(node.child2);
+				maskStack.push_back(survivors);
+			}
+		}
+	}
+
+	offsets.resize(count + 1);
+	for (unsigned int q = 0; q < count; q++) {
+		offsets[q] = (unsigned int)proxies.size();
+		proxies.insert(proxies.end(), batchResults[q].begin(), batchResults[q].end());
+	}
+	offsets[count] = (unsigned int)proxies.size();
+}
+
+void DynamicAABBTree::QueryFrustums(const Frustum* frustums, unsigned int count, std::vector<int>& proxies, std::vector<unsigned int>& offsets)
+{
+	QueryBatch(count, [&](unsigned int q, const XMFLOAT3& min, const XMFLOAT3& max) -> bool {
+		return ClassifyBox(frustums[q], min, max) >= 0;
+	}, proxies, offsets);
+}
+
+void DynamicAABBTree::QuerySpheres(const XMFLOAT4* spheres, unsigned int count, std::vector<int>& proxies, std::vector<unsigned int>& offsets)
+{
+	QueryBatch(count, [&](unsigned int q, const XMFLOAT3& min, const XMFLOAT3& max) -> bool {
+		return SphereOverlapsBox(spheres[q], min, max);
+	}, proxies, offsets);
+}
+
+void DynamicAABBTree::QueryRays(const XMFLOAT3* origins, const XMFLOAT3* directions, const float* maxDistances, unsigned int count, std::vector<int>& proxies, std::vector<unsigned int>& offsets)
+{
+	invDirections.resize(count);
+	for (unsigned int q = 0; q < count; q++) {
+		invDirections[q] = XMFLOAT3(1.0f / directions[q].x, 1.0f / directions[q].y, 1.0f / directions[q].z);
+	}
+	QueryBatch(count, [&](unsigned int q, const XMFLOAT3& min, const XMFLOAT3& max) -> bool {
+		return RayOverlapsBox(origins[q], invDirections[q], maxDistances[q], min, max);
+	}, proxies, offsets);
+}
+
+int DynamicAABBTree::GetProxyCount()
+{
+	return proxyCount;
+}
+
+int DynamicAABBTree::GetHeight()
+{
+	return root == NULL_NODE ? 0 : nodes[root].height;
+}
+
+int DynamicAABBTree::GetProxyCapacity()
+{
+	return (int)nodes.size();
+}
+
+float DynamicAABBTree::GetTotalArea()
+{
+	float total = 0.0f;
+	for (int i = 0; i < nodes.size(); i++) {
+		if (nodes[i].height > 0) {
+			total += BoxArea(nodes[i].min, nodes[i].max);
+		}
+	}
+	return total;
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+#include "Bounds.h"
+#include "Frustum.h"
+#include "ISpatialIndex.h"
+
+#define NULL_NODE -1
+
+// --------------------------------------------------------
+// A dynamic bounding volume hierarchy over entity bounds.
+//
+// Leaves hold "fat" boxes (the real bounds plus a margin),
+// so small movements don't touch the tree at all.  When an
+// entity leaves its fat box, the leaf is taken out and
+// reinserted with a new fat box where it's cheapest, and
+// the ancestors on both paths are refit in place, each
+// getting a chance to rotate with a grandchild if that
+// lowers the surface area (and so the expected query cost)
+// of the subtree.  Nothing is ever rebuilt wholesale.
+//
+// Proxies are identified by the int returned from
+// CreateProxy, and carry an opaque userData pointer.
+// On top of ISpatialIndex it offers ray and batched queries.
+// --------------------------------------------------------
+class DynamicAABBTree : public ISpatialIndex
+{
+private:
+	struct TreeNode
+	{
+		DirectX::XMFLOAT3 min;
+		DirectX::XMFLOAT3 max;
+		void* userData;
+		int parent;	// Doubles as the next link while the node is on the free list
+		int child1;
+		int child2;
+		int height;	// 0 for leaves, -1 for free nodes
+
+		bool IsLeaf() const { return child1 == NULL_NODE; }
+	};
+
+	std::vector<TreeNode> nodes;
+	int root;
+	int freeList;
+	int proxyCount;
+	float margin;
+
+	// Scratch space reused between queries so steady-state queries don't allocate
+	std::vector<int> stack;
+	std::vector<unsigned int> maskStack;
+	std::vector<std::vector<int>> batchResults;
+	std::vector<unsigned int> singleOffsets;	// The offsets single queries don't hand back
+	std::vector<DirectX::XMFLOAT3> invDirections;	// Per ray, for the slab tests
+
+	int AllocateNode();
+	void FreeNode(int index);
+	void InsertLeaf(int leaf);
+	void RemoveLeaf(int leaf);
+	void RefitAncestors(int index);
+	void Rotate(int index);
+	void SetBoxFromChildren(int index);
+	void CollectLeaves(int index, std::vector<int>& proxies);
+	template <typename OverlapTest> void QueryBatch(unsigned int count, OverlapTest overlaps, std::vector<int>& proxies, std::vector<unsigned int>& offsets);
+public:
+	DynamicAABBTree(float margin = 0.1f);
+
+	int CreateProxy(const AABB& bounds, void* userData);
+	void DestroyProxy(int proxyId);
+	//returns true if the proxy outgrew its fat box and was reinserted
+	bool MoveProxy(int proxyId, const AABB& bounds);
+	void* GetUserData(int proxyId);
+	AABB GetFatBounds(int proxyId);
+
+	// Single queries append the ids of every proxy whose fat box passes the test
+	void QueryFrustum(const Frustum& frustum, std::vector<int>& proxies);
+	void QuerySphere(DirectX::XMFLOAT3 center, float radius, std::vector<int>& proxies);
+	void QueryRay(DirectX::XMFLOAT3 origin, DirectX::XMFLOAT3 direction, float maxDistance, std::vector<int>& proxies);
+
+	// Batched queries walk the tree once per 32 queries, carrying a bitmask of the queries still alive
+	// Results for query i are proxies[offsets[i]] up to proxies[offsets[i + 1]]
+	void QueryFrustums(const Frustum* frustums, unsigned int count, std::vector<int>& proxies, std::vector<unsigned int>& offsets);
+	void QuerySpheres(const DirectX::XMFLOAT4* spheres, unsigned int count, std::vector<int>& proxies, std::vector<unsigned int>& offsets); //xyz center, w radius
+	void QueryRays(const DirectX::XMFLOAT3* origins, const DirectX::XMFLOAT3* directions, const float* maxDistances, unsigned int count, std::vector<int>& proxies, std::vector<unsigned int>& offsets);
+
+	int GetProxyCount();
+	int GetHeight();
+	int GetProxyCapacity();
+	float GetTotalArea(); //sum of internal node surface areas, a rough measure of tree quality
+};
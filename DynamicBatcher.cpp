@@ -0,0 +1,313 @@
+#include <chrono>
+#include <string.h>
+#include "DynamicBatcher.h"
+#include "Profiler.h"
+
+using namespace DirectX;
+
+DynamicBatcher::DynamicBatcher(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context,
+	unsigned int ringVertexCapacity, unsigned int ringIndexCapacity)
+{
+	this->device = device;
+	this->context = context;
+	this->ringVertexCapacity = ringVertexCapacity;
+	this->ringIndexCapacity = ringIndexCapacity;
+	ringVertexOffset = 0;
+	ringIndexOffset = 0;
+	maxMeshVertices = 300;
+	maxBatchVertices = 32768;
+	materialMatch = DYNAMIC_BATCH_MATCH_MATERIAL;
+	jobs = nullptr;
+	minVerticesPerJob = 8192;
+	stats = {};
+
+	D3D11_BUFFER_DESC vbd = {};
+	vbd.Usage = D3D11_USAGE_DYNAMIC;
+	vbd.ByteWidth = sizeof(Vertex) * ringVertexCapacity;
+	vbd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	vbd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	device->CreateBuffer(&vbd, 0, vertexRing.GetAddressOf());
+
+	D3D11_BUFFER_DESC ibd = {};
+	ibd.Usage = D3D11_USAGE_DYNAMIC;
+	ibd.ByteWidth = sizeof(unsigned int) * ringIndexCapacity;
+	ibd.BindFlags = D3D11_BIND_INDEX_BUFFER;
+	ibd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	device->CreateBuffer(&ibd, 0, indexRing.GetAddressOf());
+}
+
+void DynamicBatcher::SetMaxMeshVertices(unsigned int vertices)
+{
+	maxMeshVertices = vertices;
+}
+
+void DynamicBatcher::SetMaxBatchVertices(unsigned int vertices)
+{
+	maxBatchVertices = vertices > 0 ? vertices : 1;
+}
+
+void DynamicBatcher::SetMaterialMatch(int match)
+{
+	materialMatch = match;
+}
+
+void DynamicBatcher::SetJobSystem(JobSystem* jobs)
+{
+	this->jobs = jobs;
+}
+
+void DynamicBatcher::SetMinVerticesPerJob(unsigned int vertices)
+{
+	minVerticesPerJob = vertices > 0 ? vertices : 1;
+}
+
+void DynamicBatcher::Clear()
+{
+	pending.clear();
+	batchEntities.clear();
+	batches.clear();
+	stats = {};
+}
+
+bool DynamicBatcher::Add(const RenderObject* object)
+{
+	Mesh* mesh = object->RenderMesh;
+	size_t vertexCount = mesh->GetVertices().size();
+	size_t indexCount = mesh->GetIndices().size();
+	if (vertexCount > maxMeshVertices || vertexCount > ringVertexCapacity || indexCount > ringIndexCapacity) {
+		stats.Rejected++;
+		return false;
+	}
+	pending.push_back(object);
+	return true;
+}
+
+// Materials are only compared the first time they show up in a frame
+unsigned int DynamicBatcher::FindGroup(Material* material)
+{
+	std::unordered_map<Material*, unsigned int>::iterator found = materialGroups.find(material);
+	if (found != materialGroups.end()) {
+		return found->second;
+	}
+	unsigned int group = (unsigned int)groupMaterials.size();
+	if (materialMatch == DYNAMIC_BATCH_MATCH_EQUIVALENT) {
+		for (unsigned int g = 0; g < groupMaterials.size(); g++) {
+			if (groupMaterials[g]->IsEquivalentTo(material)) {
+				group = g;
+				break;
+			}
+		}
+	}
+	if (group == groupMaterials.size()) {
+		groupMaterials.push_back(material);
+	}
+	materialGroups.insert({ material, group });
+	return group;
+}
+
+// --------------------------------------------------------
+// Buckets the pending entities by material group with a
+// counting sort (so each group keeps the order they were
+// added in), then cuts each group into batches no bigger
+// than maxBatchVertices or the rings
+// --------------------------------------------------------
+void DynamicBatcher::Build()
+{
+	PROFILE_FUNCTION();
+	materialGroups.clear();
+	groupMaterials.clear();
+	batchEntities.clear();
+	batches.clear();
+	stats.Entities = (unsigned int)pending.size();
+	stats.Vertices = 0;
+	stats.Indices = 0;
+
+	entityGroups.resize(pending.size());
+	for (int i = 0; i < pending.size(); ++i) {
+		entityGroups[i] = FindGroup(pending[i]->RenderMaterial);
+	}
+
+	groupFill.assign(groupMaterials.size() + 1, 0);
+	for (int i = 0; i < pending.size(); ++i) {
+		groupFill[entityGroups[i] + 1]++;
+	}
+	for (int g = 1; g < groupFill.size(); ++g) {
+		groupFill[g] += groupFill[g - 1];
+	}
+	batchEntities.resize(pending.size());
+	for (int i = 0; i < pending.size(); ++i) {
+		BatchEntity& entity = batchEntities[groupFill[entityGroups[i]]++];
+		entity.mesh = pending[i]->RenderMesh;
+		entity.world = pending[i]->World;
+		entity.batch = entityGroups[i]; //the group for now, replaced by the batch below
+	}
+
+	unsigned int batchVertexLimit = maxBatchVertices < ringVertexCapacity ? maxBatchVertices : ringVertexCapacity;
+	for (int e = 0; e < batchEntities.size(); ++e) {
+		BatchEntity& entity = batchEntities[e];
+		Material* material = groupMaterials[entity.batch];
+		unsigned int vertexCount = (unsigned int)entity.mesh->GetVertices().size();
+		unsigned int indexCount = (unsigned int)entity.mesh->GetIndices().size();
+		if (batches.empty() ||
+			batches.back().material != material ||
+			batches.back().vertexCount + vertexCount > batchVertexLimit ||
+			batches.back().indexCount + indexCount > ringIndexCapacity) {
+			Batch batch = {};
+			batch.material = material;
+			batch.firstEntity = e;
+			batches.push_back(batch);
+		}
+		Batch& batch = batches.back();
+		entity.batch = (unsigned int)batches.size() - 1;
+		entity.firstVertex = batch.vertexCount;
+		entity.firstIndex = batch.indexCount;
+		batch.entityCount++;
+		batch.vertexCount += vertexCount;
+		batch.indexCount += indexCount;
+		stats.Vertices += vertexCount;
+		stats.Indices += indexCount;
+	}
+	stats.Batches = (unsigned int)batches.size();
+}
+
+// --------------------------------------------------------
+// Transforms one mesh into merged geometry.  The position
+// and normal/tangent passes use the strided stream
+// transforms, so the interleaved vertices go through SSE
+// without being split into separate arrays first.
+// --------------------------------------------------------
+void DynamicBatcher::MergeMesh(const Vertex* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount,
+	const XMFLOAT4X4& world, unsigned int baseVertex, Vertex* outVertices, unsigned int* outIndices)
+{
+	XMMATRIX worldMatrix = XMLoadFloat4x4(&world);
+	// Normals stay perpendicular to their surface under non-uniform scale only through the inverse transpose,
+	// tangents lie along the surface and take the world matrix like positions
+	XMMATRIX worldInvTranspose = XMMatrixInverse(nullptr, XMMatrixTranspose(worldMatrix));
+	// Copy first for the UVs, then overwrite the transformed members in place
+	memcpy(outVertices, vertices, sizeof(Vertex) * vertexCount);
+	XMVector3TransformCoordStream(&outVertices[0].Position, sizeof(Vertex), &vertices[0].Position, sizeof(Vertex), vertexCount, worldMatrix);
+	XMVector3TransformNormalStream(&outVertices[0].Normal, sizeof(Vertex), &vertices[0].Normal, sizeof(Vertex), vertexCount, worldInvTranspose);
+	XMVector3TransformNormalStream(&outVertices[0].Tangent, sizeof(Vertex), &vertices[0].Tangent, sizeof(Vertex), vertexCount, worldMatrix);
+	for (unsigned int i = 0; i < indexCount; i++) {
+		outIndices[i] = indices[i] + baseVertex;
+	}
+}
+
+// Merges batchEntities [firstEntity, lastEntity) into the mapped rings, called from jobs
+void DynamicBatcher::MergeRange(unsigned int firstEntity, unsigned int lastEntity, Vertex* vertexBase, unsigned int* indexBase)
+{
+	for (unsigned int e = firstEntity; e < lastEntity; e++) {
+		const BatchEntity& entity = batchEntities[e];
+		const Batch& batch = batches[entity.batch];
+		const std::vector<Vertex>& vertices = entity.mesh->GetVertices();
+		const std::vector<unsigned int>& indices = entity.mesh->GetIndices();
+		if (vertices.empty() || indices.empty()) {
+			continue;
+		}
+		MergeMesh(&vertices[0], (unsigned int)vertices.size(), &indices[0], (unsigned int)indices.size(), entity.world,
+			entity.firstVertex, vertexBase + batch.ringVertex + entity.firstVertex, indexBase + batch.ringIndex + entity.firstIndex);
+	}
+}
+
+void DynamicBatcher::Submit(std::shared_ptr<Camera> camera)
+{
+	if (!vertexRing || !indexRing) {
+		return;
+	}
+
+	unsigned int b = 0;
+	while (b < batches.size()) {
+		// Restart the rings if the next batch doesn't fit in what's left of them
+		bool discard = ringVertexOffset == 0 && ringIndexOffset == 0;
+		if (ringVertexOffset + batches[b].vertexCount > ringVertexCapacity ||
+			ringIndexOffset + batches[b].indexCount > ringIndexCapacity) {
+			ringVertexOffset = 0;
+			ringIndexOffset = 0;
+			discard = true;
+			stats.RingWraps++;
+		}
+
+		// Place as many batches as fit, they all get merged under one Map
+		unsigned int end = b;
+		while (end < batches.size() &&
+			ringVertexOffset + batches[end].vertexCount <= ringVertexCapacity &&
+			ringIndexOffset + batches[end].indexCount <= ringIndexCapacity) {
+			batches[end].ringVertex = ringVertexOffset;
+			batches[end].ringIndex = ringIndexOffset;
+			ringVertexOffset += batches[end].vertexCount;
+			ringIndexOffset += batches[end].indexCount;
+			end++;
+		}
+
+		D3D11_MAP mapType = discard ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE;
+		D3D11_MAPPED_SUBRESOURCE mappedVertices = {};
+		D3D11_MAPPED_SUBRESOURCE mappedIndices = {};
+		if (FAILED(context->Map(vertexRing.Get(), 0, mapType, 0, &mappedVertices))) {
+			return;
+		}
+		if (FAILED(context->Map(indexRing.Get(), 0, mapType, 0, &mappedIndices))) {
+			context->Unmap(vertexRing.Get(), 0);
+			return;
+		}
+
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		Vertex* vertexBase = (Vertex*)mappedVertices.pData;
+		unsigned int* indexBase = (unsigned int*)mappedIndices.pData;
+		unsigned int firstEntity = batches[b].firstEntity;
+		unsigned int lastEntity = batches[end - 1].firstEntity + batches[end - 1].entityCount;
+		unsigned int vertices = ringVertexOffset - batches[b].ringVertex;
+		unsigned int entities = lastEntity - firstEntity;
+		unsigned int ranges = vertices / minVerticesPerJob;
+		ranges = ranges < entities ? ranges : entities;
+		if (!jobs || ranges <= 1) {
+			MergeRange(firstEntity, lastEntity, vertexBase, indexBase);
+		}
+		else {
+			// Even entity counts per job is close enough, everything in here is small by definition
+			jobs->ParallelFor(entities, (entities + ranges - 1) / ranges, [&](unsigned int first, unsigned int last) {
+				MergeRange(firstEntity + first, firstEntity + last, vertexBase, indexBase);
+			});
+		}
+		std::chrono::high_resolution_clock::time_point finish = std::chrono::high_resolution_clock::now();
+		stats.MergeMicroseconds += std::chrono::duration<double, std::micro>(finish - start).count();
+
+		context->Unmap(indexRing.Get(), 0);
+		context->Unmap(vertexRing.Get(), 0);
+
+		UINT stride = sizeof(Vertex);
+		UINT offset = 0;
+		context->IASetVertexBuffers(0, 1, vertexRing.GetAddressOf(), &stride, &offset);
+		context->IASetIndexBuffer(indexRing.Get(), DXGI_FORMAT_R32_UINT, 0);
+		for (unsigned int i = b; i < end; i++) {
+			DrawBatch(batches[i], camera);
+		}
+		b = end;
+	}
+}
+
+void DynamicBatcher::DrawBatch(const Batch& batch, std::shared_ptr<Camera> camera)
+{
+	// The vertices are already in world space
+	XMFLOAT4X4 identity;
+	XMStoreFloat4x4(&identity, XMMatrixIdentity());
+
+	std::shared_ptr<SimpleVertexShader> vs = batch.material->GetVertexShader();
+	std::shared_ptr<SimplePixelShader> ps = batch.material->GetPixelShader();
+	vs->SetShader();
+	ps->SetShader();
+	vs->SetMatrix4x4("world", identity);
+	vs->SetMatrix4x4("worldInvTranspose", identity);
+	vs->SetMatrix4x4("view", camera->GetViewMatrix());
+	vs->SetMatrix4x4("projection", camera->GetProjectionMatrix());
+	vs->CopyAllBufferData();
+	batch.material->BindResources();
+	ps->SetFloat4("colorTint", batch.material->GetColorTint());
+	ps->CopyAllBufferData();
+
+	context->DrawIndexed(batch.indexCount, batch.ringIndex, batch.ringVertex);
+}
+
+const DynamicBatchStats& DynamicBatcher::GetStats()
+{
+	return stats;
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <DirectXMath.h>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "Camera.h"
+#include "JobSystem.h"
+#include "RenderObject.h"
+#include "Vertex.h"
+
+#define DYNAMIC_BATCH_MATCH_MATERIAL 0		// Only entities with the very same Material merge
+#define DYNAMIC_BATCH_MATCH_EQUIVALENT 1	// Different Materials merge too, if Material::IsEquivalentTo says so
+
+// --------------------------------------------------------
+// Per-frame counters from DynamicBatcher
+// --------------------------------------------------------
+struct DynamicBatchStats
+{
+	unsigned int Entities;
+	unsigned int Rejected;		// Entities Add turned down for having too many vertices
+	unsigned int Batches;
+	unsigned int Vertices;
+	unsigned int Indices;
+	unsigned int RingWraps;
+	double MergeMicroseconds;
+};
+
+// --------------------------------------------------------
+// Merges small meshes that share a material into one draw
+// by transforming their vertices into world space on the
+// CPU, every frame.  That's the fallback for geometry that
+// can't be instanced because the meshes all differ (cubes,
+// quads, debris...), so it only pays off for tiny meshes,
+// hence the vertex count limit in Add.
+//
+// The merged vertices and indices are written straight into
+// a pair of dynamic ring buffers: each batch is appended
+// with MAP_WRITE_NO_OVERWRITE, and the rings are discarded
+// and restarted only when they fill up.  The transform
+// itself is DirectXMath's SIMD stream transform, split
+// into jobs once a frame has enough vertices.
+// --------------------------------------------------------
+class DynamicBatcher
+{
+private:
+	struct BatchEntity
+	{
+		Mesh* mesh;
+		DirectX::XMFLOAT4X4 world;
+		unsigned int batch;
+		unsigned int firstVertex;	// Offsets inside the batch
+		unsigned int firstIndex;
+	};
+
+	struct Batch
+	{
+		Material* material;
+		unsigned int firstEntity;	// Range in batchEntities
+		unsigned int entityCount;
+		unsigned int vertexCount;
+		unsigned int indexCount;
+		unsigned int ringVertex;	// Where the batch landed in the rings this frame
+		unsigned int ringIndex;
+	};
+
+	Microsoft::WRL::ComPtr<ID3D11Device> device;
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> context;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> vertexRing;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> indexRing;
+	unsigned int ringVertexCapacity;
+	unsigned int ringIndexCapacity;
+	unsigned int ringVertexOffset;
+	unsigned int ringIndexOffset;
+
+	unsigned int maxMeshVertices;
+	unsigned int maxBatchVertices;
+	int materialMatch;
+	JobSystem* jobs;
+	unsigned int minVerticesPerJob;
+
+	std::vector<const RenderObject*> pending;
+	std::unordered_map<Material*, unsigned int> materialGroups;	// Every material seen this frame, to its group
+	std::vector<Material*> groupMaterials;
+	std::vector<unsigned int> entityGroups;
+	std::vector<unsigned int> groupFill;
+	std::vector<BatchEntity> batchEntities;
+	std::vector<Batch> batches;
+	DynamicBatchStats stats;
+
+	unsigned int FindGroup(Material* material);
+	void MergeRange(unsigned int firstEntity, unsigned int lastEntity, Vertex* vertexBase, unsigned int* indexBase);
+	void DrawBatch(const Batch& batch, std::shared_ptr<Camera> camera);
+public:
+	// The rings hold this many vertices and indices, and no single batch will ever be bigger
+	DynamicBatcher(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context,
+		unsigned int ringVertexCapacity = 65536, unsigned int ringIndexCapacity = 196608);
+
+	void SetMaxMeshVertices(unsigned int vertices);	// Meshes with more vertices than this are turned down by Add
+	void SetMaxBatchVertices(unsigned int vertices);	// A group bigger than this is split into several draws
+	void SetMaterialMatch(int match);					// One of the DYNAMIC_BATCH_MATCH_ defines
+	void SetJobSystem(JobSystem* jobs);					// Null merges everything on the calling thread
+	void SetMinVerticesPerJob(unsigned int vertices);
+
+	void Clear();
+	//false if the object's mesh is too big to batch, draw it some other way
+	bool Add(const RenderObject* object);
+	//groups everything added since Clear, in the order added
+	void Build();
+	//merges the groups into the rings and draws them, one DrawIndexed per batch
+	void Submit(std::shared_ptr<Camera> camera);
+	const DynamicBatchStats& GetStats();
+
+	// The merge kernel: writes the mesh's vertices transformed by world, normals by its inverse transpose,
+	// and its indices offset by baseVertex.  Normals and tangents aren't renormalized, the pixel shaders
+	// already do that
+	static void MergeMesh(const Vertex* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount,
+		const DirectX::XMFLOAT4X4& world, unsigned int baseVertex, Vertex* outVertices, unsigned int* outIndices);
+};
@@ -0,0 +1,296 @@
+#include "EntityWorld.h"
+
+using namespace DirectX;
+
+EntityWorld::EntityWorld()
+{
+	entityCount = 0;
+}
+
+int EntityWorld::FindOrCreateArchetype(unsigned int mask)
+{
+	// There are only ever a handful of archetypes, a linear search beats hashing
+	for (int i = 0; i < archetypes.size(); ++i) {
+		if (archetypes[i].Mask == mask) {
+			return i;
+		}
+	}
+	Archetype archetype;
+	archetype.Mask = mask;
+	archetypes.push_back(archetype);
+	return (int)archetypes.size() - 1;
+}
+
+uint32_t EntityWorld::AddRow(int archetypeIndex, EntityHandle handle)
+{
+	Archetype& archetype = archetypes[archetypeIndex];
+	archetype.Entities.push_back(handle);
+	if (archetype.Mask & COMPONENT_TRANSFORM) {
+		TransformComponent transform = {};
+		transform.Scale = XMFLOAT3(1, 1, 1);
+		transform.Dirty = true;
+		XMStoreFloat4x4(&transform.World, XMMatrixIdentity());
+		archetype.Transforms.push_back(transform);
+	}
+	if (archetype.Mask & COMPONENT_RENDERABLE) {
+		RenderableComponent renderable = {};
+		renderable.SpatialProxy = -1;
+		archetype.Renderables.push_back(renderable);
+	}
+	if (archetype.Mask & COMPONENT_BOUNDS) {
+		BoundsComponent bounds = {};
+		archetype.Bounds.push_back(bounds);
+	}
+	return (uint32_t)archetype.Entities.size() - 1;
+}
+
+// Swap-remove: the archetype's last row moves into the hole
+void EntityWorld::RemoveRow(int archetypeIndex, uint32_t row)
+{
+	Archetype& archetype = archetypes[archetypeIndex];
+	uint32_t last = (uint32_t)archetype.Entities.size() - 1;
+	if (row != last) {
+		archetype.Entities[row] = archetype.Entities[last];
+		if (archetype.Mask & COMPONENT_TRANSFORM) {
+			archetype.Transforms[row] = archetype.Transforms[last];
+		}
+		if (archetype.Mask & COMPONENT_RENDERABLE) {
+			archetype.Renderables[row] = archetype.Renderables[last];
+		}
+		if (archetype.Mask & COMPONENT_BOUNDS) {
+			archetype.Bounds[row] = archetype.Bounds[last];
+		}
+		records[archetype.Entities[row].Index].row = row;
+	}
+	archetype.Entities.pop_back();
+	if (archetype.Mask & COMPONENT_TRANSFORM) {
+		archetype.Transforms.pop_back();
+	}
+	if (archetype.Mask & COMPONENT_RENDERABLE) {
+		archetype.Renderables.pop_back();
+	}
+	if (archetype.Mask & COMPONENT_BOUNDS) {
+		archetype.Bounds.pop_back();
+	}
+}
+
+const EntityWorld::EntityRecord* EntityWorld::Find(EntityHandle handle) const
+{
+	if (handle.Index >= records.size()) {
+		return nullptr;
+	}
+	const EntityRecord& record = records[handle.Index];
+	if (record.generation != handle.Generation || record.archetype < 0) {
+		return nullptr;
+	}
+	return &record;
+}
+
+EntityHandle EntityWorld::Create(unsigned int componentMask)
+{
+	EntityHandle handle;
+	if (!freeSlots.empty()) {
+		handle.Index = freeSlots.back();
+		freeSlots.pop_back();
+	}
+	else {
+		handle.Index = (uint32_t)records.size();
+		EntityRecord record = {};
+		record.archetype = -1;
+		records.push_back(record);
+	}
+	EntityRecord& record = records[handle.Index];
+	handle.Generation = record.generation;
+	record.archetype = FindOrCreateArchetype(componentMask);
+	record.row = AddRow(record.archetype, handle);
+	entityCount++;
+	return handle;
+}
+
+void EntityWorld::Destroy(EntityHandle handle)
+{
+	if (!Find(handle)) {
+		return;
+	}
+	EntityRecord& record = records[handle.Index];
+	RemoveRow(record.archetype, record.row);
+	record.archetype = -1;
+	record.generation++;
+	freeSlots.push_back(handle.Index);
+	entityCount--;
+}
+
+bool EntityWorld::IsAlive(EntityHandle handle) const
+{
+	return Find(handle) != nullptr;
+}
+
+void EntityWorld::Clear()
+{
+	// Bump every live slot's generation so old handles stay dead
+	for (uint32_t i = 0; i < records.size(); i++) {
+		if (records[i].archetype >= 0) {
+			records[i].archetype = -1;
+			records[i].generation++;
+			freeSlots.push_back(i);
+		}
+	}
+	for (int i = 0; i < archetypes.size(); ++i) {
+		archetypes[i].Entities.clear();
+		archetypes[i].Transforms.clear();
+		archetypes[i].Renderables.clear();
+		archetypes[i].Bounds.clear();
+	}
+	entityCount = 0;
+}
+
+void EntityWorld::AddComponents(EntityHandle handle, unsigned int componentMask)
+{
+	const EntityRecord* found = Find(handle);
+	if (!found) {
+		return;
+	}
+	unsigned int oldMask = archetypes[found->archetype].Mask;
+	unsigned int newMask = oldMask | componentMask;
+	if (newMask == oldMask) {
+		return;
+	}
+
+	EntityRecord& record = records[handle.Index];
+	int oldArchetype = record.archetype;
+	uint32_t oldRow = record.row;
+	int newArchetype = FindOrCreateArchetype(newMask); //may reallocate archetypes, so no references across this
+	uint32_t newRow = AddRow(newArchetype, handle);
+
+	Archetype& from = archetypes[oldArchetype];
+	Archetype& to = archetypes[newArchetype];
+	if (oldMask & COMPONENT_TRANSFORM) {
+		to.Transforms[newRow] = from.Transforms[oldRow];
+	}
+	if (oldMask & COMPONENT_RENDERABLE) {
+		to.Renderables[newRow] = from.Renderables[oldRow];
+	}
+	if (oldMask & COMPONENT_BOUNDS) {
+		to.Bounds[newRow] = from.Bounds[oldRow];
+	}
+	RemoveRow(oldArchetype, oldRow);
+	record.archetype = newArchetype;
+	record.row = newRow;
+}
+
+void EntityWorld::RemoveComponents(EntityHandle handle, unsigned int componentMask)
+{
+	const EntityRecord* found = Find(handle);
+	if (!found) {
+		return;
+	}
+	unsigned int oldMask = archetypes[found->archetype].Mask;
+	unsigned int newMask = oldMask & ~componentMask;
+	if (newMask == oldMask) {
+		return;
+	}
+
+	EntityRecord& record = records[handle.Index];
+	int oldArchetype = record.archetype;
+	uint32_t oldRow = record.row;
+	int newArchetype = FindOrCreateArchetype(newMask);
+	uint32_t newRow = AddRow(newArchetype, handle);
+
+	Archetype& from = archetypes[oldArchetype];
+	Archetype& to = archetypes[newArchetype];
+	if (newMask & COMPONENT_TRANSFORM) {
+		to.Transforms[newRow] = from.Transforms[oldRow];
+	}
+	if (newMask & COMPONENT_RENDERABLE) {
+		to.Renderables[newRow] = from.Renderables[oldRow];
+	}
+	if (newMask & COMPONENT_BOUNDS) {
+		to.Bounds[newRow] = from.Bounds[oldRow];
+	}
+	RemoveRow(oldArchetype, oldRow);
+	record.archetype = newArchetype;
+	record.row = newRow;
+}
+
+unsigned int EntityWorld::GetComponentMask(EntityHandle handle) const
+{
+	const EntityRecord* record = Find(handle);
+	return record ? archetypes[record->archetype].Mask : 0;
+}
+
+TransformComponent* EntityWorld::GetTransform(EntityHandle handle)
+{
+	const EntityRecord* record = Find(handle);
+	if (!record || !(archetypes[record->archetype].Mask & COMPONENT_TRANSFORM)) {
+		return nullptr;
+	}
+	return &archetypes[record->archetype].Transforms[record->row];
+}
+
+RenderableComponent* EntityWorld::GetRenderable(EntityHandle handle)
+{
+	const EntityRecord* record = Find(handle);
+	if (!record || !(archetypes[record->archetype].Mask & COMPONENT_RENDERABLE)) {
+		return nullptr;
+	}
+	return &archetypes[record->archetype].Renderables[record->row];
+}
+
+BoundsComponent* EntityWorld::GetBounds(EntityHandle handle)
+{
+	const EntityRecord* record = Find(handle);
+	if (!record || !(archetypes[record->archetype].Mask & COMPONENT_BOUNDS)) {
+		return nullptr;
+	}
+	return &archetypes[record->archetype].Bounds[record->row];
+}
+
+unsigned int EntityWorld::GetEntityCount() const
+{
+	return entityCount;
+}
+
+unsigned int EntityWorld::GetArchetypeCount() const
+{
+	return (unsigned int)archetypes.size();
+}
+
+Archetype& EntityWorld::GetArchetype(unsigned int index)
+{
+	return archetypes[index];
+}
+
+void EntityWorld::ForEach(unsigned int requiredMask, unsigned int excludedMask,
+	const std::function<void(Archetype&, unsigned int, unsigned int)>& func,
+	JobSystem* jobs, unsigned int minRowsPerJob)
+{
+	if (minRowsPerJob == 0) {
+		minRowsPerJob = 1;
+	}
+	JobCounter counter;
+	for (int a = 0; a < archetypes.size(); ++a) {
+		Archetype& archetype = archetypes[a];
+		if ((archetype.Mask & requiredMask) != requiredMask || (archetype.Mask & excludedMask) != 0) {
+			continue;
+		}
+		unsigned int rows = (unsigned int)archetype.Entities.size();
+		if (rows == 0) {
+			continue;
+		}
+		if (!jobs || rows < minRowsPerJob) {
+			func(archetype, 0, rows);
+			continue;
+		}
+
+		unsigned int ranges = rows / minRowsPerJob;
+		ranges = ranges < jobs->GetThreadCount() ? ranges : jobs->GetThreadCount();
+		unsigned int perRange = (rows + ranges - 1) / ranges;
+		for (unsigned int first = 0; first < rows; first += perRange) {
+			unsigned int last = first + perRange < rows ? first + perRange : rows;
+			jobs->Run([&func, &archetype, first, last] { func(archetype, first, last); }, &counter);
+		}
+	}
+	if (jobs) {
+		jobs->Wait(counter);
+	}
+}
@@ -0,0 +1,130 @@
+#pragma once
+#include <DirectXMath.h>
+#include <functional>
+#include <stdint.h>
+#include <vector>
+#include "Bounds.h"
+#include "JobSystem.h"
+#include "Mesh.h"
+#include "Material.h"
+
+// Component bits, an entity's set of these picks its archetype
+#define COMPONENT_TRANSFORM 0x1
+#define COMPONENT_RENDERABLE 0x2
+#define COMPONENT_BOUNDS 0x4
+#define COMPONENT_STATIC 0x8	// Tag only, no data: never moves, baked by StaticBatcher
+
+// --------------------------------------------------------
+// A generational handle: Index picks the slot, Generation
+// goes up every time the slot is reused, so a handle to a
+// destroyed entity never finds its replacement
+// --------------------------------------------------------
+struct EntityHandle
+{
+	uint32_t Index;
+	uint32_t Generation;
+};
+
+// Position, rotation (pitch/yaw/roll) and scale, like Transform, with the world matrix cached
+struct TransformComponent
+{
+	DirectX::XMFLOAT3 Position;
+	DirectX::XMFLOAT3 Rotation;
+	DirectX::XMFLOAT3 Scale;
+	bool Dirty;						// Set when anything above changes, cleared by TransformSystem
+	DirectX::XMFLOAT4X4 World;
+};
+
+struct RenderableComponent
+{
+	Mesh* RenderMesh;
+	Material* RenderMaterial;
+	int SpatialProxy;				// -1 if not in a spatial index
+};
+
+struct BoundsComponent
+{
+	AABB WorldBounds;				// Kept up to date by TransformSystem
+};
+
+// --------------------------------------------------------
+// Every entity with exactly the same component set, with
+// each component in its own dense array.  Row r of every
+// array (and of Entities) is the same entity; arrays for
+// components the archetype doesn't have stay empty.
+// --------------------------------------------------------
+struct Archetype
+{
+	unsigned int Mask;
+	std::vector<EntityHandle> Entities;
+	std::vector<TransformComponent> Transforms;
+	std::vector<RenderableComponent> Renderables;
+	std::vector<BoundsComponent> Bounds;
+};
+
+// --------------------------------------------------------
+// Archetype-based entity storage.  Entities are rows in
+// their archetype's arrays, so a system that wants, say,
+// transforms and bounds walks a few contiguous arrays
+// instead of chasing a pointer per entity.
+//
+// Destroying an entity or changing its components moves
+// the last row of the archetype into the hole, so rows
+// (and component pointers) are only good until the next
+// structural change; handles stay valid throughout.
+// --------------------------------------------------------
+class EntityWorld
+{
+private:
+	struct EntityRecord
+	{
+		uint32_t generation;
+		int archetype;		// -1 when the slot is free
+		uint32_t row;
+	};
+
+	std::vector<EntityRecord> records;
+	std::vector<uint32_t> freeSlots;
+	std::vector<Archetype> archetypes;
+	unsigned int entityCount;
+
+	int FindOrCreateArchetype(unsigned int mask);
+	uint32_t AddRow(int archetype, EntityHandle handle);
+	void RemoveRow(int archetype, uint32_t row);
+	const EntityRecord* Find(EntityHandle handle) const;
+public:
+	EntityWorld();
+
+	// New components are zeroed, except Scale (1, 1, 1), Dirty (true) and SpatialProxy (-1)
+	EntityHandle Create(unsigned int componentMask);
+	void Destroy(EntityHandle handle);
+	bool IsAlive(EntityHandle handle) const;
+	void Clear();
+
+	// Moves the entity to the archetype for its new component set, keeping the components it already had
+	void AddComponents(EntityHandle handle, unsigned int componentMask);
+	void RemoveComponents(EntityHandle handle, unsigned int componentMask);
+	unsigned int GetComponentMask(EntityHandle handle) const;
+
+	// Null if the entity is dead or lacks the component
+	TransformComponent* GetTransform(EntityHandle handle);
+	RenderableComponent* GetRenderable(EntityHandle handle);
+	BoundsComponent* GetBounds(EntityHandle handle);
+
+	unsigned int GetEntityCount() const;
+	unsigned int GetArchetypeCount() const;
+	Archetype& GetArchetype(unsigned int index);
+
+	// --------------------------------------------------------
+	// Calls func(archetype, firstRow, lastRow) over the rows of
+	// every archetype that has all of the required components
+	// and none of the excluded ones.  Given a job system the
+	// rows are split into ranges of at least minRowsPerJob and
+	// every archetype's ranges run as jobs side by side, so
+	// func must only touch its own rows.  No structural
+	// changes are allowed inside.
+	// --------------------------------------------------------
+	void ForEach(unsigned int requiredMask, unsigned int excludedMask,
+		const std::function<void(Archetype&, unsigned int, unsigned int)>& func,
+		JobSystem* jobs = nullptr, unsigned int minRowsPerJob = 4096);
+};
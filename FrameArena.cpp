@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <atomic>
+#include <mutex>
+#include "FrameArena.h"
+
+struct FrameBlock
+{
+	uint8_t* Memory;
+	std::atomic<size_t> Offset;		// Can run past the capacity, when the last chunks didn't fit
+	std::vector<void*> Overflow;	// Heap allocations to free when the block is reset
+};
+
+// What the thread is bumping through; stale once the generation moves on
+struct FrameChunk
+{
+	uint8_t* Cursor;
+	uint8_t* End;
+	uint64_t Generation;
+};
+
+static FrameBlock blocks[FRAME_ARENA_FRAMES];
+static size_t capacity = 0;
+static std::atomic<unsigned int> currentBlock(0);
+static std::atomic<uint64_t> generation(1);
+static std::mutex overflowMutex;
+static std::atomic<unsigned int> overflows(0);
+static size_t lastUsed = 0;
+static size_t peakUsed = 0;
+
+static thread_local FrameChunk threadChunk = { nullptr, nullptr, 0 };
+
+static uint8_t* AlignUp(uint8_t* address, size_t alignment)
+{
+	return (uint8_t*)(((uintptr_t)address + alignment - 1) & ~(uintptr_t)(alignment - 1));
+}
+
+void FrameArena::Initialize(size_t bytesPerFrame)
+{
+	if (capacity > 0) {
+		return; //once per run, the blocks could be in use
+	}
+	for (unsigned int b = 0; b < FRAME_ARENA_FRAMES; b++) {
+		blocks[b].Memory = new uint8_t[bytesPerFrame];
+		blocks[b].Offset.store(0, std::memory_order_relaxed);
+	}
+	capacity = bytesPerFrame;
+	generation.fetch_add(1, std::memory_order_release);
+}
+
+// Rotates even before Initialize, when every allocation is an overflow, so those get freed too
+void FrameArena::BeginFrame()
+{
+	unsigned int finished = currentBlock.load(std::memory_order_relaxed);
+	if (capacity > 0) {
+		size_t used = blocks[finished].Offset.load(std::memory_order_relaxed);
+		lastUsed = used < capacity ? used : capacity;
+		peakUsed = lastUsed > peakUsed ? lastUsed : peakUsed;
+	}
+
+	unsigned int next = (finished + 1) % FRAME_ARENA_FRAMES;
+	blocks[next].Offset.store(0, std::memory_order_relaxed);
+	{
+		std::lock_guard<std::mutex> lock(overflowMutex);
+		for (size_t i = 0; i < blocks[next].Overflow.size(); i++) {
+			::operator delete(blocks[next].Overflow[i]);
+		}
+		blocks[next].Overflow.clear();
+	}
+	currentBlock.store(next, std::memory_order_relaxed);
+	generation.fetch_add(1, std::memory_order_release);
+}
+
+void* FrameArena::Allocate(size_t size, size_t alignment)
+{
+	uint64_t currentGeneration = generation.load(std::memory_order_acquire);
+	FrameChunk& chunk = threadChunk;
+	if (chunk.Generation == currentGeneration) {
+		uint8_t* start = AlignUp(chunk.Cursor, alignment);
+		if (start + size <= chunk.End) {
+			chunk.Cursor = start + size;
+			return start;
+		}
+	}
+
+	FrameBlock& block = blocks[currentBlock.load(std::memory_order_relaxed)];
+	if (capacity > 0) {
+		if (size + alignment > FRAME_ARENA_CHUNK / 4) {
+			// Big enough to waste a good part of a chunk, so it gets its own piece of the block
+			size_t offset = block.Offset.fetch_add(size + alignment, std::memory_order_relaxed);
+			if (offset + size + alignment <= capacity) {
+				return AlignUp(block.Memory + offset, alignment);
+			}
+		}
+		else {
+			size_t offset = block.Offset.fetch_add(FRAME_ARENA_CHUNK, std::memory_order_relaxed);
+			if (offset + FRAME_ARENA_CHUNK <= capacity) {
+				chunk.Cursor = block.Memory + offset;
+				chunk.End = chunk.Cursor + FRAME_ARENA_CHUNK;
+				chunk.Generation = currentGeneration;
+				uint8_t* start = AlignUp(chunk.Cursor, alignment);
+				chunk.Cursor = start + size;
+				return start;
+			}
+		}
+	}
+
+	// Out of room (or never initialized): the heap, until this block comes round again
+	void* memory = ::operator new(size + alignment);
+	{
+		std::lock_guard<std::mutex> lock(overflowMutex);
+		block.Overflow.push_back(memory);
+	}
+	if (overflows.fetch_add(1, std::memory_order_relaxed) == 0 && capacity > 0) {
+		printf("Frame arena: %u bytes per frame aren't enough, falling back to the heap\n", (unsigned int)capacity);
+	}
+	return AlignUp((uint8_t*)memory, alignment);
+}
+
+FrameArenaStats FrameArena::GetStats()
+{
+	FrameArenaStats stats;
+	stats.Capacity = capacity;
+	stats.Used = lastUsed;
+	stats.Peak = peakUsed;
+	stats.Overflows = overflows.load(std::memory_order_relaxed);
+	return stats;
+}
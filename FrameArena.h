@@ -0,0 +1,98 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <new>
+#include <vector>
+
+// Frames kept alive at once; memory from a frame is reused when this many more have begun
+#define FRAME_ARENA_FRAMES 3
+#define FRAME_ARENA_DEFAULT_SIZE (16 * 1024 * 1024)
+// What a thread takes from the shared frame block at a time, to bump through on its own
+#define FRAME_ARENA_CHUNK (64 * 1024)
+#define FRAME_ARENA_ALIGNMENT 16
+
+struct FrameArenaStats
+{
+	size_t Capacity;		// Per frame
+	size_t Used;			// By the last complete frame, including what threads' chunks left unused
+	size_t Peak;			// The most any frame has used
+	unsigned int Overflows;	// Allocations that didn't fit and went to the heap instead, over the whole run
+};
+
+// --------------------------------------------------------
+// Scratch memory for the frame, from a bump allocator that
+// is reset wholesale instead of freed piece by piece.
+//
+// There are FRAME_ARENA_FRAMES blocks used round robin, so
+// memory allocated during a frame stays valid through the
+// next FRAME_ARENA_FRAMES - 1 frames (long enough for data
+// staged for the GPU) and is reused when BeginFrame comes
+// round to its block again.  Destructors never run; only
+// put trivially destructible data in it, or data whose
+// destructor doesn't need to run, like FrameVector's.
+//
+// Each thread bumps through a chunk of its own, so
+// allocating from jobs takes no locks, only an atomic add
+// when a chunk runs out.  BeginFrame must not be called
+// while other threads are allocating (DXCore calls it
+// between frames, when no jobs are running).  Anything that
+// doesn't fit in the block comes from the heap, is freed at
+// the same time the block is reset and is counted as an
+// overflow, so it shows up in the allocation tracker.
+// Before Initialize every allocation is an overflow, freed
+// by BeginFrame just the same.
+//
+// It's for scratch whose size comes and goes, like the
+// streamer's load candidates.  What every frame rebuilds at
+// about the same size (sort keys, visible lists, packed
+// instances, staged constants) stays in member vectors that
+// are cleared rather than freed, which stop allocating once
+// the first frames have grown them; code outside the frame
+// loop, which never calls BeginFrame, shouldn't use it.
+// --------------------------------------------------------
+class FrameArena
+{
+public:
+	static void Initialize(size_t bytesPerFrame = FRAME_ARENA_DEFAULT_SIZE);
+	static void BeginFrame();
+
+	//alignment must be a power of two
+	static void* Allocate(size_t size, size_t alignment = FRAME_ARENA_ALIGNMENT);
+	//uninitialized
+	template <typename T> static T* AllocateArray(size_t count)
+	{
+		return (T*)Allocate(sizeof(T) * count, alignof(T) > FRAME_ARENA_ALIGNMENT ? alignof(T) : FRAME_ARENA_ALIGNMENT);
+	}
+
+	static FrameArenaStats GetStats();
+};
+
+// --------------------------------------------------------
+// Lets standard containers allocate from the frame arena.
+// deallocate does nothing, so a container that grows leaves
+// its old storage behind until the block is reset; reserve
+// up front where the size is known.  Containers using it
+// must be gone (or at least never touched again) within
+// FRAME_ARENA_FRAMES - 1 frames.
+// --------------------------------------------------------
+template <typename T>
+class FrameAllocator
+{
+public:
+	typedef T value_type;
+
+	FrameAllocator() {}
+	template <typename U> FrameAllocator(const FrameAllocator<U>&) {}
+
+	T* allocate(size_t count)
+	{
+		return FrameArena::AllocateArray<T>(count);
+	}
+
+	void deallocate(T*, size_t) {}
+
+	template <typename U> bool operator==(const FrameAllocator<U>&) const { return true; }
+	template <typename U> bool operator!=(const FrameAllocator<U>&) const { return false; }
+};
+
+template <typename T> using FrameVector = std::vector<T, FrameAllocator<T>>;
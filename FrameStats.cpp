@@ -0,0 +1,194 @@
+#include <stdio.h>
+#include <fstream>
+#include "FrameStats.h"
+
+static const char* phaseNames[FRAME_PHASE_COUNT] = { "update", "draw", "present", "total" };
+
+void FrameStats::Histogram::Add(float ms)
+{
+	unsigned int bucket = (unsigned int)(ms / FRAME_STATS_BUCKET_MS);
+	Counts[bucket < FRAME_STATS_BUCKETS ? bucket : FRAME_STATS_BUCKETS]++;
+	Frames++;
+	TotalMs += ms;
+	MaxMs = ms > MaxMs ? ms : MaxMs;
+}
+
+// Doesn't lower MaxMs; the window works its max out from the ring instead
+void FrameStats::Histogram::Remove(float ms)
+{
+	unsigned int bucket = (unsigned int)(ms / FRAME_STATS_BUCKET_MS);
+	Counts[bucket < FRAME_STATS_BUCKETS ? bucket : FRAME_STATS_BUCKETS]--;
+	Frames--;
+	TotalMs -= ms;
+}
+
+// The top of the bucket the percentile falls in, but never more than the slowest frame
+float FrameStats::Histogram::GetPercentile(float fraction, float maxMs) const
+{
+	if (Frames == 0) {
+		return 0.0f;
+	}
+	unsigned int rank = (unsigned int)(fraction * Frames + 0.999999f);
+	rank = rank < 1 ? 1 : rank;
+	unsigned int seen = 0;
+	for (unsigned int b = 0; b < FRAME_STATS_BUCKETS; b++) {
+		seen += Counts[b];
+		if (seen >= rank) {
+			float top = (b + 1) * FRAME_STATS_BUCKET_MS;
+			return top < maxMs ? top : maxMs;
+		}
+	}
+	return maxMs;
+}
+
+FrameStats::FrameStats()
+{
+	for (int p = 0; p < FRAME_PHASE_COUNT; p++) {
+		runHistograms[p].Counts.assign(FRAME_STATS_BUCKETS + 1, 0);
+		runHistograms[p].Frames = 0;
+		runHistograms[p].TotalMs = 0;
+		runHistograms[p].MaxMs = 0;
+		windowHistograms[p] = runHistograms[p];
+		window[p].assign(FRAME_STATS_WINDOW, 0.0f);
+		phaseMs[p] = 0;
+	}
+	windowNext = 0;
+	currentPhase = -1;
+	SetBudgets({ 1000.0f / 60.0f, 1000.0f / 30.0f });
+}
+
+void FrameStats::SetBudgets(const std::vector<float>& budgetsMs)
+{
+	this->budgetsMs = budgetsMs;
+	runHitches.assign(budgetsMs.size(), 0);
+}
+
+const std::vector<float>& FrameStats::GetBudgets() const
+{
+	return budgetsMs;
+}
+
+void FrameStats::BeginFrame()
+{
+	frameStart = std::chrono::high_resolution_clock::now();
+	currentPhase = -1;
+	for (int p = 0; p < FRAME_PHASE_COUNT; p++) {
+		phaseMs[p] = 0;
+	}
+}
+
+void FrameStats::EndPhase(std::chrono::high_resolution_clock::time_point now)
+{
+	if (currentPhase >= 0) {
+		phaseMs[currentPhase] += std::chrono::duration<float, std::milli>(now - phaseStart).count();
+	}
+}
+
+void FrameStats::BeginPhase(FramePhase phase)
+{
+	std::chrono::high_resolution_clock::time_point now = std::chrono::high_resolution_clock::now();
+	EndPhase(now);
+	currentPhase = phase;
+	phaseStart = now;
+}
+
+void FrameStats::EndFrame()
+{
+	std::chrono::high_resolution_clock::time_point now = std::chrono::high_resolution_clock::now();
+	EndPhase(now);
+	currentPhase = -1;
+	phaseMs[FRAME_PHASE_TOTAL] = std::chrono::duration<float, std::milli>(now - frameStart).count();
+	AddFrame(phaseMs);
+}
+
+void FrameStats::AddFrame(const float phaseMs[FRAME_PHASE_COUNT])
+{
+	bool full = runHistograms[FRAME_PHASE_TOTAL].Frames >= FRAME_STATS_WINDOW;
+	for (int p = 0; p < FRAME_PHASE_COUNT; p++) {
+		runHistograms[p].Add(phaseMs[p]);
+		if (full) {
+			windowHistograms[p].Remove(window[p][windowNext]);
+		}
+		windowHistograms[p].Add(phaseMs[p]);
+		window[p][windowNext] = phaseMs[p];
+	}
+	windowNext = (windowNext + 1) % FRAME_STATS_WINDOW;
+
+	for (size_t b = 0; b < budgetsMs.size(); b++) {
+		if (phaseMs[FRAME_PHASE_TOTAL] > budgetsMs[b]) {
+			runHitches[b]++;
+		}
+	}
+}
+
+FramePhaseSummary FrameStats::GetSummary(FramePhase phase, bool wholeRun) const
+{
+	const Histogram& histogram = wholeRun ? runHistograms[phase] : windowHistograms[phase];
+	float maxMs = histogram.MaxMs;
+	if (!wholeRun) {
+		maxMs = 0;
+		for (unsigned int i = 0; i < histogram.Frames; i++) {
+			maxMs = window[phase][i] > maxMs ? window[phase][i] : maxMs;
+		}
+	}
+
+	FramePhaseSummary summary;
+	summary.Frames = histogram.Frames;
+	summary.MeanMs = histogram.Frames > 0 ? (float)(histogram.TotalMs / histogram.Frames) : 0.0f;
+	summary.P50Ms = histogram.GetPercentile(0.5f, maxMs);
+	summary.P95Ms = histogram.GetPercentile(0.95f, maxMs);
+	summary.P99Ms = histogram.GetPercentile(0.99f, maxMs);
+	summary.MaxMs = maxMs;
+	return summary;
+}
+
+unsigned int FrameStats::GetHitches(unsigned int budget, bool wholeRun) const
+{
+	if (budget >= budgetsMs.size()) {
+		return 0;
+	}
+	if (wholeRun) {
+		return runHitches[budget];
+	}
+	unsigned int hitches = 0;
+	for (unsigned int i = 0; i < windowHistograms[FRAME_PHASE_TOTAL].Frames; i++) {
+		hitches += window[FRAME_PHASE_TOTAL][i] > budgetsMs[budget] ? 1 : 0;
+	}
+	return hitches;
+}
+
+void FrameStats::Print() const
+{
+	printf("Frame times over %u frames, ms:\n", runHistograms[FRAME_PHASE_TOTAL].Frames);
+	printf("  %-8s %9s %9s %9s %9s %9s\n", "phase", "mean", "p50", "p95", "p99", "max");
+	for (int p = 0; p < FRAME_PHASE_COUNT; p++) {
+		FramePhaseSummary summary = GetSummary((FramePhase)p, true);
+		printf("  %-8s %9.3f %9.3f %9.3f %9.3f %9.3f\n", phaseNames[p], summary.MeanMs, summary.P50Ms, summary.P95Ms, summary.P99Ms, summary.MaxMs);
+	}
+	for (size_t b = 0; b < budgetsMs.size(); b++) {
+		printf("  %u frames over %.2f ms\n", runHitches[b], budgetsMs[b]);
+	}
+}
+
+bool FrameStats::WriteCsv(const std::string& path) const
+{
+	std::ofstream file(path, std::ios::trunc);
+	if (!file) {
+		printf("Frame stats: couldn't write %s\n", path.c_str());
+		return false;
+	}
+	file << "phase,statistic,value\n";
+	for (int p = 0; p < FRAME_PHASE_COUNT; p++) {
+		FramePhaseSummary summary = GetSummary((FramePhase)p, true);
+		file << phaseNames[p] << ",frames," << summary.Frames << "\n";
+		file << phaseNames[p] << ",mean_ms," << summary.MeanMs << "\n";
+		file << phaseNames[p] << ",p50_ms," << summary.P50Ms << "\n";
+		file << phaseNames[p] << ",p95_ms," << summary.P95Ms << "\n";
+		file << phaseNames[p] << ",p99_ms," << summary.P99Ms << "\n";
+		file << phaseNames[p] << ",max_ms," << summary.MaxMs << "\n";
+	}
+	for (size_t b = 0; b < budgetsMs.size(); b++) {
+		file << "total,hitches_over_" << budgetsMs[b] << "_ms," << runHitches[b] << "\n";
+	}
+	return (bool)file;
+}
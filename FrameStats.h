@@ -0,0 +1,89 @@
+#pragma once
+#include <chrono>
+#include <string>
+#include <vector>
+
+enum FramePhase
+{
+	FRAME_PHASE_UPDATE,
+	FRAME_PHASE_DRAW,
+	FRAME_PHASE_PRESENT,
+	FRAME_PHASE_TOTAL,		// The whole frame, including anything between the phases
+	FRAME_PHASE_COUNT
+};
+
+#define FRAME_STATS_BUCKET_MS 0.05f		// Histogram resolution
+#define FRAME_STATS_BUCKETS 2000		// Up to 100 ms, anything longer goes in one more bucket
+#define FRAME_STATS_WINDOW 1024			// Frames in the rolling window
+
+struct FramePhaseSummary
+{
+	unsigned int Frames;
+	float MeanMs;
+	float P50Ms;
+	float P95Ms;
+	float P99Ms;
+	float MaxMs;
+};
+
+// --------------------------------------------------------
+// Frame time statistics, per phase, both for the last
+// FRAME_STATS_WINDOW frames and for the whole run.
+//
+// Every frame goes into a histogram with 0.05 ms buckets,
+// so percentiles are exact to that and stutter shows up in
+// p99 and max instead of disappearing into an average.
+// Frames over each budget are counted as hitches.
+//
+// Mark the frame with BeginFrame, BeginPhase for each phase
+// (a phase lasts until the next one starts) and EndFrame,
+// or hand in finished timings with AddFrame.
+// --------------------------------------------------------
+class FrameStats
+{
+private:
+	struct Histogram
+	{
+		std::vector<unsigned int> Counts;
+		unsigned int Frames;
+		double TotalMs;
+		float MaxMs;
+
+		void Add(float ms);
+		void Remove(float ms);
+		float GetPercentile(float fraction, float maxMs) const;
+	};
+
+	Histogram runHistograms[FRAME_PHASE_COUNT];
+	Histogram windowHistograms[FRAME_PHASE_COUNT];
+	std::vector<float> window[FRAME_PHASE_COUNT];	// Rings of the last frames' times
+	unsigned int windowNext;
+	std::vector<float> budgetsMs;
+	std::vector<unsigned int> runHitches;			// Per budget
+
+	std::chrono::high_resolution_clock::time_point frameStart;
+	std::chrono::high_resolution_clock::time_point phaseStart;
+	int currentPhase;								// -1 outside of any phase
+	float phaseMs[FRAME_PHASE_COUNT];
+
+	void EndPhase(std::chrono::high_resolution_clock::time_point now);
+public:
+	FrameStats();
+	//hitches are frames whose total time is over a budget; 60 and 30 fps to start with
+	void SetBudgets(const std::vector<float>& budgetsMs);
+	const std::vector<float>& GetBudgets() const;
+
+	void BeginFrame();
+	void BeginPhase(FramePhase phase);
+	void EndFrame();
+	//one frame's times in ms, indexed by FramePhase; FRAME_PHASE_TOTAL included
+	void AddFrame(const float phaseMs[FRAME_PHASE_COUNT]);
+
+	//over the rolling window, or the whole run
+	FramePhaseSummary GetSummary(FramePhase phase, bool wholeRun) const;
+	unsigned int GetHitches(unsigned int budget, bool wholeRun) const;
+
+	void Print() const; //the whole run
+	//the whole run, one statistic per row (phase,statistic,value) so runs are easy to diff
+	bool WriteCsv(const std::string& path) const;
+};
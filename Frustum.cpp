@@ -0,0 +1,81 @@
+#include <float.h>
+#include <math.h>
+#include "Frustum.h"
+
+using namespace DirectX;
+
+Frustum::Frustum()
+{
+	for (int i = 0; i < 6; i++) {
+		planes[i] = XMFLOAT4(0, 0, 0, 0);
+	}
+}
+
+// Gribb/Hartmann plane extraction from the combined view-projection matrix
+// DirectXMath uses row vectors (clip = v * M), so the planes come from the columns of M,
+// and D3D clip space z runs from 0 to w, so the near plane is just the third column
+Frustum::Frustum(XMFLOAT4X4 view, XMFLOAT4X4 projection)
+{
+	XMFLOAT4X4 m;
+	XMStoreFloat4x4(&m, XMMatrixMultiply(XMLoadFloat4x4(&view), XMLoadFloat4x4(&projection)));
+
+	planes[FRUSTUM_PLANE_LEFT] = XMFLOAT4(m._14 + m._11, m._24 + m._21, m._34 + m._31, m._44 + m._41);
+	planes[FRUSTUM_PLANE_RIGHT] = XMFLOAT4(m._14 - m._11, m._24 - m._21, m._34 - m._31, m._44 - m._41);
+	planes[FRUSTUM_PLANE_BOTTOM] = XMFLOAT4(m._14 + m._12, m._24 + m._22, m._34 + m._32, m._44 + m._42);
+	planes[FRUSTUM_PLANE_TOP] = XMFLOAT4(m._14 - m._12, m._24 - m._22, m._34 - m._32, m._44 - m._42);
+	planes[FRUSTUM_PLANE_NEAR] = XMFLOAT4(m._13, m._23, m._33, m._43);
+	planes[FRUSTUM_PLANE_FAR] = XMFLOAT4(m._14 - m._13, m._24 - m._23, m._34 - m._33, m._44 - m._43);
+
+	for (int i = 0; i < 6; i++) {
+		XMStoreFloat4(&planes[i], XMPlaneNormalize(XMLoadFloat4(&planes[i])));
+	}
+}
+
+XMFLOAT4 Frustum::GetPlane(int index) const
+{
+	return planes[index];
+}
+
+bool Frustum::Intersects(const AABB& box) const
+{
+	for (int i = 0; i < 6; i++) {
+		const XMFLOAT4& p = planes[i];
+		float distance = p.x * box.Center.x + p.y * box.Center.y + p.z * box.Center.z + p.w;
+		float radius = fabsf(p.x) * box.Extents.x + fabsf(p.y) * box.Extents.y + fabsf(p.z) * box.Extents.z;
+		if (distance < -radius) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// The point where three planes meet, assuming no two of them are parallel
+static XMFLOAT3 Intersect(const XMFLOAT4& a, const XMFLOAT4& b, const XMFLOAT4& c)
+{
+	XMFLOAT3 bc(b.y * c.z - b.z * c.y, b.z * c.x - b.x * c.z, b.x * c.y - b.y * c.x);
+	XMFLOAT3 ca(c.y * a.z - c.z * a.y, c.z * a.x - c.x * a.z, c.x * a.y - c.y * a.x);
+	XMFLOAT3 ab(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+	float invDenominator = -1.0f / (a.x * bc.x + a.y * bc.y + a.z * bc.z);
+	return XMFLOAT3(
+		(a.w * bc.x + b.w * ca.x + c.w * ab.x) * invDenominator,
+		(a.w * bc.y + b.w * ca.y + c.w * ab.y) * invDenominator,
+		(a.w * bc.z + b.w * ca.z + c.w * ab.z) * invDenominator);
+}
+
+AABB Frustum::GetBounds() const
+{
+	XMFLOAT3 min(FLT_MAX, FLT_MAX, FLT_MAX);
+	XMFLOAT3 max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	for (int corner = 0; corner < 8; corner++) {
+		XMFLOAT3 p = Intersect(
+			planes[(corner & 1) ? FRUSTUM_PLANE_RIGHT : FRUSTUM_PLANE_LEFT],
+			planes[(corner & 2) ? FRUSTUM_PLANE_TOP : FRUSTUM_PLANE_BOTTOM],
+			planes[(corner & 4) ? FRUSTUM_PLANE_FAR : FRUSTUM_PLANE_NEAR]);
+		min = XMFLOAT3(fminf(min.x, p.x), fminf(min.y, p.y), fminf(min.z, p.z));
+		max = XMFLOAT3(fmaxf(max.x, p.x), fmaxf(max.y, p.y), fmaxf(max.z, p.z));
+	}
+	AABB bounds;
+	bounds.Center = XMFLOAT3((min.x + max.x) * 0.5f, (min.y + max.y) * 0.5f, (min.z + max.z) * 0.5f);
+	bounds.Extents = XMFLOAT3((max.x - min.x) * 0.5f, (max.y - min.y) * 0.5f, (max.z - min.z) * 0.5f);
+	return bounds;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <DirectXMath.h>
+#include "Bounds.h"
+
+#define FRUSTUM_PLANE_LEFT 0
+#define FRUSTUM_PLANE_RIGHT 1
+#define FRUSTUM_PLANE_BOTTOM 2
+#define FRUSTUM_PLANE_TOP 3
+#define FRUSTUM_PLANE_NEAR 4
+#define FRUSTUM_PLANE_FAR 5
+
+// --------------------------------------------------------
+// Six world-space planes bounding what a camera can see.
+// Each plane is stored as (a, b, c, d) with a normalized,
+// inward-facing normal, so a point p is inside when
+// dot(n, p) + d >= 0 for every plane
+// --------------------------------------------------------
+class Frustum
+{
+private:
+	DirectX::XMFLOAT4 planes[6];
+public:
+	Frustum();
+	Frustum(DirectX::XMFLOAT4X4 view, DirectX::XMFLOAT4X4 projection);
+	DirectX::XMFLOAT4 GetPlane(int index) const;
+	bool Intersects(const AABB& box) const; //scalar test, use FrustumCuller for large batches
+	AABB GetBounds() const; //the box around the eight corners
+};
@@ -0,0 +1,160 @@
+#include <chrono>
+#include <math.h>
+#include <xmmintrin.h>
+#include "FrustumCuller.h"
+
+using namespace DirectX;
+
+#define CULL_BATCH_SIZE 8
+
+// Every plane component (and its absolute value) splatted across a register
+struct SplatPlanes
+{
+	__m128 X[6], Y[6], Z[6], W[6];
+	__m128 AbsX[6], AbsY[6], AbsZ[6];
+};
+
+FrustumCuller::FrustumCuller()
+{
+	count = 0;
+	jobs = nullptr;
+	stats = {};
+}
+
+void FrustumCuller::SetJobSystem(JobSystem* jobs)
+{
+	this->jobs = jobs;
+}
+
+void FrustumCuller::Clear()
+{
+	count = 0;
+	centerX.clear();
+	centerY.clear();
+	centerZ.clear();
+	extentX.clear();
+	extentY.clear();
+	extentZ.clear();
+}
+
+void FrustumCuller::Reserve(unsigned int capacity)
+{
+	unsigned int padded = (capacity + CULL_BATCH_SIZE - 1) & ~(CULL_BATCH_SIZE - 1);
+	centerX.reserve(padded);
+	centerY.reserve(padded);
+	centerZ.reserve(padded);
+	extentX.reserve(padded);
+	extentY.reserve(padded);
+	extentZ.reserve(padded);
+}
+
+unsigned int FrustumCuller::Add(const AABB& box)
+{
+	// Keep the arrays padded so the last batch can always be loaded whole.
+	// Padding entries are degenerate boxes, and their results are masked off in Cull()
+	if (count % CULL_BATCH_SIZE == 0) {
+		centerX.resize(count + CULL_BATCH_SIZE, 0.0f);
+		centerY.resize(count + CULL_BATCH_SIZE, 0.0f);
+		centerZ.resize(count + CULL_BATCH_SIZE, 0.0f);
+		extentX.resize(count + CULL_BATCH_SIZE, 0.0f);
+		extentY.resize(count + CULL_BATCH_SIZE, 0.0f);
+		extentZ.resize(count + CULL_BATCH_SIZE, 0.0f);
+	}
+	centerX[count] = box.Center.x;
+	centerY[count] = box.Center.y;
+	centerZ[count] = box.Center.z;
+	extentX[count] = box.Extents.x;
+	extentY[count] = box.Extents.y;
+	extentZ[count] = box.Extents.z;
+	return count++;
+}
+
+unsigned int FrustumCuller::GetCount()
+{
+	return count;
+}
+
+unsigned int FrustumCuller::Cull(const Frustum& frustum, std::vector<unsigned int>& visibleIndices)
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	visibleIndices.clear();
+
+	// Splat every plane once up front
+	SplatPlanes planes;
+	for (int p = 0; p < 6; p++) {
+		XMFLOAT4 plane = frustum.GetPlane(p);
+		planes.X[p] = _mm_set1_ps(plane.x);
+		planes.Y[p] = _mm_set1_ps(plane.y);
+		planes.Z[p] = _mm_set1_ps(plane.z);
+		planes.W[p] = _mm_set1_ps(plane.w);
+		planes.AbsX[p] = _mm_set1_ps(fabsf(plane.x));
+		planes.AbsY[p] = _mm_set1_ps(fabsf(plane.y));
+		planes.AbsZ[p] = _mm_set1_ps(fabsf(plane.z));
+	}
+
+	// Each batch gets a mask of its visible boxes, so ranges of batches can be tested as separate jobs.
+	// The lambda has two captures, few enough for std::function to hold without allocating
+	unsigned int batchCount = (count + CULL_BATCH_SIZE - 1) / CULL_BATCH_SIZE;
+	batchMasks.resize(batchCount);
+	std::function<void(unsigned int, unsigned int)> testBatches = [this, &planes](unsigned int firstBatch, unsigned int lastBatch) {
+		const __m128 zero = _mm_setzero_ps();
+		for (unsigned int base = firstBatch * CULL_BATCH_SIZE; base < lastBatch * CULL_BATCH_SIZE; base += CULL_BATCH_SIZE) {
+			// Two halves of four boxes each
+			__m128 outsideLo = zero;
+			__m128 outsideHi = zero;
+			__m128 cxLo = _mm_loadu_ps(&centerX[base]), cxHi = _mm_loadu_ps(&centerX[base + 4]);
+			__m128 cyLo = _mm_loadu_ps(&centerY[base]), cyHi = _mm_loadu_ps(&centerY[base + 4]);
+			__m128 czLo = _mm_loadu_ps(&centerZ[base]), czHi = _mm_loadu_ps(&centerZ[base + 4]);
+			__m128 exLo = _mm_loadu_ps(&extentX[base]), exHi = _mm_loadu_ps(&extentX[base + 4]);
+			__m128 eyLo = _mm_loadu_ps(&extentY[base]), eyHi = _mm_loadu_ps(&extentY[base + 4]);
+			__m128 ezLo = _mm_loadu_ps(&extentZ[base]), ezHi = _mm_loadu_ps(&extentZ[base + 4]);
+
+			for (int p = 0; p < 6; p++) {
+				// distance = n . c + d, radius = |n| . e, outside when distance + radius < 0
+				__m128 distLo = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planes.X[p], cxLo), _mm_mul_ps(planes.Y[p], cyLo)), _mm_add_ps(_mm_mul_ps(planes.Z[p], czLo), planes.W[p]));
+				__m128 distHi = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planes.X[p], cxHi), _mm_mul_ps(planes.Y[p], cyHi)), _mm_add_ps(_mm_mul_ps(planes.Z[p], czHi), planes.W[p]));
+				__m128 radLo = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planes.AbsX[p], exLo), _mm_mul_ps(planes.AbsY[p], eyLo)), _mm_mul_ps(planes.AbsZ[p], ezLo));
+				__m128 radHi = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planes.AbsX[p], exHi), _mm_mul_ps(planes.AbsY[p], eyHi)), _mm_mul_ps(planes.AbsZ[p], ezHi));
+				outsideLo = _mm_or_ps(outsideLo, _mm_cmplt_ps(_mm_add_ps(distLo, radLo), zero));
+				outsideHi = _mm_or_ps(outsideHi, _mm_cmplt_ps(_mm_add_ps(distHi, radHi), zero));
+			}
+
+			int outsideMask = _mm_movemask_ps(outsideLo) | (_mm_movemask_ps(outsideHi) << 4);
+			int visibleMask = ~outsideMask & 0xFF;
+			if (count - base < CULL_BATCH_SIZE) {
+				visibleMask &= (1 << (count - base)) - 1; //drop the padding
+			}
+			batchMasks[base / CULL_BATCH_SIZE] = (uint8_t)visibleMask;
+		}
+	};
+	if (jobs) {
+		jobs->ParallelFor(batchCount, 256, testBatches);
+	}
+	else {
+		testBatches(0, batchCount);
+	}
+
+	for (unsigned int batch = 0; batch < batchCount; batch++) {
+		int visibleMask = batchMasks[batch];
+		while (visibleMask) {
+			int bit = 0;
+			while (!(visibleMask & (1 << bit))) bit++;
+			visibleIndices.push_back(batch * CULL_BATCH_SIZE + bit);
+			visibleMask &= visibleMask - 1;
+		}
+	}
+
+	std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+	stats.Tested = count;
+	stats.Visible = (unsigned int)visibleIndices.size();
+	stats.Culled = stats.Tested - stats.Visible;
+	stats.Microseconds = std::chrono::duration<double, std::micro>(end - start).count();
+	stats.MicrosecondsPer10k = count > 0 ? stats.Microseconds * 10000.0 / count : 0.0;
+	stats.CullRate = count > 0 ? (float)stats.Culled / count : 0.0f;
+	return stats.Visible;
+}
+
+const CullStats& FrustumCuller::GetStats()
+{
+	return stats;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+#include "Bounds.h"
+#include "Frustum.h"
+#include "JobSystem.h"
+
+// --------------------------------------------------------
+// Counters from the most recent call to FrustumCuller::Cull
+// --------------------------------------------------------
+struct CullStats
+{
+	unsigned int Tested;
+	unsigned int Visible;
+	unsigned int Culled;
+	double Microseconds;		// Time spent in the SIMD plane tests
+	double MicrosecondsPer10k;	// Microseconds normalized to 10,000 boxes
+	float CullRate;				// Culled / Tested, 0 - 1
+};
+
+// --------------------------------------------------------
+// Tests batches of world-space AABBs against a frustum.
+// Boxes are kept as structure-of-arrays so eight of them
+// can be tested against a plane with two SSE registers.
+// With a job system, ranges of batches are tested as jobs.
+// Has no dependency on the device, so it can run headless
+// --------------------------------------------------------
+class FrustumCuller
+{
+private:
+	// SoA box storage, padded to a multiple of 8
+	std::vector<float> centerX;
+	std::vector<float> centerY;
+	std::vector<float> centerZ;
+	std::vector<float> extentX;
+	std::vector<float> extentY;
+	std::vector<float> extentZ;
+	unsigned int count;
+	std::vector<uint8_t> batchMasks;	// Visible boxes of each batch of 8, one bit each
+	JobSystem* jobs;
+	CullStats stats;
+public:
+	FrustumCuller();
+	void SetJobSystem(JobSystem* jobs); //null tests everything on the calling thread
+	void Clear();
+	void Reserve(unsigned int capacity);
+	unsigned int Add(const AABB& box); //returns the index reported back by Cull
+	unsigned int GetCount();
+	//writes the indices of every box at least partially inside the frustum, in the order they were added
+	unsigned int Cull(const Frustum& frustum, std::vector<unsigned int>& visibleIndices);
+	const CullStats& GetStats();
+};
@@ -1,11 +1,14 @@
 #include <DDSTextureLoader.h>
-#include <algorithm> //for std::sort
 #include "Game.h"
 #include "Vertex.h"
 #include "Input.h"
+#include "Profiler.h"
+#include "AllocationTracker.h"
 #include "Lights.h"
 #include "Sphere.h"
 #include "WICTextureLoader.h"
+#include <algorithm>
+#include <chrono>
 
 // Needed for a helper function to read compiled shader files from the hard drive
 #pragma comment(lib, "d3dcompiler.lib")
@@ -14,6 +17,11 @@
 // For the DirectX Math library
 using namespace DirectX;
 
+// Set to 1 to scatter a field of static cubes over the ground, to see what static batching saves
+#define STATIC_BATCH_TEST_SCENE 0
+// Set to 1 to stream a large field of shapes in and out around the camera, on top of Basic.scene
+#define STREAMED_WORLD 0
+
 // --------------------------------------------------------
 // Constructor
 //
@@ -29,7 +37,17 @@ Game::Game(HINSTANCE hInstance)
 		1280,			   // Width of the window's client area
 		720,			   // Height of the window's client area
 		true),			   // Show extra stats (fps) in title bar?
-	vsync(false)
+	vsync(false),
+	cullFrame(0),
+	useStressScene(false),
+	culledCandidates(0),
+	frustumVisibleTotal(0),
+	visibleTotal(0),
+	workloadHash(2166136261u),
+	streamedLoads(0),
+	streamedUnloads(0),
+	streamingMicroseconds(0),
+	streamingPeakMicroseconds(0)
 {
 #if defined(DEBUG) || defined(_DEBUG)
 	// Do we want a console window?  Probably only in debug mode
@@ -50,10 +68,10 @@ Game::~Game()
 	delete transparentMaterialG;
 	delete transparentMaterialB;
 	delete transparentMaterialY;
-	delete sphereMesh;
-	delete quadMesh;
+	for (std::map<std::string, Mesh*>::iterator it = meshes.begin(); it != meshes.end(); ++it) {
+		delete it->second;
+	}
 	delete skyBox;
-	delete cubeMesh;
 }
 
 // --------------------------------------------------------
@@ -62,32 +80,48 @@ Game::~Game()
 // --------------------------------------------------------
 void Game::Init()
 {
+	ALLOC_TAG("Init");
+	// Workers for transforms, culling, sorting and loading, one fewer than the hardware has threads
+	jobSystem = std::make_shared<JobSystem>();
+	transformSystem.SetJobSystem(jobSystem.get());
+	frustumCuller.SetJobSystem(jobSystem.get());
+	occlusionCuller.SetJobSystem(jobSystem.get());
+	renderQueue.SetJobSystem(jobSystem.get());
+	if (headless) {
+		// Recorded passes (static chunks, the opaque queue, the sky box) are only counted and checked; the
+		// dynamic batcher's and instanced renderer's uploads and draws, the clears and the post-process
+		// still use the context directly, and go to the null driver
+		nullBackend = std::make_shared<NullCommandBackend>();
+		commandBackend = nullBackend;
+	}
+	else {
+		commandBackend = std::make_shared<D3D11CommandBackend>(context);
+	}
+	stateFilter = std::make_shared<StateFilterBackend>(commandBackend.get());
+	pipelineStates = std::make_shared<PipelineStateCache>(device);
+
 	// Helper methods for loading shaders, creating some basic
 	// geometry to draw and some simple camera matrices.
 	//  - You'll be expanding and/or replacing these later
 	LoadShaders();
 	CreateBasicGeometry();
-	SetLights();
+	instancedRenderer = std::make_shared<InstancedRenderer>(device, context);
+	dynamicBatcher = std::make_shared<DynamicBatcher>(device, context);
+	dynamicBatcher->SetJobSystem(jobSystem.get());
 	camera = std::make_shared<Camera>(Transform(0, 1, -8, 0.2f, 0, 0, 1, 1, 1), (float)this->width / this->height);
-	ambientColor = XMFLOAT3(0.15f, 0.15f, 0.25f);
+	if (flythroughPath) {
+		// A fixed step, so a windowed run renders the same frames as any other and only how long they took varies
+		camera->SetPath(flythroughPath, FLYTHROUGH_STEP);
+	}
 	
 	// Tell the input assembler stage of the pipeline what kind of
 	// geometric primitives (points, lines or triangles) we want to draw.  
 	// Essentially: "What kind of shape should the GPU draw with our data?"
 	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
-	D3D11_BLEND_DESC bd = {};
-	bd.AlphaToCoverageEnable = false;
-	bd.IndependentBlendEnable = false;
-	bd.RenderTarget[0].BlendEnable = true;
-	bd.RenderTarget[0].SrcBlend = D3D11_BLEND_SRC_ALPHA;
-	bd.RenderTarget[0].DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
-	bd.RenderTarget[0].BlendOp = D3D11_BLEND_OP_ADD;
-	bd.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE;
-	bd.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ZERO;
-	bd.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
-	bd.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
-	device->CreateBlendState(&bd, &transparencyBlendState);
+	const PipelineStateCacheStats& stateStats = pipelineStates->GetStats();
+	printf("Pipeline states: %u requests, %u objects created, %.0f%% hit rate\n",
+		stateStats.Requests, stateStats.Created, pipelineStates->GetHitRate() * 100.0f);
 }
 
 // --------------------------------------------------------
@@ -106,52 +140,11 @@ void Game::LoadShaders()
 	skyBoxPixelShader = std::make_shared<SimplePixelShader>(device, context, GetFullPathTo_Wide(L"SkyBoxPixelShader.cso").c_str());
 	basicLightingShader = std::make_shared<SimplePixelShader>(device, context, GetFullPathTo_Wide(L"BasicLightingPixelShader.cso").c_str());
 	transparencyShader = std::make_shared<SimplePixelShader>(device, context, GetFullPathTo_Wide(L"TransparencyPixelShader.cso").c_str());
+	instancedVertexShader = std::make_shared<SimpleVertexShader>(device, context, GetFullPathTo_Wide(L"InstancedVertexShader.cso").c_str());
+	instancedTransparencyShader = std::make_shared<SimplePixelShader>(device, context, GetFullPathTo_Wide(L"InstancedTransparencyPixelShader.cso").c_str());
 	perturbationShader = std::make_shared<SimplePixelShader>(device, context, GetFullPathTo_Wide(L"PerturbationShader.cso").c_str());
 }
 
-void Game::SetLights() {
-	Light directionalLight = {};
-	directionalLight.type = LIGHT_TYPE_DIRECTIONAL;
-	directionalLight.color = XMFLOAT3(1, 1, 1);
-	directionalLight.direction = XMFLOAT3(0.5, -0.5, 1);
-	directionalLight.intensity = 0.8f;
-
-
-	Light pointLight1 = {};
-	pointLight1.type = LIGHT_TYPE_POINT;
-	pointLight1.color = XMFLOAT3(1, 1, 0);
-	pointLight1.position = XMFLOAT3(-6, 0, 0);
-	pointLight1.intensity = 0.8f;
-	pointLight1.range = 2;
-
-	Light pointLight2 = {};
-	pointLight2.type = LIGHT_TYPE_POINT;
-	pointLight2.color = XMFLOAT3(0, 0.5, 1);
-	pointLight2.position = XMFLOAT3(-2, 0, 0);
-	pointLight2.intensity = 0.8f;
-	pointLight2.range = 2;
-
-	Light pointLight3 = {};
-	pointLight3.type = LIGHT_TYPE_POINT;
-	pointLight3.color = XMFLOAT3(0, 1, 0);
-	pointLight3.position = XMFLOAT3(2, 0, 0);
-	pointLight3.intensity = 0.8f;
-	pointLight3.range = 2;
-
-	Light pointLight4 = {};
-	pointLight4.type = LIGHT_TYPE_POINT;
-	pointLight4.color = XMFLOAT3(1, 0, 0);
-	pointLight4.position = XMFLOAT3(6, 0, 0);
-	pointLight4.intensity = 0.8f;
-	pointLight4.range = 2;
-
-	lights.push_back(directionalLight);
-	lights.push_back(pointLight1);
-	lights.push_back(pointLight2);
-	lights.push_back(pointLight3);
-	lights.push_back(pointLight4);
-}
-
 // --------------------------------------------------------
 // Creates the geometry we're going to draw - a single triangle for now
 // --------------------------------------------------------
@@ -173,7 +166,7 @@ void Game::CreateBasicGeometry()
 	desc.Filter = D3D11_FILTER_ANISOTROPIC;
 	desc.MaxAnisotropy = 8; //1-16, higher is slower -- possibly adjust this later
 	desc.MaxLOD = D3D11_FLOAT32_MAX;
-	device->CreateSamplerState(&desc, samplerState.GetAddressOf());
+	samplerState = pipelineStates->GetSamplerState(desc);
 
 	D3D11_SAMPLER_DESC ppSampDesc = {};
 	ppSampDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
@@ -181,13 +174,37 @@ void Game::CreateBasicGeometry()
 	ppSampDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
 	ppSampDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
 	ppSampDesc.MaxLOD = D3D11_FLOAT32_MAX;
-	device->CreateSamplerState(&ppSampDesc, ppSampler.GetAddressOf());
+	ppSampler = pipelineStates->GetSamplerState(ppSampDesc);
 
 	metalHatchMaterial = new Material(XMFLOAT4(1, 1, 1, 1), vertexShader, basicLightingShader);
 	transparentMaterialR = new Material(XMFLOAT4(1, 0, 0, 0.15f), vertexShader, transparencyShader, 0.1f);
 	transparentMaterialG = new Material(XMFLOAT4(0, 1, 0, 0.1f), vertexShader, transparencyShader, 0.1f);
 	transparentMaterialB = new Material(XMFLOAT4(0, 0.5f, 1, 0.15f), vertexShader, transparencyShader, 0.1f);
 	transparentMaterialY = new Material(XMFLOAT4(1, 1, 0, 0.3f), vertexShader, transparencyShader, 0.1f);
+	// The transparent materials only differ by tint, so all four spheres can share one instanced draw
+	transparentMaterialR->SetInstancedShaders(instancedVertexShader, instancedTransparencyShader);
+	transparentMaterialG->SetInstancedShaders(instancedVertexShader, instancedTransparencyShader);
+	transparentMaterialB->SetInstancedShaders(instancedVertexShader, instancedTransparencyShader);
+	transparentMaterialY->SetInstancedShaders(instancedVertexShader, instancedTransparencyShader);
+
+	// Opaque materials draw with the default states, the transparent ones alpha blend; the cache makes each distinct pipeline once
+	PipelineStateDesc opaqueDesc;
+	opaqueDesc.VertexShader = vertexShader;
+	opaqueDesc.PixelShader = basicLightingShader;
+	metalHatchMaterial->SetPipelineStates(pipelineStates->GetPipelineState(opaqueDesc));
+	PipelineStateDesc transparentDesc;
+	transparentDesc.VertexShader = vertexShader;
+	transparentDesc.PixelShader = transparencyShader;
+	transparentDesc.Blend.RenderTarget[0].BlendEnable = true;
+	transparentDesc.Blend.RenderTarget[0].SrcBlend = D3D11_BLEND_SRC_ALPHA;
+	transparentDesc.Blend.RenderTarget[0].DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
+	PipelineStateDesc instancedTransparentDesc = transparentDesc;
+	instancedTransparentDesc.VertexShader = instancedVertexShader;
+	instancedTransparentDesc.PixelShader = instancedTransparencyShader;
+	Material* transparentMaterials[] = { transparentMaterialR, transparentMaterialG, transparentMaterialB, transparentMaterialY };
+	for (int i = 0; i < 4; i++) {
+		transparentMaterials[i]->SetPipelineStates(pipelineStates->GetPipelineState(transparentDesc), pipelineStates->GetPipelineState(instancedTransparentDesc));
+	}
 
 	metalHatchMaterial->AddTextureSRV("Albedo", metalHatchTex);
 	metalHatchMaterial->AddTextureSRV("RoughnessMap", metalHatchRoughness);
@@ -198,25 +215,236 @@ void Game::CreateBasicGeometry()
 	sphereMesh = new Mesh(GetFullPathTo("../../Assets/Models/sphere.obj").c_str(), device, context);
 	cubeMesh = new Mesh(GetFullPathTo("../../Assets/Models/cube.obj").c_str(), device, context);
 	quadMesh = new Mesh(GetFullPathTo("../../Assets/Models/quad.obj").c_str(), device, context);
+	meshes["sphere"] = sphereMesh;
+	meshes["cube"] = cubeMesh;
+	meshes["quad"] = quadMesh;
+
+	materials["metalHatch"] = metalHatchMaterial;
+	materials["redGlass"] = transparentMaterialR;
+	materials["greenGlass"] = transparentMaterialG;
+	materials["blueGlass"] = transparentMaterialB;
+	materials["yellowGlass"] = transparentMaterialY;
+
+	if (useStressScene) {
+		// Written out the first time each description is used, then cooked and loaded like any other scene
+		std::string name = StressScene::GetName(stressSceneDesc);
+		std::string textPath = GetFullPathTo(name + ".scene");
+		if (GetFileAttributesA(textPath.c_str()) == INVALID_FILE_ATTRIBUTES) {
+			SceneData stress;
+			StressScene::Generate(stressSceneDesc, stress);
+			SceneFile::SaveText(textPath.c_str(), stress);
+		}
+		LoadScene((name + ".scene").c_str(), (name + ".sceneb").c_str());
+	}
+	else {
+		LoadScene("../../Assets/Scenes/Basic.scene", "Basic.sceneb");
+	}
+
+#if STATIC_BATCH_TEST_SCENE
+	for (int x = -9; x <= 9; x++) {
+		for (int z = -9; z <= 9; z++) {
+			CreateMeshEntity(cubeMesh, metalHatchMaterial, XMFLOAT3((float)x, -0.9f, (float)z), XMFLOAT3(0.2f, 0.2f, 0.2f), true);
+		}
+	}
+#endif
+
+	// World matrices and bounds for everything, the static entities need them this once
+	transformSystem.Update(entities, true);
+
+	// A tree suits this mostly static scene; switch to a LooseGrid when most entities move every frame
+	// Entities get their proxies in Update, so ones created later (streamed in) are handled the same way
+	entityIndex = std::make_shared<DynamicAABBTree>();
+
+	// Nothing static moves, so those entities are merged into world-space chunks once here
+	std::vector<RenderObject> staticObjects;
+	entities.ForEach(COMPONENT_TRANSFORM | COMPONENT_RENDERABLE | COMPONENT_STATIC, 0, [&staticObjects](Archetype& archetype, unsigned int first, unsigned int last) {
+		for (unsigned int i = first; i < last; i++) {
+			RenderObject object;
+			object.RenderMesh = archetype.Renderables[i].RenderMesh;
+			object.RenderMaterial = archetype.Renderables[i].RenderMaterial;
+			object.World = archetype.Transforms[i].World;
+			object.Position = archetype.Transforms[i].Position;
+			staticObjects.push_back(object);
+		}
+	});
+	if (staticObjects.size() > 0) {
+		staticBatcher.Build(&staticObjects[0], (unsigned int)staticObjects.size(), device);
+	}
+	printf("Static batching: %u entities merged into %u draws (%u vertices)\n",
+		staticBatcher.GetStats().SourceEntities, staticBatcher.GetStats().Chunks, staticBatcher.GetStats().Vertices);
+
+#if STREAMED_WORLD
+	// 65536 shapes over 512x512 units, written out as 16 unit cells the first time
+	worldStreamer = std::make_shared<WorldStreamer>(device, context, jobSystem.get(), GetFullPathTo("../../Assets/Models/"));
+	std::string manifest = GetFullPathTo("StreamedWorld.world");
+	if (!worldStreamer->Open(manifest.c_str())) {
+		SceneData field;
+		field.MeshNames = { "cube", "sphere", "torus", "cylinder" };
+		field.MaterialNames.push_back("metalHatch");
+		field.AmbientColor = ambientColor;
+		for (int x = 0; x < 256; x++) {
+			for (int z = 0; z < 256; z++) {
+				SceneEntity entity = {};
+				entity.MeshIndex = (x + z) % field.MeshNames.size();
+				entity.Position = XMFLOAT3(x * 2.0f - 256.0f, -0.6f, z * 2.0f - 256.0f);
+				entity.Scale = XMFLOAT3(0.4f, 0.4f, 0.4f);
+				field.Entities.push_back(entity);
+			}
+		}
+		WorldStreamer::WriteWorld(field, 16.0f, manifest.c_str());
+		worldStreamer->Open(manifest.c_str());
+	}
+#endif
+
+	skyBox = new SkyBox(cubeMesh, skyBoxTex, skyBoxVertexShader, skyBoxPixelShader, samplerState, pipelineStates);
+}
+
+// --------------------------------------------------------
+// Creates an entity with a transform, a renderable and
+// bounds.  Static ones are baked by staticBatcher and never
+// move, the rest get culled and drawn every frame.
+// --------------------------------------------------------
+EntityHandle Game::CreateMeshEntity(Mesh* mesh, Material* material, XMFLOAT3 position, XMFLOAT3 scale, bool isStatic)
+{
+	EntityHandle entity = entities.Create(COMPONENT_TRANSFORM | COMPONENT_RENDERABLE | COMPONENT_BOUNDS | (isStatic ? COMPONENT_STATIC : 0));
+	TransformComponent* transform = entities.GetTransform(entity);
+	transform->Position = position;
+	transform->Scale = scale;
+	RenderableComponent* renderable = entities.GetRenderable(entity);
+	renderable->RenderMesh = mesh;
+	renderable->RenderMaterial = material;
+	return entity;
+}
+
+// --------------------------------------------------------
+// Creates the entities, lights and ambient color from a
+// scene.  The text form is cooked to the binary one first
+// if it's newer, after that loading is mapping the binary
+// file and walking its entity array.  Mesh names load
+// ../../Assets/Models/<name>.obj the first time they're
+// seen; material names must already be in materials.
+// --------------------------------------------------------
+bool Game::LoadScene(const char* textFileName, const char* binaryFileName)
+{
+	ALLOC_TAG("Scene load");
+	std::string textPath = GetFullPathTo(textFileName);
+	std::string binaryPath = GetFullPathTo(binaryFileName);
+	if (!SceneFile::Cook(textPath.c_str(), binaryPath.c_str())) {
+		return false;
+	}
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	MappedScene scene;
+	if (!scene.Open(binaryPath.c_str())) {
+		printf("Scene: %s is damaged or out of date, delete it to re-cook\n", binaryPath.c_str());
+		return false;
+	}
+
+	// Models that aren't loaded yet are parsed as one job each (buffer creation is free-threaded in D3D11)
+	std::vector<std::string> newMeshNames;
+	for (unsigned int i = 0; i < scene.GetMeshCount(); i++) {
+		std::string name = scene.GetMeshName(i);
+		if (meshes.find(name) == meshes.end() && std::find(newMeshNames.begin(), newMeshNames.end(), name) == newMeshNames.end()) {
+			newMeshNames.push_back(name);
+		}
+	}
+	std::vector<Mesh*> newMeshes(newMeshNames.size());
+	jobSystem->ParallelFor((unsigned int)newMeshNames.size(), 1, [&](unsigned int first, unsigned int last) {
+		for (unsigned int i = first; i < last; i++) {
+			newMeshes[i] = new Mesh(GetFullPathTo("../../Assets/Models/" + newMeshNames[i] + ".obj").c_str(), device, context);
+		}
+	});
+	for (int i = 0; i < newMeshNames.size(); ++i) {
+		meshes[newMeshNames[i]] = newMeshes[i];
+	}
+	std::vector<Mesh*> sceneMeshes(scene.GetMeshCount());
+	for (unsigned int i = 0; i < scene.GetMeshCount(); i++) {
+		sceneMeshes[i] = meshes[scene.GetMeshName(i)];
+	}
+	std::vector<Material*> sceneMaterials(scene.GetMaterialCount());
+	for (unsigned int i = 0; i < scene.GetMaterialCount(); i++) {
+		sceneMaterials[i] = FindMaterial(scene.GetMaterialName(i));
+	}
+
+	const SceneEntity* sceneEntities = scene.GetEntities();
+	for (unsigned int i = 0; i < scene.GetEntityCount(); i++) {
+		const SceneEntity& sceneEntity = sceneEntities[i];
+		if (sceneEntity.MeshIndex >= sceneMeshes.size() || sceneEntity.MaterialIndex >= sceneMaterials.size()) {
+			continue;
+		}
+		EntityHandle entity = CreateMeshEntity(sceneMeshes[sceneEntity.MeshIndex], sceneMaterials[sceneEntity.MaterialIndex],
+			sceneEntity.Position, sceneEntity.Scale, (sceneEntity.Flags & SCENE_ENTITY_STATIC) != 0);
+		entities.GetTransform(entity)->Rotation = sceneEntity.Rotation;
+		if (sceneEntity.Flags & SCENE_ENTITY_OCCLUDER) {
+			occluders.push_back(entity);
+		}
+	}
+
+	unsigned int lightCount = scene.GetLightCount();
+	if (lightCount > MAX_LIGHTS) {
+		printf("Scene: %u lights in %s, only the first %d are drawn\n", lightCount, textFileName, MAX_LIGHTS);
+		lightCount = MAX_LIGHTS;
+	}
+	lights.assign(scene.GetLights(), scene.GetLights() + lightCount);
+	ambientColor = scene.GetAmbientColor();
+
+	std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+	printf("Scene: %u entities from %s in %.2f ms\n", scene.GetEntityCount(), binaryFileName,
+		std::chrono::duration<double, std::milli>(end - start).count());
+	return true;
+}
+
+// Materials scene files can name, unknown names fall back to metalHatch so the entity still shows up
+Material* Game::FindMaterial(const std::string& name)
+{
+	std::map<std::string, Material*>::iterator found = materials.find(name);
+	if (found == materials.end()) {
+		printf("Scene: no material called %s, using metalHatch\n", name.c_str());
+		return metalHatchMaterial;
+	}
+	return found->second;
+}
+
+// --------------------------------------------------------
+// Applies what worldStreamer did this frame: entities of
+// cells it dropped are destroyed (with their proxies), and
+// cells it finished loading become entities.  Streamed
+// entities are never static, the static batch is baked
+// once at load.
+// --------------------------------------------------------
+void Game::StreamCells()
+{
+	ALLOC_TAG("Streaming");
+	unsigned int cell;
+	while (worldStreamer->PopUnloadedCell(cell)) {
+		std::vector<EntityHandle>& handles = cellEntities[cell];
+		for (int i = 0; i < handles.size(); ++i) {
+			RenderableComponent* renderable = entities.GetRenderable(handles[i]);
+			if (renderable && renderable->SpatialProxy >= 0) {
+				entityIndex->DestroyProxy(renderable->SpatialProxy);
+			}
+			entities.Destroy(handles[i]);
+		}
+		cellEntities.erase(cell);
+	}
 
-	std::shared_ptr<MeshEntity> sphere1 = std::make_shared<MeshEntity>(sphereMesh, transparentMaterialY);
-	sphere1->GetTransform()->SetPosition(-6, 0, 0);
-	std::shared_ptr<MeshEntity> sphere3 = std::make_shared<MeshEntity>(sphereMesh, transparentMaterialB);
-	sphere3->GetTransform()->SetPosition(-2, 0, 0);
-	std::shared_ptr<MeshEntity> sphere4 = std::make_shared<MeshEntity>(sphereMesh, transparentMaterialG);
-	sphere4->GetTransform()->SetPosition(2, 0, 0);
-	std::shared_ptr<MeshEntity> sphere2 = std::make_shared<MeshEntity>(sphereMesh, transparentMaterialR);
-	sphere2->GetTransform()->SetPosition(6, 0, 0);
-	meshEntities.push_back(sphere1);
-	meshEntities.push_back(sphere3);
-	meshEntities.push_back(sphere4);
-	meshEntities.push_back(sphere2);
-
-	ground = std::make_shared<MeshEntity>(quadMesh, metalHatchMaterial);
-	ground->GetTransform()->SetPosition(0, -1, 0);
-	ground->GetTransform()->SetScale(10, 10, 10);
-
-	skyBox = new SkyBox(cubeMesh, skyBoxTex, skyBoxVertexShader, skyBoxPixelShader, samplerState, device);
+	StreamedCell loaded;
+	while (worldStreamer->PopLoadedCell(loaded)) {
+		std::vector<Material*> cellMaterials(loaded.Scene.MaterialNames.size());
+		for (int i = 0; i < cellMaterials.size(); ++i) {
+			cellMaterials[i] = FindMaterial(loaded.Scene.MaterialNames[i]);
+		}
+		std::vector<EntityHandle>& handles = cellEntities[loaded.Cell];
+		for (int i = 0; i < loaded.Scene.Entities.size(); ++i) {
+			const SceneEntity& sceneEntity = loaded.Scene.Entities[i];
+			if (sceneEntity.MeshIndex >= loaded.Meshes.size() || !loaded.Meshes[sceneEntity.MeshIndex] || sceneEntity.MaterialIndex >= cellMaterials.size()) {
+				continue;
+			}
+			EntityHandle entity = CreateMeshEntity(loaded.Meshes[sceneEntity.MeshIndex], cellMaterials[sceneEntity.MaterialIndex], sceneEntity.Position, sceneEntity.Scale, false);
+			entities.GetTransform(entity)->Rotation = sceneEntity.Rotation;
+			handles.push_back(entity);
+		}
+	}
 }
 
 
@@ -275,23 +503,78 @@ void Game::ResizeOnePostProcessResource(
 // --------------------------------------------------------
 void Game::Update(float deltaTime, float totalTime)
 {
-	for (int i = 0; i < meshEntities.size(); ++i) {
-		//meshEntities.at(i)->GetTransform()->Turn(-0.5f * deltaTime, 0.5f * deltaTime, 0.5f * deltaTime);
+	PROFILE_FUNCTION();
+	ALLOC_TAG("Update");
+	if (worldStreamer) {
+		worldStreamer->Update(camera->GetTransform().GetPosition());
+		StreamCells();
+		const WorldStreamerStats& streamerStats = worldStreamer->GetStats();
+		streamedLoads += streamerStats.Loads;
+		streamedUnloads += streamerStats.Unloads;
+		streamingMicroseconds += streamerStats.UpdateMicroseconds;
+		streamingPeakMicroseconds = streamerStats.UpdateMicroseconds > streamingPeakMicroseconds ? streamerStats.UpdateMicroseconds : streamingPeakMicroseconds;
 	}
-	camera->Update(deltaTime);
 
-	XMFLOAT3 camPos = camera->GetTransform().GetPosition();
-	std::sort(meshEntities.begin(), meshEntities.end(), [&](std::shared_ptr<MeshEntity> a, std::shared_ptr<MeshEntity> b) -> bool {
-		XMFLOAT3 aPos = a->GetTransform()->GetPosition();
-		XMFLOAT3 bPos = b->GetTransform()->GetPosition();
-		float aDist = XMVectorGetX(XMVector3Length(XMLoadFloat3(&aPos) - XMLoadFloat3(&camPos)));
-		float bDist = XMVectorGetX(XMVector3Length(XMLoadFloat3(&bPos) - XMLoadFloat3(&camPos)));
-		return aDist > bDist;
+	// World matrices and bounds for whatever moved, then copy out what culling, sorting and drawing need
+	transformSystem.Update(entities);
+	renderObjects.clear();
+	entityPositions.clear();
+	entityBounds.clear();
+	entityProxies.clear();
+	entities.ForEach(COMPONENT_TRANSFORM | COMPONENT_RENDERABLE | COMPONENT_BOUNDS, COMPONENT_STATIC, [this](Archetype& archetype, unsigned int first, unsigned int last) {
+		for (unsigned int i = first; i < last; i++) {
+			const TransformComponent& transform = archetype.Transforms[i];
+			RenderableComponent& renderable = archetype.Renderables[i];
+			if (renderable.SpatialProxy < 0) {
+				renderable.SpatialProxy = entityIndex->CreateProxy(archetype.Bounds[i].WorldBounds, (void*)(uintptr_t)archetype.Entities[i].Index);
+			}
+			else {
+				//cheap when the entity hasn't left its fat box or cell
+				entityIndex->MoveProxy(renderable.SpatialProxy, archetype.Bounds[i].WorldBounds);
+			}
+
+			RenderObject object;
+			object.RenderMesh = renderable.RenderMesh;
+			object.RenderMaterial = renderable.RenderMaterial;
+			object.World = transform.World;
+			object.Position = transform.Position;
+			renderObjects.push_back(object);
+			entityPositions.push_back(transform.Position);
+			entityBounds.push_back(archetype.Bounds[i].WorldBounds);
+			entityProxies.push_back(renderable.SpatialProxy);
+		}
 	});
+	camera->Update(deltaTime);
+	if (!headless && camera->IsPathFinished())
+		Quit();
+
+	// Back to front order for the transparent entities, as indices into renderObjects
+	if (entityPositions.size() > 0) {
+		PROFILE_SCOPE("Depth sort");
+		ALLOC_TAG("Depth sort");
+		depthSorter.Sort(&entityPositions[0], (unsigned int)entityPositions.size(), camera->GetTransform().GetPosition());
+	}
 
 	// Example input checking: Quit if the escape key is pressed
 	if (Input::GetInstance().KeyDown(VK_ESCAPE))
 		Quit();
+
+	// F2 prints where the last frame's time went, F3 saves the recent past for chrome://tracing
+	if (Input::GetInstance().KeyPress(VK_F2))
+		Profiler::PrintFrameTree();
+	if (Input::GetInstance().KeyPress(VK_F3))
+		Profiler::ExportChromeTrace(GetFullPathTo("profile_trace.json"));
+
+	// F4 prints what the last frame allocated, F5 what was allocated since the last F5 and is still live
+	if (Input::GetInstance().KeyPress(VK_F4))
+		AllocationTracker::PrintFrame();
+	if (Input::GetInstance().KeyPress(VK_F5)) {
+		HeapSnapshot snapshot;
+		AllocationTracker::TakeSnapshot(snapshot);
+		if (!heapSnapshot.Blocks.empty())
+			AllocationTracker::PrintSnapshotDiff(heapSnapshot, snapshot);
+		heapSnapshot = std::move(snapshot);
+	}
 }
 
 // --------------------------------------------------------
@@ -299,6 +582,8 @@ void Game::Update(float deltaTime, float totalTime)
 // --------------------------------------------------------
 void Game::Draw(float deltaTime, float totalTime)
 {
+	PROFILE_FUNCTION();
+	ALLOC_TAG("Render");
 	// Background color (Cornflower Blue in this case) for clearing
 	const float color[4] = { 0.4f, 0.6f, 0.75f, 0.0f };
 
@@ -312,40 +597,201 @@ void Game::Draw(float deltaTime, float totalTime)
 		1.0f,
 		0);
 
-	// We can't do this in Material or MeshEntity because it can't be done to just any shader, just this one in particular
+	// We can't do this in Material or per entity because it can't be done to just any shader, just this one in particular
 	basicLightingShader->SetFloat3("cameraPosition", camera->GetTransform().GetPosition());
-	basicLightingShader->SetData("lights", &lights[0], sizeof(Light) * (int)lights.size());
+	basicLightingShader->SetInt("lightCount", (int)lights.size());
+	basicLightingShader->SetData("lights", lights.data(), sizeof(Light) * (int)lights.size());
 	transparencyShader->SetFloat3("cameraPosition", camera->GetTransform().GetPosition());
-	transparencyShader->SetData("lights", &lights[0], sizeof(Light) * (int)lights.size());
-	context->OMSetBlendState(NULL, NULL, 0xffffffff);
-	context->OMSetBlendState(transparencyBlendState, NULL, 0xffffffff); //all items in meshEntities are transparent
+	transparencyShader->SetInt("lightCount", (int)lights.size());
+	transparencyShader->SetData("lights", lights.data(), sizeof(Light) * (int)lights.size());
+	instancedTransparencyShader->SetFloat3("cameraPosition", camera->GetTransform().GetPosition());
+	instancedTransparencyShader->SetInt("lightCount", (int)lights.size());
+	instancedTransparencyShader->SetData("lights", lights.data(), sizeof(Light) * (int)lights.size());
 	//context->OMSetRenderTargets(1, refractionRTV.GetAddressOf(), depthStencilView.Get());
 	//context->PSSetSamplers(0, 1, samplerState.GetAddressOf());
-	ground->GetMaterial()->BindResources();
-	ground->Draw(camera, context);
-	skyBox->Draw(camera, context); //after drawing objects
-	//CreatePerturbations();
-	for (int i = 0; i < meshEntities.size(); ++i) {
-		std::shared_ptr<MeshEntity> currentEntity = meshEntities.at(i);
-		//should work fine without checking (just potentially unneccessary setting), does this help or hurt performance?
-		currentEntity->GetMaterial()->BindResources();			
-		if (currentEntity->GetMaterial()->GetPixelShader() == transparencyShader) {
-			transparencyShader->SetFloat3("position", meshEntities[i]->GetTransform()->GetPosition());
+	Frustum frustum = camera->GetFrustum();
+	CullEntities(frustum);
+
+	// Queue everything that survived culling; the queue sorts by state for opaques and back to front for transparents
+	// Small opaque meshes go to the dynamic batcher instead, anything it turns down is queued as usual
+	renderQueue.Clear();
+	dynamicBatcher->Clear();
+	for (int i = 0; i < visibleEntities.size(); ++i) {
+		const RenderObject* object = &renderObjects[visibleEntities[i]];
+		bool transparent = object->RenderMaterial->GetPixelShader() == transparencyShader;
+		if (!transparent && dynamicBatcher->Add(object)) {
+			continue;
 		}
-		currentEntity -> Draw(camera, context);
+		renderQueue.Add(object, transparent ? RENDER_PASS_TRANSPARENT : RENDER_PASS_OPAQUE, transparent, depthSorter.GetDepthSq(visibleEntities[i]));
+	}
+	// The queue sort and the batch grouping don't share anything, so the sort runs as a job alongside
+	JobCounter sorted;
+	jobSystem->Run([this] { renderQueue.Sort(); }, &sorted);
+	dynamicBatcher->Build();
+	jobSystem->Wait(sorted);
+
+	// The opaque pass is recorded in parallel chunks before the dynamic batcher sets anything on the shaders, then replayed in its place
+	// Replays go through stateFilter, which has to forget what it knows whenever something draws on the context directly
+	frameCommands.Clear();
+	staticBatcher.Record(camera, frustum, frameCommands); //the ground and anything else baked at load
+	renderQueue.Record(camera, RENDER_PASS_OPAQUE, frameCommands);
+	stateFilter->Invalidate();
+	frameCommands.Replay(*stateFilter);
+	dynamicBatcher->Submit(camera);
+	stateFilter->Invalidate();
+	frameCommands.Clear();
+	skyBox->Record(camera, frameCommands); //after opaque objects, before transparent ones
+	frameCommands.Replay(*stateFilter);
+	//CreatePerturbations();
+	// Neighbouring spheres that only differ by tint go out as one instanced draw, still back to front, with their materials' blending pipelines
+	renderQueue.GetRenderObjects(RENDER_PASS_TRANSPARENT, transparentObjects);
+	if (transparentObjects.size() > 0) {
+		instanceBatcher.Build(&transparentObjects[0], (unsigned int)transparentObjects.size(), true);
+		instancedRenderer->Begin(camera);
+		instanceBatcher.Submit(*instancedRenderer);
 	}
 	
 	// Present the back buffer to the user
 	//  - Puts the final frame we're drawing into the window so the user can see it
 	//  - Do this exactly ONCE PER FRAME (always at the very end of the frame)
-	swapChain->Present(vsync ? 1 : 0, 0);
+	frameStats.BeginPhase(FRAME_PHASE_PRESENT);
+	if (swapChain) { //there's none when running headless
+		swapChain->Present(vsync ? 1 : 0, 0);
+	}
 
 	// Due to the usage of a more sophisticated swap chain,
 	// the render target must be re-bound after every call to Present()
 	context->OMSetRenderTargets(1, backBufferRTV.GetAddressOf(), depthStencilView.Get());
 }
 
+// --------------------------------------------------------
+// Loads a camera path for the camera to fly along once it's
+// created.  Windowed, the game quits at the end of the path.
+// --------------------------------------------------------
+bool Game::SetFlythrough(const std::string& fileName)
+{
+	std::shared_ptr<CameraPath> path = std::make_shared<CameraPath>();
+	if (!path->Load(GetFullPathTo(fileName).c_str())) {
+		return false;
+	}
+	flythroughPath = path;
+	return true;
+}
+
+float Game::GetFlythroughDuration()
+{
+	return flythroughPath ? flythroughPath->GetDuration() : 0.0f;
+}
+
+void Game::SetStressScene(const StressSceneDesc& desc)
+{
+	stressSceneDesc = desc;
+	useStressScene = true;
+}
+
+// --------------------------------------------------------
+// What the recorded passes asked of the null backend over
+// a headless run, per frame, and what culling and streaming
+// got through
+// --------------------------------------------------------
+void Game::PrintHeadlessStats(unsigned int frameCount)
+{
+	if (!nullBackend) {
+		return;
+	}
+	const CommandBackendStats& stats = nullBackend->GetStats();
+	float frames = (float)frameCount;
+	printf("Headless: per frame %.1f draws (%.0f indices), %.1f shader changes, %.1f constant updates (%.0f bytes), %.1f resources, %.1f samplers, %.1f states, %.1f pipelines, %.1f mesh bindings\n",
+		stats.Draws / frames, stats.Indices / frames, stats.ShaderChanges / frames, stats.ConstantUpdates / frames, stats.ConstantBytes / frames,
+		stats.ResourceBindings / frames, stats.SamplerBindings / frames, stats.StateChanges / frames, stats.PipelineChanges / frames, stats.MeshBindings / frames);
+	printf("Headless: %u invalid calls\n", stats.Errors);
+	printf("Headless: per frame %.1f entities tested against the frustum, %.1f inside it, %.1f after occlusion culling; workload hash %08x\n",
+		culledCandidates / frames, frustumVisibleTotal / frames, visibleTotal / frames, workloadHash);
+	if (worldStreamer) {
+		printf("Headless: streaming loaded %u cells and unloaded %u, main thread %.1f us per frame, %.1f us at worst\n",
+			streamedLoads, streamedUnloads, streamingMicroseconds / frames, streamingPeakMicroseconds);
+	}
+
+	const StateFilterStats& filterStats = stateFilter->GetStats();
+	unsigned int filtered = filterStats.GetFiltered();
+	unsigned int calls = filterStats.GetIssued() + filtered;
+	printf("Headless: state filter dropped %u of %u calls (%.1f%%): %u shaders, %u constants, %u resources, %u samplers, %u states, %u pipelines, %u meshes\n",
+		filtered, calls, calls > 0 ? 100.0f * filtered / calls : 0.0f,
+		filterStats.Filtered[COMMAND_SET_VERTEX_SHADER] + filterStats.Filtered[COMMAND_SET_PIXEL_SHADER],
+		filterStats.Filtered[COMMAND_SET_CONSTANTS],
+		filterStats.Filtered[COMMAND_SET_SHADER_RESOURCE],
+		filterStats.Filtered[COMMAND_SET_SAMPLER],
+		filterStats.Filtered[COMMAND_SET_BLEND_STATE] + filterStats.Filtered[COMMAND_SET_RASTERIZER_STATE] + filterStats.Filtered[COMMAND_SET_DEPTH_STENCIL_STATE],
+		filterStats.Filtered[COMMAND_SET_PIPELINE_STATE],
+		filterStats.Filtered[COMMAND_SET_MESH_BUFFERS]);
+}
+
+// --------------------------------------------------------
+// Fills visibleEntities with the indices of every object in
+// renderObjects whose world bounds touch the frustum and are
+// not hidden behind an occluder, keeping the back-to-front
+// order from Update().  Counters for the passes are available
+// from frustumCuller.GetStats() and occlusionCuller.GetStats()
+// --------------------------------------------------------
+void Game::CullEntities(const Frustum& frustum)
+{
+	PROFILE_FUNCTION();
+	ALLOC_TAG("Culling");
+	// The occluders don't depend on the frustum passes, so they're rasterized as a job in the meantime
+	JobCounter rasterized;
+	jobSystem->Run([this] {
+		occlusionCuller.BeginFrame(camera->GetViewMatrix(), camera->GetProjectionMatrix());
+		for (int i = 0; i < occluders.size(); ++i) {
+			Mesh* occluderMesh = entities.GetRenderable(occluders[i])->RenderMesh;
+			if (occluderMesh->GetIndices().empty()) {
+				continue;
+			}
+			occlusionCuller.AddOccluder(occluderMesh->GetPositions().data(), occluderMesh->GetIndices().data(), (unsigned int)occluderMesh->GetIndices().size(), entities.GetTransform(occluders[i])->World);
+		}
+		occlusionCuller.RasterizeOccluders();
+	}, &rasterized);
+
+	// Coarse pass: the spatial index throws out whole off-screen regions using fat or loose bounds
+	cullFrame++;
+	indexHits.clear();
+	entityIndex->QueryFrustum(frustum, indexHits);
+	proxyHitFrame.resize(entityIndex->GetProxyCapacity(), 0);
+	for (int i = 0; i < indexHits.size(); ++i) {
+		proxyHitFrame[indexHits[i]] = cullFrame;
+	}
+
+	// Exact pass on the survivors, walked back to front so visibleEntities keeps that order
+	frustumCuller.Clear();
+	frustumCuller.Reserve((unsigned int)indexHits.size());
+	cullCandidates.clear();
+	const std::vector<uint32_t>& backToFront = depthSorter.GetOrder();
+	for (int o = 0; o < backToFront.size(); ++o) {
+		unsigned int i = backToFront[o];
+		if (proxyHitFrame[entityProxies[i]] != cullFrame) {
+			continue;
+		}
+		frustumCuller.Add(entityBounds[i]);
+		cullCandidates.push_back(i);
+	}
+	frustumCuller.Cull(frustum, frustumVisibleEntities);
+	for (int i = 0; i < frustumVisibleEntities.size(); ++i) {
+		frustumVisibleEntities[i] = cullCandidates[frustumVisibleEntities[i]]; //culler index -> renderObjects index
+	}
+
+	jobSystem->Wait(rasterized);
+	occlusionCuller.Cull(entityBounds, frustumVisibleEntities, visibleEntities);
+
+	culledCandidates += cullCandidates.size();
+	frustumVisibleTotal += frustumVisibleEntities.size();
+	visibleTotal += visibleEntities.size();
+	for (int i = 0; i < visibleEntities.size(); ++i) {
+		workloadHash = (workloadHash ^ visibleEntities[i]) * 16777619u; //FNV-1a
+	}
+	workloadHash = (workloadHash ^ (uint32_t)visibleEntities.size()) * 16777619u;
+}
+
 void Game::CreatePerturbations() {
+	ALLOC_TAG("Perturbations");
 	D3D11_VIEWPORT vp = {};
 	vp.Width = width;
 	vp.Height = height;
@@ -361,17 +807,18 @@ void Game::CreatePerturbations() {
 	perturbationShader->SetShaderResourceView("Pixels", refractionSRV.Get());
 
 	std::vector<Sphere> spheres;
+	spheres.reserve(renderObjects.size());
 	XMMATRIX proj = XMLoadFloat4x4(&(camera->GetProjectionMatrix()));
 	XMMATRIX view = XMLoadFloat4x4(&(camera->GetViewMatrix()));
-	for (int i = 0; i < meshEntities.size(); i++) {
-		XMMATRIX world = XMLoadFloat4x4(&(meshEntities[i]->GetTransform()->GetWorldMatrix()));
+	for (int i = 0; i < renderObjects.size(); i++) {
+		XMMATRIX world = XMLoadFloat4x4(&(renderObjects[i].World));
 		XMMATRIX wvp = XMMatrixMultiply(XMMatrixMultiply(proj, view), world);
 		Sphere sphere = {};
-		XMVECTOR spherePos = XMVector4Transform(XMLoadFloat3(&(meshEntities[i]->GetTransform()->GetPosition())), wvp);
+		XMVECTOR spherePos = XMVector4Transform(XMLoadFloat3(&(renderObjects[i].Position)), wvp);
 		XMStoreFloat2(&(sphere.Position), spherePos/XMVectorGetByIndex(spherePos, 2));
 		float one = 1.0f;
 		XMStoreFloat(&(sphere.Radius), XMLoadFloat(&one) / XMVectorGetByIndex(spherePos, 3));
-		sphere.Roughness = meshEntities[i]->GetMaterial()->GetRoughness();
+		sphere.Roughness = renderObjects[i].RenderMaterial->GetRoughness();
 		spheres.push_back(sphere);
 	}
 	perturbationShader->SetData("spheres", &spheres[0], sizeof(Sphere) * (int)spheres.size());
@@ -4,14 +4,41 @@
 #include "Lights.h"
 
 #include <wrl/client.h> // Used for ComPtr - a smart pointer for COM objects
+#include <map>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "SimpleShader.h"
 #include "Mesh.h"
-#include "MeshEntity.h"
+#include "JobSystem.h"
+#include "EntityWorld.h"
+#include "TransformSystem.h"
+#include "RenderObject.h"
+#include "SceneFile.h"
+#include "WorldStreamer.h"
 #include "Camera.h"
 #include "Skybox.h"
+#include "FrustumCuller.h"
+#include "OcclusionCuller.h"
+#include "DynamicAABBTree.h"
+#include "LooseGrid.h"
+#include "RenderQueue.h"
+#include "CommandBuffer.h"
+#include "D3D11CommandBackend.h"
+#include "NullCommandBackend.h"
+#include "StateFilterBackend.h"
+#include "PipelineStateCache.h"
+#include "DepthSorter.h"
+#include "InstanceBatcher.h"
+#include "InstancedRenderer.h"
+#include "DynamicBatcher.h"
+#include "StaticBatcher.h"
+#include "StressScene.h"
+#include "AllocationTracker.h"
+
+// How far along the benchmark flythrough each frame goes, windowed or headless; the same as -headless's default step
+#define FLYTHROUGH_STEP (1.0f / 60)
 
 class Game 
 	: public DXCore
@@ -27,6 +54,13 @@ public:
 	void OnResize();
 	void Update(float deltaTime, float totalTime);
 	void Draw(float deltaTime, float totalTime);
+	void PrintHeadlessStats(unsigned int frameCount);
+
+	// Benchmark flythrough: the camera follows the path instead of input; call before Init
+	bool SetFlythrough(const std::string& fileName);
+	float GetFlythroughDuration();
+	// A generated scene in place of Basic.scene; call before Init
+	void SetStressScene(const StressSceneDesc& desc);
 
 private:
 
@@ -37,8 +71,10 @@ private:
 	std::shared_ptr<SimplePixelShader> perturbationShader;
 	std::shared_ptr<SimplePixelShader> basicLightingShader;
 	std::shared_ptr<SimplePixelShader> transparencyShader;
+	std::shared_ptr<SimplePixelShader> instancedTransparencyShader;
 	std::shared_ptr<SimplePixelShader> skyBoxPixelShader;
 	std::shared_ptr<SimpleVertexShader> vertexShader;
+	std::shared_ptr<SimpleVertexShader> instancedVertexShader;
 	std::shared_ptr<SimpleVertexShader> fullScreenVertexShader;
 	std::shared_ptr<SimpleVertexShader> skyBoxVertexShader;
 
@@ -47,11 +83,60 @@ private:
 	Mesh* sphereMesh;
 	Mesh* quadMesh;
 	Mesh* cubeMesh;
+	std::map<std::string, Mesh*> meshes; //by model name, owns every mesh including the three above
+	std::map<std::string, Material*> materials; //by the names scene files use
 
 	SkyBox* skyBox;
 
-	std::shared_ptr<MeshEntity> ground;
-	std::vector<std::shared_ptr<MeshEntity>> meshEntities;
+	std::shared_ptr<JobSystem> jobSystem; //declared before everything that runs jobs on it, so it's destroyed after them
+	EntityWorld entities;
+	TransformSystem transformSystem;
+	std::vector<EntityHandle> occluders; //scene entities flagged as occluders
+	StaticBatcher staticBatcher; //every COMPONENT_STATIC entity, baked at load
+	// One slot per dynamic renderable entity, copied out of entities every Update
+	std::vector<RenderObject> renderObjects;
+	std::vector<DirectX::XMFLOAT3> entityPositions; //for the depth sort
+	std::vector<AABB> entityBounds;
+	std::vector<int> entityProxies;
+	DepthSorter depthSorter;
+	std::shared_ptr<WorldStreamer> worldStreamer; //only with STREAMED_WORLD
+	std::map<unsigned int, std::vector<EntityHandle>> cellEntities; //what each streamed-in cell created
+
+	// Culling
+	std::shared_ptr<ISpatialIndex> entityIndex; //holds every dynamic renderable entity, updated as they move
+	std::vector<int> indexHits;
+	std::vector<unsigned int> proxyHitFrame; //indexed by proxy id, equal to cullFrame when the index query hit it
+	unsigned int cullFrame;
+
+	// Benchmark setup, and work counted over the run for the headless report
+	std::shared_ptr<CameraPath> flythroughPath;
+	StressSceneDesc stressSceneDesc;
+	bool useStressScene;
+	uint64_t culledCandidates;		// Entities handed to the exact frustum pass
+	uint64_t frustumVisibleTotal;
+	uint64_t visibleTotal;			// After occlusion culling too
+	uint32_t workloadHash;			// Of every frame's visible set, the same on every run of the same path
+	unsigned int streamedLoads;
+	unsigned int streamedUnloads;
+	double streamingMicroseconds;	// Main thread time in WorldStreamer::Update, summed
+	double streamingPeakMicroseconds;
+	FrustumCuller frustumCuller;
+	OcclusionCuller occlusionCuller;
+	std::vector<unsigned int> cullCandidates; //renderObjects indices handed to frustumCuller, in the order they were added
+	std::vector<unsigned int> frustumVisibleEntities;
+	std::vector<unsigned int> visibleEntities; //indices into renderObjects that survived culling this frame
+
+	RenderQueue renderQueue;
+	CommandBuffer frameCommands; //recorded off the context, then replayed into stateFilter
+	std::shared_ptr<ICommandBackend> commandBackend;
+	std::shared_ptr<NullCommandBackend> nullBackend; //the commandBackend when headless, kept for its stats
+	std::shared_ptr<StateFilterBackend> stateFilter; //in front of commandBackend, drops calls that change nothing
+	std::shared_ptr<PipelineStateCache> pipelineStates; //every fixed-function state and pipeline comes from here
+	InstanceBatcher instanceBatcher;
+	std::shared_ptr<InstancedRenderer> instancedRenderer;
+	std::vector<const RenderObject*> transparentObjects; //the queue's transparent pass, back to front
+	std::shared_ptr<DynamicBatcher> dynamicBatcher; //small opaque meshes, merged into shared buffers every frame
+	HeapSnapshot heapSnapshot; //the last F5, what the next one is diffed against
 
 	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> metalHatchTex;
 	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> metalHatchRoughness;
@@ -73,7 +158,6 @@ private:
 	Material* transparentMaterialB;
 	Material* transparentMaterialY;
 
-	ID3D11BlendState* transparencyBlendState;
 
 	std::vector<Light> lights;
 
@@ -82,9 +166,13 @@ private:
 	// Initialization helper methods - feel free to customize, combine, etc.
 	void LoadShaders(); 
 	void CreateBasicGeometry();
-	void SetLights();
 	void ResizeOnePostProcessResource(Microsoft::WRL::ComPtr<ID3D11RenderTargetView>& rtv, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>& srv);
 	void CreatePerturbations();
+	void CullEntities(const Frustum& frustum);
+	bool LoadScene(const char* textFileName, const char* binaryFileName);
+	Material* FindMaterial(const std::string& name);
+	void StreamCells();
+	EntityHandle CreateMeshEntity(Mesh* mesh, Material* material, DirectX::XMFLOAT3 position, DirectX::XMFLOAT3 scale, bool isStatic);
 
 	// Note the usage of ComPtr below
 	//  - This is a smart pointer for objects that abide by the
@@ -0,0 +1,48 @@
+#pragma once
+#include <stdint.h>
+
+#define SHADER_STAGE_VERTEX 0
+#define SHADER_STAGE_PIXEL 1
+
+// --------------------------------------------------------
+// Everything a PipelineState binds, as handles: shaders,
+// input layout and the three fixed-function states
+// --------------------------------------------------------
+struct PipelineHandles
+{
+	void* VertexShader;
+	void* InputLayout;
+	void* PixelShader;
+	void* BlendState;
+	void* RasterizerState;
+	void* DepthStencilState;
+	uint32_t StencilRef;
+	uint32_t Padding;
+};
+
+// --------------------------------------------------------
+// Whatever a CommandBuffer is replayed into.  Resources are
+// opaque handles that only the backend knows how to use:
+// for D3D11CommandBackend they're the raw ID3D11 pointers.
+// A null handle unbinds, like it does in D3D11.
+// --------------------------------------------------------
+class ICommandBackend
+{
+public:
+	virtual ~ICommandBackend() {}
+
+	virtual void SetVertexShader(void* shader, void* inputLayout) = 0;
+	virtual void SetPixelShader(void* shader) = 0;
+	//uploads size bytes into buffer, then binds it to the slot
+	virtual void SetConstants(unsigned int stage, unsigned int slot, void* buffer, const void* data, unsigned int size) = 0;
+	virtual void SetShaderResource(unsigned int stage, unsigned int slot, void* resource) = 0;
+	virtual void SetSampler(unsigned int stage, unsigned int slot, void* sampler) = 0;
+	virtual void SetBlendState(void* state) = 0;
+	virtual void SetRasterizerState(void* state) = 0;
+	virtual void SetDepthStencilState(void* state, unsigned int stencilRef) = 0;
+	//all of the above but constants and bindings, in one call
+	virtual void SetPipelineState(const PipelineHandles& pipeline) = 0;
+	//32-bit indices, one vertex stream at offset 0
+	virtual void SetMeshBuffers(void* vertexBuffer, void* indexBuffer, unsigned int stride) = 0;
+	virtual void DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex) = 0;
+};
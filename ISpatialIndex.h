@@ -0,0 +1,35 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+#include "Bounds.h"
+#include "Frustum.h"
+
+// --------------------------------------------------------
+// The interface renderers and gameplay code use to find
+// entities by location, so the structure behind it can be
+// picked per scene:
+//  - DynamicAABBTree for mostly static or slow scenes
+//  - LooseGrid when most entities move every frame
+//
+// Proxy ids are handed out by CreateProxy, and each proxy
+// carries an opaque userData pointer.  Queries append the
+// ids of matching proxies and may report false positives
+// (fat or loose bounds) but never false negatives.
+// --------------------------------------------------------
+class ISpatialIndex
+{
+public:
+	virtual ~ISpatialIndex() {}
+
+	virtual int CreateProxy(const AABB& bounds, void* userData) = 0;
+	virtual void DestroyProxy(int proxyId) = 0;
+	//returns true if the structure had to change to follow the proxy
+	virtual bool MoveProxy(int proxyId, const AABB& bounds) = 0;
+	virtual void* GetUserData(int proxyId) = 0;
+
+	virtual void QueryFrustum(const Frustum& frustum, std::vector<int>& proxies) = 0;
+	virtual void QuerySphere(DirectX::XMFLOAT3 center, float radius, std::vector<int>& proxies) = 0;
+
+	virtual int GetProxyCount() = 0;
+	virtual int GetProxyCapacity() = 0; //upper bound on proxy ids, handy for sizing per-proxy arrays
+};
@@ -117,6 +117,45 @@ void Input::Update()
 	mouseYDelta = mouseY - prevMouseY;
 }
 
+// ----------------------------------------------------------
+//  Copies this frame's input state (not the timing) out,
+//  for recording.  Only whether each key is down is kept,
+//  which is all the key functions look at.
+// ----------------------------------------------------------
+void Input::GetFrame(InputFrame& frame)
+{
+	memset(frame.KeysDown, 0, sizeof(frame.KeysDown));
+	for (int i = 0; i < 256; i++)
+	{
+		if (kbState[i] & 0x80)
+			frame.KeysDown[i / 8] |= 1 << (i % 8);
+	}
+	frame.MouseX = mouseX;
+	frame.MouseY = mouseY;
+	frame.Wheel = wheelDelta;
+}
+
+// ----------------------------------------------------------
+//  Updates the input manager from a recorded frame instead
+//  of the OS.  Call it where Update would be called, after
+//  the window messages, so the recorded wheel value wins
+//  over anything the real mouse did.
+// ----------------------------------------------------------
+void Input::SetFrame(const InputFrame& frame)
+{
+	memcpy(prevKbState, kbState, sizeof(unsigned char) * 256);
+	for (int i = 0; i < 256; i++)
+		kbState[i] = (frame.KeysDown[i / 8] & (1 << (i % 8))) ? 0x80 : 0;
+
+	prevMouseX = mouseX;
+	prevMouseY = mouseY;
+	mouseX = frame.MouseX;
+	mouseY = frame.MouseY;
+	mouseXDelta = mouseX - prevMouseX;
+	mouseYDelta = mouseY - prevMouseY;
+	wheelDelta = frame.Wheel;
+}
+
 // ----------------------------------------------------------
 //  Resets the mouse wheel value at the end of the frame.
 //  This cannot occur earlier in the frame, since the wheel
@@ -2,6 +2,18 @@
 
 #include <Windows.h>
 
+// Everything Input takes from the OS in one frame, plus the frame's
+// timing from DXCore; what an InputRecording stores per frame
+struct InputFrame
+{
+	float DeltaTime;
+	float TotalTime;
+	int MouseX;
+	int MouseY;
+	float Wheel;
+	unsigned char KeysDown[32];	// One bit per virtual key
+};
+
 class Input
 {
 #pragma region Singleton
@@ -33,6 +45,10 @@ public:
 	void Update();
 	void EndOfFrame();
 
+	// Recording and playback; SetFrame takes the place of Update
+	void GetFrame(InputFrame& frame);
+	void SetFrame(const InputFrame& frame);
+
 	int GetMouseX();
 	int GetMouseY();
 	int GetMouseXDelta();
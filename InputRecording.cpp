@@ -0,0 +1,146 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <fstream>
+#include <iterator>
+#include "InputRecording.h"
+
+#define INPUT_RECORDING_MAGIC 0x52504E49	// "INPR"
+#define INPUT_RECORDING_VERSION 1
+
+struct InputRecordingHeader
+{
+	uint32_t Magic;
+	uint32_t Version;
+	uint32_t FrameCount;
+};
+
+// Each frame on disk, followed by ChangedKeys key codes
+struct InputRecordingFrame
+{
+	float DeltaTime;
+	float TotalTime;
+	int32_t MouseX;
+	int32_t MouseY;
+	float Wheel;
+	uint16_t ChangedKeys;
+};
+
+// Fields are written one at a time, so there's no padding in the file whatever the compiler does
+template<typename T>
+static void Write(std::vector<char>& buffer, const T& value)
+{
+	buffer.insert(buffer.end(), (const char*)&value, (const char*)&value + sizeof(T));
+}
+
+template<typename T>
+static bool Read(const std::vector<char>& buffer, size_t& offset, T& value)
+{
+	if (offset + sizeof(T) > buffer.size()) {
+		return false;
+	}
+	memcpy(&value, &buffer[offset], sizeof(T));
+	offset += sizeof(T);
+	return true;
+}
+
+void InputRecording::Clear()
+{
+	frames.clear();
+}
+
+void InputRecording::AddFrame(const InputFrame& frame)
+{
+	frames.push_back(frame);
+}
+
+unsigned int InputRecording::GetFrameCount() const
+{
+	return (unsigned int)frames.size();
+}
+
+const InputFrame& InputRecording::GetFrame(unsigned int index) const
+{
+	return frames[index];
+}
+
+bool InputRecording::Save(const std::string& path) const
+{
+	std::vector<char> buffer;
+	Write(buffer, (uint32_t)INPUT_RECORDING_MAGIC);
+	Write(buffer, (uint32_t)INPUT_RECORDING_VERSION);
+	Write(buffer, (uint32_t)frames.size());
+
+	unsigned char keysDown[32] = {};
+	for (size_t f = 0; f < frames.size(); f++) {
+		const InputFrame& frame = frames[f];
+		uint8_t changed[256];
+		uint16_t changedCount = 0;
+		for (int key = 0; key < 256; key++) {
+			if ((frame.KeysDown[key / 8] ^ keysDown[key / 8]) & (1 << (key % 8))) {
+				changed[changedCount++] = (uint8_t)key;
+			}
+		}
+		memcpy(keysDown, frame.KeysDown, sizeof(keysDown));
+
+		Write(buffer, frame.DeltaTime);
+		Write(buffer, frame.TotalTime);
+		Write(buffer, (int32_t)frame.MouseX);
+		Write(buffer, (int32_t)frame.MouseY);
+		Write(buffer, frame.Wheel);
+		Write(buffer, changedCount);
+		buffer.insert(buffer.end(), (const char*)changed, (const char*)changed + changedCount);
+	}
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file) {
+		printf("Input recording: couldn't write %s\n", path.c_str());
+		return false;
+	}
+	file.write(&buffer[0], buffer.size());
+	return (bool)file;
+}
+
+bool InputRecording::Load(const std::string& path)
+{
+	frames.clear();
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		printf("Input recording: couldn't open %s\n", path.c_str());
+		return false;
+	}
+	std::vector<char> buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	size_t offset = 0;
+	InputRecordingHeader header;
+	bool valid = Read(buffer, offset, header.Magic) && Read(buffer, offset, header.Version) && Read(buffer, offset, header.FrameCount)
+		&& header.Magic == INPUT_RECORDING_MAGIC && header.Version == INPUT_RECORDING_VERSION;
+
+	InputFrame frame = {};
+	for (uint32_t f = 0; valid && f < header.FrameCount; f++) {
+		InputRecordingFrame stored;
+		valid = Read(buffer, offset, stored.DeltaTime) && Read(buffer, offset, stored.TotalTime)
+			&& Read(buffer, offset, stored.MouseX) && Read(buffer, offset, stored.MouseY)
+			&& Read(buffer, offset, stored.Wheel) && Read(buffer, offset, stored.ChangedKeys)
+			&& stored.ChangedKeys <= 256 && offset + stored.ChangedKeys <= buffer.size();
+		if (!valid) {
+			break;
+		}
+		for (unsigned int k = 0; k < stored.ChangedKeys; k++) {
+			uint8_t key = (uint8_t)buffer[offset++];
+			frame.KeysDown[key / 8] ^= 1 << (key % 8);
+		}
+		frame.DeltaTime = stored.DeltaTime;
+		frame.TotalTime = stored.TotalTime;
+		frame.MouseX = stored.MouseX;
+		frame.MouseY = stored.MouseY;
+		frame.Wheel = stored.Wheel;
+		frames.push_back(frame);
+	}
+	if (!valid || offset != buffer.size()) {
+		printf("Input recording: %s is damaged or out of date\n", path.c_str());
+		frames.clear();
+		return false;
+	}
+	return true;
+}
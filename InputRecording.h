@@ -0,0 +1,29 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "Input.h"
+
+// --------------------------------------------------------
+// Input and frame timing for a run, frame by frame, so the
+// run can be played back exactly, for benchmarks that do
+// the same work every time.
+//
+// On disk it's a small header followed by each frame's
+// timing, mouse and wheel, and the keys that went up or
+// down since the frame before; a few dozen bytes a frame.
+// Saving what Load read gives back the same bytes.
+// --------------------------------------------------------
+class InputRecording
+{
+private:
+	std::vector<InputFrame> frames;
+public:
+	void Clear();
+	void AddFrame(const InputFrame& frame);
+	unsigned int GetFrameCount() const;
+	const InputFrame& GetFrame(unsigned int index) const;
+
+	bool Save(const std::string& path) const;
+	//false, and the recording is left empty, if the file is missing or damaged
+	bool Load(const std::string& path);
+};
@@ -0,0 +1,135 @@
+#include "InstanceBatcher.h"
+
+using namespace DirectX;
+
+InstanceBatcher::InstanceBatcher()
+{
+	stats = {};
+}
+
+void InstanceBatcher::PackInstance(const RenderObject* object, InstanceData& instance)
+{
+	instance.World = object->World;
+	instance.Tint = object->RenderMaterial->GetColorTint();
+	instance.Center = object->Position;
+}
+
+bool InstanceBatcher::CanShareBatch(const InstanceBatch& batch, const RenderObject* object)
+{
+	return batch.Instanced &&
+		batch.SharedMesh == object->RenderMesh &&
+		batch.SharedMaterial->CanInstanceWith(object->RenderMaterial);
+}
+
+void InstanceBatcher::Build(const RenderObject* const* objects, unsigned int count, bool keepOrder)
+{
+	instances.resize(count);
+	batches.clear();
+	stats = {};
+	stats.Objects = count;
+
+	if (keepOrder) {
+		// Objects are packed in the order given, a new batch starts whenever a neighbour can't join
+		for (unsigned int i = 0; i < count; i++) {
+			const RenderObject* object = objects[i];
+			if (batches.empty() || !CanShareBatch(batches.back(), object)) {
+				InstanceBatch batch;
+				batch.SharedMesh = object->RenderMesh;
+				batch.SharedMaterial = object->RenderMaterial;
+				batch.FirstObject = object;
+				batch.FirstInstance = i;
+				batch.InstanceCount = 0;
+				batch.Instanced = batch.SharedMaterial->IsInstanced();
+				batches.push_back(batch);
+			}
+			batches.back().InstanceCount++;
+			PackInstance(object, instances[i]);
+		}
+	}
+	else {
+		// First pass finds each object's batch, checking only the batches that use its mesh.  The lists are
+		// emptied rather than the map, so meshes seen last frame don't cost an allocation again, unless
+		// unloaded meshes have left it far bigger than this frame needs
+		if (meshBatches.size() > 2 * count + 64) {
+			meshBatches.clear();
+		}
+		for (auto it = meshBatches.begin(); it != meshBatches.end(); ++it) {
+			it->second.clear();
+		}
+		objectBatch.resize(count);
+		for (unsigned int i = 0; i < count; i++) {
+			const RenderObject* object = objects[i];
+			std::vector<unsigned int>& candidates = meshBatches[object->RenderMesh];
+			unsigned int found = (unsigned int)batches.size();
+			for (int c = 0; c < candidates.size(); ++c) {
+				if (CanShareBatch(batches[candidates[c]], object)) {
+					found = candidates[c];
+					break;
+				}
+			}
+			if (found == batches.size()) {
+				InstanceBatch batch;
+				batch.SharedMesh = object->RenderMesh;
+				batch.SharedMaterial = object->RenderMaterial;
+				batch.FirstObject = object;
+				batch.FirstInstance = 0;
+				batch.InstanceCount = 0;
+				batch.Instanced = batch.SharedMaterial->IsInstanced();
+				batches.push_back(batch);
+				if (batch.Instanced) {
+					candidates.push_back(found);	// Nothing can join the others, so they'd only lengthen the scan
+				}
+			}
+			batches[found].InstanceCount++;
+			objectBatch[i] = found;
+		}
+
+		// Then a prefix sum gives each batch its range, and the second pass packs into it
+		unsigned int total = 0;
+		batchFill.resize(batches.size());
+		for (int b = 0; b < batches.size(); ++b) {
+			batches[b].FirstInstance = total;
+			batchFill[b] = total;
+			total += batches[b].InstanceCount;
+		}
+		for (unsigned int i = 0; i < count; i++) {
+			PackInstance(objects[i], instances[batchFill[objectBatch[i]]++]);
+		}
+	}
+
+	stats.Batches = (unsigned int)batches.size();
+	for (int b = 0; b < batches.size(); ++b) {
+		if (batches[b].Instanced) {
+			stats.InstancedBatches++;
+		}
+		if (batches[b].InstanceCount > stats.LargestBatch) {
+			stats.LargestBatch = batches[b].InstanceCount;
+		}
+	}
+}
+
+void InstanceBatcher::Submit(IInstanceDrawTarget& target)
+{
+	if (instances.empty()) {
+		return;
+	}
+	target.UploadInstances(&instances[0], (unsigned int)instances.size());
+	for (int b = 0; b < batches.size(); ++b) {
+		target.DrawBatch(batches[b]);
+	}
+}
+
+const std::vector<InstanceData>& InstanceBatcher::GetInstances()
+{
+	return instances;
+}
+
+const std::vector<InstanceBatch>& InstanceBatcher::GetBatches()
+{
+	return batches;
+}
+
+const InstanceBatcherStats& InstanceBatcher::GetStats()
+{
+	return stats;
+}
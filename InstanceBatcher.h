@@ -0,0 +1,88 @@
+#pragma once
+#include <DirectXMath.h>
+#include <unordered_map>
+#include <vector>
+#include "RenderObject.h"
+
+// --------------------------------------------------------
+// One instance's worth of data in the instance buffer
+// - Must match the _PER_INSTANCE inputs of
+//   InstancedVertexShaderInput, in order
+// --------------------------------------------------------
+struct InstanceData
+{
+	DirectX::XMFLOAT4X4 World;
+	DirectX::XMFLOAT4 Tint;
+	DirectX::XMFLOAT3 Center;
+};
+
+// --------------------------------------------------------
+// A run of instances drawn with one call.  Instanced is
+// false for objects whose material has no instanced
+// shaders; those batches always hold exactly one object
+// and get drawn the regular way.
+// --------------------------------------------------------
+struct InstanceBatch
+{
+	Mesh* SharedMesh;
+	Material* SharedMaterial;	// The first object's material, every other instance only differs by tint
+	const RenderObject* FirstObject;
+	unsigned int FirstInstance;
+	unsigned int InstanceCount;
+	bool Instanced;
+};
+
+struct InstanceBatcherStats
+{
+	unsigned int Objects;
+	unsigned int Batches;
+	unsigned int InstancedBatches;
+	unsigned int LargestBatch;
+};
+
+// --------------------------------------------------------
+// Whatever actually draws the batches.  InstancedRenderer
+// is the D3D11 one; anything that just records the calls
+// can stand in for it to check the grouping and packing.
+// --------------------------------------------------------
+class IInstanceDrawTarget
+{
+public:
+	virtual ~IInstanceDrawTarget() {}
+	//called once per Submit, before any DrawBatch, with every instance of every batch
+	virtual void UploadInstances(const InstanceData* instances, unsigned int count) = 0;
+	virtual void DrawBatch(const InstanceBatch& batch) = 0;
+};
+
+// --------------------------------------------------------
+// Groups objects that share a Mesh and an instancing
+// compatible Material (Material::CanInstanceWith) and packs
+// their world matrices, tints and centers into one array,
+// laid out batch by batch.
+//
+// With keepOrder, only neighbouring objects are merged, so
+// a back-to-front list stays back to front (instances of a
+// single draw are blended in instance order).  Without it,
+// every compatible object lands in the same batch, in the
+// order the batches were first seen.
+// --------------------------------------------------------
+class InstanceBatcher
+{
+private:
+	std::vector<InstanceData> instances;
+	std::vector<InstanceBatch> batches;
+	std::vector<unsigned int> objectBatch;		// Batch index per object, only used without keepOrder
+	std::vector<unsigned int> batchFill;
+	std::unordered_map<Mesh*, std::vector<unsigned int>> meshBatches;
+	InstanceBatcherStats stats;
+
+	static void PackInstance(const RenderObject* object, InstanceData& instance);
+	static bool CanShareBatch(const InstanceBatch& batch, const RenderObject* object);
+public:
+	InstanceBatcher();
+	void Build(const RenderObject* const* objects, unsigned int count, bool keepOrder);
+	void Submit(IInstanceDrawTarget& target);
+	const std::vector<InstanceData>& GetInstances();
+	const std::vector<InstanceBatch>& GetBatches();
+	const InstanceBatcherStats& GetStats();
+};
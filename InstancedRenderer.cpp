@@ -0,0 +1,124 @@
+#include <string.h>
+#include "InstancedRenderer.h"
+
+using namespace DirectX;
+
+InstancedRenderer::InstancedRenderer(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context)
+{
+	this->device = device;
+	this->context = context;
+	instanceCapacity = 0;
+	currentPipeline = nullptr;
+	currentVS = nullptr;
+	currentPS = nullptr;
+	currentMaterial = nullptr;
+	currentMesh = nullptr;
+}
+
+void InstancedRenderer::Begin(std::shared_ptr<Camera> camera)
+{
+	view = camera->GetViewMatrix();
+	projection = camera->GetProjectionMatrix();
+	currentPipeline = nullptr;
+	currentVS = nullptr;
+	currentPS = nullptr;
+	currentMaterial = nullptr;
+	currentMesh = nullptr;
+}
+
+// --------------------------------------------------------
+// Copies every instance into the dynamic buffer with a
+// single Map(WRITE_DISCARD), growing it by doubling when
+// the frame has more instances than it can hold
+// --------------------------------------------------------
+void InstancedRenderer::UploadInstances(const InstanceData* instances, unsigned int count)
+{
+	if (count > instanceCapacity) {
+		unsigned int newCapacity = instanceCapacity > 0 ? instanceCapacity : 64;
+		while (newCapacity < count) {
+			newCapacity *= 2;
+		}
+
+		D3D11_BUFFER_DESC desc = {};
+		desc.Usage = D3D11_USAGE_DYNAMIC;
+		desc.ByteWidth = sizeof(InstanceData) * newCapacity;
+		desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+		desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		instanceBuffer.Reset();
+		if (FAILED(device->CreateBuffer(&desc, 0, instanceBuffer.GetAddressOf()))) {
+			instanceCapacity = 0;
+			return;
+		}
+		instanceCapacity = newCapacity;
+	}
+
+	D3D11_MAPPED_SUBRESOURCE mapped = {};
+	if (FAILED(context->Map(instanceBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) {
+		return;
+	}
+	memcpy(mapped.pData, instances, sizeof(InstanceData) * count);
+	context->Unmap(instanceBuffer.Get(), 0);
+
+	UINT stride = sizeof(InstanceData);
+	UINT offset = 0;
+	context->IASetVertexBuffers(1, 1, instanceBuffer.GetAddressOf(), &stride, &offset);
+}
+
+// Returns true if the pipeline changed
+bool InstancedRenderer::SetPipelineState(const PipelineState* pipeline)
+{
+	if (pipeline == currentPipeline) {
+		return false;
+	}
+	pipeline->Bind(context.Get());
+	currentPipeline = pipeline;
+	currentVS = pipeline->GetVertexShader().get();
+	currentPS = pipeline->GetPixelShader().get();
+	currentVS->SetMatrix4x4("view", view);
+	currentVS->SetMatrix4x4("projection", projection);
+	return true;
+}
+
+void InstancedRenderer::DrawBatch(const InstanceBatch& batch)
+{
+	bool materialChanged = batch.SharedMaterial != currentMaterial;
+	if (batch.SharedMesh != currentMesh) {
+		batch.SharedMesh->SetBuffers();
+		currentMesh = batch.SharedMesh;
+	}
+
+	if (batch.Instanced) {
+		if (instanceCapacity == 0) {
+			return; //the upload failed, nothing sensible to draw
+		}
+		bool shadersChanged = SetPipelineState(batch.SharedMaterial->GetInstancedPipelineState().get());
+		if (shadersChanged) {
+			currentVS->CopyAllBufferData();
+		}
+		if (materialChanged || shadersChanged) {
+			batch.SharedMaterial->BindInstancedResources();
+			currentPS->CopyAllBufferData();
+			currentMaterial = batch.SharedMaterial;
+		}
+		context->DrawIndexedInstanced(batch.SharedMesh->GetIndexCount(), batch.InstanceCount, 0, 0, batch.FirstInstance);
+		return;
+	}
+
+	// Not instanced: one object, drawn with the material's regular shaders
+	bool shadersChanged = SetPipelineState(batch.SharedMaterial->GetPipelineState().get());
+	if (materialChanged || shadersChanged) {
+		batch.SharedMaterial->BindResources();
+		currentPS->SetFloat4("colorTint", batch.SharedMaterial->GetColorTint());
+		currentMaterial = batch.SharedMaterial;
+	}
+	XMFLOAT4X4 worldInvTranspose;
+	XMStoreFloat4x4(&worldInvTranspose, XMMatrixInverse(nullptr, XMMatrixTranspose(XMLoadFloat4x4(&batch.FirstObject->World))));
+	currentVS->SetMatrix4x4("world", batch.FirstObject->World);
+	currentVS->SetMatrix4x4("worldInvTranspose", worldInvTranspose);
+	currentVS->CopyAllBufferData();
+	if (currentPS->HasVariable("position")) {
+		currentPS->SetFloat3("position", batch.FirstObject->Position);
+	}
+	currentPS->CopyAllBufferData();
+	batch.SharedMesh->DrawIndexed();
+}
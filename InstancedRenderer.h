@@ -0,0 +1,43 @@
+#pragma once
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <memory>
+#include "Camera.h"
+#include "InstanceBatcher.h"
+
+// --------------------------------------------------------
+// Draws InstanceBatcher batches with D3D11.  All instances
+// go into one dynamic vertex buffer (input slot 1) per
+// Submit, and each instanced batch is a single
+// DrawIndexedInstanced starting at its FirstInstance.
+// Batches that aren't instanced fall back to the same
+// per-object path RenderQueue uses.
+//
+// Batches are drawn with their material's pipeline states,
+// the instanced one for instanced batches.  Like
+// RenderQueue::Record, pipelines, material resources and
+// mesh buffers are only rebound when they change.
+// --------------------------------------------------------
+class InstancedRenderer : public IInstanceDrawTarget
+{
+private:
+	Microsoft::WRL::ComPtr<ID3D11Device> device;
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> context;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> instanceBuffer;
+	unsigned int instanceCapacity;
+	DirectX::XMFLOAT4X4 view;
+	DirectX::XMFLOAT4X4 projection;
+	const PipelineState* currentPipeline;
+	SimpleVertexShader* currentVS;
+	SimplePixelShader* currentPS;
+	Material* currentMaterial;
+	Mesh* currentMesh;
+
+	bool SetPipelineState(const PipelineState* pipeline);
+public:
+	InstancedRenderer(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context);
+	//call before each InstanceBatcher::Submit, it forgets whatever was bound before
+	void Begin(std::shared_ptr<Camera> camera);
+	void UploadInstances(const InstanceData* instances, unsigned int count);
+	void DrawBatch(const InstanceBatch& batch);
+};
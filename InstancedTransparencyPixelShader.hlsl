@@ -0,0 +1,37 @@
+#include "StructIncludes.hlsli"
+#include "LightingIncludes.hlsli"
+
+cbuffer externalData : register(b0) {
+	float roughness;
+	float3 cameraPosition;
+	int lightCount;
+	Light lights[32];	// MAX_LIGHTS
+}
+
+// --------------------------------------------------------
+// TransparencyPixelShader for instanced draws
+// 
+// - color and the sphere's center come in per instance, so
+//   materials that only differ by tint share a single draw
+// --------------------------------------------------------
+float4 main(InstancedVertexToPixel input) : SV_TARGET
+{
+	float3 camToPoint = input.worldPosition - cameraPosition;
+	float3 camToCenter = input.center - cameraPosition;
+	float thickness = 2 * (dot(camToPoint, camToCenter)/length(camToPoint) - length(camToPoint));
+	float alpha = 1 - pow(1 - input.tint.a, thickness);
+	LightingInfo info;
+	info.normal = normalize(input.normal);
+	info.roughness = roughness;
+	info.metalness = 0; //transparent objects are never metallic
+	info.worldPosition = input.worldPosition;
+	info.cameraPosition = cameraPosition;
+	info.surfaceColor = input.tint.rgb;
+	info.alpha = alpha;
+
+	float4 pixelColor = 0;
+	for (int i = 0; i < lightCount; i++) {
+		pixelColor += calculateTotalLighting(lights[i], info);
+	}
+	return float4(pow(pixelColor.rgb, 1/2.2f), pixelColor.a);
+}
@@ -0,0 +1,37 @@
+#include "StructIncludes.hlsli"
+
+cbuffer externalData : register(b0) {
+	matrix view;
+	matrix projection;
+}
+
+// --------------------------------------------------------
+// Vertex shader for InstanceBatcher draws
+// 
+// - The world matrix, tint and center come from the instance
+//   buffer instead of the cbuffer, so one DrawIndexedInstanced
+//   covers every entity in a batch
+// - The rows are built into a matrix as-is, so positions are
+//   multiplied on the left, matching DirectXMath
+// --------------------------------------------------------
+InstancedVertexToPixel main( InstancedVertexShaderInput input )
+{
+	InstancedVertexToPixel output;
+
+	float4x4 world = float4x4(input.worldRow0, input.worldRow1, input.worldRow2, input.worldRow3);
+	float4 worldPosition = mul(float4(input.localPosition, 1.0f), world);
+	output.screenPosition = mul(projection, mul(view, worldPosition));
+
+	output.uv = input.uv;
+	// The cofactors are the inverse transpose up to a scale the pixel shaders normalize away,
+	// so normals stay perpendicular to the surface under non-uniform scale
+	float3x3 world3 = (float3x3)world;
+	float3x3 cofactors = float3x3(cross(world3[1], world3[2]), cross(world3[2], world3[0]), cross(world3[0], world3[1]));
+	output.normal = mul(input.normal, cofactors) * sign(dot(world3[0], cofactors[0]));
+	output.tangent = mul(input.tangent, (float3x3)world);
+	output.worldPosition = worldPosition.xyz;
+	output.tint = input.tint;
+	output.center = input.center;
+
+	return output;
+}
@@ -0,0 +1,244 @@
+#include <string>
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "AllocationTracker.h"
+
+// Which system and queue the current thread works for, so pushes from a worker land in its own queue
+static thread_local JobSystem* threadSystem = nullptr;
+static thread_local unsigned int threadQueue = 0;
+
+// Ranges ParallelFor aims for per thread, so one slow range doesn't leave everyone else idle
+#define JOBS_PER_THREAD 4
+
+JobCounter::JobCounter() : pending(0)
+{
+}
+
+bool JobCounter::IsDone() const
+{
+	return pending.load() == 0;
+}
+
+JobSystem::JobSystem(unsigned int workerCount) : queuedJobs(0), sleepingWorkers(0), quitting(false), jobsRun(0), steals(0)
+{
+	if (workerCount == 0) {
+		unsigned int hardwareThreads = std::thread::hardware_concurrency();
+		//at least one worker even on a single core, background jobs are never run by a waiting thread
+		workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+	for (unsigned int q = 0; q <= workerCount; q++) {
+		queues.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue()));
+	}
+	for (unsigned int w = 0; w < workerCount; w++) {
+		workers.push_back(std::thread(&JobSystem::WorkerLoop, this, w + 1));
+	}
+}
+
+// Workers drain whatever is still queued before they exit
+JobSystem::~JobSystem()
+{
+	quitting = true;
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+	}
+	wake.notify_all();
+	for (int i = 0; i < workers.size(); ++i) {
+		workers[i].join();
+	}
+}
+
+void JobSystem::WorkerLoop(unsigned int queueIndex)
+{
+	threadSystem = this;
+	threadQueue = queueIndex;
+	Profiler::SetThreadName(("Job worker " + std::to_string(queueIndex)).c_str());
+	ALLOC_TAG("Jobs");
+	while (true) {
+		Job job;
+		if (Pop(queueIndex, job, true)) {
+			Execute(job);
+			continue;
+		}
+		if (quitting) {
+			return;
+		}
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		sleepingWorkers++;
+		wake.wait(lock, [this] { return quitting || queuedJobs > 0; });
+		sleepingWorkers--;
+	}
+}
+
+unsigned int JobSystem::GetQueueIndex()
+{
+	return threadSystem == this ? threadQueue : 0;
+}
+
+// --------------------------------------------------------
+// Queues a job and wakes a worker if any are asleep.  The
+// count goes up before the sleepers are checked and a
+// worker counts itself as asleep before it checks the
+// count, so one of the two always sees the other.
+// --------------------------------------------------------
+void JobSystem::Push(Job& job)
+{
+	if (job.Background) {
+		std::lock_guard<std::mutex> lock(backgroundMutex);
+		backgroundJobs.push_back(std::move(job));
+	}
+	else {
+		WorkerQueue& queue = *queues[GetQueueIndex()];
+		std::lock_guard<std::mutex> lock(queue.Mutex);
+		queue.Jobs.push_back(std::move(job));
+	}
+	queuedJobs++;
+	if (sleepingWorkers > 0) {
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+		}
+		wake.notify_one();
+	}
+}
+
+// Newest from our own queue, then the oldest from anyone else's, then background work if allowed
+bool JobSystem::Pop(unsigned int queueIndex, Job& job, bool allowBackground)
+{
+	if (queuedJobs <= 0) {
+		return false;
+	}
+	{
+		WorkerQueue& own = *queues[queueIndex];
+		std::lock_guard<std::mutex> lock(own.Mutex);
+		if (!own.Jobs.empty()) {
+			job = std::move(own.Jobs.back());
+			own.Jobs.pop_back();
+			queuedJobs--;
+			return true;
+		}
+	}
+	for (unsigned int i = 1; i < queues.size(); i++) {
+		WorkerQueue& victim = *queues[(queueIndex + i) % queues.size()];
+		std::lock_guard<std::mutex> lock(victim.Mutex);
+		if (!victim.Jobs.empty()) {
+			job = std::move(victim.Jobs.front());
+			victim.Jobs.pop_front();
+			queuedJobs--;
+			steals++;
+			return true;
+		}
+	}
+	if (allowBackground) {
+		std::lock_guard<std::mutex> lock(backgroundMutex);
+		if (!backgroundJobs.empty()) {
+			job = std::move(backgroundJobs.front());
+			backgroundJobs.pop_front();
+			queuedJobs--;
+			return true;
+		}
+	}
+	return false;
+}
+
+// --------------------------------------------------------
+// Runs a job and retires it from its counter.  The last
+// job to finish holds the counter's lock while it drops
+// the count to zero, which Wait relies on, and releases
+// any jobs that were held back waiting for it.
+// --------------------------------------------------------
+void JobSystem::Execute(Job& job)
+{
+	job.Work();
+	jobsRun++;
+	if (!job.Counter) {
+		return;
+	}
+	std::vector<Job> released;
+	{
+		std::lock_guard<std::mutex> lock(job.Counter->mutex);
+		if (--job.Counter->pending == 0) {
+			released.swap(job.Counter->continuations);
+		}
+	}
+	for (int i = 0; i < released.size(); ++i) {
+		Push(released[i]);
+	}
+}
+
+void JobSystem::Run(const std::function<void()>& work, JobCounter* counter, bool background)
+{
+	if (counter) {
+		counter->pending++;
+	}
+	Job job = { work, counter, background };
+	Push(job);
+}
+
+void JobSystem::RunAfter(JobCounter& dependency, const std::function<void()>& work, JobCounter* counter, bool background)
+{
+	if (counter) {
+		counter->pending++;
+	}
+	Job job = { work, counter, background };
+	{
+		std::lock_guard<std::mutex> lock(dependency.mutex);
+		if (dependency.pending > 0) {
+			dependency.continuations.push_back(std::move(job));
+			return;
+		}
+	}
+	Push(job);
+}
+
+void JobSystem::Wait(JobCounter& counter)
+{
+	unsigned int queueIndex = GetQueueIndex();
+	while (!counter.IsDone()) {
+		Job job;
+		if (Pop(queueIndex, job, false)) {
+			Execute(job);
+		}
+		else {
+			std::this_thread::yield();
+		}
+	}
+	//the job that brought it to zero may still be inside Execute, don't let the caller free the counter under it
+	std::lock_guard<std::mutex> lock(counter.mutex);
+}
+
+void JobSystem::ParallelFor(unsigned int count, unsigned int minPerJob, const std::function<void(unsigned int, unsigned int)>& body)
+{
+	if (count == 0) {
+		return;
+	}
+	minPerJob = minPerJob > 0 ? minPerJob : 1;
+	unsigned int maxJobs = GetThreadCount() * JOBS_PER_THREAD;
+	unsigned int jobs = count / minPerJob;
+	jobs = jobs < maxJobs ? jobs : maxJobs;
+	if (jobs <= 1) {
+		body(0, count);
+		return;
+	}
+
+	unsigned int perJob = (count + jobs - 1) / jobs;
+	JobCounter counter;
+	for (unsigned int first = perJob; first < count; first += perJob) {
+		unsigned int last = first + perJob < count ? first + perJob : count;
+		Run([&body, first, last] { body(first, last); }, &counter);
+	}
+	body(0, perJob); //the calling thread takes the first range
+	Wait(counter);
+}
+
+unsigned int JobSystem::GetThreadCount()
+{
+	return (unsigned int)queues.size();
+}
+
+JobSystemStats JobSystem::GetStats()
+{
+	JobSystemStats stats;
+	stats.Threads = GetThreadCount();
+	stats.JobsRun = jobsRun;
+	stats.Steals = steals;
+	return stats;
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class JobCounter;
+
+struct Job
+{
+	std::function<void()> Work;
+	JobCounter* Counter;		// Decremented once Work returns, may be null
+	bool Background;
+};
+
+// --------------------------------------------------------
+// Counts the unfinished jobs that were started against it.
+// Wait on it to block until they're done, or hand it to
+// RunAfter to start more jobs once it reaches zero.  It
+// can be reused once it's done, and must outlive its jobs.
+// --------------------------------------------------------
+class JobCounter
+{
+	friend class JobSystem;
+private:
+	std::atomic<int> pending;
+	std::mutex mutex;				// Guards continuations, and is held while the last job finishes
+	std::vector<Job> continuations;
+public:
+	JobCounter();
+	JobCounter(const JobCounter&) = delete;
+	void operator=(const JobCounter&) = delete;
+	bool IsDone() const;
+};
+
+struct JobSystemStats
+{
+	unsigned int Threads;			// Workers plus the thread that created the system
+	unsigned long long JobsRun;		// Since the system was created
+	unsigned long long Steals;		// Jobs a thread took from another thread's queue
+};
+
+// --------------------------------------------------------
+// A work-stealing job system.
+//
+// Every worker thread, and the thread that created the
+// system, has its own queue.  A thread pushes and pops at
+// the back of its own queue, so it works on what it just
+// made while that's still in cache, and when it runs dry
+// it steals the oldest job from the front of another one.
+// Threads that aren't part of the system push to the
+// creator's queue.
+//
+// Waiting doesn't block: the waiting thread runs other
+// jobs until its counter is done, so jobs can wait on
+// jobs of their own (ParallelFor inside a job is fine).
+//
+// Background jobs go to a separate queue that only idle
+// workers take from.  They're for slow work like file IO
+// that would stall a frame if the main thread picked it up
+// while waiting for culling to finish.
+// --------------------------------------------------------
+class JobSystem
+{
+private:
+	struct WorkerQueue
+	{
+		std::mutex Mutex;
+		std::deque<Job> Jobs;
+	};
+
+	std::vector<std::unique_ptr<WorkerQueue>> queues;	// [0] belongs to the creating thread, [w + 1] to workers[w]
+	std::mutex backgroundMutex;
+	std::deque<Job> backgroundJobs;
+	std::vector<std::thread> workers;
+
+	std::mutex sleepMutex;
+	std::condition_variable wake;
+	std::atomic<int> queuedJobs;		// Foreground and background, so sleeping workers know when to get up
+	std::atomic<int> sleepingWorkers;
+	std::atomic<bool> quitting;
+
+	std::atomic<unsigned long long> jobsRun;
+	std::atomic<unsigned long long> steals;
+
+	void WorkerLoop(unsigned int queueIndex);
+	unsigned int GetQueueIndex();
+	void Push(Job& job);
+	bool Pop(unsigned int queueIndex, Job& job, bool allowBackground);
+	void Execute(Job& job);
+public:
+	// 0 workers means one fewer than the hardware has threads, since the creating thread works too
+	JobSystem(unsigned int workerCount = 0);
+	~JobSystem();
+	JobSystem(const JobSystem&) = delete;
+	void operator=(const JobSystem&) = delete;
+
+	// The counter is incremented now and decremented when the job finishes
+	void Run(const std::function<void()>& work, JobCounter* counter = nullptr, bool background = false);
+	// Holds the job back until dependency is done, runs it straight away if it already is
+	void RunAfter(JobCounter& dependency, const std::function<void()>& work, JobCounter* counter = nullptr, bool background = false);
+	// Runs other foreground jobs until the counter is done
+	void Wait(JobCounter& counter);
+
+	// --------------------------------------------------------
+	// Calls body(first, last) over [0, count) split into
+	// ranges of at least minPerJob, a few per thread so an
+	// uneven range can be evened out by stealing, and waits
+	// for them all.  The calling thread takes the first
+	// range.  Small counts run inline without any jobs.
+	// --------------------------------------------------------
+	void ParallelFor(unsigned int count, unsigned int minPerJob, const std::function<void(unsigned int, unsigned int)>& body);
+
+	unsigned int GetThreadCount();
+	JobSystemStats GetStats();
+};
@@ -2,6 +2,7 @@
 #define LIGHT_TYPE_DIRECTIONAL 0
 #define LIGHT_TYPE_POINT 1
 #define LIGHT_TYPE_SPOT 2
+#define MAX_LIGHTS 32	// The size of the lights array in the pixel shaders, which only light with the first lightCount
 
 #include <DirectXMath.h>
 
@@ -0,0 +1,95 @@
+#pragma once
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <wchar.h>
+
+// --------------------------------------------------------
+// Just enough of Windows.h for Input and the shader and
+// mesh classes to build on Linux, so they can be tested and
+// benchmarked there.  There's no keyboard or mouse: every
+// key reads as up and the cursor stays put.  The console
+// calls print without colors.  Only the CMake build's
+// include path has this directory, and only off Windows.
+// --------------------------------------------------------
+typedef void* HWND;
+typedef void* HANDLE;
+typedef int BOOL;
+typedef int INT;
+typedef unsigned int UINT;
+typedef unsigned char BYTE;
+typedef unsigned short WORD;
+typedef unsigned long DWORD;
+typedef float FLOAT;
+typedef size_t SIZE_T;
+typedef int HRESULT; //long is 64 bits here, and the error codes are negative only as 32-bit values
+typedef const char* LPCSTR;
+typedef const wchar_t* LPCWSTR;
+
+struct POINT
+{
+	long x;
+	long y;
+};
+
+#define S_OK ((HRESULT)0)
+#define E_NOTIMPL ((HRESULT)0x80004001L)
+#define E_FAIL ((HRESULT)0x80004005L)
+#define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+#define FAILED(hr) (((HRESULT)(hr)) < 0)
+
+#define VK_LBUTTON 0x01
+#define VK_RBUTTON 0x02
+#define VK_MBUTTON 0x04
+#define VK_TAB 0x09
+#define VK_SHIFT 0x10
+#define VK_ESCAPE 0x1B
+#define VK_SPACE 0x20
+#define VK_LEFT 0x25
+#define VK_UP 0x26
+#define VK_RIGHT 0x27
+#define VK_DOWN 0x28
+
+// Functions rather than the real header's macros, which would break the standard library
+#ifndef NOMINMAX
+template <typename A, typename B>
+inline auto min(A a, B b) -> decltype(a < b ? a : b) { return a < b ? a : b; }
+template <typename A, typename B>
+inline auto max(A a, B b) -> decltype(a > b ? a : b) { return a > b ? a : b; }
+#endif
+
+#define ZeroMemory(destination, length) memset((destination), 0, (length))
+
+#define STD_OUTPUT_HANDLE ((DWORD)-11)
+#define FOREGROUND_BLUE 0x0001
+#define FOREGROUND_GREEN 0x0002
+#define FOREGROUND_RED 0x0004
+#define FOREGROUND_INTENSITY 0x0008
+
+inline BOOL GetKeyboardState(BYTE* keyState) { memset(keyState, 0, 256); return 1; }
+inline BOOL GetCursorPos(POINT* point) { point->x = 0; point->y = 0; return 1; }
+inline BOOL ScreenToClient(HWND, POINT*) { return 1; }
+
+inline HANDLE GetStdHandle(DWORD) { return stdout; }
+inline BOOL SetConsoleTextAttribute(HANDLE, WORD) { return 1; }
+inline void OutputDebugString(LPCSTR) {}
+inline void OutputDebugStringW(LPCWSTR) {}
+
+inline int printf_s(const char* format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	int result = vprintf(format, args);
+	va_end(args);
+	return result;
+}
+
+inline int wprintf_s(const wchar_t* format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	int result = vwprintf(format, args);
+	va_end(args);
+	return result;
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <d3d11.h>
+
+// --------------------------------------------------------
+// The shader reflection declarations from d3d11shader.h
+// that SimpleShader reads; see d3d11.h here.
+// --------------------------------------------------------
+struct GUID
+{
+	unsigned long Data1;
+	unsigned short Data2;
+	unsigned short Data3;
+	unsigned char Data4[8];
+};
+typedef const GUID& REFIID;
+
+const GUID IID_ID3D11ShaderReflection = { 0x8d536ca1, 0x0cca, 0x4956, { 0xa8, 0x37, 0x78, 0x69, 0x63, 0x75, 0x55, 0x84 } };
+
+struct D3D11_SHADER_DESC
+{
+	UINT Version;
+	LPCSTR Creator;
+	UINT Flags;
+	UINT ConstantBuffers;
+	UINT BoundResources;
+	UINT InputParameters;
+	UINT OutputParameters;
+};
+
+struct D3D11_SHADER_BUFFER_DESC
+{
+	LPCSTR Name;
+	D3D_CBUFFER_TYPE Type;
+	UINT Variables;
+	UINT Size;
+	UINT uFlags;
+};
+
+struct D3D11_SHADER_VARIABLE_DESC
+{
+	LPCSTR Name;
+	UINT StartOffset;
+	UINT Size;
+	UINT uFlags;
+	void* DefaultValue;
+};
+
+struct D3D11_SHADER_INPUT_BIND_DESC
+{
+	LPCSTR Name;
+	D3D_SHADER_INPUT_TYPE Type;
+	UINT BindPoint;
+	UINT BindCount;
+	UINT uFlags;
+};
+
+struct D3D11_SIGNATURE_PARAMETER_DESC
+{
+	LPCSTR SemanticName;
+	UINT SemanticIndex;
+	UINT Register;
+	D3D_REGISTER_COMPONENT_TYPE ComponentType;
+	BYTE Mask;
+	BYTE ReadWriteMask;
+	UINT Stream;
+};
+
+struct ID3D11ShaderReflectionVariable
+{
+	virtual HRESULT GetDesc(D3D11_SHADER_VARIABLE_DESC* desc) = 0;
+};
+
+struct ID3D11ShaderReflectionConstantBuffer
+{
+	virtual HRESULT GetDesc(D3D11_SHADER_BUFFER_DESC* desc) = 0;
+	virtual ID3D11ShaderReflectionVariable* GetVariableByIndex(UINT index) = 0;
+};
+
+struct ID3D11ShaderReflection : public IUnknown
+{
+	virtual HRESULT GetDesc(D3D11_SHADER_DESC* desc) = 0;
+	virtual ID3D11ShaderReflectionConstantBuffer* GetConstantBufferByIndex(UINT index) = 0;
+	virtual HRESULT GetResourceBindingDesc(UINT resourceIndex, D3D11_SHADER_INPUT_BIND_DESC* desc) = 0;
+	virtual HRESULT GetResourceBindingDescByName(LPCSTR name, D3D11_SHADER_INPUT_BIND_DESC* desc) = 0;
+	virtual HRESULT GetInputParameterDesc(UINT parameterIndex, D3D11_SIGNATURE_PARAMETER_DESC* desc) = 0;
+	virtual HRESULT GetOutputParameterDesc(UINT parameterIndex, D3D11_SIGNATURE_PARAMETER_DESC* desc) = 0;
+	virtual UINT GetThreadGroupSize(UINT* sizeX, UINT* sizeY, UINT* sizeZ) = 0;
+};
@@ -0,0 +1,25 @@
+#pragma once
+#include <d3d11shader.h>
+
+// --------------------------------------------------------
+// The d3dcompiler.h calls SimpleShader makes; see d3d11.h
+// here.  There's no compiler or reflection off Windows, so
+// both fail and every shader loads as invalid.
+// --------------------------------------------------------
+struct ID3DBlob : public IUnknown
+{
+	virtual void* GetBufferPointer() = 0;
+	virtual SIZE_T GetBufferSize() = 0;
+};
+
+inline HRESULT D3DReadFileToBlob(LPCWSTR, ID3DBlob** contents)
+{
+	*contents = nullptr;
+	return E_NOTIMPL;
+}
+
+inline HRESULT D3DReflect(const void*, SIZE_T, REFIID, void** reflector)
+{
+	*reflector = nullptr;
+	return E_NOTIMPL;
+}
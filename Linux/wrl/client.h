@@ -0,0 +1,54 @@
+#pragma once
+#include <stddef.h>
+
+// --------------------------------------------------------
+// Microsoft::WRL::ComPtr, for the stand-in d3d11.h here:
+// holds a reference with AddRef and Release like the real
+// one, and has only the members the engine calls.
+// --------------------------------------------------------
+namespace Microsoft {
+namespace WRL {
+
+template <typename T>
+class ComPtr
+{
+private:
+	T* ptr;
+
+	void InternalAddRef() const { if (ptr) ptr->AddRef(); }
+	void InternalRelease() { T* temp = ptr; if (temp) { ptr = nullptr; temp->Release(); } }
+public:
+	ComPtr() : ptr(nullptr) {}
+	ComPtr(decltype(nullptr)) : ptr(nullptr) {}
+	template <typename U>
+	ComPtr(U* other) : ptr(other) { InternalAddRef(); }
+	ComPtr(const ComPtr& other) : ptr(other.ptr) { InternalAddRef(); }
+	ComPtr(ComPtr&& other) : ptr(other.ptr) { other.ptr = nullptr; }
+	~ComPtr() { InternalRelease(); }
+
+	ComPtr& operator=(const ComPtr& other) { ComPtr(other).Swap(*this); return *this; }
+	ComPtr& operator=(ComPtr&& other) { ComPtr(static_cast<ComPtr&&>(other)).Swap(*this); return *this; }
+	ComPtr& operator=(T* other) { ComPtr(other).Swap(*this); return *this; }
+	ComPtr& operator=(decltype(nullptr)) { InternalRelease(); return *this; }
+
+	void Swap(ComPtr& other) { T* temp = ptr; ptr = other.ptr; other.ptr = temp; }
+	T* Get() const { return ptr; }
+	T* operator->() const { return ptr; }
+	T* const* GetAddressOf() const { return &ptr; }
+	T** GetAddressOf() { return &ptr; }
+	T** ReleaseAndGetAddressOf() { InternalRelease(); return &ptr; }
+	unsigned long Reset() { T* temp = ptr; ptr = nullptr; return temp ? temp->Release() : 0; }
+	explicit operator bool() const { return ptr != nullptr; }
+};
+
+template <typename T, typename U>
+bool operator==(const ComPtr<T>& a, const ComPtr<U>& b) { return a.Get() == b.Get(); }
+template <typename T, typename U>
+bool operator!=(const ComPtr<T>& a, const ComPtr<U>& b) { return a.Get() != b.Get(); }
+template <typename T>
+bool operator==(const ComPtr<T>& a, decltype(nullptr)) { return a.Get() == nullptr; }
+template <typename T>
+bool operator!=(const ComPtr<T>& a, decltype(nullptr)) { return a.Get() != nullptr; }
+
+}
+}
@@ -0,0 +1,347 @@
+#include <limits.h>
+#include <math.h>
+#include "LooseGrid.h"
+
+using namespace DirectX;
+
+static float LargestExtent(const AABB& bounds)
+{
+	return fmaxf(bounds.Extents.x, fmaxf(bounds.Extents.y, bounds.Extents.z));
+}
+
+// Returns -1 when the box is outside a plane, 1 when it's inside all of them, 0 when it straddles
+static int ClassifyBox(const XMFLOAT4* planes, const XMFLOAT3& center, const XMFLOAT3& extents)
+{
+	int result = 1;
+	for (int p = 0; p < 6; p++) {
+		float distance = planes[p].x * center.x + planes[p].y * center.y + planes[p].z * center.z + planes[p].w;
+		float radius = fabsf(planes[p].x) * extents.x + fabsf(planes[p].y) * extents.y + fabsf(planes[p].z) * extents.z;
+		if (distance < -radius) {
+			return -1;
+		}
+		if (distance < radius) {
+			result = 0;
+		}
+	}
+	return result;
+}
+
+LooseGrid::LooseGrid(float cellSize)
+{
+	this->cellSize = cellSize;
+	inverseCellSize = 1.0f / cellSize;
+	maxExtent = 0.0f;
+	for (int axis = 0; axis < 3; axis++) {
+		minCell[axis] = INT_MAX;
+		maxCell[axis] = INT_MIN;
+	}
+	freeProxy = -1;
+	proxyCount = 0;
+}
+
+// 21 bits per axis, which covers +-1 million cells in each direction
+uint64_t LooseGrid::CellKey(int x, int y, int z)
+{
+	return ((uint64_t)(x & 0x1FFFFF) << 42) | ((uint64_t)(y & 0x1FFFFF) << 21) | (uint64_t)(z & 0x1FFFFF);
+}
+
+int LooseGrid::CellCoordinate(float value)
+{
+	return (int)floorf(value * inverseCellSize);
+}
+
+int LooseGrid::FindOrCreateCell(int x, int y, int z)
+{
+	uint64_t key = CellKey(x, y, z);
+	std::unordered_map<uint64_t, int>::iterator found = cellLookup.find(key);
+	if (found != cellLookup.end()) {
+		return found->second;
+	}
+	// Cells are never removed, so a region that was busy once stays cheap to re-enter
+	GridCell cell;
+	cell.x = x;
+	cell.y = y;
+	cell.z = z;
+	cell.maxExtent = 0.0f;
+	cell.staleExtent = false;
+	cells.push_back(cell);
+	int index = (int)cells.size() - 1;
+	cellLookup.insert({ key, index });
+
+	int coordinates[3] = { x, y, z };
+	for (int axis = 0; axis < 3; axis++) {
+		minCell[axis] = coordinates[axis] < minCell[axis] ? coordinates[axis] : minCell[axis];
+		maxCell[axis] = coordinates[axis] > maxCell[axis] ? coordinates[axis] : maxCell[axis];
+	}
+	return index;
+}
+
+void LooseGrid::AddToCell(int proxyId, int cell, const AABB& bounds)
+{
+	GridEntry entry;
+	entry.bounds = bounds;
+	entry.proxy = proxyId;
+	cells[cell].entries.push_back(entry);
+	cells[cell].maxExtent = fmaxf(cells[cell].maxExtent, LargestExtent(bounds));
+	maxExtent = fmaxf(maxExtent, LargestExtent(bounds));
+	proxies[proxyId].cell = cell;
+	proxies[proxyId].slot = (int)cells[cell].entries.size() - 1;
+}
+
+void LooseGrid::RemoveFromCell(int proxyId)
+{
+	// Swap-remove, then point the moved entry's proxy at its new slot
+	int cell = proxies[proxyId].cell;
+	std::vector<GridEntry>& entries = cells[cell].entries;
+	int slot = proxies[proxyId].slot;
+	if (LargestExtent(entries[slot].bounds) >= cells[cell].maxExtent) {
+		MarkStale(cell);
+	}
+	entries[slot] = entries.back();
+	proxies[entries[slot].proxy].slot = slot;
+	entries.pop_back();
+}
+
+// --------------------------------------------------------
+// The entity that set a cell's extent got smaller or left.
+// Working out the new one waits for the next query, so an
+// entity that changes size every frame costs one pass over
+// its cell per frame rather than one per change
+// --------------------------------------------------------
+void LooseGrid::MarkStale(int cell)
+{
+	if (!cells[cell].staleExtent) {
+		cells[cell].staleExtent = true;
+		staleCells.push_back(cell);
+	}
+}
+
+void LooseGrid::RefreshExtents()
+{
+	bool gridExtentStale = false;
+	for (int i = 0; i < staleCells.size(); i++) {
+		GridCell& cell = cells[staleCells[i]];
+		gridExtentStale = gridExtentStale || cell.maxExtent >= maxExtent;
+		cell.maxExtent = 0.0f;
+		for (int e = 0; e < cell.entries.size(); e++) {
+			cell.maxExtent = fmaxf(cell.maxExtent, LargestExtent(cell.entries[e].bounds));
+		}
+		cell.staleExtent = false;
+	}
+	staleCells.clear();
+
+	// Only when the grid's largest entity might be the one that changed
+	if (gridExtentStale) {
+		maxExtent = 0.0f;
+		for (int c = 0; c < cells.size(); c++) {
+			maxExtent = fmaxf(maxExtent, cells[c].maxExtent);
+		}
+	}
+}
+
+int LooseGrid::CreateProxy(const AABB& bounds, void* userData)
+{
+	int proxyId;
+	if (freeProxy >= 0) {
+		proxyId = freeProxy;
+		freeProxy = proxies[proxyId].slot;
+	}
+	else {
+		proxies.push_back(GridProxy());
+		proxyId = (int)proxies.size() - 1;
+	}
+	proxies[proxyId].userData = userData;
+
+	int cell = FindOrCreateCell(CellCoordinate(bounds.Center.x), CellCoordinate(bounds.Center.y), CellCoordinate(bounds.Center.z));
+	AddToCell(proxyId, cell, bounds);
+	proxyCount++;
+	return proxyId;
+}
+
+void LooseGrid::DestroyProxy(int proxyId)
+{
+	RemoveFromCell(proxyId);
+	proxies[proxyId].cell = -1;
+	proxies[proxyId].slot = freeProxy;
+	proxies[proxyId].userData = nullptr;
+	freeProxy = proxyId;
+	proxyCount--;
+}
+
+bool LooseGrid::MoveProxy(int proxyId, const AABB& bounds)
+{
+	int x = CellCoordinate(bounds.Center.x);
+	int y = CellCoordinate(bounds.Center.y);
+	int z = CellCoordinate(bounds.Center.z);
+
+	GridProxy& proxy = proxies[proxyId];
+	GridCell& current = cells[proxy.cell];
+	if (current.x == x && current.y == y && current.z == z) {
+		// The common case, no hashing at all
+		float oldExtent = LargestExtent(current.entries[proxy.slot].bounds);
+		float newExtent = LargestExtent(bounds);
+		current.entries[proxy.slot].bounds = bounds;
+		if (newExtent > current.maxExtent) {
+			current.maxExtent = newExtent;
+			maxExtent = fmaxf(maxExtent, newExtent);
+		}
+		else if (newExtent < oldExtent && oldExtent >= current.maxExtent) {
+			MarkStale(proxy.cell);
+		}
+		return false;
+	}
+	RemoveFromCell(proxyId);
+	AddToCell(proxyId, FindOrCreateCell(x, y, z), bounds);
+	return true;
+}
+
+void* LooseGrid::GetUserData(int proxyId)
+{
+	return proxies[proxyId].userData;
+}
+
+void LooseGrid::QueryCell(const GridCell& cell, const Frustum& frustum, const XMFLOAT4* planes, std::vector<int>& proxies)
+{
+	if (cell.entries.empty()) {
+		return;
+	}
+
+	// Loose cell bounds: anything stored in a cell lies within its maxExtent of it
+	float cellExtent = cellSize * 0.5f + cell.maxExtent;
+	XMFLOAT3 center((cell.x + 0.5f) * cellSize, (cell.y + 0.5f) * cellSize, (cell.z + 0.5f) * cellSize);
+	int classification = ClassifyBox(planes, center, XMFLOAT3(cellExtent, cellExtent, cellExtent));
+	if (classification < 0) {
+		return;
+	}
+	for (int e = 0; e < cell.entries.size(); e++) {
+		if (classification > 0 || frustum.Intersects(cell.entries[e].bounds)) {
+			proxies.push_back(cell.entries[e].proxy);
+		}
+	}
+}
+
+void LooseGrid::QueryFrustum(const Frustum& frustum, std::vector<int>& proxies)
+{
+	RefreshExtents();
+	XMFLOAT4 planes[6];
+	for (int p = 0; p < 6; p++) {
+		planes[p] = frustum.GetPlane(p);
+	}
+
+	// The cells the frustum's bounds reach, grown by the looseness, within the ones ever occupied
+	AABB bounds = frustum.GetBounds();
+	float reachX = bounds.Extents.x + maxExtent, reachY = bounds.Extents.y + maxExtent, reachZ = bounds.Extents.z + maxExtent;
+	int minX = CellCoordinate(bounds.Center.x - reachX), maxX = CellCoordinate(bounds.Center.x + reachX);
+	int minY = CellCoordinate(bounds.Center.y - reachY), maxY = CellCoordinate(bounds.Center.y + reachY);
+	int minZ = CellCoordinate(bounds.Center.z - reachZ), maxZ = CellCoordinate(bounds.Center.z + reachZ);
+	minX = minX > minCell[0] ? minX : minCell[0];
+	minY = minY > minCell[1] ? minY : minCell[1];
+	minZ = minZ > minCell[2] ? minZ : minCell[2];
+	maxX = maxX < maxCell[0] ? maxX : maxCell[0];
+	maxY = maxY < maxCell[1] ? maxY : maxCell[1];
+	maxZ = maxZ < maxCell[2] ? maxZ : maxCell[2];
+	if (minX > maxX || minY > maxY || minZ > maxZ) {
+		return;
+	}
+
+	// A hash lookup costs a few times what a step through the dense list does
+	long long rangeCells = (long long)(maxX - minX + 1) * (maxY - minY + 1) * (maxZ - minZ + 1);
+	if (rangeCells * LOOSE_GRID_LOOKUP_COST > (long long)cells.size()) {
+		// Sparse scenes and long view distances: the range is mostly empty cells
+		for (int c = 0; c < cells.size(); c++) {
+			const GridCell& cell = cells[c];
+			if (cell.x < minX || cell.x > maxX || cell.y < minY || cell.y > maxY || cell.z < minZ || cell.z > maxZ) {
+				continue;
+			}
+			QueryCell(cell, frustum, planes, proxies);
+		}
+		return;
+	}
+
+	// Walk the range a row at a time, skipping rows that miss the frustum entirely
+	float rowExtent = cellSize * 0.5f + maxExtent;
+	XMFLOAT3 rowExtents((maxX - minX + 1) * cellSize * 0.5f + maxExtent, rowExtent, rowExtent);
+	for (int z = minZ; z <= maxZ; z++) {
+		for (int y = minY; y <= maxY; y++) {
+			XMFLOAT3 rowCenter((minX + maxX + 1) * cellSize * 0.5f, (y + 0.5f) * cellSize, (z + 0.5f) * cellSize);
+			if (ClassifyBox(planes, rowCenter, rowExtents) < 0) {
+				continue;
+			}
+			for (int x = minX; x <= maxX; x++) {
+				std::unordered_map<uint64_t, int>::iterator found = cellLookup.find(CellKey(x, y, z));
+				if (found != cellLookup.end()) {
+					QueryCell(cells[found->second], frustum, planes, proxies);
+				}
+			}
+		}
+	}
+}
+
+void LooseGrid::QuerySphere(XMFLOAT3 center, float radius, std::vector<int>& proxies)
+{
+	RefreshExtents();
+	float reach = radius + maxExtent;
+	int minX = CellCoordinate(center.x - reach), maxX = CellCoordinate(center.x + reach);
+	int minY = CellCoordinate(center.y - reach), maxY = CellCoordinate(center.y + reach);
+	int minZ = CellCoordinate(center.z - reach), maxZ = CellCoordinate(center.z + reach);
+
+	float radiusSq = radius * radius;
+	long long rangeCells = (long long)(maxX - minX + 1) * (maxY - minY + 1) * (maxZ - minZ + 1);
+	bool scanAllCells = rangeCells * LOOSE_GRID_LOOKUP_COST > (long long)cells.size(); //huge spheres walk the dense cell list instead
+
+	for (int c = 0; c < (scanAllCells ? (int)cells.size() : (int)rangeCells); c++) {
+		const GridCell* cell;
+		if (scanAllCells) {
+			cell = &cells[c];
+			if (cell->x < minX || cell->x > maxX || cell->y < minY || cell->y > maxY || cell->z < minZ || cell->z > maxZ) {
+				continue;
+			}
+		}
+		else {
+			int x = minX + c % (maxX - minX + 1);
+			int y = minY + (c / (maxX - minX + 1)) % (maxY - minY + 1);
+			int z = minZ + c / ((maxX - minX + 1) * (maxY - minY + 1));
+			std::unordered_map<uint64_t, int>::iterator found = cellLookup.find(CellKey(x, y, z));
+			if (found == cellLookup.end()) {
+				continue;
+			}
+			cell = &cells[found->second];
+		}
+
+		for (int e = 0; e < cell->entries.size(); e++) {
+			const AABB& box = cell->entries[e].bounds;
+			float dx = fmaxf(fabsf(center.x - box.Center.x) - box.Extents.x, 0.0f);
+			float dy = fmaxf(fabsf(center.y - box.Center.y) - box.Extents.y, 0.0f);
+			float dz = fmaxf(fabsf(center.z - box.Center.z) - box.Extents.z, 0.0f);
+			if (dx * dx + dy * dy + dz * dz <= radiusSq) {
+				proxies.push_back(cell->entries[e].proxy);
+			}
+		}
+	}
+}
+
+int LooseGrid::GetProxyCount()
+{
+	return proxyCount;
+}
+
+int LooseGrid::GetProxyCapacity()
+{
+	return (int)proxies.size();
+}
+
+int LooseGrid::GetCellCount()
+{
+	return (int)cells.size();
+}
+
+float LooseGrid::GetCellSize()
+{
+	return cellSize;
+}
+
+float LooseGrid::GetMaxExtent()
+{
+	RefreshExtents();
+	return maxExtent;
+}
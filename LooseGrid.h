@@ -0,0 +1,89 @@
+#pragma once
+#include <DirectXMath.h>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+#include "ISpatialIndex.h"
+
+// How many cells of the dense list a query could walk for the price of one hash lookup
+#define LOOSE_GRID_LOOKUP_COST 4
+
+// --------------------------------------------------------
+// A loose uniform grid (spatial hash) for scenes where most
+// entities move every frame.
+//
+// Each proxy lives in exactly one cell, picked by the center
+// of its bounds, so inserting and moving are O(1): a hash
+// lookup plus a swap-remove from the old cell.  Queries make
+// up for the looseness by growing each cell by the largest
+// extent in it, and the search region by the largest extent
+// in the grid.  Both shrink again when the entity that set
+// them gets smaller or leaves, at the next query.
+//
+// Only occupied cells exist.  Each keeps its entries in one
+// contiguous array, and the cells themselves sit in a dense
+// vector, so a query streams through memory in order.  A
+// query visits only the cells in its range, by hash lookup,
+// or walks the dense vector when that's fewer cells.
+// --------------------------------------------------------
+class LooseGrid : public ISpatialIndex
+{
+private:
+	struct GridEntry
+	{
+		AABB bounds;
+		int proxy;
+	};
+
+	struct GridCell
+	{
+		int x, y, z;
+		float maxExtent;	// Of any entry, or more while staleExtent is set
+		bool staleExtent;
+		std::vector<GridEntry> entries;
+	};
+
+	struct GridProxy
+	{
+		void* userData;
+		int cell;	// -1 while the proxy is on the free list
+		int slot;	// Index into the cell's entries, or the next free proxy
+	};
+
+	float cellSize;
+	float inverseCellSize;
+	float maxExtent;
+	int minCell[3];		// The range of cells that have ever been occupied
+	int maxCell[3];
+	std::vector<GridCell> cells;
+	std::vector<int> staleCells;
+	std::unordered_map<uint64_t, int> cellLookup;
+	std::vector<GridProxy> proxies;
+	int freeProxy;
+	int proxyCount;
+
+	static uint64_t CellKey(int x, int y, int z);
+	int CellCoordinate(float value);
+	int FindOrCreateCell(int x, int y, int z);
+	void AddToCell(int proxyId, int cell, const AABB& bounds);
+	void RemoveFromCell(int proxyId);
+	void MarkStale(int cell);
+	void RefreshExtents();
+	void QueryCell(const GridCell& cell, const Frustum& frustum, const DirectX::XMFLOAT4* planes, std::vector<int>& proxies);
+public:
+	LooseGrid(float cellSize = 4.0f);
+
+	int CreateProxy(const AABB& bounds, void* userData);
+	void DestroyProxy(int proxyId);
+	bool MoveProxy(int proxyId, const AABB& bounds); //true when the proxy changed cells
+	void* GetUserData(int proxyId);
+
+	void QueryFrustum(const Frustum& frustum, std::vector<int>& proxies);
+	void QuerySphere(DirectX::XMFLOAT3 center, float radius, std::vector<int>& proxies);
+
+	int GetProxyCount();
+	int GetProxyCapacity();
+	int GetCellCount(); //occupied and previously occupied cells
+	float GetCellSize();
+	float GetMaxExtent(); //the largest extent of any proxy's bounds
+};
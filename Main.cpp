@@ -1,7 +1,36 @@
 
 #include <Windows.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
 #include "Game.h"
 
+#define HEADLESS_DEFAULT_FRAMES 5000
+#define HEADLESS_STEPS_PER_SECOND 60
+#define FLYTHROUGH_DEFAULT_PATH "../../Assets/Paths/Basic.path"
+
+// --------------------------------------------------------
+// The word after flag on the command line, or an empty
+// string if the flag (or the word) isn't there; a word
+// starting with '-' is the next flag, not a value
+// --------------------------------------------------------
+static std::string GetArgument(const char* commandLine, const char* flag)
+{
+	const char* found = strstr(commandLine, flag);
+	if (!found)
+		return std::string();
+	const char* start = found + strlen(flag);
+	while (*start == ' ')
+		start++;
+	const char* end = start;
+	while (*end && *end != ' ')
+		end++;
+	if (*start == '-')
+		return std::string();
+	return std::string(start, end);
+}
+
 // --------------------------------------------------------
 // Entry point for a graphical (non-console) Windows application
 // --------------------------------------------------------
@@ -25,6 +54,54 @@ int WINAPI WinMain(
 	// Result variable for function calls below
 	HRESULT hr = S_OK;
 
+	// "-record file" saves the run's input and frame times when it ends,
+	// "-playback file" replays them instead of the real ones
+	std::string recordPath = GetArgument(lpCmdLine, "-record");
+	if (!recordPath.empty())
+		dxGame.RecordInput(recordPath);
+	std::string playbackPath = GetArgument(lpCmdLine, "-playback");
+	if (!playbackPath.empty() && !dxGame.PlayInput(playbackPath))
+		return E_FAIL;
+
+	// "-flythrough [file]" flies the camera along a path instead of
+	// reading input, so every run of the same path does the same work
+	if (strstr(lpCmdLine, "-flythrough"))
+	{
+		std::string pathFile = GetArgument(lpCmdLine, "-flythrough");
+		if (!dxGame.SetFlythrough(pathFile.empty() ? FLYTHROUGH_DEFAULT_PATH : pathFile))
+			return E_FAIL;
+	}
+
+	// "-stress count" or "-stress spheres=N,cubes=N,tori=N,lights=N,transparent=F,static=F,seed=N"
+	// generates a scene with that many shapes and lights in place of the starter scene,
+	// up to the MAX_LIGHTS the shaders draw
+	if (strstr(lpCmdLine, "-stress"))
+	{
+		StressSceneDesc stressDesc;
+		if (!StressScene::Parse(GetArgument(lpCmdLine, "-stress"), stressDesc))
+			return E_INVALIDARG;
+		dxGame.SetStressScene(stressDesc);
+	}
+
+	// "-headless [frames]" runs the game loop with no window, on D3D11's
+	// null driver, and reports the CPU time of each frame.  That needs no
+	// GPU, but it's still Windows only (and the null driver comes with the
+	// Graphics Tools optional feature); the Benchmarks directory has what
+	// runs elsewhere.  With -playback, the recording's frames are run
+	// instead, uncapped, and with -flythrough exactly as many as the path takes
+	const char* headlessArg = strstr(lpCmdLine, "-headless");
+	if (headlessArg)
+	{
+		int frameCount = atoi(headlessArg + strlen("-headless"));
+		if (frameCount <= 0)
+			frameCount = HEADLESS_DEFAULT_FRAMES;
+		if (dxGame.GetFlythroughDuration() > 0)
+			frameCount = (int)ceilf(dxGame.GetFlythroughDuration() * HEADLESS_STEPS_PER_SECOND);
+		hr = dxGame.InitHeadless();
+		if (FAILED(hr)) return hr;
+		return dxGame.RunHeadless(frameCount, 1.0f / HEADLESS_STEPS_PER_SECOND);
+	}
+
 	// Attempt to create the window for our program, and
 	// exit early if something failed
 	hr = dxGame.InitWindow();
@@ -1,5 +1,7 @@
 #include "Material.h"
 
+unsigned int Material::nextId = 0;
+
 // roughness must be within the range 0 - 1
 Material::Material(DirectX::XMFLOAT4 colorTint, std::shared_ptr<SimpleVertexShader> vertexShader, std::shared_ptr<SimplePixelShader> pixelShader, float roughness)
 {
@@ -7,6 +9,7 @@ Material::Material(DirectX::XMFLOAT4 colorTint, std::shared_ptr<SimpleVertexShad
 	this->vertexShader = vertexShader;
 	this->pixelShader = pixelShader;
 	this->roughness = roughness;
+	this->id = nextId++;
 }
 
 DirectX::XMFLOAT4 Material::GetColorTint()
@@ -19,6 +22,11 @@ float Material::GetRoughness()
 	return roughness;
 }
 
+unsigned int Material::GetId()
+{
+	return id;
+}
+
 std::shared_ptr<SimpleVertexShader> Material::GetVertexShader()
 {
 	return vertexShader;
@@ -29,6 +37,74 @@ std::shared_ptr<SimplePixelShader> Material::GetPixelShader()
 	return pixelShader;
 }
 
+void Material::SetInstancedShaders(std::shared_ptr<SimpleVertexShader> vertexShader, std::shared_ptr<SimplePixelShader> pixelShader)
+{
+	instancedVertexShader = vertexShader;
+	instancedPixelShader = pixelShader;
+}
+
+std::shared_ptr<SimpleVertexShader> Material::GetInstancedVertexShader()
+{
+	return instancedVertexShader;
+}
+
+std::shared_ptr<SimplePixelShader> Material::GetInstancedPixelShader()
+{
+	return instancedPixelShader;
+}
+
+bool Material::IsInstanced()
+{
+	return instancedVertexShader && instancedPixelShader;
+}
+
+void Material::SetPipelineStates(std::shared_ptr<PipelineState> pipelineState, std::shared_ptr<PipelineState> instancedPipelineState)
+{
+	this->pipelineState = pipelineState;
+	this->instancedPipelineState = instancedPipelineState;
+}
+
+std::shared_ptr<PipelineState> Material::GetPipelineState()
+{
+	return pipelineState;
+}
+
+std::shared_ptr<PipelineState> Material::GetInstancedPipelineState()
+{
+	return instancedPipelineState;
+}
+
+bool Material::CanInstanceWith(Material* other)
+{
+	if (other == this) {
+		return IsInstanced();
+	}
+	return IsInstanced() &&
+		instancedVertexShader == other->instancedVertexShader &&
+		instancedPixelShader == other->instancedPixelShader &&
+		instancedPipelineState == other->instancedPipelineState &&
+		roughness == other->roughness &&
+		textureSRVs == other->textureSRVs &&
+		samplers == other->samplers;
+}
+
+bool Material::IsEquivalentTo(Material* other)
+{
+	if (other == this) {
+		return true;
+	}
+	return vertexShader == other->vertexShader &&
+		pixelShader == other->pixelShader &&
+		pipelineState == other->pipelineState &&
+		colorTint.x == other->colorTint.x &&
+		colorTint.y == other->colorTint.y &&
+		colorTint.z == other->colorTint.z &&
+		colorTint.w == other->colorTint.w &&
+		roughness == other->roughness &&
+		textureSRVs == other->textureSRVs &&
+		samplers == other->samplers;
+}
+
 void Material::AddTextureSRV(std::string shaderName, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv)
 {
 	textureSRVs.insert({ shaderName, srv });
@@ -50,3 +126,32 @@ void Material::BindResources()
 	pixelShader->SetFloat("roughness", roughness);
 	pixelShader->SetFloat4("color", colorTint);
 }
+
+void Material::RecordResources(CommandBuffer& commands, ShaderConstants& pixelConstants)
+{
+	for (auto& t : textureSRVs) {
+		const SimpleSRV* srv = pixelShader->GetShaderResourceViewInfo(t.first);
+		if (srv) {
+			commands.SetShaderResource(SHADER_STAGE_PIXEL, srv->BindIndex, t.second.Get());
+		}
+	}
+	for (auto& s : samplers) {
+		const SimpleSampler* sampler = pixelShader->GetSamplerInfo(s.first);
+		if (sampler) {
+			commands.SetSampler(SHADER_STAGE_PIXEL, sampler->BindIndex, s.second.Get());
+		}
+	}
+	pixelConstants.SetFloat("roughness", roughness);
+	pixelConstants.SetFloat4("color", colorTint);
+}
+
+void Material::BindInstancedResources()
+{
+	for (auto& t : textureSRVs) {
+		instancedPixelShader->SetShaderResourceView(t.first.c_str(), t.second);
+	}
+	for (auto& s : samplers) {
+		instancedPixelShader->SetSamplerState(s.first.c_str(), s.second);
+	}
+	instancedPixelShader->SetFloat("roughness", roughness);
+}
@@ -3,6 +3,9 @@
 #include <memory>
 
 #include <unordered_map>
+#include "CommandBuffer.h"
+#include "PipelineState.h"
+#include "ShaderConstants.h"
 #include "SimpleShader.h"
 
 class Material
@@ -10,20 +13,43 @@ class Material
 private:
 	DirectX::XMFLOAT4 colorTint;
 	float roughness;
+	unsigned int id;
+	static unsigned int nextId;
 	std::shared_ptr<SimpleVertexShader> vertexShader;
 	std::shared_ptr<SimplePixelShader> pixelShader;
+	std::shared_ptr<SimpleVertexShader> instancedVertexShader; //null unless the material can be drawn by InstanceBatcher
+	std::shared_ptr<SimplePixelShader> instancedPixelShader;
+	std::shared_ptr<PipelineState> pipelineState; //the shaders above with the states of the pass the material is drawn in
+	std::shared_ptr<PipelineState> instancedPipelineState;
 	std::unordered_map<std::string, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>> textureSRVs;
 	std::unordered_map<std::string, Microsoft::WRL::ComPtr<ID3D11SamplerState>> samplers;
 public:
 	Material(DirectX::XMFLOAT4 colorTint, std::shared_ptr<SimpleVertexShader> vertexShader, std::shared_ptr<SimplePixelShader> pixelShader, float roughness = 0.5f);
 	DirectX::XMFLOAT4 GetColorTint();
 	float GetRoughness();
+	unsigned int GetId(); //unique per material, in creation order
 	std::shared_ptr<SimpleVertexShader> GetVertexShader();
 	std::shared_ptr<SimplePixelShader> GetPixelShader();
 	//shaderName is the name of the variable inside the shader
 	void AddTextureSRV(std::string shaderName, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv);
 	//shaderName is the name of the variable inside the shader
 	void AddSampler(std::string shaderName, Microsoft::WRL::ComPtr<ID3D11SamplerState> sampler);
+	//instanced versions of this material's shaders, which take the world matrix, tint and center per instance
+	void SetInstancedShaders(std::shared_ptr<SimpleVertexShader> vertexShader, std::shared_ptr<SimplePixelShader> pixelShader);
+	std::shared_ptr<SimpleVertexShader> GetInstancedVertexShader();
+	std::shared_ptr<SimplePixelShader> GetInstancedPixelShader();
+	bool IsInstanced();
+	//from the PipelineStateCache, made from this material's shaders (and instanced shaders); RenderQueue and InstancedRenderer bind these
+	void SetPipelineStates(std::shared_ptr<PipelineState> pipelineState, std::shared_ptr<PipelineState> instancedPipelineState = nullptr);
+	std::shared_ptr<PipelineState> GetPipelineState();
+	std::shared_ptr<PipelineState> GetInstancedPipelineState();
+	//true if both materials can share one instanced draw, i.e. everything but the color tint matches
+	bool CanInstanceWith(Material* other);
+	//true if binding either material sets exactly the same state, so their geometry can be merged into one draw
+	bool IsEquivalentTo(Material* other);
 	void BindResources();
+	void BindInstancedResources(); //everything BindResources sets except the color tint, on the instanced pixel shader
+	//what BindResources sets, recorded instead; pixelConstants must have been reset to this material's pixel shader
+	void RecordResources(CommandBuffer& commands, ShaderConstants& pixelConstants);
 };
 
@@ -1,7 +1,11 @@
 #pragma once
 #include <d3d11.h>
 #include <wrl/client.h> // Used for ComPtr - a smart pointer for COM objects
+#include <atomic>
+#include <vector>
 #include "Vertex.h"
+#include "Bounds.h"
+#include "CommandBuffer.h"
 
 class Mesh
 {
@@ -10,7 +14,12 @@ private:
 	Microsoft::WRL::ComPtr<ID3D11Buffer> indexBuffer;
 	Microsoft::WRL::ComPtr<ID3D11DeviceContext> context;
 	unsigned int numIndices;
-	void CalculateTangents(Vertex* verts, int numVerts, unsigned int* indices, int numIndices); //private since it's only used internally
+	unsigned int id;
+	static std::atomic<unsigned int> nextId; //meshes can be loaded on streaming threads
+	AABB localBounds;
+	std::vector<DirectX::XMFLOAT3> cpuPositions; //kept on the CPU for the software occlusion rasterizer
+	std::vector<Vertex> cpuVertices; //and the full vertices for batching, with tangents already calculated
+	std::vector<unsigned int> cpuIndices;
 public:
 	Mesh(Vertex* vertices, unsigned int numVertices, unsigned int* indices, unsigned int numIndices, Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context);
 	Mesh(const char* fileName, Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context);
@@ -19,6 +28,18 @@ public:
 	Microsoft::WRL::ComPtr<ID3D11Buffer> GetVertexBuffer();
 	Microsoft::WRL::ComPtr<ID3D11Buffer> GetIndexBuffer();
 	unsigned int GetIndexCount();
+	unsigned int GetId(); //unique per mesh, in creation order
+	AABB GetLocalBounds();
+	const std::vector<DirectX::XMFLOAT3>& GetPositions();
+	const std::vector<Vertex>& GetVertices();
+	const std::vector<unsigned int>& GetIndices();
+	size_t GetMemoryUsage(); //GPU buffers plus the CPU copies, in bytes
 	void Draw();
+	void SetBuffers();
+	void DrawIndexed(); //draws with whatever buffers are currently bound
+	//the same three, recorded into a command buffer instead of going to the context
+	void RecordDraw(CommandBuffer& commands);
+	void RecordBuffers(CommandBuffer& commands);
+	void RecordDrawIndexed(CommandBuffer& commands);
 };
 
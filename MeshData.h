@@ -0,0 +1,16 @@
+#pragma once
+#include <vector>
+#include "Vertex.h"
+
+// --------------------------------------------------------
+// The CPU side of building a Mesh: reading OBJ files and
+// calculating tangents.  Nothing here touches the device,
+// so it can run on streaming threads and in the benchmarks.
+// --------------------------------------------------------
+class MeshData
+{
+public:
+	//replaces whatever vertices and indices held; false if the file can't be opened
+	static bool LoadObj(const char* fileName, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+	static void CalculateTangents(Vertex* verts, int numVerts, unsigned int* indices, int numIndices);
+};
@@ -0,0 +1,132 @@
+#include <stdio.h>
+#include <string.h>
+#include "NullCommandBackend.h"
+
+NullCommandBackend::NullCommandBackend()
+{
+	memset(&stats, 0, sizeof(stats));
+	vertexShader = nullptr;
+	inputLayout = nullptr;
+	pixelShader = nullptr;
+	vertexBuffer = nullptr;
+	indexBuffer = nullptr;
+}
+
+void NullCommandBackend::Error(const char* message, unsigned int value)
+{
+	if (stats.Errors < NULL_BACKEND_REPORTED_ERRORS) {
+		printf("Null backend: %s (%u)\n", message, value);
+	}
+	stats.Errors++;
+}
+
+void NullCommandBackend::SetVertexShader(void* shader, void* inputLayout)
+{
+	vertexShader = shader;
+	this->inputLayout = inputLayout;
+	stats.ShaderChanges++;
+}
+
+void NullCommandBackend::SetPixelShader(void* shader)
+{
+	pixelShader = shader;
+	stats.ShaderChanges++;
+}
+
+void NullCommandBackend::SetConstants(unsigned int stage, unsigned int slot, void* buffer, const void* data, unsigned int size)
+{
+	if (stage > SHADER_STAGE_PIXEL) {
+		Error("constants for an unknown shader stage", stage);
+	}
+	if (slot >= NULL_BACKEND_CONSTANT_SLOTS) {
+		Error("constant buffer slot out of range", slot);
+	}
+	if (!buffer || !data) {
+		Error("constants with no buffer or data, slot", slot);
+	}
+	if (size == 0 || size % 16 != 0) {
+		Error("constant data isn't a multiple of 16 bytes", size);
+	}
+	stats.ConstantUpdates++;
+	stats.ConstantBytes += size;
+}
+
+void NullCommandBackend::SetShaderResource(unsigned int stage, unsigned int slot, void* resource)
+{
+	if (stage > SHADER_STAGE_PIXEL) {
+		Error("shader resource for an unknown shader stage", stage);
+	}
+	if (slot >= NULL_BACKEND_RESOURCE_SLOTS) {
+		Error("shader resource slot out of range", slot);
+	}
+	stats.ResourceBindings++;
+}
+
+void NullCommandBackend::SetSampler(unsigned int stage, unsigned int slot, void* sampler)
+{
+	if (stage > SHADER_STAGE_PIXEL) {
+		Error("sampler for an unknown shader stage", stage);
+	}
+	if (slot >= NULL_BACKEND_SAMPLER_SLOTS) {
+		Error("sampler slot out of range", slot);
+	}
+	stats.SamplerBindings++;
+}
+
+void NullCommandBackend::SetBlendState(void* state)
+{
+	stats.StateChanges++;
+}
+
+void NullCommandBackend::SetRasterizerState(void* state)
+{
+	stats.StateChanges++;
+}
+
+void NullCommandBackend::SetDepthStencilState(void* state, unsigned int stencilRef)
+{
+	stats.StateChanges++;
+}
+
+void NullCommandBackend::SetPipelineState(const PipelineHandles& pipeline)
+{
+	vertexShader = pipeline.VertexShader;
+	inputLayout = pipeline.InputLayout;
+	pixelShader = pipeline.PixelShader;
+	stats.PipelineChanges++;
+}
+
+void NullCommandBackend::SetMeshBuffers(void* vertexBuffer, void* indexBuffer, unsigned int stride)
+{
+	if ((vertexBuffer || indexBuffer) && stride == 0) {
+		Error("mesh buffers with a zero stride", stride);
+	}
+	this->vertexBuffer = vertexBuffer;
+	this->indexBuffer = indexBuffer;
+	stats.MeshBindings++;
+}
+
+void NullCommandBackend::DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex)
+{
+	if (!vertexShader || !inputLayout || !pixelShader) {
+		Error("draw without a vertex shader, input layout and pixel shader bound, draw", stats.Draws);
+	}
+	if (!vertexBuffer || !indexBuffer) {
+		Error("draw without mesh buffers bound, draw", stats.Draws);
+	}
+	if (indexCount == 0) {
+		Error("draw of zero indices, draw", stats.Draws);
+	}
+	stats.Draws++;
+	stats.Indices += indexCount;
+}
+
+const CommandBackendStats& NullCommandBackend::GetStats() const
+{
+	return stats;
+}
+
+void NullCommandBackend::ResetStats()
+{
+	memset(&stats, 0, sizeof(stats));
+}
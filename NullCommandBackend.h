@@ -0,0 +1,68 @@
+#pragma once
+#include <stdint.h>
+#include "ICommandBackend.h"
+
+// Same limits as D3D11, so anything the real context would reject is caught here too
+#define NULL_BACKEND_CONSTANT_SLOTS 14
+#define NULL_BACKEND_RESOURCE_SLOTS 128
+#define NULL_BACKEND_SAMPLER_SLOTS 16
+#define NULL_BACKEND_REPORTED_ERRORS 16
+
+struct CommandBackendStats
+{
+	unsigned int Draws;
+	uint64_t Indices;
+	unsigned int ShaderChanges;
+	unsigned int ConstantUpdates;
+	uint64_t ConstantBytes;
+	unsigned int ResourceBindings;
+	unsigned int SamplerBindings;
+	unsigned int StateChanges;
+	unsigned int PipelineChanges;
+	unsigned int MeshBindings;
+	unsigned int Errors;
+};
+
+// --------------------------------------------------------
+// A backend that never touches a GPU.  It counts what it's
+// asked to do and checks each call the way the D3D11 debug
+// layer would: slots in range, constant buffers a multiple
+// of 16 bytes, and a shader pair, input layout and mesh
+// bound for every draw.  The first few problems are
+// printed, every one of them is counted in Errors.
+//
+// It's plain C++, so it builds and is tested anywhere
+// (see Tests/NullCommandBackendTests.cpp), but it only sees
+// what's replayed into it.  Headless runs of the game still
+// need D3D11's null driver for everything that isn't
+// recorded yet: buffer uploads, instanced draws, clears.
+// --------------------------------------------------------
+class NullCommandBackend : public ICommandBackend
+{
+private:
+	CommandBackendStats stats;
+	void* vertexShader;
+	void* inputLayout;
+	void* pixelShader;
+	void* vertexBuffer;
+	void* indexBuffer;
+
+	void Error(const char* message, unsigned int value);
+public:
+	NullCommandBackend();
+
+	void SetVertexShader(void* shader, void* inputLayout);
+	void SetPixelShader(void* shader);
+	void SetConstants(unsigned int stage, unsigned int slot, void* buffer, const void* data, unsigned int size);
+	void SetShaderResource(unsigned int stage, unsigned int slot, void* resource);
+	void SetSampler(unsigned int stage, unsigned int slot, void* sampler);
+	void SetBlendState(void* state);
+	void SetRasterizerState(void* state);
+	void SetDepthStencilState(void* state, unsigned int stencilRef);
+	void SetPipelineState(const PipelineHandles& pipeline);
+	void SetMeshBuffers(void* vertexBuffer, void* indexBuffer, unsigned int stride);
+	void DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex);
+
+	const CommandBackendStats& GetStats() const;
+	void ResetStats(); //bound state is kept, like a context's is between frames
+};
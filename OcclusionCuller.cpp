@@ -0,0 +1,415 @@
+#include <algorithm>
+#include <chrono>
+#include <float.h>
+#include <math.h>
+#include <emmintrin.h>
+#include "OcclusionCuller.h"
+#include "Profiler.h"
+
+using namespace DirectX;
+
+OcclusionCuller::OcclusionCuller(unsigned int width, unsigned int height, unsigned int bandCount)
+{
+	this->width = (width + 3) & ~3u; //rows are processed four pixels at a time
+	this->height = height;
+	this->bandCount = bandCount > 0 ? bandCount : 1;
+	this->cullBackFaces = true;
+	jobs = nullptr;
+	depthBuffer.assign(this->width * this->height, 1.0f);
+	coverageMasks.assign(this->width * this->height, 0);
+	occluderDepth.assign(this->width * this->height, 0.0f);
+	XMStoreFloat4x4(&viewProjection, XMMatrixIdentity());
+	stats = {};
+}
+
+void OcclusionCuller::SetCullBackFaces(bool cull)
+{
+	cullBackFaces = cull;
+}
+
+void OcclusionCuller::SetJobSystem(JobSystem* jobs)
+{
+	this->jobs = jobs;
+}
+
+void OcclusionCuller::BeginFrame(XMFLOAT4X4 view, XMFLOAT4X4 projection)
+{
+	XMStoreFloat4x4(&viewProjection, XMMatrixMultiply(XMLoadFloat4x4(&view), XMLoadFloat4x4(&projection)));
+	std::fill(depthBuffer.begin(), depthBuffer.end(), 1.0f);
+	triangles.clear();
+	occluderStarts.clear();
+	stats = {};
+}
+
+void OcclusionCuller::AddOccluder(const XMFLOAT3* positions, const unsigned int* indices, unsigned int indexCount, XMFLOAT4X4 world)
+{
+	XMMATRIX worldViewProj = XMMatrixMultiply(XMLoadFloat4x4(&world), XMLoadFloat4x4(&viewProjection));
+	occluderStarts.push_back((unsigned int)triangles.size());
+	for (unsigned int i = 0; i + 2 < indexCount; i += 3) {
+		XMFLOAT4 clip[3];
+		for (int v = 0; v < 3; v++) {
+			XMStoreFloat4(&clip[v], XMVector3Transform(XMLoadFloat3(&positions[indices[i + v]]), worldViewProj));
+		}
+
+		// Clip against the near plane (z >= 0 in D3D clip space) so we never divide by w <= 0
+		// One plane can turn a triangle into at most a quad
+		XMFLOAT4 polygon[4];
+		int polygonCount = 0;
+		for (int v = 0; v < 3; v++) {
+			const XMFLOAT4& current = clip[v];
+			const XMFLOAT4& next = clip[(v + 1) % 3];
+			bool currentInside = current.z >= 0;
+			bool nextInside = next.z >= 0;
+			if (currentInside) {
+				polygon[polygonCount++] = current;
+			}
+			if (currentInside != nextInside) {
+				float t = current.z / (current.z - next.z);
+				polygon[polygonCount++] = XMFLOAT4(
+					current.x + (next.x - current.x) * t,
+					current.y + (next.y - current.y) * t,
+					0.0f,
+					current.w + (next.w - current.w) * t);
+			}
+		}
+		for (int v = 1; v + 1 < polygonCount; v++) {
+			BinTriangle(polygon[0], polygon[v], polygon[v + 1]);
+		}
+	}
+}
+
+void OcclusionCuller::BinTriangle(XMFLOAT4 a, XMFLOAT4 b, XMFLOAT4 c)
+{
+	const XMFLOAT4* clip[3] = { &a, &b, &c };
+	ScreenTriangle tri;
+	for (int v = 0; v < 3; v++) {
+		float invW = 1.0f / clip[v]->w;
+		tri.x[v] = (clip[v]->x * invW * 0.5f + 0.5f) * width;
+		tri.y[v] = (0.5f - clip[v]->y * invW * 0.5f) * height; //pixel rows run top to bottom
+		tri.z[v] = clip[v]->z * invW;
+	}
+
+	// With y pointing down, D3D's clockwise front faces have a positive area
+	float area = (tri.x[1] - tri.x[0]) * (tri.y[2] - tri.y[0]) - (tri.y[1] - tri.y[0]) * (tri.x[2] - tri.x[0]);
+	if (area == 0 || (area < 0 && cullBackFaces)) {
+		return;
+	}
+	if (area < 0) {
+		std::swap(tri.x[1], tri.x[2]);
+		std::swap(tri.y[1], tri.y[2]);
+		std::swap(tri.z[1], tri.z[2]);
+	}
+
+	tri.minX = fminf(tri.x[0], fminf(tri.x[1], tri.x[2]));
+	tri.maxX = fmaxf(tri.x[0], fmaxf(tri.x[1], tri.x[2]));
+	tri.minY = fminf(tri.y[0], fminf(tri.y[1], tri.y[2]));
+	tri.maxY = fmaxf(tri.y[0], fmaxf(tri.y[1], tri.y[2]));
+	if (tri.maxY < 0 || tri.minY > height || tri.maxX < 0 || tri.minX > width) {
+		return;
+	}
+	triangles.push_back(tri);
+}
+
+void OcclusionCuller::RasterizeOccluders()
+{
+	PROFILE_FUNCTION();
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	unsigned int rowsPerBand = (height + bandCount - 1) / bandCount;
+	std::function<void(unsigned int, unsigned int)> rasterizeBands = [this, rowsPerBand](unsigned int firstBand, unsigned int lastBand) {
+		for (unsigned int band = firstBand; band < lastBand; band++) {
+			unsigned int firstRow = band * rowsPerBand;
+			unsigned int lastRow = firstRow + rowsPerBand < height ? firstRow + rowsPerBand : height;
+			if (firstRow < lastRow) {
+				RasterizeBand(firstRow, lastRow);
+			}
+		}
+	};
+	if (jobs) {
+		jobs->ParallelFor(bandCount, 1, rasterizeBands);
+	}
+	else {
+		rasterizeBands(0, bandCount);
+	}
+
+	std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+	stats.OccluderTriangles = (unsigned int)triangles.size();
+	stats.RasterizeMicroseconds = std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+// The first and last pixel whose square, edges included, touches [minCoord, maxCoord], clamped to [0, size)
+static int FirstPixel(float minCoord, unsigned int size)
+{
+	int first = (int)ceilf(fminf(fmaxf(minCoord, 0.0f), (float)size)) - 1;
+	return first < 0 ? 0 : first;
+}
+
+static int LastPixel(float maxCoord, unsigned int size)
+{
+	int last = (int)floorf(fminf(fmaxf(maxCoord, 0.0f), (float)size));
+	return last > (int)size - 1 ? (int)size - 1 : last;
+}
+
+void OcclusionCuller::RasterizeBand(unsigned int firstRow, unsigned int lastRow)
+{
+	// An occluder's triangles are masked together, then resolved before the next one starts
+	for (unsigned int occluder = 0; occluder < occluderStarts.size(); occluder++) {
+		unsigned int first = occluderStarts[occluder];
+		unsigned int last = occluder + 1 < occluderStarts.size() ? occluderStarts[occluder + 1] : (unsigned int)triangles.size();
+		int startX = (int)width, endX = -1, startY = (int)lastRow, endY = -1;
+		for (unsigned int i = first; i < last; i++) {
+			const ScreenTriangle& tri = triangles[i];
+			int triStartY = std::max(FirstPixel(tri.minY, height), (int)firstRow);
+			int triEndY = std::min(LastPixel(tri.maxY, height), (int)lastRow - 1);
+			if (triStartY > triEndY) {
+				continue;
+			}
+			RasterizeTriangle(tri, triStartY, triEndY);
+			startX = std::min(startX, FirstPixel(tri.minX, width));
+			endX = std::max(endX, LastPixel(tri.maxX, width));
+			startY = std::min(startY, triStartY);
+			endY = std::max(endY, triEndY);
+		}
+		if (startY <= endY) {
+			ResolveOccluder(startX, endX, startY, endY);
+		}
+	}
+}
+
+void OcclusionCuller::RasterizeTriangle(const ScreenTriangle& tri, int startY, int endY)
+{
+	// Edge function for the edge a->b: A * x + B * y + C, positive on the inside.  Each edge is
+	// set up from its lower vertex and negated if need be, so two triangles sharing an edge get
+	// exactly opposite values at every sample, and the top-left rule gives a tie to one of them
+	float edgeA[3], edgeB[3], edgeC[3];
+	__m128 ties[3];
+	for (int e = 0; e < 3; e++) {
+		int a = (e + 1) % 3;
+		int b = (e + 2) % 3;
+		bool flip = tri.x[b] < tri.x[a] || (tri.x[b] == tri.x[a] && tri.y[b] < tri.y[a]);
+		if (flip) {
+			std::swap(a, b);
+		}
+		edgeA[e] = tri.y[a] - tri.y[b];
+		edgeB[e] = tri.x[b] - tri.x[a];
+		edgeC[e] = (tri.y[b] - tri.y[a]) * tri.x[a] - (tri.x[b] - tri.x[a]) * tri.y[a];
+		if (flip) {
+			edgeA[e] = -edgeA[e];
+			edgeB[e] = -edgeB[e];
+			edgeC[e] = -edgeC[e];
+		}
+		bool topLeft = edgeA[e] > 0 || (edgeA[e] == 0 && edgeB[e] > 0);
+		ties[e] = _mm_castsi128_ps(_mm_set1_epi32(topLeft ? -1 : 0));
+	}
+	float invArea = 1.0f / (edgeA[0] * tri.x[0] + edgeB[0] * tri.y[0] + edgeC[0]);
+
+	int startX = FirstPixel(tri.minX, width) & ~3;
+	int endX = LastPixel(tri.maxX, width);
+
+	const __m128 laneOffsets = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128i fullMask = _mm_set1_epi32(0xFFFF);
+	const float sampleOffsets[4] = { 0.0f, 1.0f / 3.0f, 2.0f / 3.0f, 1.0f };
+
+	// At the pixel's center: every corner is inside an edge past insideMargin, and every sample
+	// is outside it below -outsideMargin (kept a whole pixel out, well clear of rounding)
+	__m128 stepX[3], insideMargin[3], outsideMargin[3];
+	for (int e = 0; e < 3; e++) {
+		stepX[e] = _mm_set1_ps(edgeA[e]);
+		insideMargin[e] = _mm_set1_ps(0.5f * (fabsf(edgeA[e]) + fabsf(edgeB[e])));
+		outsideMargin[e] = _mm_set1_ps(-(fabsf(edgeA[e]) + fabsf(edgeB[e])));
+	}
+	__m128 z0 = _mm_set1_ps(tri.z[0] * invArea);
+	__m128 z1 = _mm_set1_ps(tri.z[1] * invArea);
+	__m128 z2 = _mm_set1_ps(tri.z[2] * invArea);
+
+	// Pixels take the farthest depth the triangle's plane has anywhere in them
+	float depthDx = (edgeA[0] * tri.z[0] + edgeA[1] * tri.z[1] + edgeA[2] * tri.z[2]) * invArea;
+	float depthDy = (edgeB[0] * tri.z[0] + edgeB[1] * tri.z[1] + edgeB[2] * tri.z[2]) * invArea;
+	__m128 farthestOffset = _mm_set1_ps(0.5f * (fabsf(depthDx) + fabsf(depthDy)));
+
+	for (int y = startY; y <= endY; y++) {
+		__m128 rowCenter[3];
+		for (int e = 0; e < 3; e++) {
+			rowCenter[e] = _mm_set1_ps(edgeB[e] * (y + 0.5f) + edgeC[e]);
+		}
+		uint32_t* maskRow = &coverageMasks[y * width];
+		float* depthRow = &occluderDepth[y * width];
+		for (int x = startX; x <= endX; x += 4) {
+			__m128 pixelX = _mm_add_ps(_mm_set1_ps((float)x), laneOffsets);
+			__m128 centerX = _mm_add_ps(pixelX, half);
+			__m128 w[3];
+			for (int e = 0; e < 3; e++) {
+				w[e] = _mm_add_ps(_mm_mul_ps(stepX[e], centerX), rowCenter[e]);
+			}
+			if (_mm_movemask_ps(_mm_cmplt_ps(w[0], outsideMargin[0])) == 0xF ||
+				_mm_movemask_ps(_mm_cmplt_ps(w[1], outsideMargin[1])) == 0xF ||
+				_mm_movemask_ps(_mm_cmplt_ps(w[2], outsideMargin[2])) == 0xF) {
+				continue;
+			}
+
+			__m128i mask;
+			__m128 allInside = _mm_and_ps(_mm_and_ps(
+				_mm_cmpge_ps(w[0], insideMargin[0]), _mm_cmpge_ps(w[1], insideMargin[1])), _mm_cmpge_ps(w[2], insideMargin[2]));
+			if (_mm_movemask_ps(allInside) == 0xF) {
+				mask = fullMask;
+			}
+			else {
+				// Along the triangle's edges, test each sample on its own
+				mask = _mm_setzero_si128();
+				for (int sy = 0; sy < 4; sy++) {
+					float sampleY = y + sampleOffsets[sy];
+					__m128 rowTerm[3];
+					for (int e = 0; e < 3; e++) {
+						rowTerm[e] = _mm_set1_ps(edgeB[e] * sampleY + edgeC[e]);
+					}
+					for (int sx = 0; sx < 4; sx++) {
+						__m128 sampleX = _mm_add_ps(pixelX, _mm_set1_ps(sampleOffsets[sx]));
+						__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+						for (int e = 0; e < 3; e++) {
+							__m128 sample = _mm_add_ps(_mm_mul_ps(stepX[e], sampleX), rowTerm[e]);
+							inside = _mm_and_ps(inside, _mm_or_ps(_mm_cmpgt_ps(sample, zero), _mm_and_ps(_mm_cmpeq_ps(sample, zero), ties[e])));
+						}
+						mask = _mm_or_si128(mask, _mm_and_si128(_mm_castps_si128(inside), _mm_set1_epi32(1 << (sy * 4 + sx))));
+					}
+				}
+			}
+			__m128 touched = _mm_castsi128_ps(_mm_cmpgt_epi32(mask, _mm_setzero_si128()));
+			if (!_mm_movemask_ps(touched)) {
+				continue;
+			}
+			_mm_storeu_si128((__m128i*)(maskRow + x), _mm_or_si128(_mm_loadu_si128((const __m128i*)(maskRow + x)), mask));
+
+			// z/w is affine in screen space, so the barycentric blend is exact at pixel centers
+			__m128 depth = _mm_add_ps(_mm_add_ps(_mm_mul_ps(w[0], z0), _mm_mul_ps(w[1], z1)), _mm_mul_ps(w[2], z2));
+			depth = _mm_add_ps(depth, farthestOffset);
+			__m128 old = _mm_loadu_ps(depthRow + x);
+			__m128 farther = _mm_max_ps(old, depth);
+			_mm_storeu_ps(depthRow + x, _mm_or_ps(_mm_and_ps(touched, farther), _mm_andnot_ps(touched, old)));
+		}
+	}
+}
+
+void OcclusionCuller::ResolveOccluder(int startX, int endX, int startY, int endY)
+{
+	// Only pixels the occluder covers at every sample are written, so a pixel never claims to
+	// be hidden by more occluder than it holds.  The masks and depths are left cleared
+	const __m128i fullMask = _mm_set1_epi32(0xFFFF);
+	for (int y = startY; y <= endY; y++) {
+		uint32_t* maskRow = &coverageMasks[y * width];
+		float* occluderRow = &occluderDepth[y * width];
+		float* row = &depthBuffer[y * width];
+		for (int x = startX & ~3; x <= endX; x += 4) {
+			__m128 covered = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(maskRow + x)), fullMask));
+			__m128 old = _mm_loadu_ps(row + x);
+			__m128 closer = _mm_min_ps(old, _mm_loadu_ps(occluderRow + x));
+			_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(covered, closer), _mm_andnot_ps(covered, old)));
+			_mm_storeu_si128((__m128i*)(maskRow + x), _mm_setzero_si128());
+			_mm_storeu_ps(occluderRow + x, _mm_setzero_ps());
+		}
+	}
+}
+
+bool OcclusionCuller::IsVisible(const AABB& worldBounds)
+{
+	XMMATRIX viewProj = XMLoadFloat4x4(&viewProjection);
+	float minX = FLT_MAX, minY = FLT_MAX, minZ = FLT_MAX;
+	float maxX = -FLT_MAX, maxY = -FLT_MAX;
+	for (int corner = 0; corner < 8; corner++) {
+		XMVECTOR position = XMVectorSet(
+			worldBounds.Center.x + ((corner & 1) ? worldBounds.Extents.x : -worldBounds.Extents.x),
+			worldBounds.Center.y + ((corner & 2) ? worldBounds.Extents.y : -worldBounds.Extents.y),
+			worldBounds.Center.z + ((corner & 4) ? worldBounds.Extents.z : -worldBounds.Extents.z),
+			1.0f);
+		XMFLOAT4 clip;
+		XMStoreFloat4(&clip, XMVector4Transform(position, viewProj));
+		if (clip.z < 0 || clip.w <= 0) {
+			return true; //straddles the near plane, so it's right in front of the camera
+		}
+		float invW = 1.0f / clip.w;
+		minX = fminf(minX, clip.x * invW);
+		maxX = fmaxf(maxX, clip.x * invW);
+		minY = fminf(minY, clip.y * invW);
+		maxY = fmaxf(maxY, clip.y * invW);
+		minZ = fminf(minZ, clip.z * invW);
+	}
+
+	// Conservative pixel rectangle, widened out to whole 4-pixel columns
+	int x0 = (int)floorf((minX * 0.5f + 0.5f) * width);
+	int x1 = (int)ceilf((maxX * 0.5f + 0.5f) * width);
+	int y0 = (int)floorf((0.5f - maxY * 0.5f) * height);
+	int y1 = (int)ceilf((0.5f - minY * 0.5f) * height);
+	if (x1 < 0 || y1 < 0 || x0 >= (int)width || y0 >= (int)height) {
+		return true; //off screen entirely, that's the frustum culler's call to make
+	}
+	x0 = (x0 < 0 ? 0 : x0) & ~3;
+	x1 = x1 >= (int)width ? width - 1 : x1;
+	y0 = y0 < 0 ? 0 : y0;
+	y1 = y1 >= (int)height ? height - 1 : y1;
+
+	// Hidden only if every pixel in the rectangle holds an occluder closer than the box's nearest point
+	__m128 boxDepth = _mm_set1_ps(minZ);
+	for (int y = y0; y <= y1; y++) {
+		const float* row = &depthBuffer[y * width];
+		for (int x = x0; x <= x1; x += 4) {
+			if (_mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(row + x), boxDepth))) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void OcclusionCuller::Cull(const std::vector<AABB>& worldBounds, const std::vector<unsigned int>& candidates, std::vector<unsigned int>& visible)
+{
+	PROFILE_FUNCTION();
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	unsigned int count = (unsigned int)candidates.size();
+	candidateVisible.resize(count);
+	// Bundled so the lambda has two captures, few enough for std::function to hold without allocating
+	struct { const AABB* Bounds; const unsigned int* Candidates; } input = { worldBounds.data(), candidates.data() };
+	std::function<void(unsigned int, unsigned int)> test = [this, &input](unsigned int first, unsigned int last) {
+		for (unsigned int i = first; i < last; i++) {
+			candidateVisible[i] = IsVisible(input.Bounds[input.Candidates[i]]) ? 1 : 0;
+		}
+	};
+	if (jobs) {
+		jobs->ParallelFor(count, 512, test);
+	}
+	else {
+		test(0, count);
+	}
+	visible.clear();
+	for (unsigned int i = 0; i < count; i++) {
+		if (candidateVisible[i]) {
+			visible.push_back(candidates[i]);
+		}
+	}
+
+	std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+	stats.Tested = (unsigned int)candidates.size();
+	stats.Occluded = stats.Tested - (unsigned int)visible.size();
+	stats.TestMicroseconds = std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+float OcclusionCuller::GetDepth(unsigned int x, unsigned int y)
+{
+	return depthBuffer[y * width + x];
+}
+
+unsigned int OcclusionCuller::GetWidth()
+{
+	return width;
+}
+
+unsigned int OcclusionCuller::GetHeight()
+{
+	return height;
+}
+
+const OcclusionStats& OcclusionCuller::GetStats()
+{
+	return stats;
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <DirectXMath.h>
+#include <stdint.h>
+#include <vector>
+#include "Bounds.h"
+#include "JobSystem.h"
+
+// --------------------------------------------------------
+// Counters from the most recent frame of occlusion culling
+// --------------------------------------------------------
+struct OcclusionStats
+{
+	unsigned int OccluderTriangles;	// Triangles binned after near-plane clipping and backface culling
+	unsigned int Tested;
+	unsigned int Occluded;
+	double RasterizeMicroseconds;
+	double TestMicroseconds;
+};
+
+// --------------------------------------------------------
+// A software occlusion culler.
+//
+// Occluder triangles are rasterized into a small CPU depth
+// buffer (four pixels at a time with SSE), and then the
+// screen-space rectangle of each entity's bounds is tested
+// against it.  Coverage is masked: each occluder's
+// triangles OR their samples (a 4x4 grid per pixel, corners
+// included) into a per-pixel mask with a top-left fill
+// rule, so the edges a mesh's triangles share are covered
+// exactly once.  When the occluder is done, only pixels
+// whose masks are full are written, with the farthest depth
+// any of its triangles has inside them, so an entity is
+// never hidden by more than the occluders hold.  The depth
+// buffer is split into horizontal bands that are rasterized as separate jobs; each band
+// owns its rows, and depth is resolved with min(), so the
+// result is identical no matter how the jobs interleave.
+// The bounds tests only read, so they're split up too.
+//
+// Depth is D3D-style z/w, cleared to 1 (far).  Nothing here
+// touches the device, so it can run and be tested headless.
+// --------------------------------------------------------
+class OcclusionCuller
+{
+private:
+	struct ScreenTriangle
+	{
+		float x[3];
+		float y[3];
+		float z[3];
+		float minX;
+		float maxX;
+		float minY;
+		float maxY;
+	};
+
+	unsigned int width;		// Always a multiple of 4
+	unsigned int height;
+	unsigned int bandCount;
+	bool cullBackFaces;
+	JobSystem* jobs;
+	std::vector<float> depthBuffer;
+	std::vector<uint32_t> coverageMasks;	// Per pixel, the samples the current occluder covers
+	std::vector<float> occluderDepth;		// Per pixel, the farthest depth the current occluder has there
+	std::vector<ScreenTriangle> triangles;
+	std::vector<unsigned int> occluderStarts;	// Index of each occluder's first triangle
+	std::vector<uint8_t> candidateVisible;	// Cull's per-candidate results, before they're compacted in order
+	DirectX::XMFLOAT4X4 viewProjection;
+	OcclusionStats stats;
+
+	void BinTriangle(DirectX::XMFLOAT4 a, DirectX::XMFLOAT4 b, DirectX::XMFLOAT4 c);
+	void RasterizeBand(unsigned int firstRow, unsigned int lastRow);
+	void RasterizeTriangle(const ScreenTriangle& tri, int startY, int endY);
+	void ResolveOccluder(int startX, int endX, int startY, int endY);
+public:
+	OcclusionCuller(unsigned int width = 256, unsigned int height = 128, unsigned int bandCount = 4);
+	void SetCullBackFaces(bool cull); //matches the default D3D rasterizer state (clockwise front faces) when true
+	void SetJobSystem(JobSystem* jobs); //null rasterizes and tests everything on the calling thread
+	void BeginFrame(DirectX::XMFLOAT4X4 view, DirectX::XMFLOAT4X4 projection);
+	void AddOccluder(const DirectX::XMFLOAT3* positions, const unsigned int* indices, unsigned int indexCount, DirectX::XMFLOAT4X4 world);
+	void RasterizeOccluders();
+	bool IsVisible(const AABB& worldBounds);
+	//keeps the candidates whose bounds are not hidden behind the occluders, preserving their order
+	void Cull(const std::vector<AABB>& worldBounds, const std::vector<unsigned int>& candidates, std::vector<unsigned int>& visible);
+	float GetDepth(unsigned int x, unsigned int y);
+	unsigned int GetWidth();
+	unsigned int GetHeight();
+	const OcclusionStats& GetStats();
+};
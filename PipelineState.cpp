@@ -0,0 +1,110 @@
+#include <string.h>
+#include "PipelineState.h"
+
+PipelineStateDesc::PipelineStateDesc()
+{
+	StencilRef = 0;
+
+	// The same values D3D11 uses when no state object is bound
+	memset(&Blend, 0, sizeof(Blend));
+	for (int i = 0; i < 8; i++) {
+		Blend.RenderTarget[i].SrcBlend = D3D11_BLEND_ONE;
+		Blend.RenderTarget[i].DestBlend = D3D11_BLEND_ZERO;
+		Blend.RenderTarget[i].BlendOp = D3D11_BLEND_OP_ADD;
+		Blend.RenderTarget[i].SrcBlendAlpha = D3D11_BLEND_ONE;
+		Blend.RenderTarget[i].DestBlendAlpha = D3D11_BLEND_ZERO;
+		Blend.RenderTarget[i].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+		Blend.RenderTarget[i].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+	}
+
+	memset(&Rasterizer, 0, sizeof(Rasterizer));
+	Rasterizer.FillMode = D3D11_FILL_SOLID;
+	Rasterizer.CullMode = D3D11_CULL_BACK;
+	Rasterizer.DepthClipEnable = true;
+
+	memset(&DepthStencil, 0, sizeof(DepthStencil));
+	DepthStencil.DepthEnable = true;
+	DepthStencil.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
+	DepthStencil.DepthFunc = D3D11_COMPARISON_LESS;
+	DepthStencil.StencilReadMask = 0xff;
+	DepthStencil.StencilWriteMask = 0xff;
+	D3D11_DEPTH_STENCILOP_DESC stencilOp = { D3D11_STENCIL_OP_KEEP, D3D11_STENCIL_OP_KEEP, D3D11_STENCIL_OP_KEEP, D3D11_COMPARISON_ALWAYS };
+	DepthStencil.FrontFace = stencilOp;
+	DepthStencil.BackFace = stencilOp;
+}
+
+PipelineState::PipelineState(std::shared_ptr<SimpleVertexShader> vertexShader, std::shared_ptr<SimplePixelShader> pixelShader,
+	Microsoft::WRL::ComPtr<ID3D11BlendState> blendState, Microsoft::WRL::ComPtr<ID3D11RasterizerState> rasterizerState,
+	Microsoft::WRL::ComPtr<ID3D11DepthStencilState> depthStencilState, unsigned int stencilRef, uint64_t hash)
+{
+	this->vertexShader = vertexShader;
+	this->pixelShader = pixelShader;
+	this->blendState = blendState;
+	this->rasterizerState = rasterizerState;
+	this->depthStencilState = depthStencilState;
+	this->stencilRef = stencilRef;
+	this->hash = hash;
+
+	handles.VertexShader = vertexShader->GetDirectXShader().Get();
+	handles.InputLayout = vertexShader->GetInputLayout().Get();
+	handles.PixelShader = pixelShader->GetDirectXShader().Get();
+	handles.BlendState = blendState.Get();
+	handles.RasterizerState = rasterizerState.Get();
+	handles.DepthStencilState = depthStencilState.Get();
+	handles.StencilRef = stencilRef;
+	handles.Padding = 0;
+}
+
+std::shared_ptr<SimpleVertexShader> PipelineState::GetVertexShader() const
+{
+	return vertexShader;
+}
+
+std::shared_ptr<SimplePixelShader> PipelineState::GetPixelShader() const
+{
+	return pixelShader;
+}
+
+ID3D11BlendState* PipelineState::GetBlendState() const
+{
+	return blendState.Get();
+}
+
+ID3D11RasterizerState* PipelineState::GetRasterizerState() const
+{
+	return rasterizerState.Get();
+}
+
+ID3D11DepthStencilState* PipelineState::GetDepthStencilState() const
+{
+	return depthStencilState.Get();
+}
+
+unsigned int PipelineState::GetStencilRef() const
+{
+	return stencilRef;
+}
+
+uint64_t PipelineState::GetHash() const
+{
+	return hash;
+}
+
+const PipelineHandles& PipelineState::GetHandles() const
+{
+	return handles;
+}
+
+void PipelineState::Record(CommandBuffer& commands) const
+{
+	commands.SetPipelineState(handles);
+}
+
+void PipelineState::Bind(ID3D11DeviceContext* context) const
+{
+	vertexShader->SetShader();
+	pixelShader->SetShader();
+	context->OMSetBlendState(blendState.Get(), 0, 0xffffffff);
+	context->RSSetState(rasterizerState.Get());
+	context->OMSetDepthStencilState(depthStencilState.Get(), stencilRef);
+}
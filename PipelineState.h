@@ -0,0 +1,62 @@
+#pragma once
+#include <d3d11.h>
+#include <stdint.h>
+#include <wrl/client.h>
+#include <memory>
+#include "CommandBuffer.h"
+#include "SimpleShader.h"
+
+// --------------------------------------------------------
+// Everything a PipelineState is made from.  Starts out with
+// D3D11's default fixed-function states, so only what
+// differs from them needs filling in.
+// --------------------------------------------------------
+struct PipelineStateDesc
+{
+	std::shared_ptr<SimpleVertexShader> VertexShader;
+	std::shared_ptr<SimplePixelShader> PixelShader;
+	D3D11_BLEND_DESC Blend;
+	D3D11_RASTERIZER_DESC Rasterizer;
+	D3D11_DEPTH_STENCIL_DESC DepthStencil;
+	unsigned int StencilRef;
+
+	PipelineStateDesc();
+};
+
+// --------------------------------------------------------
+// Shaders, input layout and fixed-function states bundled
+// into one immutable object.  They only come from a
+// PipelineStateCache, which hands out the same object for
+// the same description, so two pipelines are the same if
+// and only if their pointers are.
+// --------------------------------------------------------
+class PipelineState
+{
+private:
+	std::shared_ptr<SimpleVertexShader> vertexShader;
+	std::shared_ptr<SimplePixelShader> pixelShader;
+	Microsoft::WRL::ComPtr<ID3D11BlendState> blendState;
+	Microsoft::WRL::ComPtr<ID3D11RasterizerState> rasterizerState;
+	Microsoft::WRL::ComPtr<ID3D11DepthStencilState> depthStencilState;
+	unsigned int stencilRef;
+	uint64_t hash;
+	PipelineHandles handles; //what Record puts in the command
+public:
+	PipelineState(std::shared_ptr<SimpleVertexShader> vertexShader, std::shared_ptr<SimplePixelShader> pixelShader,
+		Microsoft::WRL::ComPtr<ID3D11BlendState> blendState, Microsoft::WRL::ComPtr<ID3D11RasterizerState> rasterizerState,
+		Microsoft::WRL::ComPtr<ID3D11DepthStencilState> depthStencilState, unsigned int stencilRef, uint64_t hash);
+
+	std::shared_ptr<SimpleVertexShader> GetVertexShader() const;
+	std::shared_ptr<SimplePixelShader> GetPixelShader() const;
+	ID3D11BlendState* GetBlendState() const;
+	ID3D11RasterizerState* GetRasterizerState() const;
+	ID3D11DepthStencilState* GetDepthStencilState() const;
+	unsigned int GetStencilRef() const;
+	uint64_t GetHash() const;
+	const PipelineHandles& GetHandles() const;
+
+	//records binding the shaders, input layout and all three states, as a single command
+	void Record(CommandBuffer& commands) const;
+	//binds the same on the context right away, for code that draws without a command buffer; the shaders' constant buffers are bound too
+	void Bind(ID3D11DeviceContext* context) const;
+};
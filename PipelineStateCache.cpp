@@ -0,0 +1,241 @@
+#include <stdio.h>
+#include <string.h>
+#include "PipelineStateCache.h"
+
+#define FNV_OFFSET_BASIS 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+static void AddField(StateKey& key, uint32_t value)
+{
+	key.Fields.push_back(value);
+	for (int b = 0; b < 4; b++) {
+		key.Hash ^= (value >> (b * 8)) & 0xFF;
+		key.Hash *= FNV_PRIME;
+	}
+}
+
+static void AddField(StateKey& key, float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	AddField(key, bits);
+}
+
+static void AddField(StateKey& key, const void* pointer)
+{
+	uint64_t bits = (uint64_t)(uintptr_t)pointer;
+	AddField(key, (uint32_t)bits);
+	AddField(key, (uint32_t)(bits >> 32));
+}
+
+static StateKey StartKey(uint32_t kind)
+{
+	StateKey key;
+	key.Hash = FNV_OFFSET_BASIS;
+	AddField(key, kind); //so different kinds of state never hash alike
+	return key;
+}
+
+bool StateKey::operator==(const StateKey& other) const
+{
+	return Hash == other.Hash && Fields == other.Fields;
+}
+
+StateKey PipelineStateCache::MakeKey(const D3D11_BLEND_DESC& desc)
+{
+	StateKey key = StartKey(0);
+	AddField(key, (uint32_t)desc.AlphaToCoverageEnable);
+	AddField(key, (uint32_t)desc.IndependentBlendEnable);
+	int targets = desc.IndependentBlendEnable ? 8 : 1; //the rest are ignored otherwise
+	for (int i = 0; i < targets; i++) {
+		const D3D11_RENDER_TARGET_BLEND_DESC& target = desc.RenderTarget[i];
+		AddField(key, (uint32_t)target.BlendEnable);
+		AddField(key, (uint32_t)target.SrcBlend);
+		AddField(key, (uint32_t)target.DestBlend);
+		AddField(key, (uint32_t)target.BlendOp);
+		AddField(key, (uint32_t)target.SrcBlendAlpha);
+		AddField(key, (uint32_t)target.DestBlendAlpha);
+		AddField(key, (uint32_t)target.BlendOpAlpha);
+		AddField(key, (uint32_t)target.RenderTargetWriteMask);
+	}
+	return key;
+}
+
+StateKey PipelineStateCache::MakeKey(const D3D11_RASTERIZER_DESC& desc)
+{
+	StateKey key = StartKey(1);
+	AddField(key, (uint32_t)desc.FillMode);
+	AddField(key, (uint32_t)desc.CullMode);
+	AddField(key, (uint32_t)desc.FrontCounterClockwise);
+	AddField(key, (uint32_t)desc.DepthBias);
+	AddField(key, desc.DepthBiasClamp);
+	AddField(key, desc.SlopeScaledDepthBias);
+	AddField(key, (uint32_t)desc.DepthClipEnable);
+	AddField(key, (uint32_t)desc.ScissorEnable);
+	AddField(key, (uint32_t)desc.MultisampleEnable);
+	AddField(key, (uint32_t)desc.AntialiasedLineEnable);
+	return key;
+}
+
+StateKey PipelineStateCache::MakeKey(const D3D11_DEPTH_STENCIL_DESC& desc)
+{
+	StateKey key = StartKey(2);
+	AddField(key, (uint32_t)desc.DepthEnable);
+	AddField(key, (uint32_t)desc.DepthWriteMask);
+	AddField(key, (uint32_t)desc.DepthFunc);
+	AddField(key, (uint32_t)desc.StencilEnable);
+	AddField(key, (uint32_t)desc.StencilReadMask);
+	AddField(key, (uint32_t)desc.StencilWriteMask);
+	const D3D11_DEPTH_STENCILOP_DESC* faces[2] = { &desc.FrontFace, &desc.BackFace };
+	for (int f = 0; f < 2; f++) {
+		AddField(key, (uint32_t)faces[f]->StencilFailOp);
+		AddField(key, (uint32_t)faces[f]->StencilDepthFailOp);
+		AddField(key, (uint32_t)faces[f]->StencilPassOp);
+		AddField(key, (uint32_t)faces[f]->StencilFunc);
+	}
+	return key;
+}
+
+StateKey PipelineStateCache::MakeKey(const D3D11_SAMPLER_DESC& desc)
+{
+	StateKey key = StartKey(3);
+	AddField(key, (uint32_t)desc.Filter);
+	AddField(key, (uint32_t)desc.AddressU);
+	AddField(key, (uint32_t)desc.AddressV);
+	AddField(key, (uint32_t)desc.AddressW);
+	AddField(key, desc.MipLODBias);
+	AddField(key, (uint32_t)desc.MaxAnisotropy);
+	AddField(key, (uint32_t)desc.ComparisonFunc);
+	for (int i = 0; i < 4; i++) {
+		AddField(key, desc.BorderColor[i]);
+	}
+	AddField(key, desc.MinLOD);
+	AddField(key, desc.MaxLOD);
+	return key;
+}
+
+PipelineStateCache::PipelineStateCache(Microsoft::WRL::ComPtr<ID3D11Device> device)
+{
+	this->device = device;
+	memset(&stats, 0, sizeof(stats));
+}
+
+Microsoft::WRL::ComPtr<ID3D11BlendState> PipelineStateCache::GetBlendState(const D3D11_BLEND_DESC& desc)
+{
+	stats.Requests++;
+	StateKey key = MakeKey(desc);
+	auto found = blendStates.find(key);
+	if (found != blendStates.end()) {
+		stats.Hits++;
+		return found->second;
+	}
+	Microsoft::WRL::ComPtr<ID3D11BlendState> state;
+	if (FAILED(device->CreateBlendState(&desc, state.GetAddressOf()))) {
+		printf("Pipeline state cache: couldn't create a blend state\n");
+		return nullptr;
+	}
+	blendStates[key] = state;
+	stats.Created++;
+	return state;
+}
+
+Microsoft::WRL::ComPtr<ID3D11RasterizerState> PipelineStateCache::GetRasterizerState(const D3D11_RASTERIZER_DESC& desc)
+{
+	stats.Requests++;
+	StateKey key = MakeKey(desc);
+	auto found = rasterizerStates.find(key);
+	if (found != rasterizerStates.end()) {
+		stats.Hits++;
+		return found->second;
+	}
+	Microsoft::WRL::ComPtr<ID3D11RasterizerState> state;
+	if (FAILED(device->CreateRasterizerState(&desc, state.GetAddressOf()))) {
+		printf("Pipeline state cache: couldn't create a rasterizer state\n");
+		return nullptr;
+	}
+	rasterizerStates[key] = state;
+	stats.Created++;
+	return state;
+}
+
+Microsoft::WRL::ComPtr<ID3D11DepthStencilState> PipelineStateCache::GetDepthStencilState(const D3D11_DEPTH_STENCIL_DESC& desc)
+{
+	stats.Requests++;
+	StateKey key = MakeKey(desc);
+	auto found = depthStencilStates.find(key);
+	if (found != depthStencilStates.end()) {
+		stats.Hits++;
+		return found->second;
+	}
+	Microsoft::WRL::ComPtr<ID3D11DepthStencilState> state;
+	if (FAILED(device->CreateDepthStencilState(&desc, state.GetAddressOf()))) {
+		printf("Pipeline state cache: couldn't create a depth-stencil state\n");
+		return nullptr;
+	}
+	depthStencilStates[key] = state;
+	stats.Created++;
+	return state;
+}
+
+Microsoft::WRL::ComPtr<ID3D11SamplerState> PipelineStateCache::GetSamplerState(const D3D11_SAMPLER_DESC& desc)
+{
+	stats.Requests++;
+	StateKey key = MakeKey(desc);
+	auto found = samplerStates.find(key);
+	if (found != samplerStates.end()) {
+		stats.Hits++;
+		return found->second;
+	}
+	Microsoft::WRL::ComPtr<ID3D11SamplerState> state;
+	if (FAILED(device->CreateSamplerState(&desc, state.GetAddressOf()))) {
+		printf("Pipeline state cache: couldn't create a sampler state\n");
+		return nullptr;
+	}
+	samplerStates[key] = state;
+	stats.Created++;
+	return state;
+}
+
+// --------------------------------------------------------
+// The fixed-function states come from the cache first, so
+// a pipeline's key is just the identity of its parts: the
+// shaders and the three (already shared) state objects.
+// --------------------------------------------------------
+std::shared_ptr<PipelineState> PipelineStateCache::GetPipelineState(const PipelineStateDesc& desc)
+{
+	Microsoft::WRL::ComPtr<ID3D11BlendState> blendState = GetBlendState(desc.Blend);
+	Microsoft::WRL::ComPtr<ID3D11RasterizerState> rasterizerState = GetRasterizerState(desc.Rasterizer);
+	Microsoft::WRL::ComPtr<ID3D11DepthStencilState> depthStencilState = GetDepthStencilState(desc.DepthStencil);
+	if (!desc.VertexShader || !desc.PixelShader || !blendState || !rasterizerState || !depthStencilState) {
+		return nullptr;
+	}
+
+	stats.Requests++;
+	StateKey key = StartKey(4);
+	AddField(key, desc.VertexShader.get());
+	AddField(key, desc.PixelShader.get());
+	AddField(key, blendState.Get());
+	AddField(key, rasterizerState.Get());
+	AddField(key, depthStencilState.Get());
+	AddField(key, (uint32_t)desc.StencilRef);
+	auto found = pipelineStates.find(key);
+	if (found != pipelineStates.end()) {
+		stats.Hits++;
+		return found->second;
+	}
+	std::shared_ptr<PipelineState> pipeline = std::make_shared<PipelineState>(desc.VertexShader, desc.PixelShader,
+		blendState, rasterizerState, depthStencilState, desc.StencilRef, key.Hash);
+	pipelineStates[key] = pipeline;
+	stats.Created++;
+	return pipeline;
+}
+
+const PipelineStateCacheStats& PipelineStateCache::GetStats() const
+{
+	return stats;
+}
+
+float PipelineStateCache::GetHitRate() const
+{
+	return stats.Requests > 0 ? (float)stats.Hits / stats.Requests : 0.0f;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <d3d11.h>
+#include <stdint.h>
+#include <wrl/client.h>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "PipelineState.h"
+
+// --------------------------------------------------------
+// A state description flattened into the fields D3D11
+// actually looks at, one per uint32, and an FNV-1a hash of
+// them.  Padding never gets in, and neither do render
+// targets 1-7 of a blend state that doesn't use them, so
+// descriptions D3D11 would treat the same get equal keys.
+// --------------------------------------------------------
+struct StateKey
+{
+	std::vector<uint32_t> Fields;
+	uint64_t Hash;
+
+	bool operator==(const StateKey& other) const;
+};
+
+struct StateKeyHasher
+{
+	size_t operator()(const StateKey& key) const { return (size_t)key.Hash; }
+};
+
+struct PipelineStateCacheStats
+{
+	unsigned int Requests;	// Every Get call
+	unsigned int Hits;		// Requests answered with an object made earlier
+	unsigned int Created;	// State and pipeline objects actually made
+};
+
+// --------------------------------------------------------
+// Makes each distinct state object once.  Every blend,
+// rasterizer, depth-stencil and sampler state and every
+// pipeline should come from the game's one cache, so that
+// identical descriptions anywhere share one object and
+// comparing two of them is comparing pointers.
+//
+// Not thread safe, everything is meant to be made while
+// loading.  Null if the device turns a description down.
+// --------------------------------------------------------
+class PipelineStateCache
+{
+private:
+	Microsoft::WRL::ComPtr<ID3D11Device> device;
+	PipelineStateCacheStats stats;
+	std::unordered_map<StateKey, Microsoft::WRL::ComPtr<ID3D11BlendState>, StateKeyHasher> blendStates;
+	std::unordered_map<StateKey, Microsoft::WRL::ComPtr<ID3D11RasterizerState>, StateKeyHasher> rasterizerStates;
+	std::unordered_map<StateKey, Microsoft::WRL::ComPtr<ID3D11DepthStencilState>, StateKeyHasher> depthStencilStates;
+	std::unordered_map<StateKey, Microsoft::WRL::ComPtr<ID3D11SamplerState>, StateKeyHasher> samplerStates;
+	std::unordered_map<StateKey, std::shared_ptr<PipelineState>, StateKeyHasher> pipelineStates;
+public:
+	PipelineStateCache(Microsoft::WRL::ComPtr<ID3D11Device> device);
+
+	Microsoft::WRL::ComPtr<ID3D11BlendState> GetBlendState(const D3D11_BLEND_DESC& desc);
+	Microsoft::WRL::ComPtr<ID3D11RasterizerState> GetRasterizerState(const D3D11_RASTERIZER_DESC& desc);
+	Microsoft::WRL::ComPtr<ID3D11DepthStencilState> GetDepthStencilState(const D3D11_DEPTH_STENCIL_DESC& desc);
+	Microsoft::WRL::ComPtr<ID3D11SamplerState> GetSamplerState(const D3D11_SAMPLER_DESC& desc);
+	std::shared_ptr<PipelineState> GetPipelineState(const PipelineStateDesc& desc);
+
+	static StateKey MakeKey(const D3D11_BLEND_DESC& desc);
+	static StateKey MakeKey(const D3D11_RASTERIZER_DESC& desc);
+	static StateKey MakeKey(const D3D11_DEPTH_STENCIL_DESC& desc);
+	static StateKey MakeKey(const D3D11_SAMPLER_DESC& desc);
+
+	const PipelineStateCacheStats& GetStats() const;
+	float GetHitRate() const; //0-1, 0 before any requests
+};
@@ -0,0 +1,343 @@
+#include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "Profiler.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define PROFILER_USE_TSC
+#endif
+
+// How long the tick rate is measured over, at the least
+#define PROFILER_MIN_CALIBRATION_NS 10000000ULL
+
+// --------------------------------------------------------
+// A thread's ring.  Only the owner writes; the fields are
+// atomics so readers on other threads can copy them while
+// it does.  Release stores and acquire loads are plain
+// moves on x86/x64, and a reader that sees a rewritten
+// slot is then sure to see the head that gives it away.
+// --------------------------------------------------------
+struct ProfilerSlot
+{
+	std::atomic<const char*> Name;
+	std::atomic<uint64_t> Start;
+	std::atomic<uint64_t> End;
+	std::atomic<uint32_t> Depth;
+};
+
+struct ProfilerThread
+{
+	ProfilerSlot Slots[PROFILER_RING_SIZE];
+	std::atomic<uint64_t> Head;		// Events ever written, the next goes to Head % PROFILER_RING_SIZE
+	uint32_t Index;
+	std::string Name;
+};
+
+// Rings outlive their threads, so events from finished threads can still be read
+static std::mutex threadsMutex;
+static std::vector<std::unique_ptr<ProfilerThread>> threads;
+
+static thread_local ProfilerThread* currentThread = nullptr;
+static thread_local uint32_t currentDepth = 0;
+
+static uint64_t frameStarts[PROFILER_FRAME_HISTORY];	// In ticks
+static std::atomic<uint64_t> frameCount(0);
+
+static ProfilerThread* GetThread()
+{
+	if (!currentThread) {
+		std::unique_ptr<ProfilerThread> thread(new ProfilerThread());
+		thread->Head.store(0);
+		std::lock_guard<std::mutex> lock(threadsMutex);
+		thread->Index = (uint32_t)threads.size();
+		thread->Name = "Thread " + std::to_string(thread->Index);
+		currentThread = thread.get();
+		threads.push_back(std::move(thread));
+	}
+	return currentThread;
+}
+
+uint64_t Profiler::Now()
+{
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+}
+
+uint64_t Profiler::GetTicks()
+{
+#ifdef PROFILER_USE_TSC
+	return __rdtsc();
+#else
+	return Now();
+#endif
+}
+
+// Both clocks read together once, at startup, to line ticks up with Now()
+static const uint64_t calibrationTicks = Profiler::GetTicks();
+static const uint64_t calibrationNs = Profiler::Now();
+
+// --------------------------------------------------------
+// The tick rate, measured against the clock over however
+// long the program has run so far, which gets it right to
+// well under a part per million after a few seconds.
+// --------------------------------------------------------
+static double GetNsPerTick()
+{
+#ifdef PROFILER_USE_TSC
+	uint64_t elapsedNs = Profiler::Now() - calibrationNs;
+	if (elapsedNs < PROFILER_MIN_CALIBRATION_NS) {
+		std::this_thread::sleep_for(std::chrono::nanoseconds(PROFILER_MIN_CALIBRATION_NS - elapsedNs));
+	}
+	uint64_t ticks = Profiler::GetTicks();
+	elapsedNs = Profiler::Now() - calibrationNs;
+	return ticks > calibrationTicks ? (double)elapsedNs / (ticks - calibrationTicks) : 1.0;
+#else
+	return 1.0;
+#endif
+}
+
+uint64_t Profiler::TicksToNs(uint64_t ticks)
+{
+	return calibrationNs + (uint64_t)((double)(int64_t)(ticks - calibrationTicks) * GetNsPerTick());
+}
+
+void Profiler::Record(const char* name, uint64_t start, uint64_t end, uint32_t depth)
+{
+	ProfilerThread* thread = GetThread();
+	uint64_t head = thread->Head.load(std::memory_order_relaxed);
+	ProfilerSlot& slot = thread->Slots[head % PROFILER_RING_SIZE];
+	slot.Name.store(name, std::memory_order_release);
+	slot.Start.store(start, std::memory_order_release);
+	slot.End.store(end, std::memory_order_release);
+	slot.Depth.store(depth, std::memory_order_release);
+	thread->Head.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::SetThreadName(const char* name)
+{
+	ProfilerThread* thread = GetThread();
+	std::lock_guard<std::mutex> lock(threadsMutex);
+	thread->Name = name;
+}
+
+void Profiler::BeginFrame()
+{
+	uint64_t frame = frameCount.load(std::memory_order_relaxed);
+	frameStarts[frame % PROFILER_FRAME_HISTORY] = GetTicks();
+	frameCount.store(frame + 1, std::memory_order_release);
+}
+
+uint64_t Profiler::GetFrameCount()
+{
+	return frameCount.load(std::memory_order_acquire);
+}
+
+// --------------------------------------------------------
+// Copies each ring, then checks how far its owner got in
+// the meantime: any slot it could have reached again was
+// possibly half rewritten during the copy, so it's dropped.
+// --------------------------------------------------------
+void Profiler::GetEvents(std::vector<ProfileEvent>& events)
+{
+	events.clear();
+	double nsPerTick = GetNsPerTick();
+	std::lock_guard<std::mutex> lock(threadsMutex);
+	for (size_t t = 0; t < threads.size(); t++) {
+		ProfilerThread& thread = *threads[t];
+		uint64_t head = thread.Head.load(std::memory_order_acquire);
+		uint64_t first = head > PROFILER_RING_SIZE ? head - PROFILER_RING_SIZE : 0;
+		size_t copied = events.size();
+		for (uint64_t i = first; i < head; i++) {
+			const ProfilerSlot& slot = thread.Slots[i % PROFILER_RING_SIZE];
+			ProfileEvent event;
+			event.Name = slot.Name.load(std::memory_order_acquire);
+			event.Start = slot.Start.load(std::memory_order_acquire);
+			event.End = slot.End.load(std::memory_order_acquire);
+			event.Start = calibrationNs + (uint64_t)((double)(int64_t)(event.Start - calibrationTicks) * nsPerTick);
+			event.End = calibrationNs + (uint64_t)((double)(int64_t)(event.End - calibrationTicks) * nsPerTick);
+			event.Depth = slot.Depth.load(std::memory_order_acquire);
+			event.Thread = thread.Index;
+			events.push_back(event);
+		}
+
+		uint64_t newHead = thread.Head.load(std::memory_order_acquire);
+		uint64_t overwritten = newHead + 1 > PROFILER_RING_SIZE ? newHead + 1 - PROFILER_RING_SIZE : 0; //+1 for the slot being written now
+		if (overwritten > first) {
+			size_t drop = (size_t)(overwritten - first < head - first ? overwritten - first : head - first);
+			events.erase(events.begin() + copied, events.begin() + copied + drop);
+		}
+	}
+	std::sort(events.begin(), events.end(), [](const ProfileEvent& a, const ProfileEvent& b) {
+		return a.Start != b.Start ? a.Start < b.Start : a.Depth < b.Depth;
+	});
+}
+
+// --------------------------------------------------------
+// Scopes are recorded as they close, so children come
+// before their parents in the rings; sorted by start time
+// every parent comes first again, and the scope open one
+// level up on the same thread is always the parent.
+// --------------------------------------------------------
+bool Profiler::GetFrameTree(std::vector<ProfileNode>& nodes)
+{
+	nodes.clear();
+	uint64_t frames = GetFrameCount();
+	if (frames < 2) {
+		return false;
+	}
+	uint64_t frameStart = TicksToNs(frameStarts[(frames - 2) % PROFILER_FRAME_HISTORY]);
+	uint64_t frameEnd = TicksToNs(frameStarts[(frames - 1) % PROFILER_FRAME_HISTORY]);
+
+	std::vector<ProfileEvent> events;
+	GetEvents(events);
+
+	std::vector<std::vector<int>> openNodes; //per thread, the node of the scope open at each depth
+	for (size_t e = 0; e < events.size(); e++) {
+		const ProfileEvent& event = events[e];
+		if (event.Start < frameStart || event.Start >= frameEnd) {
+			continue;
+		}
+		if (event.Thread >= openNodes.size()) {
+			openNodes.resize(event.Thread + 1);
+		}
+		std::vector<int>& open = openNodes[event.Thread];
+		if (event.Depth > open.size()) {
+			continue; //its parent opened before the frame did
+		}
+		open.resize(event.Depth);
+		int parent = event.Depth > 0 ? open[event.Depth - 1] : -1;
+
+		int node = -1;
+		for (size_t n = 0; n < nodes.size(); n++) {
+			if (nodes[n].Parent == parent && nodes[n].Thread == event.Thread && nodes[n].Name == event.Name) {
+				node = (int)n;
+				break;
+			}
+		}
+		if (node < 0) {
+			ProfileNode added = { event.Name, parent, event.Depth, event.Thread, 0, 0 };
+			nodes.push_back(added);
+			node = (int)nodes.size() - 1;
+		}
+		nodes[node].Calls++;
+		nodes[node].TotalNs += event.End - event.Start;
+		open.push_back(node);
+	}
+	return true;
+}
+
+static void PrintNodeChildren(const std::vector<ProfileNode>& nodes, int parent, uint32_t thread)
+{
+	for (size_t n = 0; n < nodes.size(); n++) {
+		if (nodes[n].Parent != parent || nodes[n].Thread != thread) {
+			continue;
+		}
+		printf("%*s%-*s %9.3f ms %6u calls\n", nodes[n].Depth * 2, "", 48 - nodes[n].Depth * 2, nodes[n].Name,
+			nodes[n].TotalNs / 1000000.0, nodes[n].Calls);
+		PrintNodeChildren(nodes, (int)n, thread);
+	}
+}
+
+void Profiler::PrintFrameTree()
+{
+	std::vector<ProfileNode> nodes;
+	if (!GetFrameTree(nodes)) {
+		printf("Profiler: no complete frame yet\n");
+		return;
+	}
+	uint32_t threadCount = 0;
+	for (size_t n = 0; n < nodes.size(); n++) {
+		threadCount = nodes[n].Thread + 1 > threadCount ? nodes[n].Thread + 1 : threadCount;
+	}
+	printf("Profiler: frame %llu\n", (unsigned long long)(GetFrameCount() - 1));
+	for (uint32_t t = 0; t < threadCount; t++) {
+		std::string name;
+		{
+			std::lock_guard<std::mutex> lock(threadsMutex);
+			name = threads[t]->Name;
+		}
+		printf("-- %s\n", name.c_str());
+		PrintNodeChildren(nodes, -1, t);
+	}
+}
+
+static void WriteJsonString(std::ostream& file, const char* text)
+{
+	file << '"';
+	for (const char* c = text; *c; c++) {
+		if (*c == '"' || *c == '\\') {
+			file << '\\';
+		}
+		if ((unsigned char)*c >= 0x20) {
+			file << *c;
+		}
+	}
+	file << '"';
+}
+
+bool Profiler::ExportChromeTrace(const std::string& path)
+{
+	std::vector<ProfileEvent> events;
+	GetEvents(events);
+
+	std::ofstream file(path, std::ios::trunc);
+	if (!file) {
+		printf("Profiler: couldn't write %s\n", path.c_str());
+		return false;
+	}
+
+	// Timestamps are microseconds; starting from the first event keeps them short
+	uint64_t base = events.empty() ? 0 : events[0].Start;
+	file << std::fixed << std::setprecision(3);
+	file << "{\"traceEvents\":[\n";
+	bool first = true;
+	{
+		std::lock_guard<std::mutex> lock(threadsMutex);
+		for (size_t t = 0; t < threads.size(); t++) {
+			file << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << threads[t]->Index << ",\"args\":{\"name\":";
+			WriteJsonString(file, threads[t]->Name.c_str());
+			file << "}}";
+			first = false;
+		}
+	}
+	for (size_t e = 0; e < events.size(); e++) {
+		file << (first ? "" : ",\n") << "{\"name\":";
+		WriteJsonString(file, events[e].Name);
+		file << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << events[e].Thread
+			<< ",\"ts\":" << (events[e].Start - base) / 1000.0
+			<< ",\"dur\":" << (events[e].End - events[e].Start) / 1000.0 << "}";
+		first = false;
+	}
+	file << "\n],\"displayTimeUnit\":\"ns\"}\n";
+	if (!file) {
+		printf("Profiler: couldn't write %s\n", path.c_str());
+		return false;
+	}
+	printf("Profiler: %u events written to %s\n", (unsigned int)events.size(), path.c_str());
+	return true;
+}
+
+ProfileScope::ProfileScope(const char* name)
+{
+	this->name = name;
+	depth = currentDepth++;
+	start = Profiler::GetTicks();
+}
+
+ProfileScope::~ProfileScope()
+{
+	uint64_t end = Profiler::GetTicks();
+	currentDepth--;
+	Profiler::Record(name, start, end, depth);
+}
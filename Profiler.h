@@ -0,0 +1,103 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Events kept per thread; older ones are overwritten
+#define PROFILER_RING_SIZE 16384
+// Frame start times kept, for finding a frame's events
+#define PROFILER_FRAME_HISTORY 64
+
+// --------------------------------------------------------
+// Scoped instrumentation.  PROFILE_SCOPE("name") times the
+// rest of the enclosing block, PROFILE_FUNCTION() the whole
+// function.  Names must be string literals (or otherwise
+// live forever), only the pointer is stored.
+//
+// Defining PROFILER_DISABLED compiles every scope out.
+// --------------------------------------------------------
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#ifdef PROFILER_DISABLED
+#define PROFILE_SCOPE(name)
+#define PROFILE_FUNCTION()
+#else
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
+#endif
+
+// One closed scope, as copied out of a thread's ring
+struct ProfileEvent
+{
+	const char* Name;
+	uint64_t Start;		// Nanoseconds, same clock for every thread
+	uint64_t End;
+	uint32_t Depth;		// Scopes open on the thread when this one opened
+	uint32_t Thread;	// Index in registration order, the first thread to profile is 0
+};
+
+// Every call of the same scope under the same parent on the same thread, over one frame
+struct ProfileNode
+{
+	const char* Name;
+	int Parent;			// Index into the same list, -1 for a thread's outermost scopes
+	uint32_t Depth;
+	uint32_t Thread;
+	unsigned int Calls;
+	uint64_t TotalNs;
+};
+
+// --------------------------------------------------------
+// A CPU profiler for the whole process.
+//
+// Each thread writes closed scopes into a ring buffer of
+// its own, without locks, so a scope costs two reads of
+// the time stamp counter and a few stores.  Ticks become
+// nanoseconds only when the rings are read, which assumes
+// an invariant TSC, as every x64 CPU from the last decade
+// has.  Readers copy the rings and throw away
+// anything that was overwritten while they copied, so
+// they're safe to call while other threads keep profiling.
+//
+// BeginFrame marks where frames start (call it from one
+// thread, once per frame); GetFrameTree then adds up the
+// last complete frame into a call tree per thread.
+// --------------------------------------------------------
+class Profiler
+{
+public:
+	static uint64_t Now(); //in nanoseconds
+	//the CPU's time stamp counter where there is one, a few ns to read where a clock takes tens
+	static uint64_t GetTicks();
+	static uint64_t TicksToNs(uint64_t ticks); //on the same timeline as Now()
+	//start and end from GetTicks()
+	static void Record(const char* name, uint64_t start, uint64_t end, uint32_t depth);
+	static void SetThreadName(const char* name); //shown in traces and frame trees, copied
+
+	static void BeginFrame();
+	static uint64_t GetFrameCount();
+
+	//everything still in the rings, sorted by start time
+	static void GetEvents(std::vector<ProfileEvent>& events);
+	//false if there's no complete frame yet
+	static bool GetFrameTree(std::vector<ProfileNode>& nodes);
+	static void PrintFrameTree();
+	//everything still in the rings, in Chrome's trace event format (chrome://tracing, Perfetto)
+	static bool ExportChromeTrace(const std::string& path);
+};
+
+// --------------------------------------------------------
+// Times its own lifetime; see PROFILE_SCOPE
+// --------------------------------------------------------
+class ProfileScope
+{
+private:
+	const char* name;
+	uint64_t start;
+	uint32_t depth;
+public:
+	ProfileScope(const char* name);
+	~ProfileScope();
+	ProfileScope(const ProfileScope&) = delete;
+	void operator=(const ProfileScope&) = delete;
+};
@@ -0,0 +1,19 @@
+#pragma once
+#include <DirectXMath.h>
+#include "Mesh.h"
+#include "Material.h"
+
+// --------------------------------------------------------
+// Everything the render queue and the batchers need to know
+// about one thing to draw, copied out of the entity world
+// once per frame.  They hold pointers to these, so whatever
+// array they live in must not change until the frame has
+// been submitted.
+// --------------------------------------------------------
+struct RenderObject
+{
+	Mesh* RenderMesh;
+	Material* RenderMaterial;
+	DirectX::XMFLOAT4X4 World;
+	DirectX::XMFLOAT3 Position;
+};
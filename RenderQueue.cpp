@@ -0,0 +1,257 @@
+#include <string.h>
+#include "RenderQueue.h"
+#include "Profiler.h"
+#include "ShaderConstants.h"
+
+using namespace DirectX;
+
+#define KEY_PASS_SHIFT 60
+#define KEY_TRANSLUCENT_SHIFT 59
+
+// Positive floats sort the same as their bit patterns, so the top bits make a monotonic depth key
+static uint64_t QuantizeDepth(float depth, int bits)
+{
+	if (!(depth > 0.0f)) {
+		return 0; //also catches NaN
+	}
+	uint32_t floatBits;
+	memcpy(&floatBits, &depth, sizeof(float));
+	return floatBits >> (32 - bits);
+}
+
+RenderQueue::RenderQueue()
+{
+	jobs = nullptr;
+	stats = {};
+}
+
+void RenderQueue::SetJobSystem(JobSystem* jobs)
+{
+	this->jobs = jobs;
+}
+
+void RenderQueue::Clear()
+{
+	items.clear();
+	keys.clear();
+	order.clear();
+	stats = {};
+}
+
+unsigned int RenderQueue::GetPipelineId(const PipelineState* pipeline)
+{
+	std::unordered_map<const PipelineState*, unsigned int>::iterator found = pipelineIds.find(pipeline);
+	if (found == pipelineIds.end()) {
+		found = pipelineIds.insert({ pipeline, (unsigned int)pipelineIds.size() }).first;
+	}
+	return found->second & 0x3FF;
+}
+
+void RenderQueue::Add(const RenderObject* object, unsigned int pass, bool translucent, float depth)
+{
+	RenderItem item;
+	item.object = object;
+	item.material = object->RenderMaterial;
+	item.mesh = object->RenderMesh;
+
+	uint64_t pipeline = GetPipelineId(item.material->GetPipelineState().get());
+	uint64_t material = item.material->GetId() & 0xFFF;
+	uint64_t mesh = item.mesh->GetId() & 0xFFF;
+
+	uint64_t key = ((uint64_t)(pass & 0xF) << KEY_PASS_SHIFT) | ((uint64_t)(translucent ? 1 : 0) << KEY_TRANSLUCENT_SHIFT);
+	if (translucent) {
+		uint64_t farToNear = ~QuantizeDepth(depth, 24) & 0xFFFFFF;
+		key |= (farToNear << 35) | (pipeline << 25) | (material << 13) | (mesh << 1);
+	}
+	else {
+		key |= (pipeline << 49) | (material << 37) | (mesh << 25) | QuantizeDepth(depth, 25);
+	}
+
+	items.push_back(item);
+	keys.push_back(key);
+}
+
+void RenderQueue::Sort()
+{
+	PROFILE_FUNCTION();
+	order.resize(items.size());
+	for (uint32_t i = 0; i < order.size(); i++) {
+		order[i] = i;
+	}
+	RadixSort();
+	stats.Items = (unsigned int)items.size();
+}
+
+// --------------------------------------------------------
+// LSD radix sort of (key, item) pairs, one byte per pass.
+// Stable, and any byte that's the same for every key (the
+// pass bits in a single-pass frame, unused id bits, etc.)
+// is skipped entirely.
+// --------------------------------------------------------
+void RenderQueue::RadixSort()
+{
+	size_t count = order.size();
+	sortKeys.assign(keys.begin(), keys.end());
+	sortOrder.resize(count);
+	scratchKeys.resize(count);
+
+	for (int shift = 0; shift < 64; shift += 8) {
+		unsigned int histogram[256] = {};
+		for (size_t i = 0; i < count; i++) {
+			histogram[(sortKeys[i] >> shift) & 0xFF]++;
+		}
+		if (count == 0 || histogram[(sortKeys[0] >> shift) & 0xFF] == count) {
+			continue;
+		}
+
+		unsigned int offsets[256];
+		unsigned int total = 0;
+		for (int b = 0; b < 256; b++) {
+			offsets[b] = total;
+			total += histogram[b];
+		}
+		for (size_t i = 0; i < count; i++) {
+			unsigned int destination = offsets[(sortKeys[i] >> shift) & 0xFF]++;
+			scratchKeys[destination] = sortKeys[i];
+			sortOrder[destination] = order[i];
+		}
+		sortKeys.swap(scratchKeys);
+		order.swap(sortOrder);
+	}
+}
+
+void RenderQueue::Record(std::shared_ptr<Camera> camera, unsigned int pass, CommandBuffer& commands)
+{
+	PROFILE_FUNCTION();
+	XMFLOAT4X4 view = camera->GetViewMatrix();
+	XMFLOAT4X4 projection = camera->GetProjectionMatrix();
+
+	// The pass is one run of the sorted order
+	unsigned int first = 0;
+	while (first < order.size() && (unsigned int)(keys[order[first]] >> KEY_PASS_SHIFT) < pass) {
+		first++;
+	}
+	unsigned int last = first;
+	while (last < order.size() && (unsigned int)(keys[order[last]] >> KEY_PASS_SHIFT) == pass) {
+		last++;
+	}
+
+	unsigned int chunks = jobs ? (last - first) / RENDER_QUEUE_MIN_ITEMS_PER_CHUNK : 1;
+	chunks = jobs && chunks > jobs->GetThreadCount() ? jobs->GetThreadCount() : chunks;
+	if (chunks <= 1) {
+		RecordRange(view, projection, first, last, commands, stats);
+		return;
+	}
+
+	chunkCommands.resize(chunks);
+	chunkStats.resize(chunks);
+	unsigned int perChunk = (last - first + chunks - 1) / chunks;
+	JobCounter recorded;
+	for (unsigned int c = 0; c < chunks; c++) {
+		unsigned int chunkFirst = first + c * perChunk;
+		unsigned int chunkLast = chunkFirst + perChunk < last ? chunkFirst + perChunk : last;
+		jobs->Run([this, &view, &projection, c, chunkFirst, chunkLast] {
+			chunkCommands[c].Clear();
+			chunkStats[c] = {};
+			RecordRange(view, projection, chunkFirst, chunkLast, chunkCommands[c], chunkStats[c]);
+		}, &recorded);
+	}
+	jobs->Wait(recorded);
+
+	for (unsigned int c = 0; c < chunks; c++) {
+		commands.Append(chunkCommands[c]);
+		stats.Draws += chunkStats[c].Draws;
+		stats.PipelineSwitches += chunkStats[c].PipelineSwitches;
+		stats.MaterialSwitches += chunkStats[c].MaterialSwitches;
+		stats.MeshSwitches += chunkStats[c].MeshSwitches;
+	}
+}
+
+// Records sorted items [first, last) as if nothing was bound beforehand; only reads the queue, materials and pipelines
+void RenderQueue::RecordRange(const XMFLOAT4X4& view, const XMFLOAT4X4& projection, unsigned int first, unsigned int last,
+	CommandBuffer& commands, RenderQueueStats& rangeStats)
+{
+	const PipelineState* currentPipeline = nullptr;
+	Material* currentMaterial = nullptr;
+	Mesh* currentMesh = nullptr;
+	bool psWantsPosition = false;
+	ShaderConstants vsConstants;
+	ShaderConstants psConstants;
+
+	for (unsigned int i = first; i < last; i++) {
+		const RenderItem& item = items[order[i]];
+
+		if (item.material != currentMaterial) {
+			const PipelineState* pipeline = item.material->GetPipelineState().get();
+			if (pipeline != currentPipeline) {
+				pipeline->Record(commands);
+				SimpleVertexShader* vs = pipeline->GetVertexShader().get();
+				SimplePixelShader* ps = pipeline->GetPixelShader().get();
+				vsConstants.Reset(vs);
+				psConstants.Reset(ps);
+				// The camera is the same for the whole pass, so these only need setting once per pipeline
+				vsConstants.SetMatrix4x4("view", view);
+				vsConstants.SetMatrix4x4("projection", projection);
+				psWantsPosition = ps->HasVariable("position");
+				currentPipeline = pipeline;
+				rangeStats.PipelineSwitches++;
+			}
+			item.material->RecordResources(commands, psConstants);
+			psConstants.SetFloat4("colorTint", item.material->GetColorTint());
+			currentMaterial = item.material;
+			rangeStats.MaterialSwitches++;
+		}
+		if (item.mesh != currentMesh) {
+			item.mesh->RecordBuffers(commands);
+			currentMesh = item.mesh;
+			rangeStats.MeshSwitches++;
+		}
+
+		XMFLOAT4X4 worldInvTranspose;
+		XMStoreFloat4x4(&worldInvTranspose, XMMatrixInverse(nullptr, XMMatrixTranspose(XMLoadFloat4x4(&item.object->World))));
+		vsConstants.SetMatrix4x4("world", item.object->World);
+		vsConstants.SetMatrix4x4("worldInvTranspose", worldInvTranspose);
+		vsConstants.Record(commands, SHADER_STAGE_VERTEX);
+		if (psWantsPosition) {
+			psConstants.SetFloat3("position", item.object->Position); //the transparency shader needs the sphere's center
+		}
+		psConstants.Record(commands, SHADER_STAGE_PIXEL); //only when the material or position changed
+
+		item.mesh->RecordDrawIndexed(commands);
+		rangeStats.Draws++;
+	}
+}
+
+void RenderQueue::GetRenderObjects(unsigned int pass, std::vector<const RenderObject*>& objects)
+{
+	objects.clear();
+	for (size_t i = 0; i < order.size(); i++) {
+		unsigned int itemPass = (unsigned int)(keys[order[i]] >> KEY_PASS_SHIFT);
+		if (itemPass > pass) {
+			break;
+		}
+		if (itemPass == pass) {
+			objects.push_back(items[order[i]].object);
+		}
+	}
+}
+
+uint64_t RenderQueue::GetKey(unsigned int sortedIndex)
+{
+	return keys[order[sortedIndex]];
+}
+
+const RenderObject* RenderQueue::GetRenderObject(unsigned int sortedIndex)
+{
+	return items[order[sortedIndex]].object;
+}
+
+unsigned int RenderQueue::GetCount()
+{
+	return (unsigned int)items.size();
+}
+
+const RenderQueueStats& RenderQueue::GetStats()
+{
+	return stats;
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <memory>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+#include "Camera.h"
+#include "CommandBuffer.h"
+#include "JobSystem.h"
+#include "PipelineState.h"
+#include "RenderObject.h"
+
+#define RENDER_PASS_OPAQUE 0
+#define RENDER_PASS_TRANSPARENT 2
+
+// Fewer items than this per chunk and recording it as a job costs more than it saves
+#define RENDER_QUEUE_MIN_ITEMS_PER_CHUNK 256
+
+// --------------------------------------------------------
+// Per-frame counters from RenderQueue::Record
+// --------------------------------------------------------
+struct RenderQueueStats
+{
+	unsigned int Items;
+	unsigned int Draws;
+	unsigned int PipelineSwitches;
+	unsigned int MaterialSwitches;
+	unsigned int MeshSwitches;
+};
+
+// --------------------------------------------------------
+// Collects the frame's visible objects as 64-bit sort keys,
+// radix sorts them, then records them in key order, only
+// rebinding pipeline states, material resources and mesh
+// buffers when they actually change between consecutive
+// draws.  Every queued material needs a pipeline state
+// (Material::SetPipelineStates).
+//
+// With a job system, a pass is cut into chunks that are
+// recorded side by side, each binding everything its first
+// draw needs, and appended back together in key order.
+//
+// Key layout, most significant bits first:
+//   pass (4) | translucent (1) | ...
+//   opaque:      pipeline (10) | material (12) | mesh (12) | depth (25, near to far)
+//   translucent: depth (24, far to near) | pipeline (10) | material (12) | mesh (12) | unused (1)
+//
+// Ids wider than their field wrap, which only costs some
+// sorting quality since binds compare the real objects.
+// --------------------------------------------------------
+class RenderQueue
+{
+private:
+	struct RenderItem
+	{
+		const RenderObject* object;
+		Material* material;
+		Mesh* mesh;
+	};
+
+	std::vector<RenderItem> items;
+	std::vector<uint64_t> keys;
+	std::vector<uint32_t> order;		// Item indices, sorted by key
+	std::vector<uint64_t> sortKeys;		// Radix sort scratch, kept between frames
+	std::vector<uint64_t> scratchKeys;
+	std::vector<uint32_t> sortOrder;
+	std::unordered_map<const PipelineState*, unsigned int> pipelineIds; //assigned on first sight, stable for the queue's lifetime
+	JobSystem* jobs;
+	std::vector<CommandBuffer> chunkCommands;
+	std::vector<RenderQueueStats> chunkStats;
+	RenderQueueStats stats;
+
+	unsigned int GetPipelineId(const PipelineState* pipeline);
+	void RadixSort();
+	void RecordRange(const DirectX::XMFLOAT4X4& view, const DirectX::XMFLOAT4X4& projection, unsigned int first, unsigned int last,
+		CommandBuffer& commands, RenderQueueStats& rangeStats);
+public:
+	RenderQueue();
+	void SetJobSystem(JobSystem* jobs); //null records everything on the calling thread
+	void Clear();
+	//depth is any non-negative distance from the camera (squared distance works fine, it only has to sort)
+	void Add(const RenderObject* object, unsigned int pass, bool translucent, float depth);
+	void Sort();
+	//records every item in the given pass, in key order, after whatever commands already holds
+	void Record(std::shared_ptr<Camera> camera, unsigned int pass, CommandBuffer& commands);
+	//the objects in the given pass, in key order, for drawing them some other way (e.g. InstanceBatcher)
+	void GetRenderObjects(unsigned int pass, std::vector<const RenderObject*>& objects);
+	uint64_t GetKey(unsigned int sortedIndex);
+	const RenderObject* GetRenderObject(unsigned int sortedIndex);
+	unsigned int GetCount();
+	const RenderQueueStats& GetStats();
+};
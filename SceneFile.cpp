@@ -0,0 +1,491 @@
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include "SceneFile.h"
+
+using namespace DirectX;
+
+#define SCENE_BINARY_MAGIC 0x424E4353	// "SCNB"
+#define SCENE_BINARY_VERSION 1
+
+// --------------------------------------------------------
+// An offset from the start of the file on disk, and the
+// pointer it's replaced with once the file is mapped.
+// Always 64 bits so the layout is the same for any build.
+// --------------------------------------------------------
+template<typename T>
+union SceneOffset
+{
+	uint64_t Offset;
+	T* Pointer;
+};
+
+struct SceneString
+{
+	SceneOffset<const char> Text;	// Null terminated
+	uint32_t Length;
+	uint32_t Padding;
+};
+
+// Everything after the header is 16 byte aligned
+struct SceneFileHeader
+{
+	uint32_t Magic;
+	uint32_t Version;
+	uint64_t FileSize;
+	uint32_t MeshCount;
+	uint32_t MaterialCount;
+	uint32_t EntityCount;
+	uint32_t LightCount;
+	XMFLOAT3 AmbientColor;
+	uint32_t Padding;
+	SceneOffset<SceneString> MeshNames;
+	SceneOffset<SceneString> MaterialNames;
+	SceneOffset<SceneEntity> Entities;
+	SceneOffset<Light> Lights;
+};
+
+static const char* lightTypeNames[] = { "directional", "point", "spot" };
+
+// Pads the buffer out to the next 16 bytes and returns where that is
+static uint64_t AlignBuffer(std::vector<char>& buffer)
+{
+	buffer.resize((buffer.size() + 15) & ~(size_t)15, 0);
+	return buffer.size();
+}
+
+static uint64_t AppendStrings(std::vector<char>& buffer, const std::vector<std::string>& names, std::vector<char>& stringBlob, std::vector<uint64_t>& textOffsets)
+{
+	uint64_t tableOffset = AlignBuffer(buffer);
+	for (int i = 0; i < names.size(); ++i) {
+		SceneString string = {};
+		string.Text.Offset = stringBlob.size(); //relative to the blob for now, rebased once the blob's placed
+		string.Length = (uint32_t)names[i].size();
+		stringBlob.insert(stringBlob.end(), names[i].begin(), names[i].end());
+		stringBlob.push_back(0);
+		textOffsets.push_back(buffer.size() + offsetof(SceneString, Text));
+		buffer.insert(buffer.end(), (const char*)&string, (const char*)&string + sizeof(SceneString));
+	}
+	return tableOffset;
+}
+
+static bool ReadFloat3(std::istringstream& stream, XMFLOAT3& value)
+{
+	return (bool)(stream >> value.x >> value.y >> value.z);
+}
+
+uint32_t SceneFile::FindOrAddName(std::vector<std::string>& names, const std::string& name)
+{
+	for (uint32_t i = 0; i < names.size(); i++) {
+		if (names[i] == name) {
+			return i;
+		}
+	}
+	names.push_back(name);
+	return (uint32_t)names.size() - 1;
+}
+
+bool SceneFile::LoadText(const char* fileName, SceneData& scene)
+{
+	scene = SceneData();
+	scene.AmbientColor = XMFLOAT3(0, 0, 0);
+	std::ifstream file(fileName);
+	if (!file.is_open()) {
+		printf("Scene: couldn't open %s\n", fileName);
+		return false;
+	}
+
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(file, line)) {
+		lineNumber++;
+		size_t comment = line.find('#');
+		if (comment != std::string::npos) {
+			line.erase(comment);
+		}
+		std::istringstream stream(line);
+		std::string keyword;
+		if (!(stream >> keyword)) {
+			continue; //blank
+		}
+
+		bool valid = true;
+		if (keyword == "ambient") {
+			valid = ReadFloat3(stream, scene.AmbientColor);
+		}
+		else if (keyword == "entity") {
+			std::string meshName;
+			std::string materialName;
+			valid = (bool)(stream >> meshName >> materialName);
+			SceneEntity entity = {};
+			entity.MeshIndex = FindOrAddName(scene.MeshNames, meshName);
+			entity.MaterialIndex = FindOrAddName(scene.MaterialNames, materialName);
+			entity.Scale = XMFLOAT3(1, 1, 1);
+			std::string property;
+			while (valid && stream >> property) {
+				if (property == "position") valid = ReadFloat3(stream, entity.Position);
+				else if (property == "rotation") valid = ReadFloat3(stream, entity.Rotation);
+				else if (property == "scale") valid = ReadFloat3(stream, entity.Scale);
+				else if (property == "static") entity.Flags |= SCENE_ENTITY_STATIC;
+				else if (property == "occluder") entity.Flags |= SCENE_ENTITY_OCCLUDER;
+				else valid = false;
+			}
+			scene.Entities.push_back(entity);
+		}
+		else if (keyword == "light") {
+			std::string typeName;
+			valid = (bool)(stream >> typeName);
+			Light light = {};
+			light.type = -1;
+			for (int t = 0; t < 3; ++t) {
+				if (typeName == lightTypeNames[t]) {
+					light.type = t;
+				}
+			}
+			valid = valid && light.type >= 0;
+			std::string property;
+			while (valid && stream >> property) {
+				if (property == "color") valid = ReadFloat3(stream, light.color);
+				else if (property == "direction") valid = ReadFloat3(stream, light.direction);
+				else if (property == "position") valid = ReadFloat3(stream, light.position);
+				else if (property == "intensity") valid = (bool)(stream >> light.intensity);
+				else if (property == "range") valid = (bool)(stream >> light.range);
+				else if (property == "falloff") valid = (bool)(stream >> light.spotFalloff);
+				else valid = false;
+			}
+			scene.Lights.push_back(light);
+		}
+		else {
+			valid = false;
+		}
+
+		if (!valid) {
+			printf("Scene: %s(%d): can't read \"%s\"\n", fileName, lineNumber, line.c_str());
+			return false;
+		}
+	}
+	return true;
+}
+
+bool SceneFile::SaveText(const char* fileName, const SceneData& scene)
+{
+	std::ofstream file(fileName);
+	if (!file.is_open()) {
+		printf("Scene: couldn't write %s\n", fileName);
+		return false;
+	}
+	// Enough digits that every float reads back exactly
+	file << std::setprecision(9);
+
+	const XMFLOAT3& ambient = scene.AmbientColor;
+	file << "ambient " << ambient.x << " " << ambient.y << " " << ambient.z << "\n";
+	for (int i = 0; i < scene.Lights.size(); ++i) {
+		const Light& light = scene.Lights[i];
+		file << "light " << lightTypeNames[light.type]
+			<< " color " << light.color.x << " " << light.color.y << " " << light.color.z
+			<< " direction " << light.direction.x << " " << light.direction.y << " " << light.direction.z
+			<< " position " << light.position.x << " " << light.position.y << " " << light.position.z
+			<< " intensity " << light.intensity << " range " << light.range << " falloff " << light.spotFalloff << "\n";
+	}
+	for (int i = 0; i < scene.Entities.size(); ++i) {
+		const SceneEntity& entity = scene.Entities[i];
+		file << "entity " << scene.MeshNames[entity.MeshIndex] << " " << scene.MaterialNames[entity.MaterialIndex]
+			<< " position " << entity.Position.x << " " << entity.Position.y << " " << entity.Position.z
+			<< " rotation " << entity.Rotation.x << " " << entity.Rotation.y << " " << entity.Rotation.z
+			<< " scale " << entity.Scale.x << " " << entity.Scale.y << " " << entity.Scale.z;
+		if (entity.Flags & SCENE_ENTITY_STATIC) {
+			file << " static";
+		}
+		if (entity.Flags & SCENE_ENTITY_OCCLUDER) {
+			file << " occluder";
+		}
+		file << "\n";
+	}
+	return file.good();
+}
+
+// --------------------------------------------------------
+// Lays the scene out exactly as MappedScene will use it:
+// header, the two name tables, the entity and light arrays,
+// then every name's characters
+// --------------------------------------------------------
+bool SceneFile::SaveBinary(const char* fileName, const SceneData& scene)
+{
+	std::vector<char> buffer(sizeof(SceneFileHeader), 0);
+	std::vector<char> stringBlob;
+	std::vector<uint64_t> textOffsets; //where each SceneString's Text is, to rebase them onto the blob
+	SceneFileHeader header = {};
+	header.Magic = SCENE_BINARY_MAGIC;
+	header.Version = SCENE_BINARY_VERSION;
+	header.MeshCount = (uint32_t)scene.MeshNames.size();
+	header.MaterialCount = (uint32_t)scene.MaterialNames.size();
+	header.EntityCount = (uint32_t)scene.Entities.size();
+	header.LightCount = (uint32_t)scene.Lights.size();
+	header.AmbientColor = scene.AmbientColor;
+
+	header.MeshNames.Offset = AppendStrings(buffer, scene.MeshNames, stringBlob, textOffsets);
+	header.MaterialNames.Offset = AppendStrings(buffer, scene.MaterialNames, stringBlob, textOffsets);
+	header.Entities.Offset = AlignBuffer(buffer);
+	if (!scene.Entities.empty()) {
+		buffer.insert(buffer.end(), (const char*)&scene.Entities[0], (const char*)&scene.Entities[0] + sizeof(SceneEntity) * scene.Entities.size());
+	}
+	header.Lights.Offset = AlignBuffer(buffer);
+	if (!scene.Lights.empty()) {
+		buffer.insert(buffer.end(), (const char*)&scene.Lights[0], (const char*)&scene.Lights[0] + sizeof(Light) * scene.Lights.size());
+	}
+
+	uint64_t blobOffset = AlignBuffer(buffer);
+	buffer.insert(buffer.end(), stringBlob.begin(), stringBlob.end());
+	for (int i = 0; i < textOffsets.size(); ++i) {
+		SceneOffset<const char>* text = (SceneOffset<const char>*)&buffer[(size_t)textOffsets[i]];
+		text->Offset += blobOffset;
+	}
+	header.FileSize = buffer.size();
+	memcpy(&buffer[0], &header, sizeof(SceneFileHeader));
+
+	std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+	if (!file.is_open()) {
+		printf("Scene: couldn't write %s\n", fileName);
+		return false;
+	}
+	file.write(&buffer[0], buffer.size());
+	return file.good();
+}
+
+bool SceneFile::IsBinaryStale(const char* textFileName, const char* binaryFileName)
+{
+#ifdef _WIN32
+	WIN32_FILE_ATTRIBUTE_DATA text;
+	WIN32_FILE_ATTRIBUTE_DATA binary;
+	if (!GetFileAttributesExA(binaryFileName, GetFileExInfoStandard, &binary)) {
+		return true;
+	}
+	if (!GetFileAttributesExA(textFileName, GetFileExInfoStandard, &text)) {
+		return false; //shipped without the source, the binary is all there is
+	}
+	return CompareFileTime(&text.ftLastWriteTime, &binary.ftLastWriteTime) > 0;
+#else
+	struct stat text;
+	struct stat binary;
+	if (stat(binaryFileName, &binary) != 0) {
+		return true;
+	}
+	if (stat(textFileName, &text) != 0) {
+		return false;
+	}
+	return text.st_mtim.tv_sec > binary.st_mtim.tv_sec ||
+		(text.st_mtim.tv_sec == binary.st_mtim.tv_sec && text.st_mtim.tv_nsec > binary.st_mtim.tv_nsec);
+#endif
+}
+
+bool SceneFile::Cook(const char* textFileName, const char* binaryFileName)
+{
+	if (!IsBinaryStale(textFileName, binaryFileName)) {
+		return true;
+	}
+	SceneData scene;
+	return LoadText(textFileName, scene) && SaveBinary(binaryFileName, scene);
+}
+
+MappedScene::MappedScene()
+{
+#ifdef _WIN32
+	fileHandle = INVALID_HANDLE_VALUE;
+#else
+	fileHandle = nullptr;
+#endif
+	mappingHandle = nullptr;
+	header = nullptr;
+	mappedSize = 0;
+}
+
+MappedScene::~MappedScene()
+{
+	Close();
+}
+
+// Checks an on-disk table fits in the file before it's turned into a pointer
+static bool TableFits(uint64_t offset, uint64_t count, uint64_t elementSize, uint64_t fileSize)
+{
+	return offset <= fileSize && count <= (fileSize - offset) / elementSize;
+}
+
+static bool FixUpStrings(char* base, SceneOffset<SceneString>& table, uint32_t count, uint64_t fileSize)
+{
+	if (!TableFits(table.Offset, count, sizeof(SceneString), fileSize)) {
+		return false;
+	}
+	table.Pointer = (SceneString*)(base + table.Offset);
+	for (uint32_t i = 0; i < count; i++) {
+		SceneString& string = table.Pointer[i];
+		if (!TableFits(string.Text.Offset, (uint64_t)string.Length + 1, 1, fileSize) || base[string.Text.Offset + string.Length] != 0) {
+			return false;
+		}
+		string.Text.Pointer = base + string.Text.Offset;
+	}
+	return true;
+}
+
+// --------------------------------------------------------
+// Maps the file copy-on-write (so the fixups never reach
+// the disk), checks every table lies inside it, then swaps
+// the offsets for pointers
+// --------------------------------------------------------
+bool MappedScene::Open(const char* fileName)
+{
+	Close();
+#ifdef _WIN32
+	fileHandle = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (fileHandle == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(fileHandle, &size) || (uint64_t)size.QuadPart < sizeof(SceneFileHeader)) {
+		Close();
+		return false;
+	}
+	mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+	if (!mappingHandle) {
+		Close();
+		return false;
+	}
+	header = (SceneFileHeader*)MapViewOfFile(mappingHandle, FILE_MAP_COPY, 0, 0, 0);
+	if (!header) {
+		Close();
+		return false;
+	}
+	uint64_t fileSize = (uint64_t)size.QuadPart;
+#else
+	// A private writable mapping is the same copy-on-write view, and it outlives the descriptor
+	int file = open(fileName, O_RDONLY);
+	if (file < 0) {
+		return false;
+	}
+	struct stat info;
+	if (fstat(file, &info) != 0 || (uint64_t)info.st_size < sizeof(SceneFileHeader)) {
+		close(file);
+		return false;
+	}
+	void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+	close(file);
+	if (view == MAP_FAILED) {
+		return false;
+	}
+	header = (SceneFileHeader*)view;
+	uint64_t fileSize = (uint64_t)info.st_size;
+#endif
+	mappedSize = fileSize;
+
+	char* base = (char*)header;
+	bool valid = header->Magic == SCENE_BINARY_MAGIC && header->Version == SCENE_BINARY_VERSION && header->FileSize == fileSize
+		&& FixUpStrings(base, header->MeshNames, header->MeshCount, fileSize)
+		&& FixUpStrings(base, header->MaterialNames, header->MaterialCount, fileSize)
+		&& TableFits(header->Entities.Offset, header->EntityCount, sizeof(SceneEntity), fileSize)
+		&& TableFits(header->Lights.Offset, header->LightCount, sizeof(Light), fileSize);
+	if (!valid) {
+		Close();
+		return false;
+	}
+	header->Entities.Pointer = (SceneEntity*)(base + header->Entities.Offset);
+	header->Lights.Pointer = (Light*)(base + header->Lights.Offset);
+	return true;
+}
+
+void MappedScene::Close()
+{
+#ifdef _WIN32
+	if (header) {
+		UnmapViewOfFile(header);
+		header = nullptr;
+	}
+	if (mappingHandle) {
+		CloseHandle(mappingHandle);
+		mappingHandle = nullptr;
+	}
+	if (fileHandle != INVALID_HANDLE_VALUE) {
+		CloseHandle(fileHandle);
+		fileHandle = INVALID_HANDLE_VALUE;
+	}
+#else
+	if (header) {
+		munmap(header, (size_t)mappedSize);
+		header = nullptr;
+	}
+#endif
+	mappedSize = 0;
+}
+
+bool MappedScene::IsOpen() const
+{
+	return header != nullptr;
+}
+
+unsigned int MappedScene::GetMeshCount() const
+{
+	return header->MeshCount;
+}
+
+const char* MappedScene::GetMeshName(unsigned int index) const
+{
+	return header->MeshNames.Pointer[index].Text.Pointer;
+}
+
+unsigned int MappedScene::GetMaterialCount() const
+{
+	return header->MaterialCount;
+}
+
+const char* MappedScene::GetMaterialName(unsigned int index) const
+{
+	return header->MaterialNames.Pointer[index].Text.Pointer;
+}
+
+unsigned int MappedScene::GetEntityCount() const
+{
+	return header->EntityCount;
+}
+
+const SceneEntity* MappedScene::GetEntities() const
+{
+	return header->Entities.Pointer;
+}
+
+unsigned int MappedScene::GetLightCount() const
+{
+	return header->LightCount;
+}
+
+const Light* MappedScene::GetLights() const
+{
+	return header->Lights.Pointer;
+}
+
+XMFLOAT3 MappedScene::GetAmbientColor() const
+{
+	return header->AmbientColor;
+}
+
+void MappedScene::ToSceneData(SceneData& scene) const
+{
+	scene = SceneData();
+	for (unsigned int i = 0; i < GetMeshCount(); i++) {
+		scene.MeshNames.push_back(GetMeshName(i));
+	}
+	for (unsigned int i = 0; i < GetMaterialCount(); i++) {
+		scene.MaterialNames.push_back(GetMaterialName(i));
+	}
+	scene.Entities.assign(GetEntities(), GetEntities() + GetEntityCount());
+	scene.Lights.assign(GetLights(), GetLights() + GetLightCount());
+	scene.AmbientColor = GetAmbientColor();
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <DirectXMath.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "Lights.h"
+
+// SceneEntity::Flags
+#define SCENE_ENTITY_STATIC 0x1		// Baked by StaticBatcher, never moves
+#define SCENE_ENTITY_OCCLUDER 0x2	// Rasterized into the occlusion buffer
+
+struct SceneFileHeader;
+
+// --------------------------------------------------------
+// One entity as stored in both forms of a scene.  Meshes
+// and materials are indices into the scene's name tables,
+// which the game resolves to its own Mesh and Material.
+// The binary form points straight at an array of these.
+// --------------------------------------------------------
+struct SceneEntity
+{
+	uint32_t MeshIndex;
+	uint32_t MaterialIndex;
+	DirectX::XMFLOAT3 Position;
+	DirectX::XMFLOAT3 Rotation;		// Pitch, yaw, roll
+	DirectX::XMFLOAT3 Scale;
+	uint32_t Flags;
+};
+
+// A whole scene in ordinary containers, what the text form loads into and what both forms are saved from
+struct SceneData
+{
+	std::vector<std::string> MeshNames;		// Model file names without the .obj, e.g. "sphere"
+	std::vector<std::string> MaterialNames;
+	std::vector<SceneEntity> Entities;
+	std::vector<Light> Lights;
+	DirectX::XMFLOAT3 AmbientColor;
+};
+
+// --------------------------------------------------------
+// Reading and writing scene files.
+//
+// The text form is for authoring, one line per entity or
+// light:
+//
+//   ambient 0.15 0.15 0.25
+//   light point color 1 0 0 position 6 0 0 intensity 0.8 range 2
+//   entity sphere redGlass position 6 0 0 scale 1 1 1
+//   entity quad metalHatch position 0 -1 0 scale 10 10 10 static occluder
+//
+// Anything after a # is a comment, and properties that are
+// left out keep their defaults (zero, scale of one).
+//
+// The binary form is cooked from the text one and loaded
+// with MappedScene.
+// --------------------------------------------------------
+class SceneFile
+{
+public:
+	// False (and a message on the console) if the file can't be read or has a bad line
+	static bool LoadText(const char* fileName, SceneData& scene);
+	static bool SaveText(const char* fileName, const SceneData& scene);
+	static bool SaveBinary(const char* fileName, const SceneData& scene);
+	// True if the binary file is missing or older than the text file it's cooked from
+	static bool IsBinaryStale(const char* textFileName, const char* binaryFileName);
+	// Re-cooks the binary file if it's stale, false if that was needed and failed
+	static bool Cook(const char* textFileName, const char* binaryFileName);
+	// Interns a name into a scene's name table, returning its index
+	static uint32_t FindOrAddName(std::vector<std::string>& names, const std::string& name);
+};
+
+// --------------------------------------------------------
+// A binary scene mapped straight into memory.
+//
+// Every table in the file is stored as an offset from the
+// start of the file.  Open maps the file copy-on-write and
+// overwrites each offset with a real pointer in place, so
+// loading is one pass over the (few) strings and nothing
+// is parsed or copied; the entity and light arrays are
+// used exactly as they sit in the file.  Those pages are
+// only ever read, so they stay shared with the file cache.
+// --------------------------------------------------------
+class MappedScene
+{
+private:
+	void* fileHandle;			// Windows only, elsewhere the view is all that's kept
+	void* mappingHandle;
+	SceneFileHeader* header;	// Also the base of the mapped view
+	uint64_t mappedSize;
+public:
+	MappedScene();
+	~MappedScene();
+	MappedScene(const MappedScene&) = delete;
+	void operator=(const MappedScene&) = delete;
+
+	// False if the file is missing, too small, or from a different version, in which case it should be re-cooked
+	bool Open(const char* fileName);
+	void Close();
+	bool IsOpen() const;
+
+	unsigned int GetMeshCount() const;
+	const char* GetMeshName(unsigned int index) const;
+	unsigned int GetMaterialCount() const;
+	const char* GetMaterialName(unsigned int index) const;
+	unsigned int GetEntityCount() const;
+	const SceneEntity* GetEntities() const;
+	unsigned int GetLightCount() const;
+	const Light* GetLights() const;
+	DirectX::XMFLOAT3 GetAmbientColor() const;
+
+	// Copies everything back out, mostly for checking a cook round-trips
+	void ToSceneData(SceneData& scene) const;
+};
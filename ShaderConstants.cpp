@@ -0,0 +1,73 @@
+#include <string.h>
+#include "ShaderConstants.h"
+
+using namespace DirectX;
+
+ShaderConstants::ShaderConstants()
+{
+	shader = nullptr;
+}
+
+void ShaderConstants::Reset(ISimpleShader* shader)
+{
+	this->shader = shader;
+	data.clear();
+	bufferOffsets.clear();
+	for (unsigned int b = 0; b < shader->GetBufferCount(); b++) {
+		const SimpleConstantBuffer* buffer = shader->GetBufferInfo(b);
+		bufferOffsets.push_back((unsigned int)data.size());
+		data.insert(data.end(), buffer->LocalDataBuffer, buffer->LocalDataBuffer + buffer->Size);
+	}
+	dirtyBuffers.assign(bufferOffsets.size(), true);
+}
+
+ISimpleShader* ShaderConstants::GetShader()
+{
+	return shader;
+}
+
+bool ShaderConstants::SetData(const std::string& name, const void* value, unsigned int size)
+{
+	const SimpleShaderVariable* variable = shader->GetVariableInfo(name);
+	if (!variable || size > variable->Size) {
+		return false;
+	}
+	memcpy(&data[bufferOffsets[variable->ConstantBufferIndex] + variable->ByteOffset], value, size);
+	dirtyBuffers[variable->ConstantBufferIndex] = true;
+	return true;
+}
+
+bool ShaderConstants::SetFloat(const std::string& name, float value)
+{
+	return SetData(name, &value, sizeof(float));
+}
+
+bool ShaderConstants::SetFloat3(const std::string& name, XMFLOAT3 value)
+{
+	return SetData(name, &value, sizeof(XMFLOAT3));
+}
+
+bool ShaderConstants::SetFloat4(const std::string& name, XMFLOAT4 value)
+{
+	return SetData(name, &value, sizeof(XMFLOAT4));
+}
+
+bool ShaderConstants::SetMatrix4x4(const std::string& name, const XMFLOAT4X4& value)
+{
+	return SetData(name, &value, sizeof(XMFLOAT4X4));
+}
+
+void ShaderConstants::Record(CommandBuffer& commands, unsigned int stage)
+{
+	for (unsigned int b = 0; b < bufferOffsets.size(); b++) {
+		if (!dirtyBuffers[b]) {
+			continue;
+		}
+		const SimpleConstantBuffer* buffer = shader->GetBufferInfo(b);
+		if (buffer->Type != D3D11_CT_CBUFFER) {
+			continue; //same as SimpleShader, texture buffers and the like aren't bound as constants
+		}
+		commands.SetConstants(stage, buffer->BindIndex, buffer->ConstantBuffer.Get(), &data[bufferOffsets[b]], buffer->Size);
+		dirtyBuffers[b] = false;
+	}
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <DirectXMath.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "CommandBuffer.h"
+#include "SimpleShader.h"
+
+// --------------------------------------------------------
+// A private copy of a shader's constant buffers, for
+// recording commands without writing to the shader.
+//
+// Reset copies whatever the shader's own local buffers
+// hold right now (lights, camera position and anything
+// else set on it for the whole frame); the Set functions
+// then change the copy by variable name, and Record emits
+// a SetConstants for every buffer that changed since the
+// last Record.  Reading the shader is safe from any number
+// of threads, as long as nothing sets values on the shader
+// itself while they record.
+// --------------------------------------------------------
+class ShaderConstants
+{
+private:
+	ISimpleShader* shader;
+	std::vector<uint8_t> data;					// Every constant buffer of the shader, back to back
+	std::vector<unsigned int> bufferOffsets;
+	std::vector<bool> dirtyBuffers;
+public:
+	ShaderConstants();
+	void Reset(ISimpleShader* shader);
+	ISimpleShader* GetShader();
+
+	//false, and nothing changes, if the shader has no such variable or it's smaller than size
+	bool SetData(const std::string& name, const void* value, unsigned int size);
+	bool SetFloat(const std::string& name, float value);
+	bool SetFloat3(const std::string& name, DirectX::XMFLOAT3 value);
+	bool SetFloat4(const std::string& name, DirectX::XMFLOAT4 value);
+	bool SetMatrix4x4(const std::string& name, const DirectX::XMFLOAT4X4& value);
+
+	void Record(CommandBuffer& commands, unsigned int stage);
+};
@@ -1,4 +1,5 @@
 #include "SimpleShader.h"
+#include "Profiler.h"
 
 // Default error reporting state
 bool ISimpleShader::ReportErrors = false;
@@ -80,6 +81,7 @@ void ISimpleShader::CleanUp()
 // --------------------------------------------------------
 bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 {
+	PROFILE_FUNCTION();
 	// Load the shader to a blob and ensure it worked
 	HRESULT hr = D3DReadFileToBlob(shaderFile, shaderBlob.GetAddressOf());
 	if (hr != S_OK)
@@ -1,40 +1,42 @@
 #include "SkyBox.h"
 #include "DXCore.h"
+#include "ShaderConstants.h"
 
-SkyBox::SkyBox(Mesh* skyMesh, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> cubeMapSRV, std::shared_ptr<SimpleVertexShader> vertexShader, std::shared_ptr<SimplePixelShader> pixelShader, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState, Microsoft::WRL::ComPtr<ID3D11Device> device)
+SkyBox::SkyBox(Mesh* skyMesh, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> cubeMapSRV, std::shared_ptr<SimpleVertexShader> vertexShader, std::shared_ptr<SimplePixelShader> pixelShader, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState, std::shared_ptr<PipelineStateCache> pipelineStates)
 {
 	this->skyMesh = skyMesh;
 	this->cubeMapSRV = cubeMapSRV;
 	this->samplerState = samplerState;
 	this->vertexShader = vertexShader;
 	this->pixelShader = pixelShader;
-	D3D11_RASTERIZER_DESC rastDesc = {};
-	rastDesc.FillMode = D3D11_FILL_SOLID;
-	rastDesc.CullMode = D3D11_CULL_FRONT;
-	device->CreateRasterizerState(&rastDesc, rasterizerState.GetAddressOf());
 
-	D3D11_DEPTH_STENCIL_DESC stencilDesc = {};
-	stencilDesc.DepthEnable = true;
-	stencilDesc.DepthFunc = D3D11_COMPARISON_LESS_EQUAL;
-	device->CreateDepthStencilState(&stencilDesc, depthStencilState.GetAddressOf());
+	PipelineStateDesc desc;
+	desc.VertexShader = vertexShader;
+	desc.PixelShader = pixelShader;
+	desc.Rasterizer.CullMode = D3D11_CULL_FRONT; //we're inside the cube
+	desc.Rasterizer.DepthClipEnable = false;
+	desc.DepthStencil.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+	desc.DepthStencil.DepthFunc = D3D11_COMPARISON_LESS_EQUAL; //the sky sits right on the far plane
+	pipeline = pipelineStates->GetPipelineState(desc);
 }
 
-void SkyBox::Draw(std::shared_ptr<Camera> camera, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context)
+void SkyBox::Record(std::shared_ptr<Camera> camera, CommandBuffer& commands)
 {
-	context->RSSetState(rasterizerState.Get());
-	context->OMSetDepthStencilState(depthStencilState.Get(), 0);
-	vertexShader->SetShader();
-	vertexShader->SetMatrix4x4("view", camera->GetViewMatrix());
-	vertexShader->SetMatrix4x4("projection", camera->GetProjectionMatrix());
-	vertexShader->CopyAllBufferData();
-	pixelShader->SetShader();
-	pixelShader->SetSamplerState("Sampler", samplerState);
-	pixelShader->SetShaderResourceView("CubeMap", cubeMapSRV);
-	pixelShader->CopyAllBufferData();
-	
-	skyMesh->Draw();
-	context->RSSetState(0);
-	context->OMSetDepthStencilState(0, 0);
+	pipeline->Record(commands);
+	ShaderConstants vertexConstants;
+	vertexConstants.Reset(vertexShader.get());
+	vertexConstants.SetMatrix4x4("view", camera->GetViewMatrix());
+	vertexConstants.SetMatrix4x4("projection", camera->GetProjectionMatrix());
+	vertexConstants.Record(commands, SHADER_STAGE_VERTEX);
+	commands.SetSampler(SHADER_STAGE_PIXEL, pixelShader->GetSamplerInfo("Sampler")->BindIndex, samplerState.Get());
+	commands.SetShaderResource(SHADER_STAGE_PIXEL, pixelShader->GetShaderResourceViewInfo("CubeMap")->BindIndex, cubeMapSRV.Get());
+	ShaderConstants pixelConstants;
+	pixelConstants.Reset(pixelShader.get());
+	pixelConstants.Record(commands, SHADER_STAGE_PIXEL);
+
+	skyMesh->RecordDraw(commands);
+	commands.SetRasterizerState(nullptr);
+	commands.SetDepthStencilState(nullptr, 0);
 }
 
 SkyBox::~SkyBox()
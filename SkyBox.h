@@ -3,20 +3,22 @@
 #include <memory>
 #include "Mesh.h"
 #include "Camera.h"
+#include "CommandBuffer.h"
+#include "PipelineStateCache.h"
 #include "SimpleShader.h"
 class SkyBox
 {
 private:
 	Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState;
 	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> cubeMapSRV;
-	Microsoft::WRL::ComPtr<ID3D11DepthStencilState> depthStencilState;
-	Microsoft::WRL::ComPtr<ID3D11RasterizerState> rasterizerState;
+	std::shared_ptr<PipelineState> pipeline; //front faces culled, depth tested with less-equal but not written
 	Mesh* skyMesh;
 	std::shared_ptr<SimplePixelShader> pixelShader;
 	std::shared_ptr<SimpleVertexShader> vertexShader;
 public:
-	SkyBox(Mesh* skyMesh, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> cubeMapSRV, std::shared_ptr<SimpleVertexShader> vertexShader, std::shared_ptr<SimplePixelShader> pixelShader, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState, Microsoft::WRL::ComPtr<ID3D11Device> device);
-	void Draw(std::shared_ptr<Camera> camera, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context);
+	SkyBox(Mesh* skyMesh, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> cubeMapSRV, std::shared_ptr<SimpleVertexShader> vertexShader, std::shared_ptr<SimplePixelShader> pixelShader, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState, std::shared_ptr<PipelineStateCache> pipelineStates);
+	//records the sky with its own pipeline, then puts the default rasterizer and depth states back
+	void Record(std::shared_ptr<Camera> camera, CommandBuffer& commands);
 	~SkyBox();
 };
 
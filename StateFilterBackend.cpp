@@ -0,0 +1,207 @@
+#include <string.h>
+#include "StateFilterBackend.h"
+
+// Never a real handle, so it never matches one
+#define STATE_UNKNOWN ((void*)~(uintptr_t)0)
+
+unsigned int StateFilterStats::GetIssued() const
+{
+	unsigned int total = 0;
+	for (int t = 0; t < COMMAND_TYPE_COUNT; t++) {
+		total += Issued[t];
+	}
+	return total;
+}
+
+unsigned int StateFilterStats::GetFiltered() const
+{
+	unsigned int total = 0;
+	for (int t = 0; t < COMMAND_TYPE_COUNT; t++) {
+		total += Filtered[t];
+	}
+	return total;
+}
+
+StateFilterBackend::StateFilterBackend(ICommandBackend* target)
+{
+	this->target = target;
+	ResetStats();
+	Invalidate();
+}
+
+void StateFilterBackend::Invalidate()
+{
+	vertexShader = STATE_UNKNOWN;
+	inputLayout = STATE_UNKNOWN;
+	pixelShader = STATE_UNKNOWN;
+	for (int s = 0; s < STATE_FILTER_STAGES; s++) {
+		for (int i = 0; i < STATE_FILTER_CONSTANT_SLOTS; i++) {
+			constantBuffers[s][i] = STATE_UNKNOWN;
+		}
+		for (int i = 0; i < STATE_FILTER_RESOURCE_SLOTS; i++) {
+			resources[s][i] = STATE_UNKNOWN;
+		}
+		for (int i = 0; i < STATE_FILTER_SAMPLER_SLOTS; i++) {
+			samplers[s][i] = STATE_UNKNOWN;
+		}
+	}
+	blendState = STATE_UNKNOWN;
+	rasterizerState = STATE_UNKNOWN;
+	depthStencilState = STATE_UNKNOWN;
+	stencilRef = 0;
+	vertexBuffer = STATE_UNKNOWN;
+	indexBuffer = STATE_UNKNOWN;
+	stride = 0;
+	// Keeps the copies so their memory is reused
+	for (auto it = constantContents.begin(); it != constantContents.end(); ++it) {
+		it->second.Known = false;
+	}
+}
+
+// Counts the call, true if it should be dropped
+bool StateFilterBackend::Filter(CommandType type, bool redundant)
+{
+	if (redundant) {
+		stats.Filtered[type]++;
+	}
+	else {
+		stats.Issued[type]++;
+	}
+	return redundant;
+}
+
+void StateFilterBackend::SetVertexShader(void* shader, void* inputLayout)
+{
+	if (Filter(COMMAND_SET_VERTEX_SHADER, shader == vertexShader && inputLayout == this->inputLayout)) {
+		return;
+	}
+	vertexShader = shader;
+	this->inputLayout = inputLayout;
+	target->SetVertexShader(shader, inputLayout);
+}
+
+void StateFilterBackend::SetPixelShader(void* shader)
+{
+	if (Filter(COMMAND_SET_PIXEL_SHADER, shader == pixelShader)) {
+		return;
+	}
+	pixelShader = shader;
+	target->SetPixelShader(shader);
+}
+
+void StateFilterBackend::SetConstants(unsigned int stage, unsigned int slot, void* buffer, const void* data, unsigned int size)
+{
+	if (stage >= STATE_FILTER_STAGES || slot >= STATE_FILTER_CONSTANT_SLOTS || !buffer) {
+		Filter(COMMAND_SET_CONSTANTS, false); //not something to shadow, let the target deal with it
+		target->SetConstants(stage, slot, buffer, data, size);
+		return;
+	}
+
+	ConstantContents& contents = constantContents[buffer];
+	bool sameData = contents.Known && contents.Data.size() == size && (size == 0 || memcmp(contents.Data.data(), data, size) == 0);
+	if (Filter(COMMAND_SET_CONSTANTS, sameData && constantBuffers[stage][slot] == buffer)) {
+		return;
+	}
+	contents.Known = true;
+	contents.Data.assign((const uint8_t*)data, (const uint8_t*)data + size);
+	constantBuffers[stage][slot] = buffer;
+	target->SetConstants(stage, slot, buffer, data, size);
+}
+
+void StateFilterBackend::SetShaderResource(unsigned int stage, unsigned int slot, void* resource)
+{
+	bool tracked = stage < STATE_FILTER_STAGES && slot < STATE_FILTER_RESOURCE_SLOTS;
+	if (Filter(COMMAND_SET_SHADER_RESOURCE, tracked && resources[stage][slot] == resource)) {
+		return;
+	}
+	if (tracked) {
+		resources[stage][slot] = resource;
+	}
+	target->SetShaderResource(stage, slot, resource);
+}
+
+void StateFilterBackend::SetSampler(unsigned int stage, unsigned int slot, void* sampler)
+{
+	bool tracked = stage < STATE_FILTER_STAGES && slot < STATE_FILTER_SAMPLER_SLOTS;
+	if (Filter(COMMAND_SET_SAMPLER, tracked && samplers[stage][slot] == sampler)) {
+		return;
+	}
+	if (tracked) {
+		samplers[stage][slot] = sampler;
+	}
+	target->SetSampler(stage, slot, sampler);
+}
+
+void StateFilterBackend::SetBlendState(void* state)
+{
+	if (Filter(COMMAND_SET_BLEND_STATE, state == blendState)) {
+		return;
+	}
+	blendState = state;
+	target->SetBlendState(state);
+}
+
+void StateFilterBackend::SetRasterizerState(void* state)
+{
+	if (Filter(COMMAND_SET_RASTERIZER_STATE, state == rasterizerState)) {
+		return;
+	}
+	rasterizerState = state;
+	target->SetRasterizerState(state);
+}
+
+void StateFilterBackend::SetDepthStencilState(void* state, unsigned int stencilRef)
+{
+	if (Filter(COMMAND_SET_DEPTH_STENCIL_STATE, state == depthStencilState && stencilRef == this->stencilRef)) {
+		return;
+	}
+	depthStencilState = state;
+	this->stencilRef = stencilRef;
+	target->SetDepthStencilState(state, stencilRef);
+}
+
+// Dropped only if it would change nothing at all, otherwise the whole pipeline goes through as one call
+void StateFilterBackend::SetPipelineState(const PipelineHandles& pipeline)
+{
+	bool redundant = pipeline.VertexShader == vertexShader && pipeline.InputLayout == inputLayout && pipeline.PixelShader == pixelShader &&
+		pipeline.BlendState == blendState && pipeline.RasterizerState == rasterizerState &&
+		pipeline.DepthStencilState == depthStencilState && pipeline.StencilRef == stencilRef;
+	if (Filter(COMMAND_SET_PIPELINE_STATE, redundant)) {
+		return;
+	}
+	vertexShader = pipeline.VertexShader;
+	inputLayout = pipeline.InputLayout;
+	pixelShader = pipeline.PixelShader;
+	blendState = pipeline.BlendState;
+	rasterizerState = pipeline.RasterizerState;
+	depthStencilState = pipeline.DepthStencilState;
+	stencilRef = pipeline.StencilRef;
+	target->SetPipelineState(pipeline);
+}
+
+void StateFilterBackend::SetMeshBuffers(void* vertexBuffer, void* indexBuffer, unsigned int stride)
+{
+	if (Filter(COMMAND_SET_MESH_BUFFERS, vertexBuffer == this->vertexBuffer && indexBuffer == this->indexBuffer && stride == this->stride)) {
+		return;
+	}
+	this->vertexBuffer = vertexBuffer;
+	this->indexBuffer = indexBuffer;
+	this->stride = stride;
+	target->SetMeshBuffers(vertexBuffer, indexBuffer, stride);
+}
+
+void StateFilterBackend::DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex)
+{
+	Filter(COMMAND_DRAW_INDEXED, false);
+	target->DrawIndexed(indexCount, startIndex, baseVertex);
+}
+
+const StateFilterStats& StateFilterBackend::GetStats() const
+{
+	return stats;
+}
+
+void StateFilterBackend::ResetStats()
+{
+	memset(&stats, 0, sizeof(stats));
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+#include "CommandBuffer.h"
+#include "ICommandBackend.h"
+
+#define STATE_FILTER_STAGES 2
+#define STATE_FILTER_CONSTANT_SLOTS 14
+#define STATE_FILTER_RESOURCE_SLOTS 128
+#define STATE_FILTER_SAMPLER_SLOTS 16
+
+// Calls passed on to the target and calls dropped as no-ops, indexed by CommandType
+struct StateFilterStats
+{
+	unsigned int Issued[COMMAND_TYPE_COUNT];
+	unsigned int Filtered[COMMAND_TYPE_COUNT];
+
+	unsigned int GetIssued() const;
+	unsigned int GetFiltered() const;
+};
+
+// --------------------------------------------------------
+// Sits in front of another backend and shadows everything
+// bound through it, dropping any call that would leave the
+// pipeline as it already is: the same shaders, states,
+// bindings or mesh, or the same constant data uploaded
+// again to a buffer that's still bound in the same slot.
+// Draws always go through.
+//
+// The shadow only knows about calls made through the
+// filter, so Invalidate has to be called after anything
+// else touches the context (a SimpleShader, one of the
+// batchers), or the filter could drop a call that's no
+// longer a no-op.  Starts out invalidated.
+// --------------------------------------------------------
+class StateFilterBackend : public ICommandBackend
+{
+private:
+	struct ConstantContents
+	{
+		bool Known;
+		std::vector<uint8_t> Data;
+	};
+
+	ICommandBackend* target;
+	StateFilterStats stats;
+
+	// Shadowed state, nullptr means unbound and STATE_UNKNOWN anything at all
+	void* vertexShader;
+	void* inputLayout;
+	void* pixelShader;
+	void* constantBuffers[STATE_FILTER_STAGES][STATE_FILTER_CONSTANT_SLOTS];
+	void* resources[STATE_FILTER_STAGES][STATE_FILTER_RESOURCE_SLOTS];
+	void* samplers[STATE_FILTER_STAGES][STATE_FILTER_SAMPLER_SLOTS];
+	void* blendState;
+	void* rasterizerState;
+	void* depthStencilState;
+	unsigned int stencilRef;
+	void* vertexBuffer;
+	void* indexBuffer;
+	unsigned int stride;
+	std::unordered_map<void*, ConstantContents> constantContents; //last data uploaded to each buffer
+
+	bool Filter(CommandType type, bool redundant);
+public:
+	StateFilterBackend(ICommandBackend* target);
+	void Invalidate();
+
+	void SetVertexShader(void* shader, void* inputLayout);
+	void SetPixelShader(void* shader);
+	void SetConstants(unsigned int stage, unsigned int slot, void* buffer, const void* data, unsigned int size);
+	void SetShaderResource(unsigned int stage, unsigned int slot, void* resource);
+	void SetSampler(unsigned int stage, unsigned int slot, void* sampler);
+	void SetBlendState(void* state);
+	void SetRasterizerState(void* state);
+	void SetDepthStencilState(void* state, unsigned int stencilRef);
+	void SetPipelineState(const PipelineHandles& pipeline);
+	void SetMeshBuffers(void* vertexBuffer, void* indexBuffer, unsigned int stride);
+	void DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex);
+
+	const StateFilterStats& GetStats() const;
+	void ResetStats();
+};
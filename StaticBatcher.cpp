@@ -0,0 +1,196 @@
+#include <float.h>
+#include <math.h>
+#include <map>
+#include <stdint.h>
+#include "StaticBatcher.h"
+#include "DynamicBatcher.h"
+#include "Profiler.h"
+
+using namespace DirectX;
+
+StaticBatcher::StaticBatcher(float chunkSize, unsigned int maxChunkVertices)
+{
+	this->chunkSize = chunkSize > 0 ? chunkSize : 1.0f;
+	this->maxChunkVertices = maxChunkVertices > 0 ? maxChunkVertices : 1;
+	stats = {};
+}
+
+// --------------------------------------------------------
+// Groups the entities by (material, cell), then bakes each
+// group into world-space geometry, splitting any group that
+// goes over maxChunkVertices
+// --------------------------------------------------------
+void StaticBatcher::Build(const RenderObject* objects, unsigned int count, Microsoft::WRL::ComPtr<ID3D11Device> device)
+{
+	chunks.clear();
+	vertexBuffer.Reset();
+	indexBuffer.Reset();
+	stats = {};
+	stats.SourceEntities = count;
+
+	// Material group in the top 16 bits and the cell below it, so ordered iteration keeps each material's chunks together
+	std::vector<Material*> groupMaterials;
+	std::map<uint64_t, std::vector<unsigned int>> groups;
+	for (unsigned int i = 0; i < count; i++) {
+		Material* material = objects[i].RenderMaterial;
+		unsigned int group = (unsigned int)groupMaterials.size();
+		for (unsigned int g = 0; g < groupMaterials.size(); g++) {
+			if (groupMaterials[g]->IsEquivalentTo(material)) {
+				group = g;
+				break;
+			}
+		}
+		if (group == groupMaterials.size()) {
+			groupMaterials.push_back(material);
+		}
+
+		AABB bounds = TransformBounds(objects[i].RenderMesh->GetLocalBounds(), objects[i].World);
+		uint64_t cellX = (uint64_t)((int)floorf(bounds.Center.x / chunkSize) + 0x8000) & 0xFFFF;
+		uint64_t cellY = (uint64_t)((int)floorf(bounds.Center.y / chunkSize) + 0x8000) & 0xFFFF;
+		uint64_t cellZ = (uint64_t)((int)floorf(bounds.Center.z / chunkSize) + 0x8000) & 0xFFFF;
+		uint64_t key = ((uint64_t)(group & 0xFFFF) << 48) | (cellX << 32) | (cellY << 16) | cellZ;
+		groups[key].push_back(i);
+	}
+
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+	for (std::map<uint64_t, std::vector<unsigned int>>::iterator it = groups.begin(); it != groups.end(); ++it) {
+		const std::vector<unsigned int>& members = it->second;
+		StaticChunk chunk = {};
+		XMVECTOR minCorner = XMVectorReplicate(FLT_MAX);
+		XMVECTOR maxCorner = XMVectorReplicate(-FLT_MAX);
+
+		for (int m = 0; m < members.size(); ++m) {
+			const RenderObject& object = objects[members[m]];
+			Mesh* mesh = object.RenderMesh;
+			const std::vector<Vertex>& meshVertices = mesh->GetVertices();
+			const std::vector<unsigned int>& meshIndices = mesh->GetIndices();
+			if (meshVertices.empty() || meshIndices.empty()) {
+				continue;
+			}
+
+			// Close the chunk if this mesh would push it over the limit (a lone oversized mesh still gets its own chunk)
+			unsigned int chunkVertices = (unsigned int)vertices.size() - chunk.BaseVertex;
+			if (chunk.EntityCount > 0 && chunkVertices + meshVertices.size() > maxChunkVertices) {
+				XMStoreFloat3(&chunk.Bounds.Center, (minCorner + maxCorner) * 0.5f);
+				XMStoreFloat3(&chunk.Bounds.Extents, (maxCorner - minCorner) * 0.5f);
+				chunks.push_back(chunk);
+				chunk = {};
+				minCorner = XMVectorReplicate(FLT_MAX);
+				maxCorner = XMVectorReplicate(-FLT_MAX);
+			}
+			if (chunk.EntityCount == 0) {
+				chunk.ChunkMaterial = object.RenderMaterial;
+				chunk.StartIndex = (unsigned int)indices.size();
+				chunk.BaseVertex = (unsigned int)vertices.size();
+			}
+
+			// Same kernel the dynamic batcher runs every frame, here it runs once
+			unsigned int firstVertex = (unsigned int)vertices.size();
+			unsigned int firstIndex = (unsigned int)indices.size();
+			vertices.resize(firstVertex + meshVertices.size());
+			indices.resize(firstIndex + meshIndices.size());
+			DynamicBatcher::MergeMesh(&meshVertices[0], (unsigned int)meshVertices.size(), &meshIndices[0], (unsigned int)meshIndices.size(),
+				object.World, firstVertex - chunk.BaseVertex, &vertices[firstVertex], &indices[firstIndex]);
+
+			AABB bounds = TransformBounds(mesh->GetLocalBounds(), object.World);
+			XMVECTOR center = XMLoadFloat3(&bounds.Center);
+			XMVECTOR extents = XMLoadFloat3(&bounds.Extents);
+			minCorner = XMVectorMin(minCorner, center - extents);
+			maxCorner = XMVectorMax(maxCorner, center + extents);
+			chunk.IndexCount += (unsigned int)meshIndices.size();
+			chunk.EntityCount++;
+		}
+
+		if (chunk.EntityCount > 0) {
+			XMStoreFloat3(&chunk.Bounds.Center, (minCorner + maxCorner) * 0.5f);
+			XMStoreFloat3(&chunk.Bounds.Extents, (maxCorner - minCorner) * 0.5f);
+			chunks.push_back(chunk);
+		}
+	}
+
+	stats.Chunks = (unsigned int)chunks.size();
+	stats.Vertices = (unsigned int)vertices.size();
+	stats.Indices = (unsigned int)indices.size();
+	if (vertices.empty()) {
+		return;
+	}
+
+	D3D11_BUFFER_DESC vbd = {};
+	vbd.Usage = D3D11_USAGE_IMMUTABLE;
+	vbd.ByteWidth = sizeof(Vertex) * (unsigned int)vertices.size();
+	vbd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	D3D11_SUBRESOURCE_DATA initialVertexData = {};
+	initialVertexData.pSysMem = &vertices[0];
+	device->CreateBuffer(&vbd, &initialVertexData, vertexBuffer.GetAddressOf());
+
+	D3D11_BUFFER_DESC ibd = {};
+	ibd.Usage = D3D11_USAGE_IMMUTABLE;
+	ibd.ByteWidth = sizeof(unsigned int) * (unsigned int)indices.size();
+	ibd.BindFlags = D3D11_BIND_INDEX_BUFFER;
+	D3D11_SUBRESOURCE_DATA initialIndexData = {};
+	initialIndexData.pSysMem = &indices[0];
+	device->CreateBuffer(&ibd, &initialIndexData, indexBuffer.GetAddressOf());
+}
+
+void StaticBatcher::Record(std::shared_ptr<Camera> camera, const Frustum& frustum, CommandBuffer& commands)
+{
+	PROFILE_FUNCTION();
+	stats.VisibleChunks = 0;
+	if (!vertexBuffer || !indexBuffer) {
+		return;
+	}
+
+	// The geometry is already in world space
+	XMFLOAT4X4 identity;
+	XMStoreFloat4x4(&identity, XMMatrixIdentity());
+	XMFLOAT4X4 view = camera->GetViewMatrix();
+	XMFLOAT4X4 projection = camera->GetProjectionMatrix();
+
+	// Constants go through private copies, so the shaders themselves are never written while recording
+	bool buffersSet = false;
+	Material* currentMaterial = nullptr;
+	for (int i = 0; i < chunks.size(); ++i) {
+		const StaticChunk& chunk = chunks[i];
+		if (!frustum.Intersects(chunk.Bounds)) {
+			continue;
+		}
+		if (!buffersSet) {
+			commands.SetMeshBuffers(vertexBuffer.Get(), indexBuffer.Get(), sizeof(Vertex));
+			buffersSet = true;
+		}
+		// Chunks are ordered by material, so this mostly happens once per material
+		if (chunk.ChunkMaterial != currentMaterial) {
+			const PipelineState* pipeline = chunk.ChunkMaterial->GetPipelineState().get();
+			pipeline->Record(commands);
+			vsConstants.Reset(pipeline->GetVertexShader().get());
+			psConstants.Reset(pipeline->GetPixelShader().get());
+			vsConstants.SetMatrix4x4("world", identity);
+			vsConstants.SetMatrix4x4("worldInvTranspose", identity);
+			vsConstants.SetMatrix4x4("view", view);
+			vsConstants.SetMatrix4x4("projection", projection);
+			vsConstants.Record(commands, SHADER_STAGE_VERTEX);
+			chunk.ChunkMaterial->RecordResources(commands, psConstants);
+			psConstants.SetFloat4("colorTint", chunk.ChunkMaterial->GetColorTint());
+			psConstants.Record(commands, SHADER_STAGE_PIXEL);
+			currentMaterial = chunk.ChunkMaterial;
+		}
+		commands.DrawIndexed(chunk.IndexCount, chunk.StartIndex, chunk.BaseVertex);
+		stats.VisibleChunks++;
+	}
+}
+
+unsigned int StaticBatcher::GetChunkCount()
+{
+	return (unsigned int)chunks.size();
+}
+
+const StaticChunk& StaticBatcher::GetChunk(unsigned int index)
+{
+	return chunks[index];
+}
+
+const StaticBatchStats& StaticBatcher::GetStats()
+{
+	return stats;
+}
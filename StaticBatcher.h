@@ -0,0 +1,71 @@
+#pragma once
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <memory>
+#include <vector>
+#include "Bounds.h"
+#include "Camera.h"
+#include "CommandBuffer.h"
+#include "Frustum.h"
+#include "RenderObject.h"
+#include "ShaderConstants.h"
+
+// --------------------------------------------------------
+// A piece of merged static geometry: one material, one
+// region of the world, one draw
+// --------------------------------------------------------
+struct StaticChunk
+{
+	Material* ChunkMaterial;
+	AABB Bounds;				// World space, the union of its entities' bounds
+	unsigned int StartIndex;
+	unsigned int IndexCount;
+	unsigned int BaseVertex;
+	unsigned int EntityCount;
+};
+
+struct StaticBatchStats
+{
+	unsigned int SourceEntities;	// Entities merged by Build, i.e. the draws this replaces
+	unsigned int Chunks;
+	unsigned int Vertices;
+	unsigned int Indices;
+	unsigned int VisibleChunks;		// From the last Record, which is also its draw count
+};
+
+// --------------------------------------------------------
+// Bakes entities that never move into combined geometry at
+// load time.  Entities are grouped by material (using
+// Material::IsEquivalentTo, so duplicate materials merge
+// too) and by which chunkSize cell of the world their
+// bounds' center falls in, and each group is transformed
+// into world space once and appended to a single immutable
+// vertex/index buffer pair.
+//
+// Keeping the world split into cells means each chunk
+// still has tight bounds, so Record can frustum cull them;
+// one chunk for the whole level would always be drawn.
+// Chunks draw with their material's pipeline state, so
+// every material needs one (Material::SetPipelineStates).
+// --------------------------------------------------------
+class StaticBatcher
+{
+private:
+	Microsoft::WRL::ComPtr<ID3D11Buffer> vertexBuffer;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> indexBuffer;
+	std::vector<StaticChunk> chunks;
+	ShaderConstants vsConstants;	// Kept between frames so recording doesn't allocate
+	ShaderConstants psConstants;
+	float chunkSize;
+	unsigned int maxChunkVertices;
+	StaticBatchStats stats;
+public:
+	StaticBatcher(float chunkSize = 8.0f, unsigned int maxChunkVertices = 65536);
+	//one object per static entity, they're only read, so they can be thrown away afterwards
+	void Build(const RenderObject* objects, unsigned int count, Microsoft::WRL::ComPtr<ID3D11Device> device);
+	//records every chunk that touches the frustum, after whatever commands already holds
+	void Record(std::shared_ptr<Camera> camera, const Frustum& frustum, CommandBuffer& commands);
+	unsigned int GetChunkCount();
+	const StaticChunk& GetChunk(unsigned int index);
+	const StaticBatchStats& GetStats();
+};
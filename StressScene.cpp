@@ -0,0 +1,158 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sstream>
+#include "StressScene.h"
+
+using namespace DirectX;
+
+// Units of ground per shape, so the field grows with the count instead of getting denser
+#define STRESS_SCENE_AREA_PER_SHAPE 4.0f
+
+static const char* glassMaterials[] = { "redGlass", "greenGlass", "blueGlass", "yellowGlass" };
+
+// --------------------------------------------------------
+// xorshift32, seeded through a round of splitmix so nearby
+// seeds give unrelated sequences
+// --------------------------------------------------------
+class StressRandom
+{
+private:
+	uint32_t state;
+public:
+	StressRandom(uint32_t seed)
+	{
+		uint32_t z = seed + 0x9E3779B9u;
+		z = (z ^ (z >> 16)) * 0x85EBCA6Bu;
+		z = (z ^ (z >> 13)) * 0xC2B2AE35u;
+		state = (z ^ (z >> 16)) | 1;
+	}
+
+	uint32_t Next()
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	}
+
+	//[0, 1)
+	float Float()
+	{
+		return (Next() >> 8) * (1.0f / 16777216.0f);
+	}
+
+	float Range(float min, float max)
+	{
+		return min + (max - min) * Float();
+	}
+};
+
+StressSceneDesc::StressSceneDesc()
+{
+	Spheres = 1000;
+	Cubes = 1000;
+	Tori = 1000;
+	PointLights = 16;
+	TransparentFraction = 0.25f;
+	StaticFraction = 0.0f;
+	Seed = 1;
+}
+
+void StressScene::Generate(const StressSceneDesc& desc, SceneData& scene)
+{
+	scene = SceneData();
+	scene.AmbientColor = XMFLOAT3(0.15f, 0.15f, 0.25f);
+	scene.MeshNames = { "sphere", "cube", "torus" };
+	scene.MaterialNames.push_back("metalHatch");
+	for (int g = 0; g < 4; g++) {
+		scene.MaterialNames.push_back(glassMaterials[g]);
+	}
+
+	StressRandom random(desc.Seed);
+	unsigned int counts[3] = { desc.Spheres, desc.Cubes, desc.Tori };
+	unsigned int total = desc.Spheres + desc.Cubes + desc.Tori;
+	float halfSize = sqrtf(total * STRESS_SCENE_AREA_PER_SHAPE) * 0.5f;
+	scene.Entities.reserve(total);
+	for (uint32_t mesh = 0; mesh < 3; mesh++) {
+		for (unsigned int i = 0; i < counts[mesh]; i++) {
+			SceneEntity entity = {};
+			entity.MeshIndex = mesh;
+			entity.Position = XMFLOAT3(random.Range(-halfSize, halfSize), random.Range(-0.5f, 3.0f), random.Range(-halfSize, halfSize));
+			entity.Rotation = XMFLOAT3(random.Range(0, XM_2PI), random.Range(0, XM_2PI), 0);
+			float scale = random.Range(0.2f, 0.7f);
+			entity.Scale = XMFLOAT3(scale, scale, scale);
+			if (random.Float() < desc.TransparentFraction) {
+				entity.MaterialIndex = 1 + random.Next() % 4;
+			}
+			else if (random.Float() < desc.StaticFraction) {
+				entity.Flags = SCENE_ENTITY_STATIC;
+			}
+			scene.Entities.push_back(entity);
+		}
+	}
+
+	Light sun = {};
+	sun.type = LIGHT_TYPE_DIRECTIONAL;
+	sun.color = XMFLOAT3(1, 1, 1);
+	sun.direction = XMFLOAT3(0.5f, -0.5f, 1);
+	sun.intensity = 0.8f;
+	scene.Lights.push_back(sun);
+	unsigned int pointLights = desc.PointLights;
+	if (pointLights > MAX_LIGHTS - 1) {
+		printf("Stress scene: %u point lights is more than the shaders draw, using %d\n", pointLights, MAX_LIGHTS - 1);
+		pointLights = MAX_LIGHTS - 1;
+	}
+	for (unsigned int i = 0; i < pointLights; i++) {
+		Light light = {};
+		light.type = LIGHT_TYPE_POINT;
+		light.color = XMFLOAT3(random.Float(), random.Float(), random.Float());
+		light.position = XMFLOAT3(random.Range(-halfSize, halfSize), random.Range(0.0f, 3.0f), random.Range(-halfSize, halfSize));
+		light.intensity = 0.8f;
+		light.range = random.Range(2.0f, 6.0f);
+		scene.Lights.push_back(light);
+	}
+}
+
+bool StressScene::Parse(const std::string& text, StressSceneDesc& desc)
+{
+	desc = StressSceneDesc();
+	if (text.find('=') == std::string::npos) {
+		int count = atoi(text.c_str());
+		if (count <= 0) {
+			return false;
+		}
+		desc.Spheres = count / 3 + (count % 3 > 0 ? 1 : 0);
+		desc.Cubes = count / 3 + (count % 3 > 1 ? 1 : 0);
+		desc.Tori = count / 3;
+		return true;
+	}
+
+	std::istringstream stream(text);
+	std::string option;
+	while (std::getline(stream, option, ',')) {
+		size_t equals = option.find('=');
+		if (equals == std::string::npos) {
+			return false;
+		}
+		std::string name = option.substr(0, equals);
+		const char* value = option.c_str() + equals + 1;
+		if (name == "spheres") desc.Spheres = (unsigned int)atoi(value);
+		else if (name == "cubes") desc.Cubes = (unsigned int)atoi(value);
+		else if (name == "tori") desc.Tori = (unsigned int)atoi(value);
+		else if (name == "lights") desc.PointLights = (unsigned int)atoi(value);
+		else if (name == "transparent") desc.TransparentFraction = (float)atof(value);
+		else if (name == "static") desc.StaticFraction = (float)atof(value);
+		else if (name == "seed") desc.Seed = (uint32_t)strtoul(value, nullptr, 10);
+		else return false;
+	}
+	return true;
+}
+
+std::string StressScene::GetName(const StressSceneDesc& desc)
+{
+	char name[160];
+	snprintf(name, sizeof(name), "Stress_%u_%u_%u_l%u_t%d_s%d_seed%u", desc.Spheres, desc.Cubes, desc.Tori, desc.PointLights,
+		(int)(desc.TransparentFraction * 100 + 0.5f), (int)(desc.StaticFraction * 100 + 0.5f), desc.Seed);
+	return name;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include "SceneFile.h"
+
+// --------------------------------------------------------
+// What a stress scene holds.  Shapes are scattered over a
+// square sized to keep the same density at any count.
+// --------------------------------------------------------
+struct StressSceneDesc
+{
+	unsigned int Spheres;
+	unsigned int Cubes;
+	unsigned int Tori;
+	unsigned int PointLights;	// On top of one directional light, Generate makes at most MAX_LIGHTS - 1
+	float TransparentFraction;	// Of the shapes, given one of the glass materials instead of metalHatch
+	float StaticFraction;		// Of the opaque shapes, baked by the static batcher
+	uint32_t Seed;
+
+	StressSceneDesc();
+};
+
+// --------------------------------------------------------
+// Generates scenes with as many entities and lights as
+// asked for, to find where each system stops scaling.
+//
+// The same description always gives the same scene, on any
+// machine: the random numbers come from a generator of its
+// own rather than the standard library's distributions,
+// whose output differs between implementations.
+// --------------------------------------------------------
+class StressScene
+{
+public:
+	static void Generate(const StressSceneDesc& desc, SceneData& scene);
+
+	//"10000" splits that many shapes evenly, or any of
+	//"spheres=N,cubes=N,tori=N,lights=N,transparent=F,static=F,seed=N"
+	static bool Parse(const std::string& text, StressSceneDesc& desc);
+	//a file name without extension that tells descriptions apart, e.g. for caching the generated scene
+	static std::string GetName(const StressSceneDesc& desc);
+};
@@ -25,6 +25,19 @@ struct VertexToPixel
 	float3 worldPosition	: POSITION;
 };
 
+// Same as VertexToPixel, plus the per-instance values the
+// instanced pixel shaders read instead of their cbuffer
+struct InstancedVertexToPixel
+{
+	float4 screenPosition	: SV_POSITION;
+	float2 uv				: TEXCOORD;
+	float3 normal			: NORMAL;
+	float3 tangent			: TANGENT;
+	float3 worldPosition	: POSITION;
+	nointerpolation float4 tint		: TINT;
+	nointerpolation float3 center	: CENTER;
+};
+
 struct SkyBoxVertexToPixel 
 {
 	float4 position	: SV_POSITION;
@@ -49,6 +62,25 @@ struct VertexShaderInput
 	float2 uv				: TEXCOORD;
 };
 
+// VertexShaderInput followed by one InstanceData (InstanceBatcher.h)
+// - Semantics ending in _PER_INSTANCE are read from input slot 1,
+//   stepping once per instance (see SimpleVertexShader)
+// - The world matrix comes in as its four rows, in the same
+//   row-major layout as the C++ XMFLOAT4X4
+struct InstancedVertexShaderInput
+{
+	float3 localPosition	: POSITION;
+	float3 normal			: NORMAL;
+	float3 tangent			: TANGENT;
+	float2 uv				: TEXCOORD;
+	float4 worldRow0		: WORLD_PER_INSTANCE0;
+	float4 worldRow1		: WORLD_PER_INSTANCE1;
+	float4 worldRow2		: WORLD_PER_INSTANCE2;
+	float4 worldRow3		: WORLD_PER_INSTANCE3;
+	float4 tint				: TINT_PER_INSTANCE;
+	float3 center			: CENTER_PER_INSTANCE;
+};
+
 struct Light {
 	int type				: LIGHT_TYPE;
 	float3 direction		: DIRECTION;
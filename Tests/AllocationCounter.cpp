@@ -0,0 +1,35 @@
+#include <stdlib.h>
+#include <new>
+#include "AllocationCounter.h"
+
+static thread_local unsigned long long threadAllocations = 0;
+
+void* operator new(size_t size)
+{
+	threadAllocations++;
+	void* memory = malloc(size > 0 ? size : 1);
+	if (!memory) {
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void operator delete(void* memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	free(memory);
+}
+
+AllocationCounter::AllocationCounter()
+{
+	start = threadAllocations;
+}
+
+unsigned long long AllocationCounter::GetCount() const
+{
+	return threadAllocations - start;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+// --------------------------------------------------------
+// Counts the heap allocations made on the calling thread
+// while it's alive, through a global operator new that the
+// test executable replaces.  For checking that code meant
+// to reuse its buffers stops allocating once it's warm.
+// --------------------------------------------------------
+class AllocationCounter
+{
+private:
+	unsigned long long start;
+public:
+	AllocationCounter();
+	unsigned long long GetCount() const;
+};
@@ -0,0 +1,156 @@
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include "CommandBuffer.h"
+#include "RecordingBackend.h"
+
+// Small integers stand in for resources, the buffer never looks behind them
+static void* Handle(uintptr_t id)
+{
+	return (void*)id;
+}
+
+// One draw's worth of commands, everything told apart by id
+static void RecordDraw(CommandBuffer& commands, uintptr_t id)
+{
+	commands.SetVertexShader(Handle(id), Handle(id + 1));
+	commands.SetPixelShader(Handle(id + 2));
+	float color[3] = { (float)id, 0, 1 };
+	commands.SetConstants(SHADER_STAGE_PIXEL, 0, Handle(id + 3), color, sizeof(color));
+	commands.SetShaderResource(SHADER_STAGE_PIXEL, 1, Handle(id + 4));
+	commands.SetSampler(SHADER_STAGE_PIXEL, 0, Handle(id + 5));
+	commands.SetMeshBuffers(Handle(id + 6), Handle(id + 7), 44);
+	commands.DrawIndexed((unsigned int)id, 3, 2);
+}
+
+static std::vector<std::string> ExpectedDraw(uintptr_t id)
+{
+	std::string n = std::to_string(id);
+	return {
+		"vs " + n + " " + std::to_string(id + 1) + " 0",
+		"ps " + std::to_string(id + 2) + " 0 0",
+		"constants 1 0 " + std::to_string(id + 3),
+		"srv 1 1 " + std::to_string(id + 4),
+		"sampler 1 0 " + std::to_string(id + 5),
+		"mesh " + std::to_string(id + 6) + " " + std::to_string(id + 7) + " 44",
+		"draw " + n + " 3 2",
+	};
+}
+
+TEST(CommandBuffer, ReplaysEveryCommandInOrder)
+{
+	CommandBuffer commands;
+	commands.SetBlendState(Handle(1));
+	commands.SetRasterizerState(Handle(2));
+	commands.SetDepthStencilState(Handle(3), 7);
+	PipelineHandles pipeline = { Handle(11), Handle(12), Handle(13), Handle(14), Handle(15), Handle(16), 0, 0 };
+	commands.SetPipelineState(pipeline);
+	RecordDraw(commands, 100);
+	commands.SetShaderResource(SHADER_STAGE_VERTEX, 2, nullptr);	// Unbinding is just a null handle
+	EXPECT_EQ(12u, commands.GetCommandCount());
+	EXPECT_EQ(0u, commands.GetSize() % 8);
+
+	RecordingBackend backend;
+	EXPECT_TRUE(commands.Replay(backend));
+	std::vector<std::string> expected = { "blend 1 0 0", "rasterizer 2 0 0", "depth 3 7 0", "pipeline 11 12 13", "pipeline states 14 15 16" };
+	std::vector<std::string> draw = ExpectedDraw(100);
+	expected.insert(expected.end(), draw.begin(), draw.end());
+	expected.push_back("srv 0 2 0");
+	EXPECT_EQ(expected, backend.Calls);
+
+	// Replaying doesn't use the buffer up
+	RecordingBackend again;
+	EXPECT_TRUE(commands.Replay(again));
+	EXPECT_EQ(backend.Calls, again.Calls);
+}
+
+TEST(CommandBuffer, ConstantsAreCopiedInline)
+{
+	CommandBuffer commands;
+	uint8_t odd[5] = { 1, 2, 3, 4, 5 };
+	commands.SetConstants(SHADER_STAGE_VERTEX, 1, Handle(9), odd, sizeof(odd));
+	odd[0] = 99;	// The buffer has its own copy
+	uint32_t* reserved = (uint32_t*)commands.SetConstants(SHADER_STAGE_PIXEL, 2, Handle(10), 8);
+	reserved[0] = 0xdeadbeef;
+	reserved[1] = 42;
+	commands.DrawIndexed(6, 0, 0);
+	EXPECT_EQ(0u, commands.GetSize() % 8);
+
+	RecordingBackend backend;
+	EXPECT_TRUE(commands.Replay(backend));
+	ASSERT_EQ(3u, backend.Calls.size());
+	EXPECT_EQ("constants 0 1 9", backend.Calls[0]);
+	EXPECT_EQ("constants 1 2 10", backend.Calls[1]);
+	EXPECT_EQ("draw 6 0 0", backend.Calls[2]);
+	ASSERT_EQ(2u, backend.Constants.size());
+	EXPECT_EQ(std::vector<uint8_t>({ 1, 2, 3, 4, 5 }), backend.Constants[0]);
+	ASSERT_EQ(8u, backend.Constants[1].size());
+	uint32_t words[2];
+	memcpy(words, backend.Constants[1].data(), sizeof(words));
+	EXPECT_EQ(0xdeadbeefu, words[0]);
+	EXPECT_EQ(42u, words[1]);
+}
+
+TEST(CommandBuffer, AppendKeepsTheMergeOrder)
+{
+	// Recorded on threads of their own, merged in the order they're drawn, not the order they finished
+	const unsigned int threadCount = 4;
+	std::vector<CommandBuffer> buffers(threadCount);
+	std::vector<std::thread> threads;
+	for (unsigned int t = 0; t < threadCount; t++) {
+		threads.push_back(std::thread([&buffers, t] {
+			for (uintptr_t d = 0; d < 50; d++) {
+				RecordDraw(buffers[t], 1000 * (t + 1) + 10 * d);
+			}
+		}));
+	}
+	for (unsigned int t = 0; t < threadCount; t++) {
+		threads[t].join();
+	}
+
+	CommandBuffer merged;
+	merged.SetBlendState(Handle(5));
+	unsigned int order[threadCount] = { 2, 0, 3, 1 };
+	for (unsigned int i = 0; i < threadCount; i++) {
+		merged.Append(buffers[order[i]]);
+	}
+	EXPECT_EQ(1u + threadCount * 50 * 7, merged.GetCommandCount());
+
+	std::vector<std::string> expected = { "blend 5 0 0" };
+	for (unsigned int i = 0; i < threadCount; i++) {
+		for (uintptr_t d = 0; d < 50; d++) {
+			std::vector<std::string> draw = ExpectedDraw(1000 * (order[i] + 1) + 10 * d);
+			expected.insert(expected.end(), draw.begin(), draw.end());
+		}
+	}
+	RecordingBackend backend;
+	EXPECT_TRUE(merged.Replay(backend));
+	EXPECT_EQ(expected, backend.Calls);
+	ASSERT_EQ(threadCount * 50, backend.Constants.size());
+	float color[3];
+	memcpy(color, backend.Constants[0].data(), sizeof(color));
+	EXPECT_EQ(3000.0f, color[0]);
+}
+
+TEST(CommandBuffer, ClearEmptiesIt)
+{
+	CommandBuffer commands;
+	RecordDraw(commands, 1);
+	commands.Clear();
+	EXPECT_EQ(0u, commands.GetCommandCount());
+	EXPECT_EQ(0u, commands.GetSize());
+	EXPECT_EQ(nullptr, commands.GetData());
+	RecordingBackend backend;
+	EXPECT_TRUE(commands.Replay(backend));
+	EXPECT_TRUE(backend.Calls.empty());
+
+	// Appending an empty buffer changes nothing
+	RecordDraw(commands, 1);
+	size_t size = commands.GetSize();
+	commands.Append(CommandBuffer());
+	EXPECT_EQ(size, commands.GetSize());
+	EXPECT_EQ(7u, commands.GetCommandCount());
+}
@@ -0,0 +1,138 @@
+#include <math.h>
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+#include <gtest/gtest.h>
+#include "Camera.h"
+#include "DynamicAABBTree.h"
+
+using namespace DirectX;
+
+static std::vector<AABB> MakeBounds(unsigned int count)
+{
+	std::vector<AABB> bounds(count);
+	uint32_t state = 99;
+	for (unsigned int i = 0; i < count; i++) {
+		float values[4];
+		for (int v = 0; v < 4; v++) {
+			state = state * 1664525 + 1013904223;
+			values[v] = (state >> 8) / 16777216.0f;
+		}
+		bounds[i].Center = XMFLOAT3(values[0] * 200 - 100, values[1] * 20 - 10, values[2] * 200 - 100);
+		float extent = 0.5f + values[3];
+		bounds[i].Extents = XMFLOAT3(extent, extent, extent);
+	}
+	return bounds;
+}
+
+// The tree may add false positives from fat boxes, but must never miss anything
+static void ExpectNoMisses(DynamicAABBTree& tree, const std::vector<int>& proxies, const std::vector<AABB>& bounds)
+{
+	Camera camera(Transform(0, 0, -120, 0, 0, 0, 1, 1, 1), 1.0f);
+	Frustum frustum(camera.GetViewMatrix(), camera.GetProjectionMatrix());
+	std::vector<int> inFrustum;
+	tree.QueryFrustum(frustum, inFrustum);
+	std::sort(inFrustum.begin(), inFrustum.end());
+
+	XMFLOAT3 center(10, 0, -5);
+	std::vector<int> inSphere;
+	tree.QuerySphere(center, 15, inSphere);
+	std::sort(inSphere.begin(), inSphere.end());
+
+	for (unsigned int i = 0; i < bounds.size(); i++) {
+		if (frustum.Intersects(bounds[i])) {
+			EXPECT_TRUE(std::binary_search(inFrustum.begin(), inFrustum.end(), proxies[i])) << i;
+		}
+		float dx = fmaxf(fabsf(center.x - bounds[i].Center.x) - bounds[i].Extents.x, 0.0f);
+		float dy = fmaxf(fabsf(center.y - bounds[i].Center.y) - bounds[i].Extents.y, 0.0f);
+		float dz = fmaxf(fabsf(center.z - bounds[i].Center.z) - bounds[i].Extents.z, 0.0f);
+		if (dx * dx + dy * dy + dz * dz <= 15 * 15) {
+			EXPECT_TRUE(std::binary_search(inSphere.begin(), inSphere.end(), proxies[i])) << i;
+		}
+	}
+}
+
+TEST(DynamicAABBTree, QueriesFindEverything)
+{
+	std::vector<AABB> bounds = MakeBounds(2000);
+	DynamicAABBTree tree;
+	std::vector<int> proxies;
+	for (unsigned int i = 0; i < bounds.size(); i++) {
+		proxies.push_back(tree.CreateProxy(bounds[i], &bounds[i]));
+	}
+	EXPECT_EQ(2000, tree.GetProxyCount());
+	EXPECT_EQ(&bounds[7], tree.GetUserData(proxies[7]));
+	ExpectNoMisses(tree, proxies, bounds);
+}
+
+TEST(DynamicAABBTree, SmallMovesStayInTheFatBox)
+{
+	DynamicAABBTree tree(0.5f);
+	AABB box;
+	box.Center = XMFLOAT3(0, 0, 0);
+	box.Extents = XMFLOAT3(1, 1, 1);
+	int proxy = tree.CreateProxy(box, nullptr);
+	box.Center.x = 0.25f;
+	EXPECT_FALSE(tree.MoveProxy(proxy, box));
+	box.Center.x = 2.0f;
+	EXPECT_TRUE(tree.MoveProxy(proxy, box));
+	AABB fat = tree.GetFatBounds(proxy);
+	EXPECT_FLOAT_EQ(2.0f, fat.Center.x);
+	EXPECT_FLOAT_EQ(1.5f, fat.Extents.x);
+}
+
+// Entities that travel across the world are reinserted where they end up,
+// so the tree stays as shallow as a freshly built one
+TEST(DynamicAABBTree, MovedProxiesAreReinserted)
+{
+	std::vector<AABB> bounds = MakeBounds(2000);
+	DynamicAABBTree tree;
+	std::vector<int> proxies;
+	for (unsigned int i = 0; i < bounds.size(); i++) {
+		proxies.push_back(tree.CreateProxy(bounds[i], nullptr));
+	}
+	float builtArea = tree.GetTotalArea();
+
+	for (int frame = 0; frame < 50; frame++) {
+		for (unsigned int i = 0; i < bounds.size(); i++) {
+			bounds[i].Center.x += (i & 1) ? 1.5f : -1.5f;
+			bounds[i].Center.x = bounds[i].Center.x > 100 ? bounds[i].Center.x - 200 : bounds[i].Center.x < -100 ? bounds[i].Center.x + 200 : bounds[i].Center.x;
+			tree.MoveProxy(proxies[i], bounds[i]);
+		}
+	}
+	ExpectNoMisses(tree, proxies, bounds);
+	EXPECT_LT(tree.GetTotalArea(), builtArea * 2);
+	EXPECT_LT(tree.GetHeight(), 40);
+
+	for (unsigned int i = 0; i < bounds.size(); i += 2) {
+		tree.DestroyProxy(proxies[i]);
+	}
+	EXPECT_EQ(1000, tree.GetProxyCount());
+}
+
+// Ray batches come back in the order asked, the same as one ray at a time
+TEST(DynamicAABBTree, RayBatchesMatchSingleRays)
+{
+	std::vector<AABB> bounds = MakeBounds(2000);
+	DynamicAABBTree tree;
+	for (unsigned int i = 0; i < bounds.size(); i++) {
+		tree.CreateProxy(bounds[i], nullptr);
+	}
+	XMFLOAT3 origins[3] = { XMFLOAT3(-150, 0, 0), XMFLOAT3(0, 50, 0), bounds[5].Center };
+	XMFLOAT3 directions[3] = { XMFLOAT3(1, 0, 0), XMFLOAT3(0, -1, 0.01f), XMFLOAT3(0, 0, 1) };
+	float maxDistances[3] = { 300, 100, 1 };
+	std::vector<int> batch;
+	std::vector<unsigned int> offsets;
+	tree.QueryRays(origins, directions, maxDistances, 3, batch, offsets);
+	ASSERT_EQ(4u, offsets.size());
+	for (unsigned int q = 0; q < 3; q++) {
+		std::vector<int> single;
+		tree.QueryRay(origins[q], directions[q], maxDistances[q], single);
+		std::vector<int> fromBatch(batch.begin() + offsets[q], batch.begin() + offsets[q + 1]);
+		std::sort(single.begin(), single.end());
+		std::sort(fromBatch.begin(), fromBatch.end());
+		EXPECT_EQ(single, fromBatch) << q;
+	}
+	// Starting inside a box always hits it
+	EXPECT_GT(offsets[3], offsets[2]);
+}
@@ -0,0 +1,50 @@
+#include <math.h>
+#include <gtest/gtest.h>
+#include "DynamicBatcher.h"
+
+using namespace DirectX;
+
+// A slanted triangle: its normal isn't along any axis, so a non-uniform scale tilts it
+static void MakeTriangle(Vertex vertices[3], unsigned int indices[3])
+{
+	XMFLOAT3 positions[3] = { XMFLOAT3(0, 0, 0), XMFLOAT3(1, 1, 0), XMFLOAT3(0, 1, 1) };
+	XMVECTOR edge1 = XMLoadFloat3(&positions[1]) - XMLoadFloat3(&positions[0]);
+	XMVECTOR edge2 = XMLoadFloat3(&positions[2]) - XMLoadFloat3(&positions[0]);
+	XMFLOAT3 normal;
+	XMStoreFloat3(&normal, XMVector3Normalize(XMVector3Cross(edge1, edge2)));
+	XMFLOAT3 tangent;
+	XMStoreFloat3(&tangent, XMVector3Normalize(edge1));
+	for (int i = 0; i < 3; i++) {
+		vertices[i].Position = positions[i];
+		vertices[i].Normal = normal;
+		vertices[i].Tangent = tangent;
+		vertices[i].UV = XMFLOAT2((float)i, 0.5f);
+		indices[i] = i;
+	}
+}
+
+TEST(DynamicBatcher, MergedNormalsStayPerpendicularUnderNonUniformScale)
+{
+	Vertex vertices[3];
+	unsigned int indices[3];
+	MakeTriangle(vertices, indices);
+	XMFLOAT4X4 world;
+	XMStoreFloat4x4(&world, XMMatrixScaling(4, 1, 0.5f) * XMMatrixRotationRollPitchYaw(0.3f, 1.1f, 0) * XMMatrixTranslation(5, -2, 7));
+
+	Vertex merged[3];
+	unsigned int mergedIndices[3];
+	DynamicBatcher::MergeMesh(vertices, 3, indices, 3, world, 10, merged, mergedIndices);
+
+	XMVECTOR edge1 = XMLoadFloat3(&merged[1].Position) - XMLoadFloat3(&merged[0].Position);
+	XMVECTOR edge2 = XMLoadFloat3(&merged[2].Position) - XMLoadFloat3(&merged[0].Position);
+	for (int i = 0; i < 3; i++) {
+		XMVECTOR normal = XMVector3Normalize(XMLoadFloat3(&merged[i].Normal));
+		EXPECT_NEAR(0.0f, XMVectorGetX(XMVector3Dot(normal, XMVector3Normalize(edge1))), 1e-4f) << i;
+		EXPECT_NEAR(0.0f, XMVectorGetX(XMVector3Dot(normal, XMVector3Normalize(edge2))), 1e-4f) << i;
+		// The tangent lies along the surface, so it follows the first edge
+		XMVECTOR tangent = XMVector3Normalize(XMLoadFloat3(&merged[i].Tangent));
+		EXPECT_NEAR(1.0f, XMVectorGetX(XMVector3Dot(tangent, XMVector3Normalize(edge1))), 1e-4f) << i;
+		EXPECT_EQ(vertices[i].UV.x, merged[i].UV.x);
+		EXPECT_EQ(10u + i, mergedIndices[i]);
+	}
+}
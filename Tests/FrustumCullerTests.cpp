@@ -0,0 +1,139 @@
+#include <math.h>
+#include <stdint.h>
+#include <vector>
+#include <gtest/gtest.h>
+#include "Camera.h"
+#include "Frustum.h"
+#include "FrustumCuller.h"
+#include "JobSystem.h"
+
+using namespace DirectX;
+
+// The default camera at the origin looking down +Z, near 0.01, far 1000
+static Frustum MakeFrustum()
+{
+	Camera camera(Transform(0, 0, 0, 0, 0, 0, 1, 1, 1), 1.0f);
+	return Frustum(camera.GetViewMatrix(), camera.GetProjectionMatrix());
+}
+
+static AABB MakeBox(float x, float y, float z, float extent)
+{
+	AABB box;
+	box.Center = XMFLOAT3(x, y, z);
+	box.Extents = XMFLOAT3(extent, extent, extent);
+	return box;
+}
+
+// Scattered around the camera, in front and behind, the same every run
+static std::vector<AABB> MakeBoxes(unsigned int count)
+{
+	std::vector<AABB> boxes(count);
+	uint32_t state = 7;
+	for (unsigned int i = 0; i < count; i++) {
+		float values[4];
+		for (int v = 0; v < 4; v++) {
+			state = state * 1664525 + 1013904223;
+			values[v] = (state >> 8) / 16777216.0f;
+		}
+		boxes[i] = MakeBox(values[0] * 400 - 200, values[1] * 400 - 200, values[2] * 1400 - 200, values[3] * 10);
+	}
+	return boxes;
+}
+
+static std::vector<unsigned int> ScalarVisible(const Frustum& frustum, const std::vector<AABB>& boxes)
+{
+	std::vector<unsigned int> visible;
+	for (unsigned int i = 0; i < boxes.size(); i++) {
+		if (frustum.Intersects(boxes[i])) {
+			visible.push_back(i);
+		}
+	}
+	return visible;
+}
+
+TEST(Frustum, PlanesComeFromTheCamera)
+{
+	Frustum frustum = MakeFrustum();
+	EXPECT_TRUE(frustum.Intersects(MakeBox(0, 0, 10, 1)));
+	EXPECT_FALSE(frustum.Intersects(MakeBox(0, 0, -10, 1)));		// Behind
+	EXPECT_FALSE(frustum.Intersects(MakeBox(100, 0, 10, 1)));		// Off to the right
+	EXPECT_FALSE(frustum.Intersects(MakeBox(0, -100, 10, 1)));		// Below
+	EXPECT_FALSE(frustum.Intersects(MakeBox(0, 0, 1100, 1)));		// Past the far plane
+	EXPECT_TRUE(frustum.Intersects(MakeBox(0, 0, 1000, 5)));		// Across the far plane
+	EXPECT_TRUE(frustum.Intersects(MakeBox(0, 0, 0, 0.5f)));		// Around the eye, across the near plane
+	EXPECT_TRUE(frustum.Intersects(MakeBox(12, 0, 10, 7)));			// Across the right plane
+}
+
+TEST(Frustum, BoundsHoldTheCorners)
+{
+	// The far plane comes out of the projection matrix a unit or two short in floats
+	AABB bounds = MakeFrustum().GetBounds();
+	float halfHeight = 1000 * tanf(0.5f);	// A one radian field of view, square
+	EXPECT_NEAR(0.0f, bounds.Center.x, 1e-2f);
+	EXPECT_NEAR(0.0f, bounds.Center.y, 1e-2f);
+	EXPECT_NEAR(0.01f, bounds.Center.z - bounds.Extents.z, 1e-3f);
+	EXPECT_NEAR(1000.0f, bounds.Center.z + bounds.Extents.z, 2.0f);
+	EXPECT_NEAR(halfHeight, bounds.Extents.x, 2.0f);
+	EXPECT_NEAR(halfHeight, bounds.Extents.y, 2.0f);
+}
+
+TEST(FrustumCuller, MatchesTheScalarTest)
+{
+	Frustum frustum = MakeFrustum();
+	std::vector<AABB> boxes = MakeBoxes(1003);	// Not a multiple of the batch size, so the last batch is padded
+	FrustumCuller culler;
+	for (unsigned int i = 0; i < boxes.size(); i++) {
+		EXPECT_EQ(i, culler.Add(boxes[i]));
+	}
+
+	std::vector<unsigned int> visible;
+	unsigned int count = culler.Cull(frustum, visible);
+	std::vector<unsigned int> expected = ScalarVisible(frustum, boxes);
+	EXPECT_EQ(expected, visible);
+	EXPECT_EQ(expected.size(), count);
+	EXPECT_GT(count, 0u);
+	EXPECT_LT(count, boxes.size());
+
+	const CullStats& stats = culler.GetStats();
+	EXPECT_EQ(boxes.size(), stats.Tested);
+	EXPECT_EQ(count, stats.Visible);
+	EXPECT_EQ(stats.Tested - stats.Visible, stats.Culled);
+	EXPECT_FLOAT_EQ((float)stats.Culled / stats.Tested, stats.CullRate);
+}
+
+TEST(FrustumCuller, JobsGiveTheSameResult)
+{
+	Frustum frustum = MakeFrustum();
+	std::vector<AABB> boxes = MakeBoxes(20000);	// Enough batches to be split into several jobs
+	FrustumCuller culler;
+	culler.Reserve((unsigned int)boxes.size());
+	for (unsigned int i = 0; i < boxes.size(); i++) {
+		culler.Add(boxes[i]);
+	}
+	std::vector<unsigned int> serial;
+	culler.Cull(frustum, serial);
+
+	JobSystem jobs(3);
+	culler.SetJobSystem(&jobs);
+	std::vector<unsigned int> parallel;
+	culler.Cull(frustum, parallel);
+	EXPECT_EQ(serial, parallel);
+	EXPECT_EQ(ScalarVisible(frustum, boxes), parallel);
+}
+
+TEST(FrustumCuller, ClearEmptiesIt)
+{
+	Frustum frustum = MakeFrustum();
+	FrustumCuller culler;
+	culler.Add(MakeBox(0, 0, 10, 1));
+	culler.Clear();
+	EXPECT_EQ(0u, culler.GetCount());
+
+	std::vector<unsigned int> visible(3, 0);
+	EXPECT_EQ(0u, culler.Cull(frustum, visible));
+	EXPECT_TRUE(visible.empty());
+	EXPECT_EQ(0.0f, culler.GetStats().CullRate);
+
+	EXPECT_EQ(0u, culler.Add(MakeBox(0, 0, 10, 1)));
+	EXPECT_EQ(1u, culler.Cull(frustum, visible));
+}
@@ -0,0 +1,168 @@
+#include <stdint.h>
+#include <string.h>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <gtest/gtest.h>
+#include "InputRecording.h"
+
+// Where InputRecording keeps what the corruption tests overwrite
+#define HEADER_VERSION 4
+#define HEADER_FRAME_COUNT 8
+#define HEADER_SIZE 12
+#define FIRST_FRAME_CHANGED_KEYS (HEADER_SIZE + 20)
+
+static std::string TempPath(const char* name)
+{
+	return ::testing::TempDir() + "InputRecordingTests_" + name;
+}
+
+static std::string ReadFile(const std::string& fileName)
+{
+	std::ifstream file(fileName, std::ios::binary);
+	return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+static void WriteFile(const std::string& fileName, const std::string& contents)
+{
+	std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+	file.write(contents.data(), contents.size());
+}
+
+static void SetKey(InputFrame& frame, int key, bool down)
+{
+	if (down) {
+		frame.KeysDown[key / 8] |= 1 << (key % 8);
+	}
+	else {
+		frame.KeysDown[key / 8] &= ~(1 << (key % 8));
+	}
+}
+
+// Keys held across frames, pressed and released, mouse moving and the wheel now and then
+static InputRecording MakeRecording(unsigned int frameCount)
+{
+	InputRecording recording;
+	InputFrame frame = {};
+	for (unsigned int f = 0; f < frameCount; f++) {
+		frame.DeltaTime = 1.0f / 60 + 0.0001f * (f % 7);
+		frame.TotalTime += frame.DeltaTime;
+		frame.MouseX = 400 + (int)(f * 3) - (int)(f % 11) * 5;
+		frame.MouseY = 300 - (int)(f % 13);
+		frame.Wheel = f % 17 == 0 ? 120.0f : 0.0f;
+		SetKey(frame, 'W', f % 40 < 25);
+		SetKey(frame, 0x10, f >= 10 && f < 90);	// Shift, held for a while
+		SetKey(frame, 0xFF, f % 2 == 0);		// The last key code, every other frame
+		recording.AddFrame(frame);
+	}
+	return recording;
+}
+
+static void ExpectSameFrames(const InputRecording& expected, const InputRecording& actual)
+{
+	ASSERT_EQ(expected.GetFrameCount(), actual.GetFrameCount());
+	for (unsigned int f = 0; f < expected.GetFrameCount(); f++) {
+		const InputFrame& a = expected.GetFrame(f);
+		const InputFrame& b = actual.GetFrame(f);
+		EXPECT_EQ(a.DeltaTime, b.DeltaTime) << f;
+		EXPECT_EQ(a.TotalTime, b.TotalTime) << f;
+		EXPECT_EQ(a.MouseX, b.MouseX) << f;
+		EXPECT_EQ(a.MouseY, b.MouseY) << f;
+		EXPECT_EQ(a.Wheel, b.Wheel) << f;
+		EXPECT_EQ(0, memcmp(a.KeysDown, b.KeysDown, sizeof(a.KeysDown))) << f;
+	}
+}
+
+TEST(InputRecording, RoundTripsByteForByte)
+{
+	InputRecording recorded = MakeRecording(200);
+	std::string fileName = TempPath("roundtrip.inp");
+	ASSERT_TRUE(recorded.Save(fileName));
+
+	InputRecording loaded;
+	ASSERT_TRUE(loaded.Load(fileName));
+	ExpectSameFrames(recorded, loaded);
+
+	// Saving what was loaded gives back the same file
+	std::string resavedName = TempPath("resaved.inp");
+	ASSERT_TRUE(loaded.Save(resavedName));
+	std::string original = ReadFile(fileName);
+	EXPECT_FALSE(original.empty());
+	EXPECT_EQ(original, ReadFile(resavedName));
+
+	// Only the keys that changed are stored, a held key costs nothing after the frame it went down
+	EXPECT_LT(original.size(), HEADER_SIZE + 200 * (22 + 3u));
+}
+
+TEST(InputRecording, EmptyRecordingRoundTrips)
+{
+	InputRecording empty;
+	std::string fileName = TempPath("empty.inp");
+	ASSERT_TRUE(empty.Save(fileName));
+	EXPECT_EQ((size_t)HEADER_SIZE, ReadFile(fileName).size());
+	InputRecording loaded = MakeRecording(3);
+	ASSERT_TRUE(loaded.Load(fileName));
+	EXPECT_EQ(0u, loaded.GetFrameCount());
+}
+
+template <typename T>
+static void Overwrite(std::string& bytes, size_t offset, T value)
+{
+	memcpy(&bytes[offset], &value, sizeof(T));
+}
+
+// Saves a recording, lets corrupt() change the bytes, and expects Load to turn the result down
+template <typename Corrupt>
+static void ExpectLoadFails(const char* name, Corrupt corrupt)
+{
+	std::string fileName = TempPath(name);
+	ASSERT_TRUE(MakeRecording(20).Save(fileName));
+	std::string bytes = ReadFile(fileName);
+	corrupt(bytes);
+	WriteFile(fileName, bytes);
+
+	InputRecording recording = MakeRecording(5);
+	EXPECT_FALSE(recording.Load(fileName)) << name;
+	EXPECT_EQ(0u, recording.GetFrameCount()) << name;
+}
+
+TEST(InputRecording, DamagedFilesAreRejected)
+{
+	ExpectLoadFails("empty.inp", [](std::string& bytes) { bytes.clear(); });
+	ExpectLoadFails("header.inp", [](std::string& bytes) { bytes.resize(HEADER_SIZE - 2); });
+	ExpectLoadFails("truncated.inp", [](std::string& bytes) { bytes.resize(bytes.size() - 1); });
+	ExpectLoadFails("midframe.inp", [](std::string& bytes) { bytes.resize(HEADER_SIZE + 10); });
+	ExpectLoadFails("trailing.inp", [](std::string& bytes) { bytes += "extra"; });
+	ExpectLoadFails("magic.inp", [](std::string& bytes) { bytes[0] ^= 0x20; });
+	ExpectLoadFails("version.inp", [](std::string& bytes) { Overwrite<uint32_t>(bytes, HEADER_VERSION, 99); });
+	ExpectLoadFails("fewer.inp", [](std::string& bytes) { Overwrite<uint32_t>(bytes, HEADER_FRAME_COUNT, 19); });
+	ExpectLoadFails("more.inp", [](std::string& bytes) { Overwrite<uint32_t>(bytes, HEADER_FRAME_COUNT, 0xffffffff); });
+	ExpectLoadFails("keys.inp", [](std::string& bytes) { Overwrite<uint16_t>(bytes, FIRST_FRAME_CHANGED_KEYS, 300); });
+
+	InputRecording missing;
+	EXPECT_FALSE(missing.Load(TempPath("missing.inp")));
+}
+
+// Playing a recording back through Input reproduces what was recorded from it
+TEST(InputRecording, PlaybackMatchesTheRecording)
+{
+	InputRecording recording = MakeRecording(100);
+	Input& input = Input::GetInstance();
+	input.Initialize(0);
+	for (unsigned int f = 0; f < recording.GetFrameCount(); f++) {
+		const InputFrame& recorded = recording.GetFrame(f);
+		input.SetFrame(recorded);
+		InputFrame played = {};
+		input.GetFrame(played);
+		EXPECT_EQ(0, memcmp(recorded.KeysDown, played.KeysDown, sizeof(played.KeysDown))) << f;
+		EXPECT_EQ(recorded.MouseX, played.MouseX) << f;
+		EXPECT_EQ(recorded.MouseY, played.MouseY) << f;
+		EXPECT_EQ(recorded.Wheel, played.Wheel) << f;
+		EXPECT_EQ(f == 10, input.KeyPress(0x10)) << f;
+		EXPECT_EQ(f == 90, input.KeyRelease(0x10)) << f;
+		if (f > 0) {
+			EXPECT_EQ(recorded.MouseX - recording.GetFrame(f - 1).MouseX, input.GetMouseXDelta()) << f;
+		}
+		input.EndOfFrame();
+	}
+}
@@ -0,0 +1,229 @@
+#include <string.h>
+#include <memory>
+#include <vector>
+#include <gtest/gtest.h>
+#include "InstanceBatcher.h"
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Records what Submit hands the draw target, in order
+// --------------------------------------------------------
+class RecordingTarget : public IInstanceDrawTarget
+{
+public:
+	std::vector<InstanceData> Uploaded;
+	std::vector<InstanceBatch> Drawn;
+	unsigned int Uploads = 0;
+	unsigned int DrawsBeforeUpload = 0;
+
+	void UploadInstances(const InstanceData* instances, unsigned int count)
+	{
+		Uploads++;
+		Uploaded.assign(instances, instances + count);
+	}
+
+	void DrawBatch(const InstanceBatch& batch)
+	{
+		if (Uploads == 0) {
+			DrawsBeforeUpload++;
+		}
+		Drawn.push_back(batch);
+	}
+};
+
+// --------------------------------------------------------
+// Two meshes and three materials: lit and litRed share
+// instanced shaders and differ only by tint, plain has no
+// instanced shaders.  The batcher only compares mesh
+// pointers, so the meshes are never built; the shaders fail
+// to load without a device, which doesn't matter either,
+// only whether two materials share them.
+// --------------------------------------------------------
+class InstanceBatcherTest : public ::testing::Test
+{
+protected:
+	int meshStorage[2];
+	Mesh* cube;
+	Mesh* sphere;
+	std::unique_ptr<Material> lit;
+	std::unique_ptr<Material> litRed;
+	std::unique_ptr<Material> plain;
+	std::vector<RenderObject> objects;
+
+	void SetUp()
+	{
+		cube = reinterpret_cast<Mesh*>(&meshStorage[0]);
+		sphere = reinterpret_cast<Mesh*>(&meshStorage[1]);
+		std::shared_ptr<SimpleVertexShader> vertexShader = std::make_shared<SimpleVertexShader>(nullptr, nullptr, L"VertexShader.cso");
+		std::shared_ptr<SimplePixelShader> pixelShader = std::make_shared<SimplePixelShader>(nullptr, nullptr, L"PixelShader.cso");
+		std::shared_ptr<SimpleVertexShader> instancedVertexShader = std::make_shared<SimpleVertexShader>(nullptr, nullptr, L"InstancedVertexShader.cso");
+		std::shared_ptr<SimplePixelShader> instancedPixelShader = std::make_shared<SimplePixelShader>(nullptr, nullptr, L"InstancedPixelShader.cso");
+		lit.reset(new Material(XMFLOAT4(1, 1, 1, 1), vertexShader, pixelShader));
+		lit->SetInstancedShaders(instancedVertexShader, instancedPixelShader);
+		litRed.reset(new Material(XMFLOAT4(1, 0, 0, 1), vertexShader, pixelShader));
+		litRed->SetInstancedShaders(instancedVertexShader, instancedPixelShader);
+		plain.reset(new Material(XMFLOAT4(0, 0, 1, 1), vertexShader, pixelShader));
+	}
+
+	void Add(Mesh* mesh, Material* material)
+	{
+		RenderObject object;
+		object.RenderMesh = mesh;
+		object.RenderMaterial = material;
+		float x = (float)objects.size();
+		XMStoreFloat4x4(&object.World, XMMatrixTranslation(x, 0, 0));
+		object.Position = XMFLOAT3(x, 0, 0);
+		objects.push_back(object);
+	}
+
+	std::vector<const RenderObject*> Pointers()
+	{
+		std::vector<const RenderObject*> pointers;
+		for (unsigned int i = 0; i < objects.size(); i++) {
+			pointers.push_back(&objects[i]);
+		}
+		return pointers;
+	}
+};
+
+TEST_F(InstanceBatcherTest, KeepOrderOnlyMergesNeighbours)
+{
+	Add(cube, lit.get());
+	Add(cube, litRed.get());
+	Add(sphere, lit.get());
+	Add(cube, lit.get());
+	Add(cube, plain.get());
+	Add(cube, plain.get());
+	std::vector<const RenderObject*> pointers = Pointers();
+
+	InstanceBatcher batcher;
+	batcher.Build(pointers.data(), (unsigned int)pointers.size(), true);
+	const std::vector<InstanceBatch>& batches = batcher.GetBatches();
+	ASSERT_EQ(5u, batches.size());
+	unsigned int expectedCounts[] = { 2, 1, 1, 1, 1 };
+	unsigned int expectedFirst[] = { 0, 2, 3, 4, 5 };
+	bool expectedInstanced[] = { true, true, true, false, false };
+	for (unsigned int b = 0; b < batches.size(); b++) {
+		EXPECT_EQ(expectedCounts[b], batches[b].InstanceCount);
+		EXPECT_EQ(expectedFirst[b], batches[b].FirstInstance);
+		EXPECT_EQ(expectedInstanced[b], batches[b].Instanced);
+		EXPECT_EQ(&objects[expectedFirst[b]], batches[b].FirstObject);
+	}
+	EXPECT_EQ(sphere, batches[1].SharedMesh);
+	EXPECT_EQ(lit.get(), batches[0].SharedMaterial);
+
+	// In order, instances are packed in object order
+	const std::vector<InstanceData>& instances = batcher.GetInstances();
+	ASSERT_EQ(objects.size(), instances.size());
+	for (unsigned int i = 0; i < objects.size(); i++) {
+		EXPECT_EQ((float)i, instances[i].Center.x);
+	}
+
+	const InstanceBatcherStats& stats = batcher.GetStats();
+	EXPECT_EQ(6u, stats.Objects);
+	EXPECT_EQ(5u, stats.Batches);
+	EXPECT_EQ(3u, stats.InstancedBatches);
+	EXPECT_EQ(2u, stats.LargestBatch);
+}
+
+TEST_F(InstanceBatcherTest, WithoutOrderEveryCompatibleObjectShares)
+{
+	Add(cube, lit.get());
+	Add(sphere, lit.get());
+	Add(cube, plain.get());
+	Add(cube, litRed.get());
+	Add(sphere, litRed.get());
+	Add(cube, plain.get());
+	Add(cube, lit.get());
+	std::vector<const RenderObject*> pointers = Pointers();
+
+	InstanceBatcher batcher;
+	batcher.Build(pointers.data(), (unsigned int)pointers.size(), false);
+	const std::vector<InstanceBatch>& batches = batcher.GetBatches();
+
+	// Batches come in the order first seen; objects without instanced shaders are one per batch
+	ASSERT_EQ(4u, batches.size());
+	EXPECT_EQ(cube, batches[0].SharedMesh);
+	EXPECT_EQ(3u, batches[0].InstanceCount);
+	EXPECT_EQ(sphere, batches[1].SharedMesh);
+	EXPECT_EQ(2u, batches[1].InstanceCount);
+	EXPECT_FALSE(batches[2].Instanced);
+	EXPECT_EQ(&objects[2], batches[2].FirstObject);
+	EXPECT_FALSE(batches[3].Instanced);
+	EXPECT_EQ(&objects[5], batches[3].FirstObject);
+	for (unsigned int b = 0; b < batches.size(); b++) {
+		EXPECT_TRUE(batches[b].Instanced || batches[b].InstanceCount == 1);
+	}
+
+	// Each batch's instances are contiguous, in object order within the batch
+	const std::vector<InstanceData>& instances = batcher.GetInstances();
+	float expectedCenters[] = { 0, 3, 6, 1, 4, 2, 5 };
+	unsigned int expectedFirst[] = { 0, 3, 5, 6 };
+	ASSERT_EQ(7u, instances.size());
+	for (unsigned int i = 0; i < instances.size(); i++) {
+		EXPECT_EQ(expectedCenters[i], instances[i].Center.x);
+	}
+	for (unsigned int b = 0; b < batches.size(); b++) {
+		EXPECT_EQ(expectedFirst[b], batches[b].FirstInstance);
+	}
+}
+
+TEST_F(InstanceBatcherTest, PacksWorldTintAndCenter)
+{
+	Add(cube, lit.get());
+	Add(cube, litRed.get());
+	objects[1].Position = XMFLOAT3(4, 5, 6);
+	XMStoreFloat4x4(&objects[1].World, XMMatrixScaling(2, 3, 4));
+	std::vector<const RenderObject*> pointers = Pointers();
+
+	InstanceBatcher batcher;
+	batcher.Build(pointers.data(), (unsigned int)pointers.size(), true);
+	ASSERT_EQ(1u, batcher.GetBatches().size());
+	const InstanceData& instance = batcher.GetInstances()[1];
+	EXPECT_EQ(0, memcmp(&objects[1].World, &instance.World, sizeof(XMFLOAT4X4)));
+	EXPECT_EQ(1.0f, instance.Tint.x);
+	EXPECT_EQ(0.0f, instance.Tint.y);
+	EXPECT_EQ(0.0f, instance.Tint.z);
+	EXPECT_EQ(1.0f, instance.Tint.w);
+	EXPECT_EQ(4.0f, instance.Center.x);
+	EXPECT_EQ(5.0f, instance.Center.y);
+	EXPECT_EQ(6.0f, instance.Center.z);
+}
+
+TEST_F(InstanceBatcherTest, SubmitUploadsOnceThenDrawsInOrder)
+{
+	Add(cube, lit.get());
+	Add(cube, plain.get());
+	Add(sphere, lit.get());
+	Add(cube, litRed.get());
+	std::vector<const RenderObject*> pointers = Pointers();
+
+	InstanceBatcher batcher;
+	batcher.Build(pointers.data(), (unsigned int)pointers.size(), false);
+	RecordingTarget target;
+	batcher.Submit(target);
+	EXPECT_EQ(1u, target.Uploads);
+	EXPECT_EQ(0u, target.DrawsBeforeUpload);
+	ASSERT_EQ(batcher.GetInstances().size(), target.Uploaded.size());
+	EXPECT_EQ(0, memcmp(batcher.GetInstances().data(), target.Uploaded.data(), target.Uploaded.size() * sizeof(InstanceData)));
+
+	const std::vector<InstanceBatch>& batches = batcher.GetBatches();
+	ASSERT_EQ(batches.size(), target.Drawn.size());
+	for (unsigned int b = 0; b < batches.size(); b++) {
+		EXPECT_EQ(batches[b].FirstObject, target.Drawn[b].FirstObject);
+		EXPECT_EQ(batches[b].FirstInstance, target.Drawn[b].FirstInstance);
+		EXPECT_EQ(batches[b].InstanceCount, target.Drawn[b].InstanceCount);
+	}
+}
+
+TEST_F(InstanceBatcherTest, NothingToSubmit)
+{
+	InstanceBatcher batcher;
+	batcher.Build(nullptr, 0, true);
+	RecordingTarget target;
+	batcher.Submit(target);
+	EXPECT_EQ(0u, target.Uploads);
+	EXPECT_TRUE(target.Drawn.empty());
+	EXPECT_EQ(0u, batcher.GetStats().Batches);
+}
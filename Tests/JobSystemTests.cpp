@@ -0,0 +1,171 @@
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include "JobSystem.h"
+
+// Enough workers that jobs really do run at the same time, even on a small build machine
+#define TEST_WORKERS 3
+
+TEST(JobSystem, RunsEveryJobOnce)
+{
+	JobSystem jobs(TEST_WORKERS);
+	EXPECT_EQ(TEST_WORKERS + 1u, jobs.GetThreadCount());
+	std::vector<std::atomic<int>> runs(5000);
+	JobCounter counter;
+	for (unsigned int i = 0; i < runs.size(); i++) {
+		jobs.Run([&runs, i] { runs[i]++; }, &counter);
+	}
+	jobs.Wait(counter);
+	EXPECT_TRUE(counter.IsDone());
+	for (unsigned int i = 0; i < runs.size(); i++) {
+		EXPECT_EQ(1, runs[i].load()) << i;
+	}
+	EXPECT_GE(jobs.GetStats().JobsRun, runs.size());
+}
+
+// Each link is held back until the one before it is done, so they run strictly in order
+TEST(JobSystem, DependencyChainsRunInOrder)
+{
+	JobSystem jobs(TEST_WORKERS);
+	const unsigned int links = 200;
+	std::vector<JobCounter> counters(links);
+	std::mutex orderMutex;
+	std::vector<unsigned int> order;
+	jobs.Run([&] { std::lock_guard<std::mutex> lock(orderMutex); order.push_back(0); }, &counters[0]);
+	for (unsigned int i = 1; i < links; i++) {
+		jobs.RunAfter(counters[i - 1], [&, i] { std::lock_guard<std::mutex> lock(orderMutex); order.push_back(i); }, &counters[i]);
+	}
+	jobs.Wait(counters[links - 1]);
+	ASSERT_EQ(links, order.size());
+	for (unsigned int i = 0; i < links; i++) {
+		EXPECT_EQ(i, order[i]);
+	}
+}
+
+// A continuation starts only once every job on its counter has finished, and straight away if they already have
+TEST(JobSystem, RunAfterWaitsForTheWholeCounter)
+{
+	JobSystem jobs(TEST_WORKERS);
+	for (int round = 0; round < 50; round++) {
+		const int fanIn = 32;
+		std::atomic<int> finished(0);
+		std::atomic<int> seenByContinuations(0);
+		std::atomic<int> continuationsRun(0);
+		JobCounter first;
+		JobCounter second;
+		for (int i = 0; i < fanIn; i++) {
+			jobs.Run([&finished] {
+				std::this_thread::yield();
+				finished++;
+			}, &first);
+		}
+		for (int c = 0; c < 4; c++) {
+			jobs.RunAfter(first, [&] {
+				seenByContinuations += finished.load();
+				continuationsRun++;
+			}, &second);
+		}
+		jobs.Wait(second);
+		EXPECT_EQ(4, continuationsRun.load());
+		EXPECT_EQ(4 * fanIn, seenByContinuations.load());
+
+		// first is done now, so this one isn't held back
+		JobCounter third;
+		bool ran = false;
+		jobs.RunAfter(first, [&ran] { ran = true; }, &third);
+		jobs.Wait(third);
+		EXPECT_TRUE(ran);
+	}
+}
+
+// ParallelFor inside jobs inside a ParallelFor: the waits inside jobs run other jobs rather than deadlocking
+TEST(JobSystem, NestedParallelForCoversEveryIndex)
+{
+	JobSystem jobs(TEST_WORKERS);
+	const unsigned int outer = 64;
+	const unsigned int inner = 1000;
+	std::vector<std::atomic<int>> hits(outer * inner);
+	jobs.ParallelFor(outer, 1, [&](unsigned int first, unsigned int last) {
+		for (unsigned int o = first; o < last; o++) {
+			jobs.ParallelFor(inner, 16, [&, o](unsigned int innerFirst, unsigned int innerLast) {
+				for (unsigned int i = innerFirst; i < innerLast; i++) {
+					hits[o * inner + i]++;
+				}
+			});
+		}
+	});
+	for (unsigned int i = 0; i < hits.size(); i++) {
+		ASSERT_EQ(1, hits[i].load()) << i;
+	}
+
+	// Small and empty ranges run inline
+	unsigned int calls = 0;
+	jobs.ParallelFor(10, 100, [&calls](unsigned int first, unsigned int last) {
+		EXPECT_EQ(0u, first);
+		EXPECT_EQ(10u, last);
+		calls++;
+	});
+	jobs.ParallelFor(0, 1, [&calls](unsigned int, unsigned int) { calls++; });
+	EXPECT_EQ(1u, calls);
+}
+
+// Threads that aren't part of the system push to the creator's queue and can wait like anyone else
+TEST(JobSystem, ForeignThreadsCanSubmitAndWait)
+{
+	JobSystem jobs(TEST_WORKERS);
+	const int threadCount = 4;
+	const int perThread = 500;
+	std::atomic<int> total(0);
+	std::vector<std::thread> threads;
+	for (int t = 0; t < threadCount; t++) {
+		threads.push_back(std::thread([&] {
+			JobCounter counter;
+			for (int j = 0; j < perThread; j++) {
+				jobs.Run([&total] { total++; }, &counter);
+			}
+			jobs.Wait(counter);
+		}));
+	}
+	for (int t = 0; t < threadCount; t++) {
+		threads[t].join();
+	}
+	EXPECT_EQ(threadCount * perThread, total.load());
+}
+
+// Counters on the stack of a loop, gone as soon as Wait returns; the last job must be done with them by then
+TEST(JobSystem, ShortLivedCounters)
+{
+	JobSystem jobs(TEST_WORKERS);
+	std::atomic<int> total(0);
+	for (int i = 0; i < 2000; i++) {
+		JobCounter counter;
+		jobs.Run([&total] { total++; }, &counter);
+		jobs.Run([&total] { total++; }, &counter);
+		JobCounter after;
+		jobs.RunAfter(counter, [&total] { total++; }, &after);
+		jobs.Wait(after);
+		EXPECT_TRUE(counter.IsDone());
+	}
+	EXPECT_EQ(3 * 2000, total.load());
+}
+
+// Background jobs go to idle workers only, and are still drained before the system goes away
+TEST(JobSystem, BackgroundJobsFinish)
+{
+	std::atomic<int> total(0);
+	{
+		JobSystem jobs(TEST_WORKERS);
+		JobCounter counter;
+		for (int i = 0; i < 100; i++) {
+			jobs.Run([&total] { total++; }, &counter, true);
+		}
+		jobs.Wait(counter);
+		EXPECT_EQ(100, total.load());
+		for (int i = 0; i < 100; i++) {
+			jobs.Run([&total] { total++; }, nullptr, true);
+		}
+	}
+	EXPECT_EQ(200, total.load());
+}
@@ -0,0 +1,155 @@
+#include <math.h>
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+#include <gtest/gtest.h>
+#include "Camera.h"
+#include "LooseGrid.h"
+
+using namespace DirectX;
+
+static float Random(uint32_t& state)
+{
+	state = state * 1664525 + 1013904223;
+	return (state >> 8) / 16777216.0f;
+}
+
+static std::vector<AABB> MakeBounds(unsigned int count, uint32_t seed)
+{
+	std::vector<AABB> bounds(count);
+	for (unsigned int i = 0; i < count; i++) {
+		bounds[i].Center = XMFLOAT3(Random(seed) * 200 - 100, Random(seed) * 20 - 10, Random(seed) * 200 - 100);
+		float extent = 0.25f + Random(seed) * 2;
+		bounds[i].Extents = XMFLOAT3(extent, extent, extent);
+	}
+	return bounds;
+}
+
+static std::vector<int> BruteForce(const Frustum& frustum, const std::vector<AABB>& bounds, const std::vector<int>& proxies, bool withinBounds)
+{
+	AABB frustumBounds = frustum.GetBounds();
+	std::vector<int> visible;
+	for (unsigned int i = 0; i < bounds.size(); i++) {
+		const AABB& box = bounds[i];
+		bool inBounds = fabsf(box.Center.x - frustumBounds.Center.x) <= box.Extents.x + frustumBounds.Extents.x &&
+			fabsf(box.Center.y - frustumBounds.Center.y) <= box.Extents.y + frustumBounds.Extents.y &&
+			fabsf(box.Center.z - frustumBounds.Center.z) <= box.Extents.z + frustumBounds.Extents.z;
+		if ((inBounds || !withinBounds) && frustum.Intersects(box)) {
+			visible.push_back(proxies[i]);
+		}
+	}
+	std::sort(visible.begin(), visible.end());
+	return visible;
+}
+
+static std::vector<int> BruteForce(XMFLOAT3 center, float radius, const std::vector<AABB>& bounds, const std::vector<int>& proxies)
+{
+	std::vector<int> hits;
+	for (unsigned int i = 0; i < bounds.size(); i++) {
+		float dx = fmaxf(fabsf(center.x - bounds[i].Center.x) - bounds[i].Extents.x, 0.0f);
+		float dy = fmaxf(fabsf(center.y - bounds[i].Center.y) - bounds[i].Extents.y, 0.0f);
+		float dz = fmaxf(fabsf(center.z - bounds[i].Center.z) - bounds[i].Extents.z, 0.0f);
+		if (dx * dx + dy * dy + dz * dz <= radius * radius) {
+			hits.push_back(proxies[i]);
+		}
+	}
+	std::sort(hits.begin(), hits.end());
+	return hits;
+}
+
+// The loose cells only decide where to look, so the queries agree with brute force
+TEST(LooseGrid, QueriesMatchBruteForce)
+{
+	std::vector<AABB> bounds = MakeBounds(5000, 5);
+	LooseGrid grid;
+	std::vector<int> proxies;
+	for (unsigned int i = 0; i < bounds.size(); i++) {
+		proxies.push_back(grid.CreateProxy(bounds[i], nullptr));
+	}
+	EXPECT_EQ(5000, grid.GetProxyCount());
+
+	// A far plane well past the world, so there are fewer cells than the frustum reaches
+	Camera farCamera(Transform(0, 0, -120, 0, 0, 0, 1, 1, 1), 1.5f);
+	// One that reaches fewer cells than exist, so the range is walked by lookup
+	Camera nearCamera(Transform(0, 0, -20, 0.2f, 0.5f, 0, 1, 1, 1), 1.5f, 1.0f, 0.1f, 15.0f, 4, 1);
+
+	uint32_t seed = 11;
+	for (int frame = 0; frame < 5; frame++) {
+		for (unsigned int i = 0; i < bounds.size(); i++) {
+			bounds[i].Center.x += Random(seed) * 6 - 3;
+			bounds[i].Center.z += Random(seed) * 6 - 3;
+			grid.MoveProxy(proxies[i], bounds[i]);
+		}
+
+		Camera* cameras[2] = { &farCamera, &nearCamera };
+		for (int c = 0; c < 2; c++) {
+			Frustum frustum(cameras[c]->GetViewMatrix(), cameras[c]->GetProjectionMatrix());
+			std::vector<int> visible;
+			grid.QueryFrustum(frustum, visible);
+			std::sort(visible.begin(), visible.end());
+			// Intersects keeps boxes just past a corner that no single plane rejects, and the grid
+			// may or may not, depending on whether their cells are near the frustum's bounds
+			std::vector<int> atMost = BruteForce(frustum, bounds, proxies, false);
+			std::vector<int> atLeast = BruteForce(frustum, bounds, proxies, true);
+			EXPECT_TRUE(std::includes(atMost.begin(), atMost.end(), visible.begin(), visible.end()));
+			EXPECT_TRUE(std::includes(visible.begin(), visible.end(), atLeast.begin(), atLeast.end()));
+			EXPECT_FALSE(atLeast.empty());
+		}
+
+		XMFLOAT3 center(frame * 10.0f, 0, -frame * 5.0f);
+		std::vector<int> hits;
+		grid.QuerySphere(center, 12, hits);
+		std::sort(hits.begin(), hits.end());
+		EXPECT_EQ(BruteForce(center, 12, bounds, proxies), hits);
+	}
+}
+
+TEST(LooseGrid, ExtentShrinksWhenTheLargestGoes)
+{
+	LooseGrid grid;
+	AABB small;
+	small.Center = XMFLOAT3(1, 1, 1);
+	small.Extents = XMFLOAT3(1, 0.5f, 1);
+	AABB large;
+	large.Center = XMFLOAT3(2, 1, 1);
+	large.Extents = XMFLOAT3(8, 1, 1);
+	grid.CreateProxy(small, nullptr);
+	int largeProxy = grid.CreateProxy(large, nullptr);
+	EXPECT_EQ(8.0f, grid.GetMaxExtent());
+
+	// Shrinking without changing cells
+	large.Extents.x = 4;
+	EXPECT_FALSE(grid.MoveProxy(largeProxy, large));
+	EXPECT_EQ(4.0f, grid.GetMaxExtent());
+
+	// Growing again, then moving to another cell
+	large.Extents.x = 6;
+	grid.MoveProxy(largeProxy, large);
+	EXPECT_EQ(6.0f, grid.GetMaxExtent());
+	large.Center.x = 50;
+	large.Extents.x = 3;
+	EXPECT_TRUE(grid.MoveProxy(largeProxy, large));
+	EXPECT_EQ(3.0f, grid.GetMaxExtent());
+
+	grid.DestroyProxy(largeProxy);
+	EXPECT_EQ(1.0f, grid.GetMaxExtent());
+	EXPECT_EQ(1, grid.GetProxyCount());
+}
+
+TEST(LooseGrid, DestroyedProxiesAreReused)
+{
+	LooseGrid grid;
+	AABB box;
+	box.Center = XMFLOAT3(0, 0, 0);
+	box.Extents = XMFLOAT3(1, 1, 1);
+	int first = grid.CreateProxy(box, nullptr);
+	int second = grid.CreateProxy(box, &box);
+	grid.DestroyProxy(first);
+	EXPECT_EQ(first, grid.CreateProxy(box, nullptr));
+	EXPECT_EQ(&box, grid.GetUserData(second));
+	EXPECT_EQ(2, grid.GetProxyCapacity());
+
+	std::vector<int> hits;
+	grid.QuerySphere(XMFLOAT3(0, 0, 0), 1, hits);
+	EXPECT_EQ(2u, hits.size());
+}
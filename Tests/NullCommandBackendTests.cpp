@@ -0,0 +1,149 @@
+#include <stdint.h>
+#include <gtest/gtest.h>
+#include "CommandBuffer.h"
+#include "NullCommandBackend.h"
+#include "StateFilterBackend.h"
+
+static void* Handle(uintptr_t id)
+{
+	return (void*)id;
+}
+
+static PipelineHandles MakePipeline(uintptr_t first)
+{
+	PipelineHandles pipeline = {};
+	pipeline.VertexShader = Handle(first);
+	pipeline.InputLayout = Handle(first + 1);
+	pipeline.PixelShader = Handle(first + 2);
+	pipeline.BlendState = Handle(first + 3);
+	pipeline.RasterizerState = Handle(first + 4);
+	pipeline.DepthStencilState = Handle(first + 5);
+	return pipeline;
+}
+
+// --------------------------------------------------------
+// One frame recorded the way Game::Draw records its passes:
+// the static chunks and the opaque queue in one buffer, the
+// queue's half from two chunks appended in order, then the
+// sky box in a buffer of its own.  The handles are made up;
+// the null backend only checks whether they're bound.
+// --------------------------------------------------------
+static void RecordFrame(CommandBuffer& opaque, CommandBuffer& sky)
+{
+	float vsConstants[48] = {};		// world, view, projection
+	float psConstants[8] = {};		// color, colorTint
+
+	// Static chunks: one vertex/index buffer pair for all of them
+	opaque.SetMeshBuffers(Handle(100), Handle(101), 44);
+	opaque.SetPipelineState(MakePipeline(10));
+	opaque.SetConstants(SHADER_STAGE_VERTEX, 0, Handle(20), vsConstants, sizeof(vsConstants));
+	opaque.SetShaderResource(SHADER_STAGE_PIXEL, 0, Handle(30));
+	opaque.SetSampler(SHADER_STAGE_PIXEL, 0, Handle(31));
+	opaque.SetConstants(SHADER_STAGE_PIXEL, 0, Handle(21), psConstants, sizeof(psConstants));
+	opaque.DrawIndexed(600, 0, 0);
+	opaque.DrawIndexed(300, 600, 400);
+
+	// Two recorded chunks of the queue, each binding everything its first draw needs
+	CommandBuffer chunks[2];
+	for (int c = 0; c < 2; c++) {
+		chunks[c].SetPipelineState(MakePipeline(10));
+		chunks[c].SetShaderResource(SHADER_STAGE_PIXEL, 0, Handle(30));
+		chunks[c].SetSampler(SHADER_STAGE_PIXEL, 0, Handle(31));
+		chunks[c].SetMeshBuffers(Handle(102 + c), Handle(104 + c), 44);
+		for (int draw = 0; draw < 3; draw++) {
+			chunks[c].SetConstants(SHADER_STAGE_VERTEX, 0, Handle(20), vsConstants, sizeof(vsConstants));
+			chunks[c].SetConstants(SHADER_STAGE_PIXEL, 0, Handle(21), psConstants, sizeof(psConstants));
+			chunks[c].DrawIndexed(36, 0, 0);
+		}
+		opaque.Append(chunks[c]);
+	}
+
+	sky.SetPipelineState(MakePipeline(40));
+	sky.SetConstants(SHADER_STAGE_VERTEX, 0, Handle(22), vsConstants, 32 * sizeof(float));
+	sky.SetShaderResource(SHADER_STAGE_PIXEL, 0, Handle(50));
+	sky.SetSampler(SHADER_STAGE_PIXEL, 0, Handle(31));
+	sky.SetMeshBuffers(Handle(106), Handle(107), 44);
+	sky.DrawIndexed(36, 0, 0);
+}
+
+TEST(NullCommandBackend, ReplayedFrameIsCountedWithoutErrors)
+{
+	CommandBuffer opaque;
+	CommandBuffer sky;
+	RecordFrame(opaque, sky);
+
+	NullCommandBackend backend;
+	ASSERT_TRUE(opaque.Replay(backend));
+	ASSERT_TRUE(sky.Replay(backend));
+
+	const CommandBackendStats& stats = backend.GetStats();
+	EXPECT_EQ(9u, stats.Draws);
+	EXPECT_EQ(600u + 300u + 6 * 36u + 36u, stats.Indices);
+	EXPECT_EQ(4u, stats.PipelineChanges);
+	EXPECT_EQ(0u, stats.ShaderChanges);
+	EXPECT_EQ(2u + 12u + 1u, stats.ConstantUpdates);
+	EXPECT_EQ(7 * (48 + 8) * sizeof(float) + 32 * sizeof(float), stats.ConstantBytes);
+	EXPECT_EQ(4u, stats.ResourceBindings);
+	EXPECT_EQ(4u, stats.SamplerBindings);
+	EXPECT_EQ(4u, stats.MeshBindings);
+	EXPECT_EQ(0u, stats.Errors);
+}
+
+// The filter drops the chunks' repeated bindings and the sky box's sampler; the draws are all still there
+TEST(NullCommandBackend, FilteredFrameKeepsItsDraws)
+{
+	CommandBuffer opaque;
+	CommandBuffer sky;
+	RecordFrame(opaque, sky);
+
+	NullCommandBackend backend;
+	StateFilterBackend filter(&backend);
+	ASSERT_TRUE(opaque.Replay(filter));
+	ASSERT_TRUE(sky.Replay(filter));
+
+	const CommandBackendStats& stats = backend.GetStats();
+	EXPECT_EQ(9u, stats.Draws);
+	EXPECT_EQ(2u, stats.PipelineChanges);
+	EXPECT_EQ(2u, stats.ResourceBindings);
+	EXPECT_EQ(1u, stats.SamplerBindings);
+	EXPECT_EQ(4u, stats.MeshBindings);
+	EXPECT_EQ(3u, stats.ConstantUpdates);	// The same data every draw, only the sky box's buffer is new
+	EXPECT_EQ(0u, stats.Errors);
+}
+
+TEST(NullCommandBackend, InvalidCallsAreErrors)
+{
+	float constants[4] = {};
+	CommandBuffer commands;
+	commands.DrawIndexed(36, 0, 0);												// Nothing bound
+	commands.SetPipelineState(MakePipeline(10));
+	commands.SetMeshBuffers(Handle(100), Handle(101), 0);							// Zero stride
+	commands.SetConstants(SHADER_STAGE_VERTEX, NULL_BACKEND_CONSTANT_SLOTS, Handle(20), constants, sizeof(constants));
+	commands.SetConstants(SHADER_STAGE_PIXEL, 0, Handle(21), constants, 12);		// Not a multiple of 16
+	commands.SetShaderResource(2, 0, Handle(30));									// No such stage
+	commands.SetShaderResource(SHADER_STAGE_PIXEL, NULL_BACKEND_RESOURCE_SLOTS, Handle(30));
+	commands.SetSampler(SHADER_STAGE_PIXEL, NULL_BACKEND_SAMPLER_SLOTS, Handle(31));
+	commands.DrawIndexed(0, 0, 0);													// Zero indices
+
+	NullCommandBackend backend;
+	ASSERT_TRUE(commands.Replay(backend));
+	EXPECT_EQ(2u, backend.GetStats().Draws);
+	EXPECT_EQ(2u + 7u, backend.GetStats().Errors);
+}
+
+// Bound state outlives ResetStats, like a context's does between frames
+TEST(NullCommandBackend, ResetStatsKeepsWhatsBound)
+{
+	NullCommandBackend backend;
+	backend.SetPipelineState(MakePipeline(10));
+	backend.SetMeshBuffers(Handle(100), Handle(101), 44);
+	backend.ResetStats();
+	backend.DrawIndexed(36, 0, 0);
+	EXPECT_EQ(1u, backend.GetStats().Draws);
+	EXPECT_EQ(0u, backend.GetStats().PipelineChanges);
+	EXPECT_EQ(0u, backend.GetStats().Errors);
+
+	backend.SetPipelineState(PipelineHandles());
+	backend.DrawIndexed(36, 0, 0);
+	EXPECT_EQ(1u, backend.GetStats().Errors);
+}
@@ -0,0 +1,217 @@
+#include <math.h>
+#include <vector>
+#include <gtest/gtest.h>
+#include "Camera.h"
+#include "JobSystem.h"
+#include "OcclusionCuller.h"
+
+using namespace DirectX;
+
+// The default camera at the origin looking down +Z, drawn into the culler's default 256x128 buffer
+static Camera MakeCamera()
+{
+	return Camera(Transform(0, 0, 0, 0, 0, 0, 1, 1, 1), 2.0f);
+}
+
+static XMFLOAT4X4 Identity()
+{
+	XMFLOAT4X4 identity;
+	XMStoreFloat4x4(&identity, XMMatrixIdentity());
+	return identity;
+}
+
+static AABB MakeBox(float x, float y, float z, float extent)
+{
+	AABB box;
+	box.Center = XMFLOAT3(x, y, z);
+	box.Extents = XMFLOAT3(extent, extent, extent);
+	return box;
+}
+
+// A wall across the whole view at the given distance, clockwise from the camera
+static const XMFLOAT3 wallCorners[] = {
+	XMFLOAT3(-100, 100, 0), XMFLOAT3(100, 100, 0), XMFLOAT3(100, -100, 0), XMFLOAT3(-100, -100, 0)
+};
+static const unsigned int wallIndices[] = { 0, 1, 2, 0, 2, 3 };
+
+static void AddWall(OcclusionCuller& culler, float distance)
+{
+	XMFLOAT4X4 world;
+	XMStoreFloat4x4(&world, XMMatrixTranslation(0, 0, distance));
+	culler.AddOccluder(wallCorners, wallIndices, 6, world);
+}
+
+TEST(OcclusionCuller, WallHidesWhatIsBehindIt)
+{
+	Camera camera = MakeCamera();
+	OcclusionCuller culler;
+	culler.BeginFrame(camera.GetViewMatrix(), camera.GetProjectionMatrix());
+	AddWall(culler, 10);
+	culler.RasterizeOccluders();
+	EXPECT_EQ(2u, culler.GetStats().OccluderTriangles);
+	for (unsigned int py = 0; py < culler.GetHeight(); py++) {
+		for (unsigned int px = 0; px < culler.GetWidth(); px++) {
+			ASSERT_LT(culler.GetDepth(px, py), 1.0f) << px << ", " << py;	// Diagonal included
+		}
+	}
+
+	EXPECT_FALSE(culler.IsVisible(MakeBox(4, 4, 20, 1)));		// Behind
+	EXPECT_TRUE(culler.IsVisible(MakeBox(4, 4, 5, 1)));			// In front
+	EXPECT_TRUE(culler.IsVisible(MakeBox(4, 4, 10, 1)));		// Through it
+	EXPECT_TRUE(culler.IsVisible(MakeBox(0, 0, 0, 0.5f)));		// Across the near plane
+}
+
+// The quad's two triangles each cover only part of the pixels along their shared diagonal,
+// but together they cover all of them
+TEST(OcclusionCuller, QuadHidesABoxAcrossItsDiagonal)
+{
+	Camera camera = MakeCamera();
+	OcclusionCuller culler;
+	culler.BeginFrame(camera.GetViewMatrix(), camera.GetProjectionMatrix());
+	const XMFLOAT3 corners[] = { XMFLOAT3(-6, 5, 10), XMFLOAT3(7, 6, 10), XMFLOAT3(6, -5, 10), XMFLOAT3(-5, -6, 10) };
+	culler.AddOccluder(corners, wallIndices, 6, Identity());
+	culler.RasterizeOccluders();
+	EXPECT_EQ(2u, culler.GetStats().OccluderTriangles);
+
+	EXPECT_FALSE(culler.IsVisible(MakeBox(0, 0, 20, 1)));
+	EXPECT_FALSE(culler.IsVisible(MakeBox(3, 3, 20, 1)));
+	EXPECT_FALSE(culler.IsVisible(MakeBox(-3, -3, 20, 1)));
+	EXPECT_TRUE(culler.IsVisible(MakeBox(0, 0, 8, 1)));			// In front
+
+	// The same triangles as two occluders don't cover each other's half-pixels
+	culler.BeginFrame(camera.GetViewMatrix(), camera.GetProjectionMatrix());
+	culler.AddOccluder(corners, wallIndices, 3, Identity());
+	culler.AddOccluder(corners, wallIndices + 3, 3, Identity());
+	culler.RasterizeOccluders();
+	EXPECT_TRUE(culler.IsVisible(MakeBox(0, 0, 20, 1)));
+}
+
+TEST(OcclusionCuller, BackFacesAreCulledUnlessAsked)
+{
+	Camera camera = MakeCamera();
+	const unsigned int reversed[] = { 0, 2, 1, 0, 3, 2 };
+	XMFLOAT4X4 world;
+	XMStoreFloat4x4(&world, XMMatrixTranslation(0, 0, 10));
+
+	OcclusionCuller culler;
+	culler.BeginFrame(camera.GetViewMatrix(), camera.GetProjectionMatrix());
+	culler.AddOccluder(wallCorners, reversed, 6, world);
+	culler.RasterizeOccluders();
+	EXPECT_EQ(0u, culler.GetStats().OccluderTriangles);
+	EXPECT_TRUE(culler.IsVisible(MakeBox(4, 4, 20, 1)));
+
+	culler.SetCullBackFaces(false);
+	culler.BeginFrame(camera.GetViewMatrix(), camera.GetProjectionMatrix());
+	culler.AddOccluder(wallCorners, reversed, 6, world);
+	culler.RasterizeOccluders();
+	EXPECT_FALSE(culler.IsVisible(MakeBox(4, 4, 20, 1)));
+}
+
+// Every pixel the rasterizer writes must lie entirely inside the triangle, and hold
+// a depth no nearer than the triangle's at any of the pixel's corners
+TEST(OcclusionCuller, DepthIsConservative)
+{
+	Camera camera = MakeCamera();
+	XMFLOAT4X4 view = camera.GetViewMatrix();
+	XMFLOAT4X4 projection = camera.GetProjectionMatrix();
+	const XMFLOAT3 corners[] = { XMFLOAT3(-5, 4, 8), XMFLOAT3(6, 3, 20), XMFLOAT3(-2, -5, 12) };	// Slanted away from the camera
+	const unsigned int indices[] = { 0, 1, 2 };
+
+	OcclusionCuller culler;
+	culler.SetCullBackFaces(false);
+	culler.BeginFrame(view, projection);
+	culler.AddOccluder(corners, indices, 3, Identity());
+	culler.RasterizeOccluders();
+
+	// The same projection as the culler's, to get the triangle in pixels
+	float width = (float)culler.GetWidth();
+	float height = (float)culler.GetHeight();
+	XMMATRIX viewProj = XMMatrixMultiply(XMLoadFloat4x4(&view), XMLoadFloat4x4(&projection));
+	float x[3], y[3], z[3];
+	for (int v = 0; v < 3; v++) {
+		XMFLOAT4 clip;
+		XMStoreFloat4(&clip, XMVector3Transform(XMLoadFloat3(&corners[v]), viewProj));
+		x[v] = (clip.x / clip.w * 0.5f + 0.5f) * width;
+		y[v] = (0.5f - clip.y / clip.w * 0.5f) * height;
+		z[v] = clip.z / clip.w;
+	}
+	float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+
+	unsigned int written = 0;
+	for (unsigned int py = 0; py < culler.GetHeight(); py++) {
+		for (unsigned int px = 0; px < culler.GetWidth(); px++) {
+			float depth = culler.GetDepth(px, py);
+			if (depth == 1.0f) {
+				continue;
+			}
+			written++;
+			for (int corner = 0; corner < 4; corner++) {
+				float cx = (float)px + (corner & 1);
+				float cy = (float)py + (corner >> 1);
+				float b0 = ((x[1] - cx) * (y[2] - cy) - (y[1] - cy) * (x[2] - cx)) / area;
+				float b1 = ((x[2] - cx) * (y[0] - cy) - (y[2] - cy) * (x[0] - cx)) / area;
+				float b2 = 1.0f - b0 - b1;
+				ASSERT_GE(b0, -1e-4f) << px << ", " << py;
+				ASSERT_GE(b1, -1e-4f) << px << ", " << py;
+				ASSERT_GE(b2, -1e-4f) << px << ", " << py;
+				ASSERT_GE(depth, b0 * z[0] + b1 * z[1] + b2 * z[2] - 1e-6f) << px << ", " << py;
+			}
+		}
+	}
+	EXPECT_GT(written, 100u);
+}
+
+TEST(OcclusionCuller, PartlyCoveredBoxesStayVisible)
+{
+	Camera camera = MakeCamera();
+	OcclusionCuller culler;
+	culler.BeginFrame(camera.GetViewMatrix(), camera.GetProjectionMatrix());
+	// Only the left half of the view, ending at x = 0
+	const XMFLOAT3 corners[] = { XMFLOAT3(-100, 100, 10), XMFLOAT3(0, 100, 10), XMFLOAT3(0, -100, 10), XMFLOAT3(-100, -100, 10) };
+	culler.AddOccluder(corners, wallIndices, 6, Identity());
+	culler.RasterizeOccluders();
+
+	EXPECT_FALSE(culler.IsVisible(MakeBox(-3, 0, 20, 1)));
+	EXPECT_TRUE(culler.IsVisible(MakeBox(3, 0, 20, 1)));
+	EXPECT_TRUE(culler.IsVisible(MakeBox(0, 0, 20, 1)));		// Half behind the edge
+}
+
+TEST(OcclusionCuller, JobsGiveTheSameResult)
+{
+	Camera camera = MakeCamera();
+	std::vector<AABB> bounds;
+	std::vector<unsigned int> candidates;
+	for (int i = 0; i < 2000; i++) {
+		bounds.push_back(MakeBox((i % 40) - 20.0f, (i / 40 % 10) - 5.0f, 4.0f + (i / 400) * 5.0f, 0.4f));
+		candidates.push_back(i);
+	}
+	const XMFLOAT3 corners[] = { XMFLOAT3(-8, 6, 9), XMFLOAT3(7, 2, 14), XMFLOAT3(-1, -6, 11), XMFLOAT3(9, -4, 16) };
+	const unsigned int indices[] = { 0, 1, 2, 1, 3, 2 };
+
+	OcclusionCuller serial;
+	serial.SetCullBackFaces(false);
+	serial.BeginFrame(camera.GetViewMatrix(), camera.GetProjectionMatrix());
+	serial.AddOccluder(corners, indices, 6, Identity());
+	serial.RasterizeOccluders();
+	std::vector<unsigned int> serialVisible;
+	serial.Cull(bounds, candidates, serialVisible);
+
+	JobSystem jobs(3);
+	OcclusionCuller parallel;
+	parallel.SetCullBackFaces(false);
+	parallel.SetJobSystem(&jobs);
+	parallel.BeginFrame(camera.GetViewMatrix(), camera.GetProjectionMatrix());
+	parallel.AddOccluder(corners, indices, 6, Identity());
+	parallel.RasterizeOccluders();
+	std::vector<unsigned int> parallelVisible;
+	parallel.Cull(bounds, candidates, parallelVisible);
+
+	for (unsigned int py = 0; py < serial.GetHeight(); py++) {
+		for (unsigned int px = 0; px < serial.GetWidth(); px++) {
+			ASSERT_EQ(serial.GetDepth(px, py), parallel.GetDepth(px, py));
+		}
+	}
+	EXPECT_EQ(serialVisible, parallelVisible);
+	EXPECT_LT(serialVisible.size(), candidates.size());
+	EXPECT_EQ(candidates.size() - serialVisible.size(), parallel.GetStats().Occluded);
+}
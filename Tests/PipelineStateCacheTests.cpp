@@ -0,0 +1,285 @@
+#include <string.h>
+#include <memory>
+#include <gtest/gtest.h>
+#include "PipelineStateCache.h"
+
+#ifndef _WIN32
+// --------------------------------------------------------
+// Just enough of a device for the cache: every state it's
+// asked for is a new object, unless Fail is set.  Shaders
+// and buffers can't be made, as with the rest of the
+// stand-in headers.
+// --------------------------------------------------------
+template <typename Interface>
+class FakeState : public Interface
+{
+private:
+	unsigned long references = 1;
+public:
+	unsigned long AddRef() { return ++references; }
+	unsigned long Release()
+	{
+		unsigned long left = --references;
+		if (left == 0) {
+			delete this;
+		}
+		return left;
+	}
+};
+
+class FakeDevice : public ID3D11Device
+{
+public:
+	bool Fail = false;
+
+	// Lives on the test's stack, longer than anything holding it
+	unsigned long AddRef() { return 1; }
+	unsigned long Release() { return 1; }
+
+	HRESULT CreateBuffer(const D3D11_BUFFER_DESC*, const D3D11_SUBRESOURCE_DATA*, ID3D11Buffer**) { return E_NOTIMPL; }
+	HRESULT CreateInputLayout(const D3D11_INPUT_ELEMENT_DESC*, UINT, const void*, SIZE_T, ID3D11InputLayout**) { return E_NOTIMPL; }
+	HRESULT CreateVertexShader(const void*, SIZE_T, ID3D11ClassLinkage*, ID3D11VertexShader**) { return E_NOTIMPL; }
+	HRESULT CreatePixelShader(const void*, SIZE_T, ID3D11ClassLinkage*, ID3D11PixelShader**) { return E_NOTIMPL; }
+	HRESULT CreateGeometryShader(const void*, SIZE_T, ID3D11ClassLinkage*, ID3D11GeometryShader**) { return E_NOTIMPL; }
+	HRESULT CreateGeometryShaderWithStreamOutput(const void*, SIZE_T, const D3D11_SO_DECLARATION_ENTRY*, UINT, const UINT*, UINT, UINT, ID3D11ClassLinkage*, ID3D11GeometryShader**) { return E_NOTIMPL; }
+	HRESULT CreateHullShader(const void*, SIZE_T, ID3D11ClassLinkage*, ID3D11HullShader**) { return E_NOTIMPL; }
+	HRESULT CreateDomainShader(const void*, SIZE_T, ID3D11ClassLinkage*, ID3D11DomainShader**) { return E_NOTIMPL; }
+	HRESULT CreateComputeShader(const void*, SIZE_T, ID3D11ClassLinkage*, ID3D11ComputeShader**) { return E_NOTIMPL; }
+
+	template <typename Interface>
+	HRESULT Create(Interface** state)
+	{
+		if (Fail) {
+			return E_FAIL;
+		}
+		*state = new FakeState<Interface>();
+		return S_OK;
+	}
+	HRESULT CreateBlendState(const D3D11_BLEND_DESC*, ID3D11BlendState** state) { return Create(state); }
+	HRESULT CreateRasterizerState(const D3D11_RASTERIZER_DESC*, ID3D11RasterizerState** state) { return Create(state); }
+	HRESULT CreateDepthStencilState(const D3D11_DEPTH_STENCIL_DESC*, ID3D11DepthStencilState** state) { return Create(state); }
+	HRESULT CreateSamplerState(const D3D11_SAMPLER_DESC*, ID3D11SamplerState** state) { return Create(state); }
+};
+#endif
+
+// --------------------------------------------------------
+// A cache on a device that can make states: WARP on
+// Windows, so no GPU is needed, a FakeDevice elsewhere.
+// The shaders fail to load either way, only their
+// identity matters to the cache.
+// --------------------------------------------------------
+class PipelineStateCacheTest : public ::testing::Test
+{
+protected:
+#ifdef _WIN32
+	Microsoft::WRL::ComPtr<ID3D11Device> device;
+#else
+	FakeDevice fakeDevice;
+	Microsoft::WRL::ComPtr<ID3D11Device> device;
+#endif
+	std::unique_ptr<PipelineStateCache> cache;
+	std::shared_ptr<SimpleVertexShader> vertexShader;
+	std::shared_ptr<SimplePixelShader> pixelShader;
+	std::shared_ptr<SimplePixelShader> otherPixelShader;
+
+	void SetUp()
+	{
+#ifdef _WIN32
+		ASSERT_TRUE(SUCCEEDED(D3D11CreateDevice(0, D3D_DRIVER_TYPE_WARP, 0, 0, 0, 0, D3D11_SDK_VERSION, device.GetAddressOf(), 0, 0)));
+#else
+		device = &fakeDevice;
+#endif
+		cache.reset(new PipelineStateCache(device));
+		vertexShader = std::make_shared<SimpleVertexShader>(nullptr, nullptr, L"VertexShader.cso");
+		pixelShader = std::make_shared<SimplePixelShader>(nullptr, nullptr, L"PixelShader.cso");
+		otherPixelShader = std::make_shared<SimplePixelShader>(nullptr, nullptr, L"TransparencyPixelShader.cso");
+	}
+
+	PipelineStateDesc Desc(std::shared_ptr<SimplePixelShader> pixel)
+	{
+		PipelineStateDesc desc;
+		desc.VertexShader = vertexShader;
+		desc.PixelShader = pixel;
+		return desc;
+	}
+};
+
+TEST(PipelineStateKey, EqualDescriptionsGetEqualKeys)
+{
+	PipelineStateDesc a;
+	PipelineStateDesc b;
+	EXPECT_TRUE(PipelineStateCache::MakeKey(a.Blend) == PipelineStateCache::MakeKey(b.Blend));
+	EXPECT_TRUE(PipelineStateCache::MakeKey(a.Rasterizer) == PipelineStateCache::MakeKey(b.Rasterizer));
+	EXPECT_TRUE(PipelineStateCache::MakeKey(a.DepthStencil) == PipelineStateCache::MakeKey(b.DepthStencil));
+
+	b.Rasterizer.CullMode = D3D11_CULL_FRONT;
+	StateKey culledBack = PipelineStateCache::MakeKey(a.Rasterizer);
+	StateKey culledFront = PipelineStateCache::MakeKey(b.Rasterizer);
+	EXPECT_FALSE(culledBack == culledFront);
+	EXPECT_NE(culledBack.Hash, culledFront.Hash);
+}
+
+TEST(PipelineStateKey, PaddingNeverGetsIn)
+{
+	// Same fields over different garbage: RenderTargetWriteMask is a byte followed by padding
+	D3D11_BLEND_DESC a;
+	D3D11_BLEND_DESC b;
+	memset(&a, 0x00, sizeof(a));
+	memset(&b, 0xAB, sizeof(b));
+	PipelineStateDesc defaults;
+	a.AlphaToCoverageEnable = b.AlphaToCoverageEnable = false;
+	a.IndependentBlendEnable = b.IndependentBlendEnable = false;
+	for (int i = 0; i < 8; i++) {
+		a.RenderTarget[i] = defaults.Blend.RenderTarget[i];
+		b.RenderTarget[i] = defaults.Blend.RenderTarget[i];
+	}
+	EXPECT_TRUE(PipelineStateCache::MakeKey(a) == PipelineStateCache::MakeKey(b));
+}
+
+TEST(PipelineStateKey, UnusedRenderTargetsAreIgnored)
+{
+	PipelineStateDesc a;
+	PipelineStateDesc b;
+	b.Blend.RenderTarget[3].BlendEnable = true;
+	b.Blend.RenderTarget[3].SrcBlend = D3D11_BLEND_SRC_ALPHA;
+	EXPECT_TRUE(PipelineStateCache::MakeKey(a.Blend) == PipelineStateCache::MakeKey(b.Blend));
+
+	// Unless every target blends on its own
+	a.Blend.IndependentBlendEnable = true;
+	b.Blend.IndependentBlendEnable = true;
+	EXPECT_FALSE(PipelineStateCache::MakeKey(a.Blend) == PipelineStateCache::MakeKey(b.Blend));
+}
+
+TEST(PipelineStateKey, KindsNeverCollide)
+{
+	// All zero, so only the kind tells them apart
+	D3D11_BLEND_DESC blend;
+	D3D11_RASTERIZER_DESC rasterizer;
+	D3D11_DEPTH_STENCIL_DESC depthStencil;
+	D3D11_SAMPLER_DESC sampler;
+	memset(&blend, 0, sizeof(blend));
+	memset(&rasterizer, 0, sizeof(rasterizer));
+	memset(&depthStencil, 0, sizeof(depthStencil));
+	memset(&sampler, 0, sizeof(sampler));
+	StateKey keys[4] = { PipelineStateCache::MakeKey(blend), PipelineStateCache::MakeKey(rasterizer),
+		PipelineStateCache::MakeKey(depthStencil), PipelineStateCache::MakeKey(sampler) };
+	for (int i = 0; i < 4; i++) {
+		for (int j = i + 1; j < 4; j++) {
+			EXPECT_FALSE(keys[i] == keys[j]);
+			EXPECT_NE(keys[i].Hash, keys[j].Hash);
+		}
+	}
+}
+
+TEST_F(PipelineStateCacheTest, EqualDescriptionsShareOneObject)
+{
+	EXPECT_EQ(0.0f, cache->GetHitRate());
+
+	PipelineStateDesc desc;
+	Microsoft::WRL::ComPtr<ID3D11RasterizerState> first = cache->GetRasterizerState(desc.Rasterizer);
+	Microsoft::WRL::ComPtr<ID3D11RasterizerState> second = cache->GetRasterizerState(desc.Rasterizer);
+	ASSERT_TRUE(first);
+	EXPECT_EQ(first.Get(), second.Get());
+	desc.Rasterizer.CullMode = D3D11_CULL_NONE;
+	Microsoft::WRL::ComPtr<ID3D11RasterizerState> unculled = cache->GetRasterizerState(desc.Rasterizer);
+	EXPECT_NE(first.Get(), unculled.Get());
+
+	const PipelineStateCacheStats& stats = cache->GetStats();
+	EXPECT_EQ(3u, stats.Requests);
+	EXPECT_EQ(1u, stats.Hits);
+	EXPECT_EQ(2u, stats.Created);
+	EXPECT_FLOAT_EQ(1.0f / 3.0f, cache->GetHitRate());
+}
+
+TEST_F(PipelineStateCacheTest, PipelinesShareTheirStates)
+{
+	// Each pipeline asks for its three states, then for itself
+	std::shared_ptr<PipelineState> pipeline = cache->GetPipelineState(Desc(pixelShader));
+	ASSERT_TRUE(pipeline != nullptr);
+	EXPECT_EQ(4u, cache->GetStats().Requests);
+	EXPECT_EQ(4u, cache->GetStats().Created);
+
+	EXPECT_EQ(pipeline, cache->GetPipelineState(Desc(pixelShader)));
+	EXPECT_EQ(8u, cache->GetStats().Requests);
+	EXPECT_EQ(4u, cache->GetStats().Hits);
+	EXPECT_FLOAT_EQ(0.5f, cache->GetHitRate());
+
+	// Another pixel shader is another pipeline, over the same three states
+	std::shared_ptr<PipelineState> other = cache->GetPipelineState(Desc(otherPixelShader));
+	ASSERT_TRUE(other != nullptr);
+	EXPECT_NE(pipeline, other);
+	EXPECT_NE(pipeline->GetHash(), other->GetHash());
+	EXPECT_EQ(pipeline->GetBlendState(), other->GetBlendState());
+	EXPECT_EQ(pipeline->GetRasterizerState(), other->GetRasterizerState());
+	EXPECT_EQ(pipeline->GetDepthStencilState(), other->GetDepthStencilState());
+	EXPECT_EQ(12u, cache->GetStats().Requests);
+	EXPECT_EQ(7u, cache->GetStats().Hits);
+	EXPECT_EQ(5u, cache->GetStats().Created);
+}
+
+// --------------------------------------------------------
+// Binding a pipeline is one command carrying everything,
+// not a command per shader and state
+// --------------------------------------------------------
+class PipelineRecordingBackend : public ICommandBackend
+{
+public:
+	unsigned int Calls = 0;
+	unsigned int PipelineCalls = 0;
+	PipelineHandles Pipeline;
+
+	void SetVertexShader(void*, void*) { Calls++; }
+	void SetPixelShader(void*) { Calls++; }
+	void SetConstants(unsigned int, unsigned int, void*, const void*, unsigned int) { Calls++; }
+	void SetShaderResource(unsigned int, unsigned int, void*) { Calls++; }
+	void SetSampler(unsigned int, unsigned int, void*) { Calls++; }
+	void SetBlendState(void*) { Calls++; }
+	void SetRasterizerState(void*) { Calls++; }
+	void SetDepthStencilState(void*, unsigned int) { Calls++; }
+	void SetPipelineState(const PipelineHandles& pipeline)
+	{
+		Calls++;
+		PipelineCalls++;
+		Pipeline = pipeline;
+	}
+	void SetMeshBuffers(void*, void*, unsigned int) { Calls++; }
+	void DrawIndexed(unsigned int, unsigned int, int) { Calls++; }
+};
+
+TEST_F(PipelineStateCacheTest, RecordIsOneCommand)
+{
+	PipelineStateDesc desc = Desc(pixelShader);
+	desc.StencilRef = 3;
+	std::shared_ptr<PipelineState> pipeline = cache->GetPipelineState(desc);
+	ASSERT_TRUE(pipeline != nullptr);
+
+	CommandBuffer commands;
+	pipeline->Record(commands);
+	EXPECT_EQ(1u, commands.GetCommandCount());
+
+	PipelineRecordingBackend backend;
+	EXPECT_TRUE(commands.Replay(backend));
+	EXPECT_EQ(1u, backend.Calls);
+	EXPECT_EQ(1u, backend.PipelineCalls);
+	EXPECT_EQ((void*)pipeline->GetBlendState(), backend.Pipeline.BlendState);
+	EXPECT_EQ((void*)pipeline->GetRasterizerState(), backend.Pipeline.RasterizerState);
+	EXPECT_EQ((void*)pipeline->GetDepthStencilState(), backend.Pipeline.DepthStencilState);
+	EXPECT_EQ(3u, backend.Pipeline.StencilRef);
+}
+
+#ifndef _WIN32
+TEST_F(PipelineStateCacheTest, RejectedDescriptionsAreNotCached)
+{
+	fakeDevice.Fail = true;
+	PipelineStateDesc desc;
+	EXPECT_FALSE(cache->GetBlendState(desc.Blend));
+	EXPECT_TRUE(cache->GetPipelineState(Desc(pixelShader)) == nullptr);
+	EXPECT_EQ(0u, cache->GetStats().Created);
+
+	// Nothing was remembered, so it's made as soon as the device can
+	fakeDevice.Fail = false;
+	EXPECT_TRUE(cache->GetBlendState(desc.Blend));
+	EXPECT_EQ(1u, cache->GetStats().Created);
+	EXPECT_EQ(0u, cache->GetStats().Hits);
+}
+#endif
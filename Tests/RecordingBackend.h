@@ -0,0 +1,41 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "ICommandBackend.h"
+
+// --------------------------------------------------------
+// Writes every call down as a line of text, so a replay can
+// be compared against the calls that were recorded
+// --------------------------------------------------------
+class RecordingBackend : public ICommandBackend
+{
+public:
+	std::vector<std::string> Calls;
+	std::vector<std::vector<uint8_t>> Constants;
+
+	void Add(const char* name, uintptr_t a = 0, uintptr_t b = 0, uintptr_t c = 0)
+	{
+		Calls.push_back(std::string(name) + " " + std::to_string(a) + " " + std::to_string(b) + " " + std::to_string(c));
+	}
+
+	void SetVertexShader(void* shader, void* inputLayout) { Add("vs", (uintptr_t)shader, (uintptr_t)inputLayout); }
+	void SetPixelShader(void* shader) { Add("ps", (uintptr_t)shader); }
+	void SetConstants(unsigned int stage, unsigned int slot, void* buffer, const void* data, unsigned int size)
+	{
+		Add("constants", stage, slot, (uintptr_t)buffer);
+		Constants.push_back(std::vector<uint8_t>((const uint8_t*)data, (const uint8_t*)data + size));
+	}
+	void SetShaderResource(unsigned int stage, unsigned int slot, void* resource) { Add("srv", stage, slot, (uintptr_t)resource); }
+	void SetSampler(unsigned int stage, unsigned int slot, void* sampler) { Add("sampler", stage, slot, (uintptr_t)sampler); }
+	void SetBlendState(void* state) { Add("blend", (uintptr_t)state); }
+	void SetRasterizerState(void* state) { Add("rasterizer", (uintptr_t)state); }
+	void SetDepthStencilState(void* state, unsigned int stencilRef) { Add("depth", (uintptr_t)state, stencilRef); }
+	void SetPipelineState(const PipelineHandles& pipeline)
+	{
+		Add("pipeline", (uintptr_t)pipeline.VertexShader, (uintptr_t)pipeline.InputLayout, (uintptr_t)pipeline.PixelShader);
+		Add("pipeline states", (uintptr_t)pipeline.BlendState, (uintptr_t)pipeline.RasterizerState, (uintptr_t)pipeline.DepthStencilState);
+	}
+	void SetMeshBuffers(void* vertexBuffer, void* indexBuffer, unsigned int stride) { Add("mesh", (uintptr_t)vertexBuffer, (uintptr_t)indexBuffer, stride); }
+	void DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex) { Add("draw", indexCount, startIndex, (uintptr_t)baseVertex); }
+};
@@ -0,0 +1,293 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include "SceneFile.h"
+
+using namespace DirectX;
+
+// Where SceneFileHeader keeps what the corruption tests overwrite
+#define HEADER_MAGIC 0
+#define HEADER_VERSION 4
+#define HEADER_FILE_SIZE 8
+#define HEADER_ENTITY_COUNT 24
+#define HEADER_MESH_NAMES 48
+#define HEADER_ENTITIES 64
+
+static std::string TempPath(const char* name)
+{
+	return ::testing::TempDir() + "SceneFileTests_" + name;
+}
+
+static void WriteFile(const std::string& fileName, const std::string& contents)
+{
+	std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+	file.write(contents.data(), contents.size());
+}
+
+static std::string ReadFile(const std::string& fileName)
+{
+	std::ifstream file(fileName, std::ios::binary);
+	return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// Every property set to something that isn't its default, and a name used twice
+static SceneData MakeScene()
+{
+	SceneData scene;
+	scene.AmbientColor = XMFLOAT3(0.15f, 0.2f, 0.25f);
+	scene.MeshNames = { "sphere", "quad" };
+	scene.MaterialNames = { "redGlass", "metalHatch" };
+
+	SceneEntity entity = {};
+	entity.MeshIndex = 0;
+	entity.MaterialIndex = 0;
+	entity.Position = XMFLOAT3(6, 0.1f, -3.3333333f);
+	entity.Rotation = XMFLOAT3(0.5f, 1.25f, -0.75f);
+	entity.Scale = XMFLOAT3(1, 2, 3);
+	scene.Entities.push_back(entity);
+	entity.MeshIndex = 1;
+	entity.MaterialIndex = 1;
+	entity.Flags = SCENE_ENTITY_STATIC | SCENE_ENTITY_OCCLUDER;
+	scene.Entities.push_back(entity);
+	entity.MeshIndex = 0;
+	entity.Flags = SCENE_ENTITY_OCCLUDER;
+	scene.Entities.push_back(entity);
+
+	Light light = {};
+	light.type = 1;
+	light.color = XMFLOAT3(1, 0, 0);
+	light.position = XMFLOAT3(6, 0, 0);
+	light.direction = XMFLOAT3(0, -1, 0);
+	light.intensity = 0.8f;
+	light.range = 2;
+	light.spotFalloff = 16;
+	scene.Lights.push_back(light);
+	light.type = 2;
+	light.intensity = 1.0f / 3;
+	scene.Lights.push_back(light);
+	return scene;
+}
+
+static void ExpectFloat3Eq(const XMFLOAT3& expected, const XMFLOAT3& actual)
+{
+	EXPECT_EQ(expected.x, actual.x);
+	EXPECT_EQ(expected.y, actual.y);
+	EXPECT_EQ(expected.z, actual.z);
+}
+
+// Exact equality: the text form is written with enough digits to read back every float
+static void ExpectSameScene(const SceneData& expected, const SceneData& actual)
+{
+	ExpectFloat3Eq(expected.AmbientColor, actual.AmbientColor);
+	EXPECT_EQ(expected.MeshNames, actual.MeshNames);
+	EXPECT_EQ(expected.MaterialNames, actual.MaterialNames);
+	ASSERT_EQ(expected.Entities.size(), actual.Entities.size());
+	for (unsigned int i = 0; i < expected.Entities.size(); i++) {
+		EXPECT_EQ(expected.Entities[i].MeshIndex, actual.Entities[i].MeshIndex);
+		EXPECT_EQ(expected.Entities[i].MaterialIndex, actual.Entities[i].MaterialIndex);
+		ExpectFloat3Eq(expected.Entities[i].Position, actual.Entities[i].Position);
+		ExpectFloat3Eq(expected.Entities[i].Rotation, actual.Entities[i].Rotation);
+		ExpectFloat3Eq(expected.Entities[i].Scale, actual.Entities[i].Scale);
+		EXPECT_EQ(expected.Entities[i].Flags, actual.Entities[i].Flags);
+	}
+	ASSERT_EQ(expected.Lights.size(), actual.Lights.size());
+	for (unsigned int i = 0; i < expected.Lights.size(); i++) {
+		EXPECT_EQ(expected.Lights[i].type, actual.Lights[i].type);
+		ExpectFloat3Eq(expected.Lights[i].color, actual.Lights[i].color);
+		ExpectFloat3Eq(expected.Lights[i].position, actual.Lights[i].position);
+		ExpectFloat3Eq(expected.Lights[i].direction, actual.Lights[i].direction);
+		EXPECT_EQ(expected.Lights[i].intensity, actual.Lights[i].intensity);
+		EXPECT_EQ(expected.Lights[i].range, actual.Lights[i].range);
+		EXPECT_EQ(expected.Lights[i].spotFalloff, actual.Lights[i].spotFalloff);
+	}
+}
+
+TEST(SceneFile, TextRoundTrips)
+{
+	std::string fileName = TempPath("roundtrip.txt");
+	SceneData scene = MakeScene();
+	ASSERT_TRUE(SceneFile::SaveText(fileName.c_str(), scene));
+	SceneData loaded;
+	ASSERT_TRUE(SceneFile::LoadText(fileName.c_str(), loaded));
+	ExpectSameScene(scene, loaded);
+	remove(fileName.c_str());
+}
+
+TEST(SceneFile, BinaryRoundTrips)
+{
+	std::string fileName = TempPath("roundtrip.scene");
+	SceneData scene = MakeScene();
+	ASSERT_TRUE(SceneFile::SaveBinary(fileName.c_str(), scene));
+
+	MappedScene mapped;
+	ASSERT_TRUE(mapped.Open(fileName.c_str()));
+	EXPECT_TRUE(mapped.IsOpen());
+	ASSERT_EQ(2u, mapped.GetMeshCount());
+	EXPECT_STREQ("quad", mapped.GetMeshName(1));
+	ASSERT_EQ(2u, mapped.GetMaterialCount());
+	EXPECT_STREQ("redGlass", mapped.GetMaterialName(0));
+	ASSERT_EQ(3u, mapped.GetEntityCount());
+	EXPECT_EQ((uint32_t)SCENE_ENTITY_STATIC | SCENE_ENTITY_OCCLUDER, mapped.GetEntities()[1].Flags);
+	ASSERT_EQ(2u, mapped.GetLightCount());
+	EXPECT_EQ(2, mapped.GetLights()[1].type);
+	SceneData loaded;
+	mapped.ToSceneData(loaded);
+	ExpectSameScene(scene, loaded);
+
+	// The fixups are copy-on-write, the file itself still holds offsets
+	mapped.Close();
+	EXPECT_FALSE(mapped.IsOpen());
+	ASSERT_TRUE(mapped.Open(fileName.c_str()));
+	EXPECT_STREQ("sphere", mapped.GetMeshName(0));
+	mapped.Close();
+	remove(fileName.c_str());
+}
+
+TEST(SceneFile, EmptySceneRoundTrips)
+{
+	std::string fileName = TempPath("empty.scene");
+	SceneData scene;
+	scene.AmbientColor = XMFLOAT3(0, 0, 0);
+	ASSERT_TRUE(SceneFile::SaveBinary(fileName.c_str(), scene));
+	MappedScene mapped;
+	ASSERT_TRUE(mapped.Open(fileName.c_str()));
+	EXPECT_EQ(0u, mapped.GetMeshCount());
+	EXPECT_EQ(0u, mapped.GetEntityCount());
+	EXPECT_EQ(0u, mapped.GetLightCount());
+	mapped.Close();
+	remove(fileName.c_str());
+}
+
+TEST(SceneFile, TextDefaultsAndComments)
+{
+	std::string fileName = TempPath("defaults.txt");
+	WriteFile(fileName,
+		"# a comment line\n"
+		"\n"
+		"entity sphere lit   # position and scale left out\n"
+		"entity sphere lit position 1 2 3 static\n"
+		"light directional\n");
+	SceneData scene;
+	ASSERT_TRUE(SceneFile::LoadText(fileName.c_str(), scene));
+	ExpectFloat3Eq(XMFLOAT3(0, 0, 0), scene.AmbientColor);
+	ASSERT_EQ(1u, scene.MeshNames.size());
+	ASSERT_EQ(2u, scene.Entities.size());
+	ExpectFloat3Eq(XMFLOAT3(0, 0, 0), scene.Entities[0].Position);
+	ExpectFloat3Eq(XMFLOAT3(1, 1, 1), scene.Entities[0].Scale);
+	EXPECT_EQ(0u, scene.Entities[0].Flags);
+	ExpectFloat3Eq(XMFLOAT3(1, 2, 3), scene.Entities[1].Position);
+	EXPECT_EQ((uint32_t)SCENE_ENTITY_STATIC, scene.Entities[1].Flags);
+	ASSERT_EQ(1u, scene.Lights.size());
+	EXPECT_EQ(0, scene.Lights[0].type);
+	remove(fileName.c_str());
+}
+
+TEST(SceneFile, MalformedTextIsRejected)
+{
+	const char* badLines[] = {
+		"sky blue",									// Unknown keyword
+		"entity sphere",							// No material
+		"entity sphere lit position 1 2",			// Too few numbers
+		"entity sphere lit position 1 x 3",			// Not a number
+		"entity sphere lit glowing",				// Unknown property
+		"light neon color 1 1 1",					// Unknown light type
+		"light point intensity",					// Missing value
+		"ambient 1 1",
+	};
+	std::string fileName = TempPath("malformed.txt");
+	for (const char* badLine : badLines) {
+		WriteFile(fileName, std::string("ambient 0.1 0.1 0.1\n") + badLine + "\n");
+		SceneData scene;
+		EXPECT_FALSE(SceneFile::LoadText(fileName.c_str(), scene)) << badLine;
+	}
+	remove(fileName.c_str());
+
+	SceneData scene;
+	EXPECT_FALSE(SceneFile::LoadText(TempPath("missing.txt").c_str(), scene));
+}
+
+// --------------------------------------------------------
+// Cooks the test scene, lets corrupt() change the bytes,
+// and expects Open to turn the result down
+// --------------------------------------------------------
+template<typename Corrupt>
+static void ExpectOpenFails(const char* name, Corrupt corrupt)
+{
+	std::string fileName = TempPath(name);
+	ASSERT_TRUE(SceneFile::SaveBinary(fileName.c_str(), MakeScene()));
+	std::string bytes = ReadFile(fileName);
+	corrupt(bytes);
+	WriteFile(fileName, bytes);
+	MappedScene mapped;
+	EXPECT_FALSE(mapped.Open(fileName.c_str())) << name;
+	EXPECT_FALSE(mapped.IsOpen()) << name;
+	remove(fileName.c_str());
+}
+
+template<typename T>
+static void Overwrite(std::string& bytes, size_t offset, T value)
+{
+	memcpy(&bytes[offset], &value, sizeof(T));
+}
+
+template<typename T>
+static T Read(const std::string& bytes, size_t offset)
+{
+	T value;
+	memcpy(&value, &bytes[offset], sizeof(T));
+	return value;
+}
+
+TEST(SceneFile, MalformedBinaryIsRejected)
+{
+	ExpectOpenFails("empty.bin", [](std::string& bytes) { bytes.clear(); });
+	ExpectOpenFails("short.bin", [](std::string& bytes) { bytes.resize(20); });
+	ExpectOpenFails("truncated.bin", [](std::string& bytes) { bytes.resize(bytes.size() - 4); });
+	ExpectOpenFails("magic.bin", [](std::string& bytes) { Overwrite<uint32_t>(bytes, HEADER_MAGIC, 0x12345678); });
+	ExpectOpenFails("version.bin", [](std::string& bytes) { Overwrite<uint32_t>(bytes, HEADER_VERSION, 99); });
+	ExpectOpenFails("size.bin", [](std::string& bytes) { Overwrite<uint64_t>(bytes, HEADER_FILE_SIZE, bytes.size() + 16); });
+	ExpectOpenFails("entities.bin", [](std::string& bytes) { Overwrite<uint64_t>(bytes, HEADER_ENTITIES, bytes.size() - 8); });
+	ExpectOpenFails("count.bin", [](std::string& bytes) { Overwrite<uint32_t>(bytes, HEADER_ENTITY_COUNT, 0x7fffffff); });
+	ExpectOpenFails("names.bin", [](std::string& bytes) { Overwrite<uint64_t>(bytes, HEADER_MESH_NAMES, (uint64_t)1 << 40); });
+
+	// A name whose terminator was overwritten, or whose text points past the end
+	ExpectOpenFails("terminator.bin", [](std::string& bytes) {
+		uint64_t table = Read<uint64_t>(bytes, HEADER_MESH_NAMES);
+		uint64_t text = Read<uint64_t>(bytes, (size_t)table);
+		uint32_t length = Read<uint32_t>(bytes, (size_t)table + 8);
+		bytes[(size_t)(text + length)] = 'x';
+	});
+	ExpectOpenFails("text.bin", [](std::string& bytes) {
+		uint64_t table = Read<uint64_t>(bytes, HEADER_MESH_NAMES);
+		Overwrite<uint64_t>(bytes, (size_t)table, bytes.size());
+	});
+
+	MappedScene mapped;
+	EXPECT_FALSE(mapped.Open(TempPath("missing.bin").c_str()));
+}
+
+TEST(SceneFile, CookOnlyWhenStale)
+{
+	std::string textName = TempPath("cook.txt");
+	std::string binaryName = TempPath("cook.scene");
+	remove(binaryName.c_str());
+	ASSERT_TRUE(SceneFile::SaveText(textName.c_str(), MakeScene()));
+	EXPECT_TRUE(SceneFile::IsBinaryStale(textName.c_str(), binaryName.c_str()));
+	ASSERT_TRUE(SceneFile::Cook(textName.c_str(), binaryName.c_str()));
+	EXPECT_FALSE(SceneFile::IsBinaryStale(textName.c_str(), binaryName.c_str()));
+
+	MappedScene mapped;
+	ASSERT_TRUE(mapped.Open(binaryName.c_str()));
+	EXPECT_EQ(3u, mapped.GetEntityCount());
+	mapped.Close();
+
+	// Without the text the binary is all there is
+	remove(textName.c_str());
+	EXPECT_FALSE(SceneFile::IsBinaryStale(textName.c_str(), binaryName.c_str()));
+	remove(binaryName.c_str());
+}
@@ -0,0 +1,130 @@
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include "RecordingBackend.h"
+#include "StateFilterBackend.h"
+
+static void* Handle(uintptr_t id)
+{
+	return (void*)id;
+}
+
+TEST(StateFilterBackend, DropsRepeatedBindings)
+{
+	RecordingBackend target;
+	StateFilterBackend filter(&target);
+	for (int draw = 0; draw < 3; draw++) {
+		filter.SetVertexShader(Handle(1), Handle(2));
+		filter.SetPixelShader(Handle(3));
+		filter.SetShaderResource(SHADER_STAGE_PIXEL, 0, Handle(4));
+		filter.SetSampler(SHADER_STAGE_PIXEL, 0, Handle(5));
+		filter.SetBlendState(Handle(6));
+		filter.SetRasterizerState(Handle(7));
+		filter.SetDepthStencilState(Handle(8), 1);
+		filter.SetMeshBuffers(Handle(9), Handle(10), 44);
+		filter.DrawIndexed(36, 0, 0);
+	}
+	std::vector<std::string> expected = {
+		"vs 1 2 0", "ps 3 0 0", "srv 1 0 4", "sampler 1 0 5", "blend 6 0 0", "rasterizer 7 0 0", "depth 8 1 0", "mesh 9 10 44",
+		"draw 36 0 0", "draw 36 0 0", "draw 36 0 0",
+	};
+	EXPECT_EQ(expected, target.Calls);
+
+	const StateFilterStats& stats = filter.GetStats();
+	EXPECT_EQ(11u, stats.GetIssued());
+	EXPECT_EQ(16u, stats.GetFiltered());
+	EXPECT_EQ(1u, stats.Issued[COMMAND_SET_SHADER_RESOURCE]);
+	EXPECT_EQ(2u, stats.Filtered[COMMAND_SET_SHADER_RESOURCE]);
+	EXPECT_EQ(3u, stats.Issued[COMMAND_DRAW_INDEXED]);
+	EXPECT_EQ(0u, stats.Filtered[COMMAND_DRAW_INDEXED]);
+}
+
+TEST(StateFilterBackend, ForwardsAnythingThatChanges)
+{
+	RecordingBackend target;
+	StateFilterBackend filter(&target);
+	filter.SetVertexShader(Handle(1), Handle(2));
+	filter.SetVertexShader(Handle(1), Handle(3));		// Same shader, new layout
+	filter.SetShaderResource(SHADER_STAGE_PIXEL, 0, Handle(4));
+	filter.SetShaderResource(SHADER_STAGE_PIXEL, 1, Handle(4));	// Same resource, another slot
+	filter.SetShaderResource(SHADER_STAGE_VERTEX, 0, Handle(4));	// Same slot, another stage
+	filter.SetShaderResource(SHADER_STAGE_PIXEL, 0, nullptr);		// Unbinding is a change too
+	filter.SetDepthStencilState(Handle(8), 1);
+	filter.SetDepthStencilState(Handle(8), 2);			// Same state, new stencil reference
+	filter.SetMeshBuffers(Handle(9), Handle(10), 44);
+	filter.SetMeshBuffers(Handle(9), Handle(10), 32);
+	EXPECT_EQ(10u, target.Calls.size());
+	EXPECT_EQ(0u, filter.GetStats().GetFiltered());
+}
+
+TEST(StateFilterBackend, ConstantsAreComparedByContents)
+{
+	RecordingBackend target;
+	StateFilterBackend filter(&target);
+	float color[4] = { 1, 0, 0, 1 };
+	filter.SetConstants(SHADER_STAGE_PIXEL, 0, Handle(20), color, sizeof(color));
+	filter.SetConstants(SHADER_STAGE_PIXEL, 0, Handle(20), color, sizeof(color));	// Dropped
+	color[1] = 0.5f;
+	filter.SetConstants(SHADER_STAGE_PIXEL, 0, Handle(20), color, sizeof(color));	// Same buffer, new data
+	filter.SetConstants(SHADER_STAGE_PIXEL, 1, Handle(20), color, sizeof(color));	// Same data, not bound in this slot yet
+	filter.SetConstants(SHADER_STAGE_PIXEL, 0, Handle(20), color, sizeof(float) * 3);	// Shorter upload
+	ASSERT_EQ(4u, target.Constants.size());
+	EXPECT_EQ(0.5f, ((const float*)target.Constants[1].data())[1]);
+	EXPECT_EQ(sizeof(float) * 3, target.Constants[3].size());
+	EXPECT_EQ(4u, filter.GetStats().Issued[COMMAND_SET_CONSTANTS]);
+	EXPECT_EQ(1u, filter.GetStats().Filtered[COMMAND_SET_CONSTANTS]);
+
+	// Another buffer with the same contents is another upload
+	filter.SetConstants(SHADER_STAGE_PIXEL, 0, Handle(21), color, sizeof(float) * 3);
+	EXPECT_EQ(5u, target.Constants.size());
+}
+
+TEST(StateFilterBackend, PipelinesAreDroppedOnlyWhenNothingChanges)
+{
+	RecordingBackend target;
+	StateFilterBackend filter(&target);
+	PipelineHandles pipeline = { Handle(1), Handle(2), Handle(3), Handle(4), Handle(5), Handle(6), 0, 0 };
+	filter.SetPipelineState(pipeline);
+	filter.SetPipelineState(pipeline);
+	// The pipeline already bound these, so the separate calls are no-ops
+	filter.SetVertexShader(Handle(1), Handle(2));
+	filter.SetBlendState(Handle(4));
+	pipeline.BlendState = Handle(7);
+	filter.SetPipelineState(pipeline);
+	EXPECT_EQ(2u, filter.GetStats().Issued[COMMAND_SET_PIPELINE_STATE]);
+	EXPECT_EQ(1u, filter.GetStats().Filtered[COMMAND_SET_PIPELINE_STATE]);
+	EXPECT_EQ(4u, target.Calls.size());	// Each pipeline writes two lines
+	EXPECT_EQ(3u, filter.GetStats().GetFiltered());
+}
+
+TEST(StateFilterBackend, InvalidateLetsTheNextCallThrough)
+{
+	RecordingBackend target;
+	StateFilterBackend filter(&target);
+	float data[2] = { 3, 4 };
+	filter.SetPixelShader(Handle(3));
+	filter.SetShaderResource(SHADER_STAGE_PIXEL, 0, Handle(4));
+	filter.SetConstants(SHADER_STAGE_VERTEX, 0, Handle(20), data, sizeof(data));
+	filter.SetBlendState(nullptr);
+	EXPECT_EQ(4u, target.Calls.size());
+
+	// Something else touched the context, so none of these are known to be no-ops any more
+	filter.Invalidate();
+	filter.SetPixelShader(Handle(3));
+	filter.SetShaderResource(SHADER_STAGE_PIXEL, 0, Handle(4));
+	filter.SetConstants(SHADER_STAGE_VERTEX, 0, Handle(20), data, sizeof(data));
+	filter.SetBlendState(nullptr);
+	EXPECT_EQ(8u, target.Calls.size());
+	EXPECT_EQ(0u, filter.GetStats().GetFiltered());
+
+	// And once they've been through again they're filtered again
+	filter.SetPixelShader(Handle(3));
+	filter.SetConstants(SHADER_STAGE_VERTEX, 0, Handle(20), data, sizeof(data));
+	EXPECT_EQ(8u, target.Calls.size());
+	EXPECT_EQ(2u, filter.GetStats().GetFiltered());
+
+	filter.ResetStats();
+	EXPECT_EQ(0u, filter.GetStats().GetIssued());
+	EXPECT_EQ(0u, filter.GetStats().GetFiltered());
+}
@@ -0,0 +1,134 @@
+#include <memory>
+#include <vector>
+#include <gtest/gtest.h>
+#include "AllocationCounter.h"
+#include "Camera.h"
+#include "DepthSorter.h"
+#include "FrustumCuller.h"
+#include "InstanceBatcher.h"
+#include "OcclusionCuller.h"
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// The per-frame passes keep their scratch (SoA bounds,
+// sort keys, visible lists, packed instances) in member
+// vectors that are cleared rather than freed, so once the
+// first frames have grown them to size a frame makes no
+// heap allocations at all.  Each test runs a few frames to
+// warm up, then counts the allocations of one more.
+// --------------------------------------------------------
+#define WARM_UP_FRAMES 3
+
+static std::vector<AABB> MakeBoxes(unsigned int count)
+{
+	std::vector<AABB> boxes(count);
+	for (unsigned int i = 0; i < count; i++) {
+		boxes[i].Center = XMFLOAT3((float)(i % 40) * 5 - 100, (float)(i % 7) - 3, (float)(i / 40) * 5);
+		boxes[i].Extents = XMFLOAT3(1, 1, 1);
+	}
+	return boxes;
+}
+
+static Camera MakeCamera()
+{
+	return Camera(Transform(0, 0, -10, 0, 0, 0, 1, 1, 1), 2.0f);
+}
+
+TEST(SteadyStateAllocation, FrustumCulling)
+{
+	std::vector<AABB> boxes = MakeBoxes(4000);
+	Camera camera = MakeCamera();
+	Frustum frustum(camera.GetViewMatrix(), camera.GetProjectionMatrix());
+	FrustumCuller culler;
+	std::vector<unsigned int> visible;
+	for (int frame = 0; frame <= WARM_UP_FRAMES; frame++) {
+		AllocationCounter allocations;
+		culler.Clear();
+		for (unsigned int i = 0; i < boxes.size(); i++) {
+			culler.Add(boxes[i]);
+		}
+		culler.Cull(frustum, visible);
+		if (frame == WARM_UP_FRAMES) {
+			EXPECT_EQ(0u, allocations.GetCount());
+			EXPECT_GT(visible.size(), 0u);
+		}
+	}
+}
+
+TEST(SteadyStateAllocation, OcclusionCulling)
+{
+	static const XMFLOAT3 corners[] = { XMFLOAT3(-50, 50, 0), XMFLOAT3(50, 50, 0), XMFLOAT3(50, -50, 0), XMFLOAT3(-50, -50, 0) };
+	static const unsigned int indices[] = { 0, 1, 2, 0, 2, 3 };
+	XMFLOAT4X4 world;
+	XMStoreFloat4x4(&world, XMMatrixTranslation(0, 0, 30));
+	std::vector<AABB> boxes = MakeBoxes(4000);
+	std::vector<unsigned int> candidates(boxes.size());
+	for (unsigned int i = 0; i < candidates.size(); i++) {
+		candidates[i] = i;
+	}
+	Camera camera = MakeCamera();
+	OcclusionCuller culler;
+	std::vector<unsigned int> visible;
+	for (int frame = 0; frame <= WARM_UP_FRAMES; frame++) {
+		AllocationCounter allocations;
+		culler.BeginFrame(camera.GetViewMatrix(), camera.GetProjectionMatrix());
+		culler.AddOccluder(corners, indices, 6, world);
+		culler.RasterizeOccluders();
+		culler.Cull(boxes, candidates, visible);
+		if (frame == WARM_UP_FRAMES) {
+			EXPECT_EQ(0u, allocations.GetCount());
+			EXPECT_LT(visible.size(), candidates.size());
+		}
+	}
+}
+
+TEST(SteadyStateAllocation, DepthSort)
+{
+	std::vector<XMFLOAT3> positions(3000);
+	for (unsigned int i = 0; i < positions.size(); i++) {
+		positions[i] = XMFLOAT3((float)(i % 50), 0, (float)(i / 50));
+	}
+	DepthSorter sorter;
+	for (int frame = 0; frame <= WARM_UP_FRAMES + 1; frame++) {
+		AllocationCounter allocations;
+		// Moving far enough every other frame that the coherent pass gives up and radix sorts
+		XMFLOAT3 cameraPosition(frame % 2 ? 100.0f : -100.0f, 5, (float)frame);
+		sorter.Sort(positions.data(), (unsigned int)positions.size(), cameraPosition);
+		if (frame >= WARM_UP_FRAMES) {
+			EXPECT_EQ(0u, allocations.GetCount()) << frame;
+		}
+	}
+}
+
+// The batcher only compares mesh pointers and whether materials share shaders, see InstanceBatcherTests
+TEST(SteadyStateAllocation, InstanceBatching)
+{
+	int meshStorage[8];
+	std::shared_ptr<SimpleVertexShader> vertexShader = std::make_shared<SimpleVertexShader>(nullptr, nullptr, L"VertexShader.cso");
+	std::shared_ptr<SimplePixelShader> pixelShader = std::make_shared<SimplePixelShader>(nullptr, nullptr, L"PixelShader.cso");
+	std::shared_ptr<SimpleVertexShader> instancedVertexShader = std::make_shared<SimpleVertexShader>(nullptr, nullptr, L"InstancedVertexShader.cso");
+	std::shared_ptr<SimplePixelShader> instancedPixelShader = std::make_shared<SimplePixelShader>(nullptr, nullptr, L"InstancedPixelShader.cso");
+	Material lit(XMFLOAT4(1, 1, 1, 1), vertexShader, pixelShader);
+	lit.SetInstancedShaders(instancedVertexShader, instancedPixelShader);
+	Material plain(XMFLOAT4(0, 0, 1, 1), vertexShader, pixelShader);
+
+	std::vector<RenderObject> objects(2000);
+	std::vector<const RenderObject*> pointers(objects.size());
+	for (unsigned int i = 0; i < objects.size(); i++) {
+		objects[i] = {};
+		objects[i].RenderMesh = reinterpret_cast<Mesh*>(&meshStorage[i % 8]);
+		objects[i].RenderMaterial = i % 5 == 0 ? &plain : &lit;
+		XMStoreFloat4x4(&objects[i].World, XMMatrixTranslation((float)i, 0, 0));
+		pointers[i] = &objects[i];
+	}
+	InstanceBatcher batcher;
+	for (int frame = 0; frame <= WARM_UP_FRAMES; frame++) {
+		AllocationCounter allocations;
+		batcher.Build(pointers.data(), (unsigned int)pointers.size(), false);
+		batcher.Build(pointers.data(), (unsigned int)pointers.size(), true);
+		if (frame == WARM_UP_FRAMES) {
+			EXPECT_EQ(0u, allocations.GetCount());
+		}
+	}
+}
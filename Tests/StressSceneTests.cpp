@@ -0,0 +1,53 @@
+#include <gtest/gtest.h>
+#include "StressScene.h"
+
+TEST(StressScene, ParsesCountsAndOptions)
+{
+	StressSceneDesc desc;
+	ASSERT_TRUE(StressScene::Parse("300", desc));
+	EXPECT_EQ(100u, desc.Spheres);
+	EXPECT_EQ(100u, desc.Cubes);
+	EXPECT_EQ(100u, desc.Tori);
+
+	ASSERT_TRUE(StressScene::Parse("spheres=5,cubes=0,tori=2,lights=3,seed=9", desc));
+	EXPECT_EQ(5u, desc.Spheres);
+	EXPECT_EQ(0u, desc.Cubes);
+	EXPECT_EQ(2u, desc.Tori);
+	EXPECT_EQ(3u, desc.PointLights);
+	EXPECT_EQ(9u, desc.Seed);
+
+	EXPECT_FALSE(StressScene::Parse("spheres=5,planets=2", desc));
+	EXPECT_FALSE(StressScene::Parse("spheres", desc));
+}
+
+TEST(StressScene, SameDescriptionSameScene)
+{
+	StressSceneDesc desc;
+	desc.Spheres = 40;
+	desc.Cubes = 30;
+	desc.Tori = 20;
+	SceneData first, second;
+	StressScene::Generate(desc, first);
+	StressScene::Generate(desc, second);
+	ASSERT_EQ(90u, first.Entities.size());
+	ASSERT_EQ(first.Entities.size(), second.Entities.size());
+	for (size_t i = 0; i < first.Entities.size(); i++) {
+		EXPECT_EQ(first.Entities[i].Position.x, second.Entities[i].Position.x);
+		EXPECT_EQ(first.Entities[i].MaterialIndex, second.Entities[i].MaterialIndex);
+	}
+	EXPECT_EQ(1u + desc.PointLights, first.Lights.size());
+}
+
+TEST(StressScene, NoMoreLightsThanTheShadersDraw)
+{
+	// Built in code rather than parsed, so only Generate stands between it and the shaders
+	StressSceneDesc desc;
+	desc.Spheres = 1;
+	desc.Cubes = 0;
+	desc.Tori = 0;
+	desc.PointLights = MAX_LIGHTS * 4;
+	SceneData scene;
+	StressScene::Generate(desc, scene);
+	EXPECT_EQ((size_t)MAX_LIGHTS, scene.Lights.size());
+	EXPECT_EQ(LIGHT_TYPE_DIRECTIONAL, scene.Lights[0].type);
+}
@@ -0,0 +1,33 @@
+#include <math.h>
+#include <gtest/gtest.h>
+#include "Transform.h"
+
+using namespace DirectX;
+
+TEST(Transform, InverseTransposeKeepsNormalsPerpendicular)
+{
+	// Squashed along x, so the world matrix alone would tilt a normal off its surface
+	Transform transform(1, 2, 3, 0, 0.5f, 0, 4, 1, 1);
+	XMFLOAT4X4 world = transform.GetWorldMatrix();
+	XMFLOAT4X4 worldInvTranspose = transform.GetWorldInverseTransposeMatrix();
+
+	// A surface along (1, 0, -1) in model space, with its normal
+	XMVECTOR tangent = XMVector3TransformNormal(XMVectorSet(1, 0, -1, 0), XMLoadFloat4x4(&world));
+	XMVECTOR normal = XMVector3TransformNormal(XMVectorSet(1, 0, 1, 0), XMLoadFloat4x4(&worldInvTranspose));
+	EXPECT_NEAR(0.0f, XMVectorGetX(XMVector3Dot(tangent, normal)), 1e-5f);
+
+	XMFLOAT4X4 expected;
+	XMStoreFloat4x4(&expected, XMMatrixInverse(nullptr, XMMatrixTranspose(XMLoadFloat4x4(&world))));
+	for (int r = 0; r < 4; r++) {
+		for (int c = 0; c < 4; c++) {
+			EXPECT_NEAR(expected.m[r][c], worldInvTranspose.m[r][c], 1e-5f);
+		}
+	}
+
+	// And it follows the transform when it moves
+	transform.SetScale(1, 1, 1);
+	transform.SetRotation(0, 0, 0);
+	worldInvTranspose = transform.GetWorldInverseTransposeMatrix();
+	EXPECT_NEAR(1.0f, worldInvTranspose._11, 1e-5f);
+	EXPECT_NEAR(-1.0f, worldInvTranspose._14, 1e-5f);
+}
@@ -11,7 +11,9 @@ Transform::Transform(XMFLOAT3 position, XMFLOAT3 rotation, XMFLOAT3 scale)
 	this->position = position;
 	this->rotation = rotation;
 	this->scale = scale;
-	dirty = false;
+	XMStoreFloat4x4(&world, XMMatrixIdentity());
+	XMStoreFloat4x4(&worldInverseTranspose, XMMatrixIdentity());
+	dirty = true; //so the first GetWorldMatrix builds it from the values above
 }
 
 Transform::Transform(float posX, float posY, float posZ, float pitch, float yaw, float roll, float scaleX, float scaleY, float scaleZ)
@@ -90,8 +92,9 @@ XMFLOAT4X4 Transform::GetWorldMatrix()
 XMFLOAT4X4 Transform::GetWorldInverseTransposeMatrix()
 {
 	XMFLOAT4X4 worldInvTranspose;
-	XMStoreFloat4x4(&worldInvTranspose, XMMatrixInverse(nullptr, XMMatrixTranspose(XMLoadFloat4x4(&GetWorldMatrix()))));
-	return worldInverseTranspose;
+	XMFLOAT4X4 worldMatrix = GetWorldMatrix();
+	XMStoreFloat4x4(&worldInvTranspose, XMMatrixInverse(nullptr, XMMatrixTranspose(XMLoadFloat4x4(&worldMatrix))));
+	return worldInvTranspose;
 }
 
 void Transform::Translate(float x, float y, float z)
@@ -0,0 +1,57 @@
+#include <atomic>
+#include <chrono>
+#include "TransformSystem.h"
+#include "Profiler.h"
+
+using namespace DirectX;
+
+TransformSystem::TransformSystem(unsigned int minRowsPerJob)
+{
+	this->minRowsPerJob = minRowsPerJob;
+	jobs = nullptr;
+	stats = {};
+}
+
+void TransformSystem::SetJobSystem(JobSystem* jobs)
+{
+	this->jobs = jobs;
+}
+
+void TransformSystem::Update(EntityWorld& world, bool includeStatic)
+{
+	PROFILE_FUNCTION();
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	std::atomic<unsigned int> updated(0);
+
+	world.ForEach(COMPONENT_TRANSFORM, includeStatic ? 0 : COMPONENT_STATIC, [&updated](Archetype& archetype, unsigned int first, unsigned int last) {
+		bool hasBounds = (archetype.Mask & (COMPONENT_RENDERABLE | COMPONENT_BOUNDS)) == (COMPONENT_RENDERABLE | COMPONENT_BOUNDS);
+		unsigned int count = 0;
+		for (unsigned int i = first; i < last; i++) {
+			TransformComponent& transform = archetype.Transforms[i];
+			if (!transform.Dirty) {
+				continue;
+			}
+			// Same order as Transform::GetWorldMatrix: scale, then rotate, then translate
+			XMMATRIX scaling = XMMatrixScaling(transform.Scale.x, transform.Scale.y, transform.Scale.z);
+			XMMATRIX rotation = XMMatrixRotationRollPitchYaw(transform.Rotation.x, transform.Rotation.y, transform.Rotation.z);
+			XMMATRIX translation = XMMatrixTranslation(transform.Position.x, transform.Position.y, transform.Position.z);
+			XMMATRIX worldMatrix = XMMatrixMultiply(XMMatrixMultiply(scaling, rotation), translation);
+			XMStoreFloat4x4(&transform.World, worldMatrix);
+			transform.Dirty = false;
+			if (hasBounds && archetype.Renderables[i].RenderMesh) {
+				archetype.Bounds[i].WorldBounds = TransformBounds(archetype.Renderables[i].RenderMesh->GetLocalBounds(), transform.World);
+			}
+			count++;
+		}
+		updated += count;
+	}, jobs, minRowsPerJob);
+
+	std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+	stats.Updated = updated;
+	stats.Microseconds = std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+const TransformSystemStats& TransformSystem::GetStats()
+{
+	return stats;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "EntityWorld.h"
+
+struct TransformSystemStats
+{
+	unsigned int Updated;		// Transforms that were dirty and got a new world matrix
+	double Microseconds;
+};
+
+// --------------------------------------------------------
+// Rebuilds the world matrix of every dirty transform, and
+// the world bounds of entities that also have a renderable
+// and bounds, walking each archetype's dense arrays as
+// jobs when it has a job system
+// --------------------------------------------------------
+class TransformSystem
+{
+private:
+	JobSystem* jobs;
+	unsigned int minRowsPerJob;
+	TransformSystemStats stats;
+public:
+	TransformSystem(unsigned int minRowsPerJob = 4096);
+	void SetJobSystem(JobSystem* jobs); //null runs everything on the calling thread
+	//static entities are skipped unless asked for, they only need it once after loading
+	void Update(EntityWorld& world, bool includeStatic = false);
+	const TransformSystemStats& GetStats();
+};
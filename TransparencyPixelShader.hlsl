@@ -6,7 +6,8 @@ cbuffer externalData : register(b0) {
 	float roughness;
 	float3 position; //the position of the sphere
 	float3 cameraPosition;
-	Light lights[5];
+	int lightCount;
+	Light lights[32];	// MAX_LIGHTS
 }
 
 // --------------------------------------------------------
@@ -34,7 +35,7 @@ float4 main(VertexToPixel input) : SV_TARGET
 	info.alpha = alpha;
 
 	float4 pixelColor = 0;
-	for (int i = 0; i < 5; i++) {
+	for (int i = 0; i < lightCount; i++) {
 		pixelColor += calculateTotalLighting(lights[i], info);
 
 	}
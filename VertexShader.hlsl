@@ -23,7 +23,7 @@ VertexToPixel main( VertexShaderInput input )
 	output.screenPosition = mul(wvp, float4(input.localPosition, 1.0f));
 
 	output.uv = input.uv;
-	output.normal = mul(world, input.normal); //worldInvTranspose isn't working
+	output.normal = mul((float3x3)worldInvTranspose, input.normal); //stays perpendicular to the surface under non-uniform scale
 	output.worldPosition = mul(world, float4(input.localPosition, 1)).xyz;
 	output.tangent = mul(world, input.tangent);
 
@@ -0,0 +1,470 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <math.h>
+#include <sstream>
+#include <stdio.h>
+#include "WorldStreamer.h"
+#include "FrameArena.h"
+
+using namespace DirectX;
+
+WorldStreamer::WorldStreamer(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, JobSystem* jobs, const std::string& modelDirectory,
+	size_t budgetBytes, float loadRadius, float unloadRadius, unsigned int loadJobCount)
+{
+	this->device = device;
+	this->context = context;
+	this->jobs = jobs;
+	this->modelDirectory = modelDirectory;
+	this->budgetBytes = budgetBytes;
+	this->loadRadius = loadRadius;
+	this->unloadRadius = unloadRadius > loadRadius ? unloadRadius : loadRadius;
+	this->loadJobCount = loadJobCount > 0 ? loadJobCount : 1;
+	cellSize = 1.0f;
+	quitting = false;
+	runningLoadJobs = 0;
+	meshBytes = 0;
+	knownBytes = 0;
+	knownCells = 0;
+	stats = {};
+	stats.BudgetBytes = budgetBytes;
+}
+
+WorldStreamer::~WorldStreamer()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quitting = true;
+	}
+	jobs->Wait(loadJobs); //the cells they're loading right now still finish
+	for (int i = 0; i < completed.size(); ++i) {
+		delete completed[i];
+	}
+	for (int i = 0; i < ready.size(); ++i) {
+		delete ready[i];
+	}
+	for (std::map<std::string, CachedMesh>::iterator it = meshCache.begin(); it != meshCache.end(); ++it) {
+		delete it->second.StreamedMesh;
+	}
+}
+
+bool WorldStreamer::Open(const char* manifestFileName)
+{
+	if (!cells.empty()) {
+		return false;
+	}
+	std::ifstream file(manifestFileName);
+	if (!file.is_open()) {
+		return false;
+	}
+	std::string directory = manifestFileName;
+	size_t slash = directory.find_last_of("/\\");
+	directory = slash == std::string::npos ? "" : directory.substr(0, slash + 1);
+
+	std::string line;
+	while (std::getline(file, line)) {
+		std::istringstream stream(line);
+		std::string keyword;
+		if (!(stream >> keyword) || keyword[0] == '#') {
+			continue;
+		}
+		if (keyword == "cellsize") {
+			stream >> cellSize;
+		}
+		else if (keyword == "cell") {
+			Cell cell = {};
+			std::string cellFile;
+			if (!(stream >> cell.X >> cell.Z >> cellFile)) {
+				printf("Streaming: bad line in %s: \"%s\"\n", manifestFileName, line.c_str());
+				return false;
+			}
+			cell.TextFileName = directory + cellFile;
+			cell.BinaryFileName = cell.TextFileName + "b";
+			cell.State = CELL_UNLOADED;
+			cells.push_back(cell);
+		}
+	}
+	cellSize = cellSize > 0 ? cellSize : 1.0f;
+	stats.Cells = (unsigned int)cells.size();
+	return true;
+}
+
+bool WorldStreamer::WriteWorld(const SceneData& scene, float cellSize, const char* manifestFileName)
+{
+	std::map<std::pair<int, int>, SceneData> cellScenes;
+	for (int i = 0; i < scene.Entities.size(); ++i) {
+		SceneEntity entity = scene.Entities[i];
+		int x = (int)floorf(entity.Position.x / cellSize);
+		int z = (int)floorf(entity.Position.z / cellSize);
+		SceneData& cellScene = cellScenes[std::make_pair(x, z)];
+		entity.MeshIndex = SceneFile::FindOrAddName(cellScene.MeshNames, scene.MeshNames[entity.MeshIndex]);
+		entity.MaterialIndex = SceneFile::FindOrAddName(cellScene.MaterialNames, scene.MaterialNames[entity.MaterialIndex]);
+		cellScene.Entities.push_back(entity);
+	}
+
+	// Cell files are named after the manifest: World.world -> World_3_-2.scene
+	std::string path = manifestFileName;
+	size_t slash = path.find_last_of("/\\");
+	std::string directory = slash == std::string::npos ? "" : path.substr(0, slash + 1);
+	std::string baseName = slash == std::string::npos ? path : path.substr(slash + 1);
+	baseName = baseName.substr(0, baseName.find_last_of('.'));
+
+	std::ofstream manifest(manifestFileName);
+	if (!manifest.is_open()) {
+		return false;
+	}
+	manifest << "cellsize " << cellSize << "\n";
+	for (std::map<std::pair<int, int>, SceneData>::iterator it = cellScenes.begin(); it != cellScenes.end(); ++it) {
+		std::ostringstream cellFile;
+		cellFile << baseName << "_" << it->first.first << "_" << it->first.second << ".scene";
+		it->second.AmbientColor = scene.AmbientColor;
+		if (!SceneFile::SaveText((directory + cellFile.str()).c_str(), it->second)) {
+			return false;
+		}
+		manifest << "cell " << it->first.first << " " << it->first.second << " " << cellFile.str() << "\n";
+	}
+	return manifest.good();
+}
+
+// A background job that keeps taking the nearest queued cell until there are none left
+void WorldStreamer::LoadJob()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (!quitting && !requests.empty()) {
+		unsigned int cellIndex = requests.front();
+		requests.erase(requests.begin());
+		cells[cellIndex].State = CELL_LOADING;
+		lock.unlock();
+
+		StreamedCell* result = new StreamedCell();
+		result->Cell = cellIndex;
+		LoadCell(cellIndex, *result);
+		lock.lock();
+		completed.push_back(result);
+	}
+	runningLoadJobs--;
+}
+
+// Runs in a load job, a cell that fails to load arrives empty rather than being retried forever
+void WorldStreamer::LoadCell(unsigned int cellIndex, StreamedCell& result)
+{
+	std::string textFileName;
+	std::string binaryFileName;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		textFileName = cells[cellIndex].TextFileName;
+		binaryFileName = cells[cellIndex].BinaryFileName;
+	}
+
+	MappedScene scene;
+	if (!SceneFile::Cook(textFileName.c_str(), binaryFileName.c_str()) || !scene.Open(binaryFileName.c_str())) {
+		printf("Streaming: couldn't load %s\n", textFileName.c_str());
+		return;
+	}
+	scene.ToSceneData(result.Scene);
+	for (int i = 0; i < result.Scene.MeshNames.size(); ++i) {
+		result.Meshes.push_back(AcquireMesh(result.Scene.MeshNames[i]));
+	}
+}
+
+// --------------------------------------------------------
+// Adds a reference to a cached mesh, loading it first if
+// it's new.  The file is read outside the lock, so two
+// load jobs can race to load the same mesh; the loser's copy
+// is thrown away.
+// --------------------------------------------------------
+Mesh* WorldStreamer::AcquireMesh(const std::string& name)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		std::map<std::string, CachedMesh>::iterator found = meshCache.find(name);
+		if (found != meshCache.end()) {
+			if (found->second.StreamedMesh) {
+				found->second.References++;
+			}
+			return found->second.StreamedMesh;
+		}
+	}
+
+	Mesh* mesh = new Mesh((modelDirectory + name + ".obj").c_str(), device, context);
+	if (mesh->GetVertices().empty()) {
+		printf("Streaming: couldn't load model %s\n", name.c_str());
+		delete mesh;
+		mesh = nullptr;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	std::map<std::string, CachedMesh>::iterator found = meshCache.find(name);
+	if (found != meshCache.end()) {
+		delete mesh;
+		if (found->second.StreamedMesh) {
+			found->second.References++;
+		}
+		return found->second.StreamedMesh;
+	}
+	CachedMesh cached = {};
+	cached.StreamedMesh = mesh;
+	if (mesh) {
+		cached.References = 1;
+		cached.Bytes = mesh->GetMemoryUsage();
+		meshSizes[name] = cached.Bytes;
+		meshBytes += cached.Bytes;
+	}
+	meshCache[name] = cached;
+	return mesh;
+}
+
+void WorldStreamer::ReleaseCellMeshes(Cell& cell)
+{
+	for (int i = 0; i < cell.HeldMeshes.size(); ++i) {
+		std::map<std::string, CachedMesh>::iterator found = meshCache.find(cell.HeldMeshes[i]);
+		if (found != meshCache.end() && --found->second.References == 0) {
+			meshBytes -= found->second.Bytes;
+			delete found->second.StreamedMesh;
+			meshCache.erase(found);
+		}
+	}
+	cell.HeldMeshes.clear();
+}
+
+// A cell the game hasn't picked up yet can be dropped on the spot, otherwise the game is told first
+void WorldStreamer::UnloadCell(unsigned int cellIndex)
+{
+	Cell& cell = cells[cellIndex];
+	stats.Unloads++;
+	for (int i = 0; i < ready.size(); ++i) {
+		if (ready[i]->Cell == cellIndex) {
+			delete ready[i];
+			ready.erase(ready.begin() + i);
+			ReleaseCellMeshes(cell);
+			cell.State = CELL_UNLOADED;
+			return;
+		}
+	}
+	cell.State = CELL_UNLOADING;
+	unloaded.push_back(cellIndex);
+}
+
+// The farthest loaded cell that's further away than the given distance, -1 if there isn't one
+int WorldStreamer::FindEvictionVictim(float furtherThan)
+{
+	int victim = -1;
+	for (int i = 0; i < cells.size(); ++i) {
+		if (cells[i].State == CELL_LOADED && cells[i].Distance > furtherThan && (victim < 0 || cells[i].Distance > cells[victim].Distance)) {
+			victim = i;
+		}
+	}
+	return victim;
+}
+
+// --------------------------------------------------------
+// What a cell adds on top of the cells in holders (mesh
+// name -> how many of them use it), which it then joins.
+// Cells that have been loaded before are exact, the rest
+// are guessed from what loading a new cell has cost on
+// average so far, and until the first one lands nothing is
+// known, so anything else is charged the whole budget.
+// --------------------------------------------------------
+size_t WorldStreamer::Charge(const Cell& cell, std::map<std::string, unsigned int>& holders)
+{
+	if (!cell.Known) {
+		return knownCells > 0 ? knownBytes / knownCells : budgetBytes;
+	}
+	size_t bytes = cell.EntityBytes;
+	for (int i = 0; i < cell.MeshNames.size(); ++i) {
+		if (holders[cell.MeshNames[i]]++ == 0) {
+			std::map<std::string, size_t>::iterator size = meshSizes.find(cell.MeshNames[i]);
+			bytes += size != meshSizes.end() ? size->second : 0;
+		}
+	}
+	return bytes;
+}
+
+// Unloads a loaded cell, taking back its charge: its entities and any meshes nothing else in holders uses
+void WorldStreamer::Evict(unsigned int cellIndex, size_t& committed, std::map<std::string, unsigned int>& holders)
+{
+	Cell& cell = cells[cellIndex];
+	size_t freed = cell.EntityBytes;
+	for (int i = 0; i < cell.HeldMeshes.size(); ++i) {
+		if (--holders[cell.HeldMeshes[i]] == 0) {
+			freed += meshSizes[cell.HeldMeshes[i]];
+		}
+	}
+	committed -= freed < committed ? freed : committed;
+	UnloadCell(cellIndex);
+	stats.Evictions++;
+}
+
+// --------------------------------------------------------
+// Frees what the game has finished with, hands over what
+// the load jobs have finished, then decides what to unload
+// and re-prioritizes the queue for the new camera position
+// --------------------------------------------------------
+void WorldStreamer::Update(XMFLOAT3 cameraPosition)
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	std::unique_lock<std::mutex> lock(mutex);
+	stats.Loads = 0;
+	stats.Unloads = 0;
+
+	for (int i = 0; i < releasing.size(); ++i) {
+		ReleaseCellMeshes(cells[releasing[i]]);
+		cells[releasing[i]].State = CELL_UNLOADED;
+	}
+	releasing.clear();
+
+	for (int i = 0; i < completed.size(); ++i) {
+		StreamedCell* result = completed[i];
+		Cell& cell = cells[result->Cell];
+		cell.EntityBytes = STREAMING_BYTES_PER_ENTITY * result->Scene.Entities.size();
+		cell.MeshNames.clear();
+		size_t bytes = cell.EntityBytes;
+		for (int m = 0; m < result->Meshes.size(); ++m) {
+			if (result->Meshes[m]) {
+				const std::string& name = result->Scene.MeshNames[m];
+				cell.MeshNames.push_back(name);
+				cell.HeldMeshes.push_back(name);
+				if (meshCache[name].References == 1) {
+					bytes += meshSizes[name]; //only the meshes this cell brought in
+				}
+			}
+		}
+		if (!cell.Known) {
+			knownBytes += bytes;
+			knownCells++;
+			cell.Known = true;
+		}
+		cell.State = CELL_LOADED;
+		ready.push_back(result);
+		stats.Loads++;
+	}
+	completed.clear();
+
+	// Distance to the nearest point of each cell, so the camera's own cell is always 0
+	for (int i = 0; i < cells.size(); ++i) {
+		Cell& cell = cells[i];
+		float minX = cell.X * cellSize;
+		float minZ = cell.Z * cellSize;
+		float dx = fmaxf(fmaxf(minX - cameraPosition.x, cameraPosition.x - (minX + cellSize)), 0.0f);
+		float dz = fmaxf(fmaxf(minZ - cameraPosition.z, cameraPosition.z - (minZ + cellSize)), 0.0f);
+		cell.Distance = sqrtf(dx * dx + dz * dz);
+		if (cell.State == CELL_LOADED && cell.Distance > unloadRadius) {
+			UnloadCell(i);
+		}
+	}
+
+	// What will be resident once pending unloads are done and in-flight loads land; queued
+	// requests haven't started, so they're dropped and re-sorted from scratch
+	for (int i = 0; i < requests.size(); ++i) {
+		cells[requests[i]].State = CELL_UNLOADED;
+	}
+	requests.clear();
+	std::map<std::string, unsigned int> holders;
+	size_t committed = 0;
+	FrameVector<unsigned int> candidates;
+	candidates.reserve(cells.size());
+	for (unsigned int i = 0; i < cells.size(); i++) {
+		if (cells[i].State == CELL_LOADED) {
+			committed += Charge(cells[i], holders);
+		}
+		else if (cells[i].State == CELL_UNLOADED && cells[i].Distance <= loadRadius) {
+			candidates.push_back(i);
+		}
+	}
+
+	// Anything that landed bigger than expected is made up for straight away
+	while (committed > budgetBytes) {
+		int victim = FindEvictionVictim(-1.0f);
+		if (victim < 0) {
+			break;
+		}
+		Evict(victim, committed, holders);
+	}
+	for (unsigned int i = 0; i < cells.size(); i++) {
+		if (cells[i].State == CELL_LOADING) {
+			committed += Charge(cells[i], holders);
+		}
+	}
+
+	std::sort(candidates.begin(), candidates.end(), [this](unsigned int a, unsigned int b) { return cells[a].Distance < cells[b].Distance; });
+	for (int c = 0; c < candidates.size(); ++c) {
+		Cell& cell = cells[candidates[c]];
+		std::map<std::string, unsigned int> withCell = holders;
+		size_t charge = Charge(cell, withCell);
+		while (committed + charge > budgetBytes) {
+			int victim = FindEvictionVictim(cell.Distance);
+			if (victim < 0) {
+				break;
+			}
+			Evict(victim, committed, holders);
+			withCell = holders;
+			charge = Charge(cell, withCell);
+		}
+		if (committed + charge > budgetBytes) {
+			stats.BudgetStalls++; //everything further out would have to wait too
+			break;
+		}
+		cell.State = CELL_QUEUED;
+		requests.push_back(candidates[c]);
+		committed += charge;
+		holders.swap(withCell);
+	}
+
+	stats.LoadedCells = 0;
+	stats.PendingCells = 0;
+	stats.ResidentBytes = meshBytes;
+	for (int i = 0; i < cells.size(); ++i) {
+		if (cells[i].State == CELL_LOADED || cells[i].State == CELL_UNLOADING) {
+			stats.LoadedCells += cells[i].State == CELL_LOADED ? 1 : 0;
+			stats.ResidentBytes += cells[i].EntityBytes;
+		}
+		else if (cells[i].State == CELL_QUEUED || cells[i].State == CELL_LOADING) {
+			stats.PendingCells++;
+		}
+	}
+	// Jobs already running pick up the new queue, more are started up to loadJobCount
+	unsigned int wanted = requests.size() < loadJobCount ? (unsigned int)requests.size() : loadJobCount;
+	unsigned int starting = wanted > runningLoadJobs ? wanted - runningLoadJobs : 0;
+	runningLoadJobs += starting;
+	lock.unlock();
+	for (unsigned int j = 0; j < starting; j++) {
+		jobs->Run([this] { LoadJob(); }, &loadJobs, true);
+	}
+
+	std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+	stats.UpdateMicroseconds = std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+bool WorldStreamer::PopLoadedCell(StreamedCell& cell)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (ready.empty()) {
+		return false;
+	}
+	cell = std::move(*ready.front());
+	delete ready.front();
+	ready.erase(ready.begin());
+	return true;
+}
+
+bool WorldStreamer::PopUnloadedCell(unsigned int& cell)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (unloaded.empty()) {
+		return false;
+	}
+	cell = unloaded.front();
+	unloaded.erase(unloaded.begin());
+	releasing.push_back(cell);
+	return true;
+}
+
+unsigned int WorldStreamer::GetCellCount()
+{
+	return (unsigned int)cells.size();
+}
+
+const WorldStreamerStats& WorldStreamer::GetStats()
+{
+	return stats;
+}
@@ -0,0 +1,166 @@
+#pragma once
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <DirectXMath.h>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "JobSystem.h"
+#include "Mesh.h"
+#include "SceneFile.h"
+
+// What a streamed entity costs once it's in the game: its components, render object and spatial proxy, roughly
+#define STREAMING_BYTES_PER_ENTITY 256
+
+// --------------------------------------------------------
+// A cell that finished loading, handed to the game to turn
+// into entities.  Meshes lines up with Scene.MeshNames and
+// is null where a model failed to load.  The meshes belong
+// to the streamer.
+// --------------------------------------------------------
+struct StreamedCell
+{
+	unsigned int Cell;
+	SceneData Scene;
+	std::vector<Mesh*> Meshes;
+};
+
+struct WorldStreamerStats
+{
+	unsigned int Cells;
+	unsigned int LoadedCells;		// Handed to the game and not unloaded since
+	unsigned int PendingCells;		// Queued or loading
+	size_t ResidentBytes;
+	size_t BudgetBytes;
+	unsigned int Loads;				// Cells handed over by the last Update
+	unsigned int Unloads;			// Cells dropped by the last Update, including evictions
+	unsigned int Evictions;			// Cells dropped early to fit the budget, since Open
+	unsigned int BudgetStalls;		// Updates that held a load back because nothing could be evicted for it
+	double UpdateMicroseconds;		// Main thread time in the last Update
+};
+
+// --------------------------------------------------------
+// Streams a world split into square cells on the XZ plane
+// around the camera.  Each cell is an ordinary scene file,
+// listed in a manifest:
+//
+//   cellsize 16
+//   cell 0 0 World_0_0.scene
+//   cell 1 0 World_1_0.scene
+//
+// Cells closer than loadRadius are queued nearest first and
+// loaded by background jobs: the scene is cooked and
+// mapped, and any models it uses that aren't resident yet
+// are loaded (buffer creation is free-threaded in D3D11).
+// Meshes are shared and reference counted between cells.
+// A cell is only unloaded once it's further than
+// unloadRadius, so a camera moving back and forth across a
+// boundary doesn't load and drop the same cell every frame.
+//
+// Nothing new is queued once the resident memory, plus
+// what's in flight, would go over the budget.  A nearer
+// cell can evict a loaded cell that's further away than it
+// is; if nothing qualifies it waits.  Cells that turn out
+// larger than expected are evicted farthest first as soon
+// as they land, and their real size is remembered.  Meshes
+// are charged once however many cells share them, and a
+// cell that was loaded before is only charged for the
+// meshes that aren't already resident.
+//
+// The game calls Update once a frame, then drains
+// PopUnloadedCell (destroying that cell's entities) and
+// PopLoadedCell (creating them).  Meshes of unloaded cells
+// are freed on the next Update, by which point the game
+// no longer draws them.
+// --------------------------------------------------------
+class WorldStreamer
+{
+private:
+	enum CellState
+	{
+		CELL_UNLOADED,
+		CELL_QUEUED,
+		CELL_LOADING,
+		CELL_LOADED,		// Includes loaded but not popped by the game yet
+		CELL_UNLOADING		// Waiting for the game to drop its entities, then its meshes are freed
+	};
+
+	struct Cell
+	{
+		int X;
+		int Z;
+		std::string TextFileName;
+		std::string BinaryFileName;
+		CellState State;
+		float Distance;					// From the camera to the nearest point of the cell, as of the last Update
+		bool Known;						// Loaded at least once, so the two below are exact
+		size_t EntityBytes;
+		std::vector<std::string> MeshNames;
+		std::vector<std::string> HeldMeshes;	// References it holds in meshCache right now
+	};
+
+	struct CachedMesh
+	{
+		Mesh* StreamedMesh;				// Null if the model failed to load, so it isn't retried for every cell
+		unsigned int References;
+		size_t Bytes;
+	};
+
+	Microsoft::WRL::ComPtr<ID3D11Device> device;
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> context;
+	std::string modelDirectory;
+	float cellSize;
+	float loadRadius;
+	float unloadRadius;
+	size_t budgetBytes;
+	JobSystem* jobs;
+	unsigned int loadJobCount;
+	JobCounter loadJobs;
+
+	// Everything from here down is shared with the load jobs and guarded by mutex
+	std::mutex mutex;
+	bool quitting;
+	unsigned int runningLoadJobs;
+	std::vector<Cell> cells;
+	std::map<std::string, CachedMesh> meshCache;
+	std::map<std::string, size_t> meshSizes;	// Every mesh ever loaded, resident or not
+	size_t meshBytes;							// Meshes in meshCache
+	size_t knownBytes;							// Entities and newly loaded meshes of every cell the first time it loaded
+	unsigned int knownCells;
+	std::vector<unsigned int> requests;		// Queued cells, nearest first
+	std::vector<StreamedCell*> completed;	// Loaded by a job, not picked up by Update yet
+	std::vector<StreamedCell*> ready;		// Waiting for PopLoadedCell
+	std::vector<unsigned int> unloaded;		// Waiting for PopUnloadedCell
+	std::vector<unsigned int> releasing;	// Popped by the game, meshes freed next Update
+
+	WorldStreamerStats stats;
+
+	void LoadJob();
+	void LoadCell(unsigned int cellIndex, StreamedCell& result);
+	Mesh* AcquireMesh(const std::string& name);
+	void ReleaseCellMeshes(Cell& cell);
+	void UnloadCell(unsigned int cellIndex);
+	int FindEvictionVictim(float furtherThan);
+	size_t Charge(const Cell& cell, std::map<std::string, unsigned int>& holders);
+	void Evict(unsigned int cellIndex, size_t& committed, std::map<std::string, unsigned int>& holders);
+public:
+	// modelDirectory is prefixed to "<mesh name>.obj", and at most loadJobCount cells load at once
+	WorldStreamer(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context, JobSystem* jobs, const std::string& modelDirectory,
+		size_t budgetBytes = 64 * 1024 * 1024, float loadRadius = 48.0f, float unloadRadius = 64.0f, unsigned int loadJobCount = 2);
+	~WorldStreamer();
+	WorldStreamer(const WorldStreamer&) = delete;
+	void operator=(const WorldStreamer&) = delete;
+
+	// Reads a manifest, cell file names are relative to it
+	bool Open(const char* manifestFileName);
+	// Splits a scene into cellSize squares by entity position and writes each as a scene file next to a new manifest
+	static bool WriteWorld(const SceneData& scene, float cellSize, const char* manifestFileName);
+
+	void Update(DirectX::XMFLOAT3 cameraPosition);
+	bool PopLoadedCell(StreamedCell& cell);
+	bool PopUnloadedCell(unsigned int& cell);
+
+	unsigned int GetCellCount();
+	const WorldStreamerStats& GetStats();
+};